@@ -0,0 +1,944 @@
+#include "BC7LaneEncoder.h"
+#include "LaneMath.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    using namespace LaneMath;
+
+    // =========================================================
+    // Tablas de BC7
+    // =========================================================
+
+    // Particiones de 2 subconjuntos: bit i = subconjunto del pixel i
+    const uint16_t kPartitionMask2[64] =
+    {
+        0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80,
+        0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+        0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE,
+        0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+        0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A,
+        0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+        0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C,
+        0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22,
+    };
+
+    // Pixel ancla del subconjunto 1 (el del 0 es siempre el pixel 0)
+    const uint8_t kAnchor2[64] =
+    {
+        15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+        15,  2,  8,  2,  2,  8,  8, 15,  2,  8,  2,  2,  8,  8,  2,  2,
+        15, 15,  6,  8,  2,  8, 15, 15,  2,  8,  2,  2,  2, 15, 15,  6,
+         6,  2,  6,  8, 15, 15,  2,  2, 15, 15, 15, 15, 15,  2,  2, 15,
+    };
+
+    const int kWeights2[4] = { 0, 21, 43, 64 };
+    const int kWeights3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+    const int kWeights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    struct ModeInfo
+    {
+        int mode;
+        int subsets;
+        int colorBits;      // sin p-bit
+        bool alpha;         // false: alfa = 255
+        bool sharedPbit;    // un p-bit por subconjunto (si no, uno por extremo)
+        int indexBits;
+    };
+
+    const ModeInfo kMode6 = { 6, 1, 7, true, false, 4 };
+    const ModeInfo kMode1 = { 1, 2, 6, false, true, 3 };
+    const ModeInfo kMode7 = { 7, 2, 5, true, false, 2 };
+
+    inline const int* Weights(int indexBits)
+    {
+        return indexBits == 2 ? kWeights2 : (indexBits == 3 ? kWeights3 : kWeights4);
+    }
+
+    // =========================================================
+    // Resultado de un bloque y empaquetado (escalar)
+    // =========================================================
+    struct BlockResult
+    {
+        float err;
+        int mode;
+        int partition;
+        int code[2][2][4];      // [subconjunto][extremo][canal], sin p-bit
+        int pbit[2][2];
+        int idx[16];
+    };
+
+    class BitWriter
+    {
+    public:
+        explicit BitWriter(uint8_t* out) : m_out(out) { memset(out, 0, 16); }
+
+        void Put(uint32_t value, int bits)
+        {
+            for (int b = 0; b < bits; ++b, ++m_pos)
+            {
+                if ((value >> b) & 1)
+                    m_out[m_pos >> 3] |= uint8_t(1u << (m_pos & 7));
+            }
+        }
+
+    private:
+        uint8_t* m_out;
+        int m_pos = 0;
+    };
+
+    inline int SubsetOf(int partition, int pixel, int subsets)
+    {
+        return subsets == 1 ? 0 : (kPartitionMask2[partition] >> pixel) & 1;
+    }
+
+    inline int AnchorOf(int partition, int subset)
+    {
+        return subset == 0 ? 0 : kAnchor2[partition];
+    }
+
+    void PackBlock(BlockResult r, uint8_t* out)
+    {
+        const ModeInfo& info = (r.mode == 6) ? kMode6 : (r.mode == 1 ? kMode1 : kMode7);
+        int n = 1 << info.indexBits;
+
+        // El indice del pixel ancla de cada subconjunto no lleva el bit
+        // alto: si lo tiene se intercambian los extremos
+        for (int s = 0; s < info.subsets; ++s)
+        {
+            int anchor = AnchorOf(r.partition, s);
+            if (r.idx[anchor] < n / 2)
+                continue;
+
+            for (int c = 0; c < 4; ++c)
+                std::swap(r.code[s][0][c], r.code[s][1][c]);
+            std::swap(r.pbit[s][0], r.pbit[s][1]);
+
+            for (int i = 0; i < 16; ++i)
+            {
+                if (SubsetOf(r.partition, i, info.subsets) == s)
+                    r.idx[i] = n - 1 - r.idx[i];
+            }
+        }
+
+        BitWriter w(out);
+        w.Put(1u << info.mode, info.mode + 1);
+
+        if (info.subsets == 2)
+            w.Put(uint32_t(r.partition), 6);
+
+        int channels = info.alpha ? 4 : 3;
+        for (int c = 0; c < channels; ++c)
+            for (int s = 0; s < info.subsets; ++s)
+                for (int e = 0; e < 2; ++e)
+                    w.Put(uint32_t(r.code[s][e][c]), info.colorBits);
+
+        for (int s = 0; s < info.subsets; ++s)
+        {
+            w.Put(uint32_t(r.pbit[s][0]), 1);
+            if (!info.sharedPbit)
+                w.Put(uint32_t(r.pbit[s][1]), 1);
+        }
+
+        for (int i = 0; i < 16; ++i)
+        {
+            bool anchor = (i == 0) || (info.subsets == 2 && i == kAnchor2[r.partition]);
+            w.Put(uint32_t(r.idx[i]), anchor ? info.indexBits - 1 : info.indexBits);
+        }
+    }
+
+    // =========================================================
+    // Codificador de un lote (un bloque por carril)
+    // =========================================================
+    template <class L>
+    class LaneEncoder
+    {
+        using V = typename L::V;
+        using M = typename L::M;
+        static const size_t N = L::N;
+
+        // Un subconjunto ya cuantizado
+        struct SubsetFit
+        {
+            V err;
+            V code[2][4];
+            V pbit[2];
+            V endpoint[2][4];   // extremos sin cuantizar (para refinar)
+            V idx[16];
+            V weight[16];       // peso BC7 (0..64) del indice de cada pixel
+        };
+
+    public:
+        LaneEncoder(const uint32_t (*blocks)[16], const BC7LaneParams& params)
+            : m_params(params)
+        {
+            alignas(32) float buf[16][4][N];
+            m_anyAlpha = false;
+
+            for (size_t l = 0; l < N; ++l)
+            {
+                m_hasAlpha[l] = false;
+                for (int i = 0; i < 16; ++i)
+                {
+                    uint32_t p = blocks[l][i];
+                    for (int c = 0; c < 4; ++c)
+                        buf[i][c][l] = float((p >> (8 * c)) & 0xFF);
+                    m_hasAlpha[l] |= (p >> 24) != 0xFF;
+                }
+                m_anyAlpha |= m_hasAlpha[l];
+            }
+
+            for (int i = 0; i < 16; ++i)
+                for (int c = 0; c < 4; ++c)
+                    m_px[i][c] = L::Load(buf[i][c]);
+
+            for (size_t l = 0; l < N; ++l)
+                m_best[l].err = 3.4e38f;
+        }
+
+        void Encode(uint8_t (*out)[16])
+        {
+            V ones[16];
+            for (int i = 0; i < 16; ++i)
+                ones[i] = L::Set(1.0f);
+
+            SubsetFit fit;
+            FitSubset(ones, kMode6, fit);
+            Record(kMode6, nullptr, &fit, nullptr);
+
+            if (m_params.partitions)
+                TryPartitions();
+
+            for (size_t l = 0; l < N; ++l)
+                PackBlock(m_best[l], out[l]);
+        }
+
+    private:
+        // ---------------------------------------------------------
+        // Cuantizacion de extremos
+        // ---------------------------------------------------------
+
+        // 'e' (0..255) con el p-bit 'p' -> codigo; 'expanded' es el valor
+        // de 8 bits que vera el decodificador
+        static V Quantize(V e, V p, int bits, V& expanded)
+        {
+            int nb = bits + 1;
+            V x = (e * L::Set(float((1 << nb) - 1) / 255.0f) - p) * L::Set(0.5f);
+            x = Min(Trunc(Max(x, L::Set(0.0f)) + L::Set(0.5f)), L::Set(float((1 << bits) - 1)));
+
+            V full = x * L::Set(2.0f) + p;
+            expanded = full * L::Set(float(1 << (8 - nb))) + Trunc(full * L::Set(1.0f / float(1 << (2 * nb - 8))));
+            return x;
+        }
+
+        // Error de cuantizar un extremo con cada p-bit
+        static V QuantizeError(const V e[4], V p, const ModeInfo& info)
+        {
+            V err = L::Set(0.0f);
+            int channels = info.alpha ? 4 : 3;
+            for (int c = 0; c < channels; ++c)
+            {
+                V expanded;
+                Quantize(e[c], p, info.colorBits, expanded);
+                V d = expanded - e[c];
+                err = err + d * d;
+            }
+            return err;
+        }
+
+        // Extremos con p-bits fijos -> codigos, indices y error
+        void Evaluate(const V e[2][4], const V p[2], const V W[16], const ModeInfo& info, SubsetFit& out) const
+        {
+            V expanded[2][4];
+
+            for (int j = 0; j < 2; ++j)
+            {
+                out.pbit[j] = p[j];
+                for (int c = 0; c < 4; ++c)
+                {
+                    out.endpoint[j][c] = e[j][c];
+
+                    if (c == 3 && !info.alpha)
+                    {
+                        out.code[j][c] = L::Set(0.0f);
+                        expanded[j][c] = L::Set(255.0f);
+                    }
+                    else
+                    {
+                        out.code[j][c] = Quantize(e[j][c], p[j], info.colorBits, expanded[j][c]);
+                    }
+                }
+            }
+
+            int n = 1 << info.indexBits;
+            const int* weights = Weights(info.indexBits);
+
+            V pal[16][4];
+            for (int k = 0; k < n; ++k)
+            {
+                V w0 = L::Set(float(64 - weights[k]));
+                V w1 = L::Set(float(weights[k]));
+                for (int c = 0; c < 4; ++c)
+                    pal[k][c] = Trunc((expanded[0][c] * w0 + expanded[1][c] * w1 + L::Set(32.0f)) * L::Set(1.0f / 64.0f));
+            }
+
+            V total = L::Set(0.0f);
+            for (int i = 0; i < 16; ++i)
+            {
+                V best = L::Set(3.4e38f);
+                V bestIdx = L::Set(0.0f);
+                V bestWeight = L::Set(0.0f);
+
+                for (int k = 0; k < n; ++k)
+                {
+                    V d0 = m_px[i][0] - pal[k][0];
+                    V d1 = m_px[i][1] - pal[k][1];
+                    V d2 = m_px[i][2] - pal[k][2];
+                    V d3 = m_px[i][3] - pal[k][3];
+                    V d = ((d0 * d0 + d1 * d1) + d2 * d2) + d3 * d3;
+
+                    M lt = d < best;
+                    best = Select(lt, d, best);
+                    bestIdx = Select(lt, L::Set(float(k)), bestIdx);
+                    bestWeight = Select(lt, L::Set(float(weights[k])), bestWeight);
+                }
+
+                out.idx[i] = bestIdx;
+                out.weight[i] = bestWeight;
+                total = total + best * W[i];
+            }
+
+            out.err = total;
+        }
+
+        static void SelectFit(M m, const SubsetFit& a, SubsetFit& dst)
+        {
+            dst.err = Select(m, a.err, dst.err);
+            for (int j = 0; j < 2; ++j)
+            {
+                dst.pbit[j] = Select(m, a.pbit[j], dst.pbit[j]);
+                for (int c = 0; c < 4; ++c)
+                {
+                    dst.code[j][c] = Select(m, a.code[j][c], dst.code[j][c]);
+                    dst.endpoint[j][c] = Select(m, a.endpoint[j][c], dst.endpoint[j][c]);
+                }
+            }
+            for (int i = 0; i < 16; ++i)
+            {
+                dst.idx[i] = Select(m, a.idx[i], dst.idx[i]);
+                dst.weight[i] = Select(m, a.weight[i], dst.weight[i]);
+            }
+        }
+
+        // Elige p-bits y deja el mejor resultado en 'out'
+        void QuantizeEndpoints(const V e[2][4], const V W[16], const ModeInfo& info, SubsetFit& out) const
+        {
+            V zero = L::Set(0.0f);
+            V one = L::Set(1.0f);
+
+            if (m_params.pbitSearch)
+            {
+                // Todas las combinaciones con el error real
+                int combos = info.sharedPbit ? 2 : 4;
+                for (int k = 0; k < combos; ++k)
+                {
+                    V p[2];
+                    p[0] = (k & 1) ? one : zero;
+                    p[1] = info.sharedPbit ? p[0] : ((k & 2) ? one : zero);
+
+                    if (k == 0)
+                    {
+                        Evaluate(e, p, W, info, out);
+                        continue;
+                    }
+
+                    SubsetFit candidate;
+                    Evaluate(e, p, W, info, candidate);
+                    SelectFit(candidate.err < out.err, candidate, out);
+                }
+                return;
+            }
+
+            // El p-bit que menos error de cuantizacion da a cada extremo
+            V p[2];
+            if (info.sharedPbit)
+            {
+                V err0 = QuantizeError(e[0], zero, info) + QuantizeError(e[1], zero, info);
+                V err1 = QuantizeError(e[0], one, info) + QuantizeError(e[1], one, info);
+                p[0] = p[1] = Select(err1 < err0, one, zero);
+            }
+            else
+            {
+                for (int j = 0; j < 2; ++j)
+                    p[j] = Select(QuantizeError(e[j], one, info) < QuantizeError(e[j], zero, info), one, zero);
+            }
+
+            Evaluate(e, p, W, info, out);
+        }
+
+        // ---------------------------------------------------------
+        // Ajuste de un subconjunto (W[i] = 1 si el pixel es suyo)
+        // ---------------------------------------------------------
+
+        // Eje principal de la matriz de dispersion (power iteration,
+        // empezando por la columna de mayor diagonal)
+        static void PrincipalAxis(const V cov[4][4], int channels, V axis[4])
+        {
+            V dmax = cov[0][0];
+            for (int c = 0; c < 4; ++c)
+                axis[c] = cov[c][0];
+
+            for (int d = 1; d < channels; ++d)
+            {
+                M gt = cov[d][d] > dmax;
+                dmax = Select(gt, cov[d][d], dmax);
+                for (int c = 0; c < 4; ++c)
+                    axis[c] = Select(gt, cov[c][d], axis[c]);
+            }
+
+            for (int it = 0; it < 4; ++it)
+            {
+                V next[4];
+                V scale = L::Set(0.0f);
+                for (int c = 0; c < channels; ++c)
+                {
+                    next[c] = L::Set(0.0f);
+                    for (int d = 0; d < channels; ++d)
+                        next[c] = next[c] + cov[c][d] * axis[d];
+                    scale = Max(scale, Max(next[c], L::Set(0.0f) - next[c]));
+                }
+
+                V inv = L::Set(1.0f) / Max(scale, L::Set(1e-20f));
+                for (int c = 0; c < channels; ++c)
+                    axis[c] = next[c] * inv;
+            }
+
+            V len2 = L::Set(0.0f);
+            for (int c = 0; c < channels; ++c)
+                len2 = len2 + axis[c] * axis[c];
+
+            V inv = L::Set(1.0f) / Max(Sqrt(len2), L::Set(1e-20f));
+            for (int c = 0; c < 4; ++c)
+                axis[c] = (c < channels) ? axis[c] * inv : L::Set(0.0f);
+        }
+
+        void FitSubset(const V W[16], const ModeInfo& info, SubsetFit& out) const
+        {
+            int channels = info.alpha ? 4 : 3;
+            V zero = L::Set(0.0f);
+
+            V count = zero;
+            V mean[4] = { zero, zero, zero, zero };
+            for (int i = 0; i < 16; ++i)
+            {
+                count = count + W[i];
+                for (int c = 0; c < 4; ++c)
+                    mean[c] = mean[c] + W[i] * m_px[i][c];
+            }
+
+            V inv = L::Set(1.0f) / Max(count, L::Set(1.0f));
+            for (int c = 0; c < 4; ++c)
+                mean[c] = mean[c] * inv;
+
+            V cov[4][4];
+            for (int c = 0; c < 4; ++c)
+                for (int d = 0; d < 4; ++d)
+                    cov[c][d] = zero;
+
+            for (int i = 0; i < 16; ++i)
+            {
+                V diff[4];
+                for (int c = 0; c < channels; ++c)
+                    diff[c] = (m_px[i][c] - mean[c]) * W[i];
+
+                for (int c = 0; c < channels; ++c)
+                    for (int d = c; d < channels; ++d)
+                        cov[c][d] = cov[c][d] + diff[c] * (m_px[i][d] - mean[d]);
+            }
+
+            for (int c = 0; c < channels; ++c)
+                for (int d = 0; d < c; ++d)
+                    cov[c][d] = cov[d][c];
+
+            V axis[4];
+            PrincipalAxis(cov, channels, axis);
+
+            // Extension de los pixeles del subconjunto sobre el eje
+            V tmin = L::Set(3.4e38f);
+            V tmax = L::Set(-3.4e38f);
+            for (int i = 0; i < 16; ++i)
+            {
+                V t = zero;
+                for (int c = 0; c < channels; ++c)
+                    t = t + (m_px[i][c] - mean[c]) * axis[c];
+
+                M in = W[i] > zero;
+                tmin = Select(in, Min(tmin, t), tmin);
+                tmax = Select(in, Max(tmax, t), tmax);
+            }
+
+            M empty = L::Set(0.5f) > count;
+            tmin = Select(empty, zero, tmin);
+            tmax = Select(empty, zero, tmax);
+
+            V e[2][4];
+            for (int c = 0; c < 4; ++c)
+            {
+                if (c == 3 && !info.alpha)
+                {
+                    e[0][c] = e[1][c] = L::Set(255.0f);
+                    continue;
+                }
+
+                e[0][c] = Min(Max(mean[c] + axis[c] * tmin, zero), L::Set(255.0f));
+                e[1][c] = Min(Max(mean[c] + axis[c] * tmax, zero), L::Set(255.0f));
+            }
+
+            QuantizeEndpoints(e, W, info, out);
+
+            for (uint32_t it = 0; it < m_params.refineIterations; ++it)
+                Refine(W, info, out);
+        }
+
+        // Minimos cuadrados sobre los extremos con los indices actuales;
+        // se queda con lo nuevo solo donde mejora
+        void Refine(const V W[16], const ModeInfo& info, SubsetFit& fit) const
+        {
+            int channels = info.alpha ? 4 : 3;
+            V zero = L::Set(0.0f);
+            V one = L::Set(1.0f);
+
+            V a00 = zero, a01 = zero, a11 = zero;
+            V x0[4] = { zero, zero, zero, zero };
+            V x1[4] = { zero, zero, zero, zero };
+
+            for (int i = 0; i < 16; ++i)
+            {
+                V a = fit.weight[i] * L::Set(1.0f / 64.0f);
+                V b = one - a;
+                V wa = W[i] * a;
+                V wb = W[i] * b;
+
+                a00 = a00 + wb * b;
+                a01 = a01 + wa * b;
+                a11 = a11 + wa * a;
+                for (int c = 0; c < channels; ++c)
+                {
+                    x0[c] = x0[c] + wb * m_px[i][c];
+                    x1[c] = x1[c] + wa * m_px[i][c];
+                }
+            }
+
+            V det = a00 * a11 - a01 * a01;
+            M ok = det > L::Set(1e-3f);
+            V inv = one / Select(ok, det, one);
+
+            V e[2][4];
+            for (int c = 0; c < 4; ++c)
+            {
+                if (c == 3 && !info.alpha)
+                {
+                    e[0][c] = e[1][c] = L::Set(255.0f);
+                    continue;
+                }
+
+                V e0 = (a11 * x0[c] - a01 * x1[c]) * inv;
+                V e1 = (a00 * x1[c] - a01 * x0[c]) * inv;
+                e[0][c] = Select(ok, Min(Max(e0, zero), L::Set(255.0f)), fit.endpoint[0][c]);
+                e[1][c] = Select(ok, Min(Max(e1, zero), L::Set(255.0f)), fit.endpoint[1][c]);
+            }
+
+            SubsetFit candidate;
+            QuantizeEndpoints(e, W, info, candidate);
+            SelectFit(candidate.err < fit.err, candidate, fit);
+        }
+
+        // ---------------------------------------------------------
+        // Particiones de 2 subconjuntos
+        // ---------------------------------------------------------
+
+        // Error de ajustar una recta a un subconjunto a partir de sus
+        // sumas: traza de la dispersion - autovalor principal
+        static V LineError(const V s1[4], const V s2[10], float count)
+        {
+            if (count < 0.5f)
+                return L::Set(0.0f);
+
+            V inv = L::Set(1.0f / count);
+            V cov[4][4];
+            int k = 0;
+            for (int c = 0; c < 4; ++c)
+            {
+                for (int d = c; d < 4; ++d, ++k)
+                {
+                    cov[c][d] = s2[k] - s1[c] * s1[d] * inv;
+                    cov[d][c] = cov[c][d];
+                }
+            }
+
+            V axis[4];
+            PrincipalAxis(cov, 4, axis);
+
+            V lambda = L::Set(0.0f);
+            for (int c = 0; c < 4; ++c)
+            {
+                V row = L::Set(0.0f);
+                for (int d = 0; d < 4; ++d)
+                    row = row + cov[c][d] * axis[d];
+                lambda = lambda + row * axis[c];
+            }
+
+            V trace = ((cov[0][0] + cov[1][1]) + cov[2][2]) + cov[3][3];
+            return Max(trace - lambda, L::Set(0.0f));
+        }
+
+        void TryPartitions()
+        {
+            // Momentos de cada pixel
+            V prod[16][10];
+            V t1[4], t2[10];
+            for (int c = 0; c < 4; ++c)
+                t1[c] = L::Set(0.0f);
+            for (int k = 0; k < 10; ++k)
+                t2[k] = L::Set(0.0f);
+
+            for (int i = 0; i < 16; ++i)
+            {
+                int k = 0;
+                for (int c = 0; c < 4; ++c)
+                    for (int d = c; d < 4; ++d, ++k)
+                        prod[i][k] = m_px[i][c] * m_px[i][d];
+
+                for (int c = 0; c < 4; ++c)
+                    t1[c] = t1[c] + m_px[i][c];
+                for (k = 0; k < 10; ++k)
+                    t2[k] = t2[k] + prod[i][k];
+            }
+
+            // Estimacion de las 64 particiones, las mismas para todos los carriles
+            alignas(32) float estimate[64][N];
+            for (int p = 0; p < 64; ++p)
+            {
+                uint32_t mask = kPartitionMask2[p];
+
+                V s1[4], s2[10];
+                for (int c = 0; c < 4; ++c)
+                    s1[c] = L::Set(0.0f);
+                for (int k = 0; k < 10; ++k)
+                    s2[k] = L::Set(0.0f);
+
+                int count1 = 0;
+                for (int i = 0; i < 16; ++i)
+                {
+                    if (!((mask >> i) & 1))
+                        continue;
+
+                    ++count1;
+                    for (int c = 0; c < 4; ++c)
+                        s1[c] = s1[c] + m_px[i][c];
+                    for (int k = 0; k < 10; ++k)
+                        s2[k] = s2[k] + prod[i][k];
+                }
+
+                V r1[4], r2[10];
+                for (int c = 0; c < 4; ++c)
+                    r1[c] = t1[c] - s1[c];
+                for (int k = 0; k < 10; ++k)
+                    r2[k] = t2[k] - s2[k];
+
+                V err = LineError(s1, s2, float(count1)) + LineError(r1, r2, float(16 - count1));
+                L::Store(estimate[p], err);
+            }
+
+            // Las mejores de cada bloque
+            uint32_t candidates = std::min<uint32_t>(m_params.partitions, 64);
+            int best[64][N];
+            for (size_t l = 0; l < N; ++l)
+            {
+                int order[64];
+                for (int p = 0; p < 64; ++p)
+                    order[p] = p;
+
+                std::partial_sort(order, order + candidates, order + 64, [&](int a, int b)
+                    {
+                        return estimate[a][l] < estimate[b][l] || (estimate[a][l] == estimate[b][l] && a < b);
+                    });
+
+                for (uint32_t k = 0; k < candidates; ++k)
+                    best[k][l] = order[k];
+            }
+
+            for (uint32_t k = 0; k < candidates; ++k)
+            {
+                alignas(32) float w1[16][N];
+                int partition[N];
+                for (size_t l = 0; l < N; ++l)
+                {
+                    partition[l] = best[k][l];
+                    for (int i = 0; i < 16; ++i)
+                        w1[i][l] = float((kPartitionMask2[partition[l]] >> i) & 1);
+                }
+
+                V W0[16], W1[16];
+                for (int i = 0; i < 16; ++i)
+                {
+                    W1[i] = L::Load(w1[i]);
+                    W0[i] = L::Set(1.0f) - W1[i];
+                }
+
+                SubsetFit fit0, fit1;
+                FitSubset(W0, kMode1, fit0);
+                FitSubset(W1, kMode1, fit1);
+                Record(kMode1, partition, &fit0, &fit1);
+
+                // Modo 7 solo en los carriles con alpha: el resultado de
+                // cada bloque no depende de con quien comparte lote
+                if (m_anyAlpha)
+                {
+                    FitSubset(W0, kMode7, fit0);
+                    FitSubset(W1, kMode7, fit1);
+                    Record(kMode7, partition, &fit0, &fit1, m_hasAlpha);
+                }
+            }
+        }
+
+        // ---------------------------------------------------------
+        // Mejor resultado de cada carril
+        // ---------------------------------------------------------
+        // 'lanes' (opcional): solo los carriles marcados
+        void Record(const ModeInfo& info, const int* partition, const SubsetFit* fit0, const SubsetFit* fit1,
+            const bool* lanes = nullptr)
+        {
+            const SubsetFit* fits[2] = { fit0, fit1 };
+
+            alignas(32) float err[N];
+            alignas(32) float code[2][2][4][N];
+            alignas(32) float pbit[2][2][N];
+            alignas(32) float idx[2][16][N];
+
+            V total = fit0->err;
+            if (fit1)
+                total = total + fit1->err;
+            L::Store(err, total);
+
+            for (int s = 0; s < info.subsets; ++s)
+            {
+                for (int j = 0; j < 2; ++j)
+                {
+                    L::Store(pbit[s][j], fits[s]->pbit[j]);
+                    for (int c = 0; c < 4; ++c)
+                        L::Store(code[s][j][c], fits[s]->code[j][c]);
+                }
+                for (int i = 0; i < 16; ++i)
+                    L::Store(idx[s][i], fits[s]->idx[i]);
+            }
+
+            for (size_t l = 0; l < N; ++l)
+            {
+                if ((lanes && !lanes[l]) || !(err[l] < m_best[l].err))
+                    continue;
+
+                BlockResult& r = m_best[l];
+                r.err = err[l];
+                r.mode = info.mode;
+                r.partition = partition ? partition[l] : 0;
+
+                for (int s = 0; s < info.subsets; ++s)
+                {
+                    for (int j = 0; j < 2; ++j)
+                    {
+                        r.pbit[s][j] = int(pbit[s][j][l]);
+                        for (int c = 0; c < 4; ++c)
+                            r.code[s][j][c] = int(code[s][j][c][l]);
+                    }
+                }
+
+                for (int i = 0; i < 16; ++i)
+                    r.idx[i] = int(idx[SubsetOf(r.partition, i, info.subsets)][i][l]);
+            }
+        }
+
+        const BC7LaneParams& m_params;
+        V m_px[16][4];
+        bool m_hasAlpha[N];     // algun pixel con alpha != 255
+        bool m_anyAlpha;
+        BlockResult m_best[N];
+    };
+
+    template <class L>
+    void EncodeBlocksLanes(const uint32_t (*blocks)[16], size_t count, uint8_t (*out)[16], const BC7LaneParams& params)
+    {
+        const size_t N = L::N;
+
+        for (size_t b = 0; b < count; b += N)
+        {
+            size_t n = std::min(N, count - b);
+
+            if (n == N)
+            {
+                LaneEncoder<L> encoder(blocks + b, params);
+                encoder.Encode(out + b);
+                continue;
+            }
+
+            // Ultimo lote incompleto: se rellena repitiendo el ultimo bloque
+            uint32_t tail[N][16];
+            uint8_t tailOut[N][16];
+            for (size_t l = 0; l < N; ++l)
+                memcpy(tail[l], blocks[b + std::min(l, n - 1)], sizeof(tail[l]));
+
+            LaneEncoder<L> encoder(tail, params);
+            encoder.Encode(tailOut);
+
+            for (size_t l = 0; l < n; ++l)
+                memcpy(out[b + l], tailOut[l], 16);
+        }
+    }
+
+    const BC7LaneKernels kScalarKernels = { KernelLevel::Scalar, 1, EncodeBlocksLanes<Lanes1> };
+    const BC7LaneKernels kSSE2Kernels = { KernelLevel::SSE2, 4, EncodeBlocksLanes<Lanes4> };
+    const BC7LaneKernels kAVX2Kernels = { KernelLevel::AVX2, 8, EncodeBlocksLanes<Lanes8> };
+
+    // =========================================================
+    // Eleccion de codificador por calidad
+    // =========================================================
+    const int kQualityCount = 6;
+
+    std::atomic<int> g_backend[kQualityCount] = {};
+
+    const BC7LaneParams kLaneParams[kQualityCount] =
+    {
+        { 0, 1, false },    // UltraFast: solo modo 6
+        { 2, 1, false },    // FastBalanced
+        { 4, 2, false },    // Balanced
+        { 2, 1, false },    // HighQuality (mismas flags que FastBalanced)
+        { 8, 2, true },     // HighQualityUniform
+        { 1, 1, false },    // QuickOnly
+    };
+
+    inline TEX_COMPRESS_FLAGS SerialFlags(TEX_COMPRESS_FLAGS flags)
+    {
+        return flags & ~TEX_COMPRESS_PARALLEL;
+    }
+
+    // Primera calidad con estas flags, -1 si ninguna
+    int QualityForFlags(TEX_COMPRESS_FLAGS flags)
+    {
+        flags = SerialFlags(flags);
+
+        for (int q = 0; q < kQualityCount; ++q)
+        {
+            if (SerialFlags(GetBC7CompressFlags(BC7Quality(q))) == flags)
+                return q;
+        }
+
+        return -1;
+    }
+}
+
+BC7LaneParams GetBC7LaneParams(BC7Quality quality)
+{
+    int q = int(quality);
+    return (q >= 0 && q < kQualityCount) ? kLaneParams[q] : kLaneParams[0];
+}
+
+const BC7LaneKernels* GetBC7LaneKernels(KernelLevel level)
+{
+    if (level > DetectKernelLevel())
+        return nullptr;
+
+    switch (level)
+    {
+    case KernelLevel::AVX2: return &kAVX2Kernels;
+    case KernelLevel::SSE2: return &kSSE2Kernels;
+    default:                return &kScalarKernels;
+    }
+}
+
+const BC7LaneKernels& GetBC7LaneKernels()
+{
+    return *GetBC7LaneKernels(DetectKernelLevel());
+}
+
+BC7Backend SetBC7Backend(BC7Quality quality, BC7Backend backend)
+{
+    int q = int(quality);
+    if (q < 0 || q >= kQualityCount)
+        return BC7_BACKEND_DIRECTXTEX;
+
+    BC7Backend previous = BC7Backend(g_backend[q].load());
+    TEX_COMPRESS_FLAGS flags = SerialFlags(GetBC7CompressFlags(quality));
+
+    for (int other = 0; other < kQualityCount; ++other)
+    {
+        if (SerialFlags(GetBC7CompressFlags(BC7Quality(other))) == flags)
+            g_backend[other] = int(backend);
+    }
+
+    return previous;
+}
+
+BC7Backend GetBC7Backend(BC7Quality quality)
+{
+    int q = int(quality);
+    return (q >= 0 && q < kQualityCount) ? BC7Backend(g_backend[q].load()) : BC7_BACKEND_DIRECTXTEX;
+}
+
+const BC7LaneParams* GetBC7LaneParamsForFlags(TEX_COMPRESS_FLAGS flags)
+{
+    int q = QualityForFlags(flags);
+    if (q < 0)
+        return nullptr;
+
+    return (g_backend[q].load(std::memory_order_relaxed) == BC7_BACKEND_LANES) ? &kLaneParams[q] : nullptr;
+}
+
+const BC7LaneParams* GetBC7LaneParamsForFlags(TEX_COMPRESS_FLAGS flags, BC7Backend backend)
+{
+    int q = QualityForFlags(flags);
+    if (q < 0 || backend != BC7_BACKEND_LANES)
+        return nullptr;
+
+    return &kLaneParams[q];
+}
+
+HRESULT EncodeBC7Lanes(const Image& rgba, const Image& dst, const BC7LaneParams& params, const BC7LaneKernels* kernels)
+{
+    if (!rgba.pixels || rgba.format != DXGI_FORMAT_R8G8B8A8_UNORM || !dst.pixels
+        || dst.width != rgba.width || dst.height != rgba.height)
+        return E_INVALIDARG;
+
+    if (!kernels)
+        kernels = &GetBC7LaneKernels();
+
+    size_t blocksW = (rgba.width + 3) / 4;
+    size_t blocksH = (rgba.height + 3) / 4;
+
+    // Una fila de bloques cada vez
+    std::vector<uint32_t> row(blocksW * 16);
+
+    for (size_t by = 0; by < blocksH; ++by)
+    {
+        for (size_t bx = 0; bx < blocksW; ++bx)
+        {
+            for (size_t j = 0; j < 4; ++j)
+            {
+                size_t y = std::min(by * 4 + j, rgba.height - 1);
+                const uint32_t* src = reinterpret_cast<const uint32_t*>(rgba.pixels + y * rgba.rowPitch);
+
+                for (size_t i = 0; i < 4; ++i)
+                    row[bx * 16 + j * 4 + i] = src[std::min(bx * 4 + i, rgba.width - 1)];
+            }
+        }
+
+        kernels->encode(reinterpret_cast<const uint32_t (*)[16]>(row.data()), blocksW, reinterpret_cast<uint8_t (*)[16]>(dst.pixels + by * dst.rowPitch), params);
+    }
+
+    return S_OK;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <windows.h>
+#include "DirectXTex.h"
+#include "ImageKernels.h"
+#include "TextureEncode.h"
+#include <cstddef>
+#include <cstdint>
+
+// -------------------------------------------------------------
+// Codificador BC7 propio que procesa varios bloques a la vez, uno por
+// carril SIMD (4 con SSE2, 8 con AVX2), al estilo de ISPC: ajuste de
+// extremos, eleccion de indices y evaluacion de particiones se hacen
+// con la misma secuencia de instrucciones para todos los bloques del
+// lote. La tabla de particiones es comun a todos los carriles, asi que
+// las 64 particiones de 2 subconjuntos se estiman sin ramas por bloque.
+//
+// Modos: 6 (1 subconjunto RGBA, indices de 4 bits), 1 (2
+// subconjuntos RGB, indices de 3 bits) y 7 (2 subconjuntos RGBA,
+// indices de 2 bits; solo en los bloques que tienen alfa). Cada
+// bloque se queda con el modo/particion de menor error RGBA uniforme.
+//
+// Las tres versiones dan exactamente el mismo resultado: todo es float
+// con las mismas operaciones en el mismo orden.
+// -------------------------------------------------------------
+
+enum BC7Backend
+{
+    BC7_BACKEND_DIRECTXTEX = 0,     // Compress de DirectXTex (por defecto)
+    BC7_BACKEND_LANES = 1,          // este codificador
+};
+
+struct BC7LaneParams
+{
+    uint32_t partitions;        // particiones de 2 subconjuntos que se prueban de verdad (0 = solo modo 6)
+    uint32_t refineIterations;  // pasadas de minimos cuadrados sobre los extremos
+    bool     pbitSearch;        // probar todas las combinaciones de p-bits con el error real
+};
+
+// Ajustes para cada calidad (mas particiones y pasadas cuanto mas alta)
+BC7LaneParams GetBC7LaneParams(BC7Quality quality);
+
+struct BC7LaneKernels
+{
+    KernelLevel level;
+    size_t lanes;
+
+    // 'count' bloques de 16 pixeles RGBA8 (fila a fila) -> 16 bytes BC7
+    // cada uno. count no tiene que ser multiplo de 'lanes'.
+    void (*encode)(const uint32_t (*blocks)[16], size_t count, uint8_t (*out)[16], const BC7LaneParams& params);
+};
+
+// nullptr si la CPU no soporta el nivel
+const BC7LaneKernels* GetBC7LaneKernels(KernelLevel level);
+const BC7LaneKernels& GetBC7LaneKernels();
+
+// Codificador de cada calidad. Las calidades con las mismas flags
+// (FastBalanced y HighQuality sin PARALLEL) comparten la eleccion.
+// Devuelve el anterior.
+BC7Backend SetBC7Backend(BC7Quality quality, BC7Backend backend);
+BC7Backend GetBC7Backend(BC7Quality quality);
+
+// Ajustes del codificador por carriles si las flags de Compress
+// corresponden a una calidad que lo usa; nullptr si va por DirectXTex
+const BC7LaneParams* GetBC7LaneParamsForFlags(DirectX::TEX_COMPRESS_FLAGS flags);
+
+// Igual con el codificador de la llamada en vez del de SetBC7Backend
+const BC7LaneParams* GetBC7LaneParamsForFlags(DirectX::TEX_COMPRESS_FLAGS flags, BC7Backend backend);
+
+// Imagen RGBA8 entera a 'dst' (BC7 ya reservado, mismo tamano), en el
+// hilo que llama. Los bloques incompletos repiten el borde. 'kernels'
+// fuerza un nivel (para comparar niveles); nullptr = el de la CPU.
+HRESULT EncodeBC7Lanes(const DirectX::Image& rgba, const DirectX::Image& dst, const BC7LaneParams& params,
+    const BC7LaneKernels* kernels = nullptr);
+
+#ifdef _WIN32
+// Codificador de una calidad (BC7Quality, o -1 = todas). Devuelve el
+// anterior de esa calidad (o de UltraFast con -1).
+extern "C" int __stdcall SetBC7BackendW(int quality, int backend);
+#endif
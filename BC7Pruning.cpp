@@ -0,0 +1,184 @@
+#include "BC7Pruning.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+    // Umbrales con aggressiveness = 1, en error cuadratico por pixel
+    // (suma de los 4 canales, 0..255)
+    const float kSmoothVariance = 24.0f;    // bloque casi plano: cualquier modo sirve
+    const float kLineError = 6.0f;          // casi colineal: el modo 6 no pierde
+    const float kTwoSubsetError = 48.0f;    // 3 subconjuntos casi nunca ganan
+
+    std::atomic<float> g_aggressiveness{ 0.0f };
+    std::atomic<uint64_t> g_blocks[kBC7TierCount] = {};
+
+    // Mayor autovalor de una matriz simetrica 4x4 (power iteration,
+    // empezando por la columna de mayor diagonal: nunca es ortogonal
+    // al eje principal si la matriz no es nula)
+    float LargestEigenvalue(const float cov[4][4])
+    {
+        int start = 0;
+        for (int c = 1; c < 4; ++c)
+        {
+            if (cov[c][c] > cov[start][start])
+                start = c;
+        }
+
+        float v[4] = { cov[0][start], cov[1][start], cov[2][start], cov[3][start] };
+        float lambda = 0.0f;
+
+        for (int it = 0; it < 8; ++it)
+        {
+            float w[4];
+            float scale = 0.0f;
+            for (int c = 0; c < 4; ++c)
+            {
+                w[c] = cov[c][0] * v[0] + cov[c][1] * v[1] + cov[c][2] * v[2] + cov[c][3] * v[3];
+                scale = std::max(scale, std::fabs(w[c]));
+            }
+
+            if (scale <= 0.0f)
+                return 0.0f;
+
+            for (int c = 0; c < 4; ++c)
+                v[c] = w[c] / scale;
+            lambda = scale;
+        }
+
+        // Cociente de Rayleigh con el vector final
+        float num = 0.0f, den = 0.0f;
+        for (int c = 0; c < 4; ++c)
+        {
+            float row = cov[c][0] * v[0] + cov[c][1] * v[1] + cov[c][2] * v[2] + cov[c][3] * v[3];
+            num += row * v[c];
+            den += v[c] * v[c];
+        }
+
+        return den > 0.0f ? num / den : lambda;
+    }
+}
+
+void ComputeBC7BlockStats(const uint32_t px[16], BC7BlockStats& stats)
+{
+    float mean[4] = {};
+    uint8_t alphaMin = 255, alphaMax = 0;
+    uint8_t distinct = 0;
+
+    for (int i = 0; i < 16; ++i)
+    {
+        for (int c = 0; c < 4; ++c)
+            mean[c] += float((px[i] >> (8 * c)) & 0xFF);
+
+        uint8_t a = uint8_t(px[i] >> 24);
+        alphaMin = std::min(alphaMin, a);
+        alphaMax = std::max(alphaMax, a);
+
+        bool seen = false;
+        for (int j = 0; j < i && !seen; ++j)
+            seen = (px[j] == px[i]);
+        if (!seen)
+            ++distinct;
+    }
+
+    for (int c = 0; c < 4; ++c)
+        mean[c] *= 1.0f / 16.0f;
+
+    float cov[4][4] = {};
+    for (int i = 0; i < 16; ++i)
+    {
+        float d[4];
+        for (int c = 0; c < 4; ++c)
+            d[c] = float((px[i] >> (8 * c)) & 0xFF) - mean[c];
+
+        for (int c = 0; c < 4; ++c)
+            for (int e = 0; e < 4; ++e)
+                cov[c][e] += d[c] * d[e];
+    }
+
+    for (int c = 0; c < 4; ++c)
+        for (int e = 0; e < 4; ++e)
+            cov[c][e] *= 1.0f / 16.0f;
+
+    float trace = cov[0][0] + cov[1][1] + cov[2][2] + cov[3][3];
+
+    stats.variance = trace;
+    stats.lineError = std::max(trace - LargestEigenvalue(cov), 0.0f);
+    stats.alphaRange = uint8_t(alphaMax - alphaMin);
+    stats.distinctColors = distinct;
+}
+
+BC7SearchTier ClassifyBC7Block(const BC7BlockStats& stats, float aggressiveness)
+{
+    if (aggressiveness <= 0.0f)
+        return BC7_TIER_FULL;
+
+    // Dos colores siempre estan en una recta: no hay nada que podar mal
+    if (stats.distinctColors <= 2
+        || stats.variance <= kSmoothVariance * aggressiveness
+        || stats.lineError <= kLineError * aggressiveness)
+        return BC7_TIER_LINE;
+
+    // Los modos 0 y 2 no tienen alfa: con alfa no pueden ganar
+    if (stats.alphaRange != 0)
+        return BC7_TIER_TWO_SUBSETS;
+
+    if (stats.lineError <= kTwoSubsetError * aggressiveness)
+        return BC7_TIER_TWO_SUBSETS;
+
+    return BC7_TIER_FULL;
+}
+
+BC7SearchTier ClassifyBC7Block(const uint32_t px[16], float aggressiveness)
+{
+    if (aggressiveness <= 0.0f)
+        return BC7_TIER_FULL;
+
+    BC7BlockStats stats;
+    ComputeBC7BlockStats(px, stats);
+    return ClassifyBC7Block(stats, aggressiveness);
+}
+
+TEX_COMPRESS_FLAGS GetBC7TierFlags(TEX_COMPRESS_FLAGS flags, BC7SearchTier tier)
+{
+    switch (tier)
+    {
+    case BC7_TIER_LINE:         return (flags & ~TEX_COMPRESS_BC7_USE_3SUBSETS) | TEX_COMPRESS_BC7_QUICK;
+    case BC7_TIER_TWO_SUBSETS:  return flags & ~TEX_COMPRESS_BC7_USE_3SUBSETS;
+    default:                    return flags;
+    }
+}
+
+void SetBC7Pruning(float aggressiveness)
+{
+    g_aggressiveness = std::min(std::max(aggressiveness, 0.0f), 1.0f);
+}
+
+float GetBC7Pruning()
+{
+    return g_aggressiveness.load(std::memory_order_relaxed);
+}
+
+void RecordBC7Pruning(const uint64_t blocks[kBC7TierCount])
+{
+    for (size_t t = 0; t < kBC7TierCount; ++t)
+    {
+        if (blocks[t])
+            g_blocks[t].fetch_add(blocks[t], std::memory_order_relaxed);
+    }
+}
+
+void GetBC7PruningStats(BC7PruningStats& stats)
+{
+    for (size_t t = 0; t < kBC7TierCount; ++t)
+        stats.blocks[t] = g_blocks[t].load();
+}
+
+void ResetBC7PruningStats()
+{
+    for (auto& b : g_blocks)
+        b = 0;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <windows.h>
+#include "DirectXTex.h"
+#include <cstddef>
+#include <cstdint>
+
+// -------------------------------------------------------------
+// Poda de la busqueda BC7 segun las estadisticas de cada bloque.
+//
+// Antes de codificar, cada bloque normal (no trivial) se mira:
+// varianza, error de ajustarlo a una recta (eje principal), rango de
+// alfa y colores distintos. Con eso se decide hasta donde buscar:
+//
+//   LINE          una recta basta (2 colores, bloque suave o casi
+//                 colineal): solo modo 6 (TEX_COMPRESS_BC7_QUICK)
+//   TWO_SUBSETS   sin los modos de 3 subconjuntos (0 y 2). Siempre
+//                 que el bloque tiene alfa: esos modos son opacos
+//   FULL          lo que pidan las flags
+//
+// 'aggressiveness' (0..1) escala los umbrales: 0 desactiva la poda
+// (salida identica), 1 es lo mas agresivo. La perdida de calidad se
+// mide con BenchmarkBC7PruningW.
+//
+// Con el codificador por carriles (BC7LaneEncoder.h) LINE deja solo el
+// modo 6 y TWO_SUBSETS no cambia nada: no tiene modos de 3 subconjuntos.
+// -------------------------------------------------------------
+enum BC7SearchTier
+{
+    BC7_TIER_FULL = 0,
+    BC7_TIER_TWO_SUBSETS = 1,
+    BC7_TIER_LINE = 2,
+};
+
+static const size_t kBC7TierCount = 3;
+
+struct BC7BlockStats
+{
+    float variance;         // suma de las varianzas RGBA por pixel
+    float lineError;        // error cuadratico medio por pixel respecto al eje principal
+    uint8_t alphaRange;     // max - min de alfa
+    uint8_t distinctColors; // RGBA distintos (1..16)
+};
+
+void ComputeBC7BlockStats(const uint32_t px[16], BC7BlockStats& stats);
+
+BC7SearchTier ClassifyBC7Block(const BC7BlockStats& stats, float aggressiveness);
+BC7SearchTier ClassifyBC7Block(const uint32_t px[16], float aggressiveness);
+
+// Flags de Compress para un nivel
+DirectX::TEX_COMPRESS_FLAGS GetBC7TierFlags(DirectX::TEX_COMPRESS_FLAGS flags, BC7SearchTier tier);
+
+// Para todas las codificaciones BC7 siguientes (0 = desactivada)
+void SetBC7Pruning(float aggressiveness);
+float GetBC7Pruning();
+
+// Se devuelve al llamador (tambien desde la DLL), solo tipos planos
+struct BC7PruningStats
+{
+    uint64_t blocks[kBC7TierCount];     // bloques normales por BC7SearchTier
+};
+
+void RecordBC7Pruning(const uint64_t blocks[kBC7TierCount]);
+void GetBC7PruningStats(BC7PruningStats& stats);
+void ResetBC7PruningStats();
@@ -0,0 +1,632 @@
+#include "BCDecoder.h"
+#include "TextureEncode.h"
+#include "Trace.h"
+#include "WorkStealingPool.h"
+#include <emmintrin.h>
+#include <immintrin.h>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    // Filas de bloques por banda en paralelo
+    const size_t kBandBlockRows = 16;
+
+    // =========================================================
+    // Tablas de BC7
+    // =========================================================
+
+    // Particiones de 2 subconjuntos: bit i = subconjunto del pixel i
+    const uint16_t kPartitionMask2[64] =
+    {
+        0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80,
+        0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+        0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE,
+        0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+        0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A,
+        0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+        0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C,
+        0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22,
+    };
+
+    // Particiones de 3 subconjuntos: bits 2i..2i+1 = subconjunto del pixel i
+    const uint32_t kPartition3[64] =
+    {
+        0xAA685050, 0x6A5A5040, 0x5A5A4200, 0x5450A0A8,
+        0xA5A50000, 0xA0A05050, 0x5555A0A0, 0x5A5A5050,
+        0xAA550000, 0xAA555500, 0xAAAA5500, 0x90909090,
+        0x94949494, 0xA4A4A4A4, 0xA9A59450, 0x2A0A4250,
+        0xA5945040, 0x0A425054, 0xA5A5A500, 0x55A0A0A0,
+        0xA8A85454, 0x6A6A4040, 0xA4A45000, 0x1A1A0500,
+        0x0050A4A4, 0xAAA59090, 0x14696914, 0x69691400,
+        0xA08585A0, 0xAA821414, 0x50A4A450, 0x6A5A0200,
+        0xA9A58000, 0x5090A0A8, 0xA8A09050, 0x24242424,
+        0x00AA5500, 0x24924924, 0x24499224, 0x50A50A50,
+        0x500AA550, 0xAAAA4444, 0x66660000, 0xA5A0A5A0,
+        0x50A050A0, 0x69286928, 0x44AAAA44, 0x66666600,
+        0xAA444444, 0x54A854A8, 0x95809580, 0x96969600,
+        0xA85454A8, 0x80959580, 0xAA141414, 0x96960000,
+        0xAAAA1414, 0xA05050A0, 0xA0A5A5A0, 0x96000000,
+        0x40804080, 0xA9A8A9A8, 0xAAAAAA44, 0x2A4A5254,
+    };
+
+    // Pixel ancla del subconjunto 1 con 2 subconjuntos
+    const uint8_t kAnchor2[64] =
+    {
+        15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+        15,  2,  8,  2,  2,  8,  8, 15,  2,  8,  2,  2,  8,  8,  2,  2,
+        15, 15,  6,  8,  2,  8, 15, 15,  2,  8,  2,  2,  2, 15, 15,  6,
+         6,  2,  6,  8, 15, 15,  2,  2, 15, 15, 15, 15, 15,  2,  2, 15,
+    };
+
+    // Pixeles ancla de los subconjuntos 1 y 2 con 3 subconjuntos
+    const uint8_t kAnchor3a[64] =
+    {
+         3,  3, 15, 15,  8,  3, 15, 15,  8,  8,  6,  6,  6,  5,  3,  3,
+         3,  3,  8, 15,  3,  3,  6, 10,  5,  8,  8,  6,  8,  5, 15, 15,
+         8, 15,  3,  5,  6, 10,  8, 15, 15,  3, 15,  5, 15, 15, 15, 15,
+         3, 15,  5,  5,  5,  8,  5, 10,  5, 10,  8, 13, 15, 12,  3,  3,
+    };
+
+    const uint8_t kAnchor3b[64] =
+    {
+        15,  8,  8,  3, 15, 15,  3,  8, 15, 15, 15, 15, 15, 15, 15,  8,
+        15,  8, 15,  3, 15,  8, 15,  8,  3, 15,  6, 10, 15, 15, 10,  8,
+        15,  3, 15, 10, 10,  8,  9, 10,  6, 15,  8, 15,  3,  6,  6,  8,
+        15,  3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,  3, 15, 15,  8,
+    };
+
+    const uint16_t kWeights2[4] = { 0, 21, 43, 64 };
+    const uint16_t kWeights3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+    const uint16_t kWeights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    inline const uint16_t* Weights(int indexBits)
+    {
+        return indexBits == 2 ? kWeights2 : (indexBits == 3 ? kWeights3 : kWeights4);
+    }
+
+    struct ModeInfo
+    {
+        int subsets;
+        int partitionBits;
+        int rotationBits;
+        int indexSelectionBits;
+        int colorBits;          // sin p-bit
+        int alphaBits;          // 0: alfa = 255
+        bool endpointPbits;     // un p-bit por extremo
+        bool sharedPbits;       // un p-bit por subconjunto
+        int indexBits;
+        int indexBits2;         // segundo juego de indices (modos 4 y 5)
+    };
+
+    const ModeInfo kModes[8] =
+    {
+        { 3, 4, 0, 0, 4, 0, true,  false, 3, 0 },
+        { 2, 6, 0, 0, 6, 0, false, true,  3, 0 },
+        { 3, 6, 0, 0, 5, 0, false, false, 2, 0 },
+        { 2, 6, 0, 0, 7, 0, true,  false, 2, 0 },
+        { 1, 0, 2, 1, 5, 6, false, false, 2, 3 },
+        { 1, 0, 2, 0, 7, 8, false, false, 2, 2 },
+        { 1, 0, 0, 0, 7, 7, true,  false, 4, 0 },
+        { 2, 6, 0, 0, 5, 5, true,  false, 2, 0 },
+    };
+
+    // Bits de un bloque de 128, del menos significativo al mas
+    class BitReader
+    {
+    public:
+        explicit BitReader(const uint8_t* block)
+        {
+            memcpy(&m_lo, block, 8);
+            memcpy(&m_hi, block + 8, 8);
+        }
+
+        // n <= 8
+        uint32_t Read(int n)
+        {
+            uint64_t v;
+            if (m_pos >= 64)
+                v = m_hi >> (m_pos - 64);
+            else if (m_pos + n > 64)
+                v = (m_lo >> m_pos) | (m_hi << (64 - m_pos));
+            else
+                v = m_lo >> m_pos;
+
+            m_pos += n;
+            return uint32_t(v) & ((1u << n) - 1);
+        }
+
+        int Position() const { return m_pos; }
+        void Skip(int n) { m_pos += n; }
+
+    private:
+        uint64_t m_lo;
+        uint64_t m_hi;
+        int m_pos = 0;
+    };
+
+    // Extremo de 'bits' bits (con el p-bit) a 8 bits repitiendo los altos
+    inline uint32_t Expand(uint32_t v, int bits)
+    {
+        v <<= (8 - bits);
+        return v | (v >> bits);
+    }
+
+    // Un bloque BC7 listo para mezclar: por pixel los dos extremos y el
+    // peso (0..64) de cada canal
+    struct BC7Block
+    {
+        alignas(32) uint32_t e0[16];
+        alignas(32) uint32_t e1[16];
+        alignas(32) uint16_t w[64];
+        int rotation;
+    };
+
+    // false si el modo es el reservado
+    bool ParseBC7(const uint8_t* block, BC7Block& b)
+    {
+        BitReader r(block);
+
+        int mode = 0;
+        while (mode < 8 && r.Read(1) == 0)
+            ++mode;
+        if (mode == 8)
+            return false;
+
+        const ModeInfo& m = kModes[mode];
+
+        uint32_t partition = r.Read(m.partitionBits);
+        b.rotation = int(r.Read(m.rotationBits));
+        uint32_t indexSelection = r.Read(m.indexSelectionBits);
+
+        // [subconjunto][extremo][canal]
+        uint32_t ep[3][2][4];
+        for (int c = 0; c < 3; ++c)
+            for (int s = 0; s < m.subsets; ++s)
+                for (int e = 0; e < 2; ++e)
+                    ep[s][e][c] = r.Read(m.colorBits);
+
+        for (int s = 0; s < m.subsets; ++s)
+            for (int e = 0; e < 2; ++e)
+                ep[s][e][3] = m.alphaBits ? r.Read(m.alphaBits) : 255;
+
+        int colorBits = m.colorBits;
+        int alphaBits = m.alphaBits;
+        if (m.endpointPbits || m.sharedPbits)
+        {
+            for (int s = 0; s < m.subsets; ++s)
+            {
+                uint32_t p0 = r.Read(1);
+                uint32_t p1 = m.sharedPbits ? p0 : r.Read(1);
+                for (int c = 0; c < 4; ++c)
+                {
+                    if (c == 3 && !m.alphaBits)
+                        continue;
+                    ep[s][0][c] = (ep[s][0][c] << 1) | p0;
+                    ep[s][1][c] = (ep[s][1][c] << 1) | p1;
+                }
+            }
+            ++colorBits;
+            if (alphaBits)
+                ++alphaBits;
+        }
+
+        uint32_t packed[3][2];
+        for (int s = 0; s < m.subsets; ++s)
+        {
+            for (int e = 0; e < 2; ++e)
+            {
+                uint32_t a = alphaBits ? Expand(ep[s][e][3], alphaBits) : 255;
+                packed[s][e] = Expand(ep[s][e][0], colorBits)
+                    | (Expand(ep[s][e][1], colorBits) << 8)
+                    | (Expand(ep[s][e][2], colorBits) << 16)
+                    | (a << 24);
+            }
+        }
+
+        int anchor1 = 0, anchor2 = 0;
+        if (m.subsets == 2)
+            anchor1 = kAnchor2[partition];
+        else if (m.subsets == 3)
+        {
+            anchor1 = kAnchor3a[partition];
+            anchor2 = kAnchor3b[partition];
+        }
+
+        // Indices principales (y los del canal separado en 4 y 5)
+        uint8_t index[16];
+        for (int i = 0; i < 16; ++i)
+        {
+            bool anchor = (i == 0) || (m.subsets > 1 && i == anchor1) || (m.subsets == 3 && i == anchor2);
+            index[i] = uint8_t(r.Read(anchor ? m.indexBits - 1 : m.indexBits));
+        }
+
+        uint8_t index2[16];
+        if (m.indexBits2)
+        {
+            for (int i = 0; i < 16; ++i)
+                index2[i] = uint8_t(r.Read(i == 0 ? m.indexBits2 - 1 : m.indexBits2));
+        }
+
+        const uint16_t* colorWeights = Weights(m.indexBits);
+        const uint16_t* alphaWeights = colorWeights;
+        const uint8_t* colorIndex = index;
+        const uint8_t* alphaIndex = index;
+
+        if (m.indexBits2)
+        {
+            alphaWeights = Weights(m.indexBits2);
+            alphaIndex = index2;
+
+            // Modo 4 con el bit de seleccion: 3 bits para el color
+            if (indexSelection)
+            {
+                std::swap(colorWeights, alphaWeights);
+                std::swap(colorIndex, alphaIndex);
+            }
+        }
+
+        for (int i = 0; i < 16; ++i)
+        {
+            int s = 0;
+            if (m.subsets == 2)
+                s = (kPartitionMask2[partition] >> i) & 1;
+            else if (m.subsets == 3)
+                s = (kPartition3[partition] >> (2 * i)) & 3;
+
+            b.e0[i] = packed[s][0];
+            b.e1[i] = packed[s][1];
+
+            uint16_t wc = colorWeights[colorIndex[i]];
+            b.w[i * 4 + 0] = wc;
+            b.w[i * 4 + 1] = wc;
+            b.w[i * 4 + 2] = wc;
+            b.w[i * 4 + 3] = alphaWeights[alphaIndex[i]];
+        }
+
+        return true;
+    }
+
+    // Rotacion de los modos 4 y 5: el alfa cambia con R, G o B
+    void Rotate(int rotation, uint32_t out[16])
+    {
+        if (rotation == 0)
+            return;
+
+        int shift = 8 * (rotation - 1);
+        for (int i = 0; i < 16; ++i)
+        {
+            uint32_t a = out[i] >> 24;
+            uint32_t c = (out[i] >> shift) & 0xFF;
+            out[i] = (out[i] & ~((0xFFu << shift) | 0xFF000000u)) | (a << shift) | (c << 24);
+        }
+    }
+
+    // =========================================================
+    // Mezcla de BC7: (e0 * (64 - w) + e1 * w + 32) >> 6
+    // =========================================================
+    void LerpBC7Scalar(const BC7Block& b, uint32_t out[16])
+    {
+        const uint8_t* e0 = reinterpret_cast<const uint8_t*>(b.e0);
+        const uint8_t* e1 = reinterpret_cast<const uint8_t*>(b.e1);
+        uint8_t* dst = reinterpret_cast<uint8_t*>(out);
+
+        for (int i = 0; i < 64; ++i)
+            dst[i] = uint8_t((e0[i] * (64 - b.w[i]) + e1[i] * b.w[i] + 32) >> 6);
+    }
+
+    // 4 pixeles por iteracion, 16 bits por canal (255 * 64 + 32 cabe)
+    void LerpBC7SSE2(const BC7Block& b, uint32_t out[16])
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i w64 = _mm_set1_epi16(64);
+        const __m128i half = _mm_set1_epi16(32);
+
+        for (int i = 0; i < 16; i += 4)
+        {
+            __m128i e0 = _mm_load_si128(reinterpret_cast<const __m128i*>(b.e0 + i));
+            __m128i e1 = _mm_load_si128(reinterpret_cast<const __m128i*>(b.e1 + i));
+            __m128i wLo = _mm_load_si128(reinterpret_cast<const __m128i*>(b.w + i * 4));
+            __m128i wHi = _mm_load_si128(reinterpret_cast<const __m128i*>(b.w + i * 4 + 8));
+
+            __m128i lo = _mm_add_epi16(
+                _mm_mullo_epi16(_mm_unpacklo_epi8(e0, zero), _mm_sub_epi16(w64, wLo)),
+                _mm_mullo_epi16(_mm_unpacklo_epi8(e1, zero), wLo));
+            __m128i hi = _mm_add_epi16(
+                _mm_mullo_epi16(_mm_unpackhi_epi8(e0, zero), _mm_sub_epi16(w64, wHi)),
+                _mm_mullo_epi16(_mm_unpackhi_epi8(e1, zero), wHi));
+
+            lo = _mm_srli_epi16(_mm_add_epi16(lo, half), 6);
+            hi = _mm_srli_epi16(_mm_add_epi16(hi, half), 6);
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(lo, hi));
+        }
+    }
+
+    // 8 pixeles por iteracion
+    void LerpBC7AVX2(const BC7Block& b, uint32_t out[16])
+    {
+        const __m256i w64 = _mm256_set1_epi16(64);
+        const __m256i half = _mm256_set1_epi16(32);
+
+        for (int i = 0; i < 16; i += 8)
+        {
+            __m256i e0a = _mm256_cvtepu8_epi16(_mm_load_si128(reinterpret_cast<const __m128i*>(b.e0 + i)));
+            __m256i e0b = _mm256_cvtepu8_epi16(_mm_load_si128(reinterpret_cast<const __m128i*>(b.e0 + i + 4)));
+            __m256i e1a = _mm256_cvtepu8_epi16(_mm_load_si128(reinterpret_cast<const __m128i*>(b.e1 + i)));
+            __m256i e1b = _mm256_cvtepu8_epi16(_mm_load_si128(reinterpret_cast<const __m128i*>(b.e1 + i + 4)));
+            __m256i wa = _mm256_load_si256(reinterpret_cast<const __m256i*>(b.w + i * 4));
+            __m256i wb = _mm256_load_si256(reinterpret_cast<const __m256i*>(b.w + i * 4 + 16));
+
+            __m256i a = _mm256_add_epi16(_mm256_mullo_epi16(e0a, _mm256_sub_epi16(w64, wa)), _mm256_mullo_epi16(e1a, wa));
+            __m256i c = _mm256_add_epi16(_mm256_mullo_epi16(e0b, _mm256_sub_epi16(w64, wb)), _mm256_mullo_epi16(e1b, wb));
+
+            a = _mm256_srli_epi16(_mm256_add_epi16(a, half), 6);
+            c = _mm256_srli_epi16(_mm256_add_epi16(c, half), 6);
+
+            // packus mezcla por mitades de 128: reordenar los 64 bits
+            __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, c), 0xD8);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), packed);
+        }
+    }
+
+    // =========================================================
+    // BC1-BC5
+    // =========================================================
+
+    // round(255 * num / (den * max)): lo que da DirectXTex interpolando
+    // en float y guardando a UNORM8
+    inline uint32_t ToUnorm8(uint32_t num, uint32_t den, uint32_t max)
+    {
+        return (510 * num + den * max) / (2 * den * max);
+    }
+
+    inline uint32_t PackColor(uint32_t r, uint32_t g, uint32_t b, uint32_t a)
+    {
+        return r | (g << 8) | (b << 16) | (a << 24);
+    }
+
+    // 'bc1': con c0 <= c1 modo de 3 colores + transparente. BC3 siempre 4.
+    void DecodeColorBlock(const uint8_t* block, bool bc1, uint32_t out[16])
+    {
+        uint32_t c0 = block[0] | (block[1] << 8);
+        uint32_t c1 = block[2] | (block[3] << 8);
+        uint32_t bits;
+        memcpy(&bits, block + 4, 4);
+
+        uint32_t r0 = c0 >> 11, g0 = (c0 >> 5) & 63, b0 = c0 & 31;
+        uint32_t r1 = c1 >> 11, g1 = (c1 >> 5) & 63, b1 = c1 & 31;
+
+        uint32_t palette[4];
+        palette[0] = PackColor(ToUnorm8(r0, 1, 31), ToUnorm8(g0, 1, 63), ToUnorm8(b0, 1, 31), 255);
+        palette[1] = PackColor(ToUnorm8(r1, 1, 31), ToUnorm8(g1, 1, 63), ToUnorm8(b1, 1, 31), 255);
+
+        if (bc1 && c0 <= c1)
+        {
+            palette[2] = PackColor(ToUnorm8(r0 + r1, 2, 31), ToUnorm8(g0 + g1, 2, 63), ToUnorm8(b0 + b1, 2, 31), 255);
+            palette[3] = 0;
+        }
+        else
+        {
+            palette[2] = PackColor(ToUnorm8(2 * r0 + r1, 3, 31), ToUnorm8(2 * g0 + g1, 3, 63), ToUnorm8(2 * b0 + b1, 3, 31), 255);
+            palette[3] = PackColor(ToUnorm8(r0 + 2 * r1, 3, 31), ToUnorm8(g0 + 2 * g1, 3, 63), ToUnorm8(b0 + 2 * b1, 3, 31), 255);
+        }
+
+        for (int i = 0; i < 16; ++i)
+            out[i] = palette[(bits >> (2 * i)) & 3];
+    }
+
+    // Bloque de alfa de BC3 / canal de BC4 y BC5
+    void DecodeAlphaBlock(const uint8_t* block, uint8_t out[16])
+    {
+        uint32_t a0 = block[0], a1 = block[1];
+
+        uint8_t palette[8];
+        palette[0] = uint8_t(a0);
+        palette[1] = uint8_t(a1);
+
+        // round(x / 7) y round(x / 5): nunca hay empate
+        if (a0 > a1)
+        {
+            for (uint32_t i = 1; i < 7; ++i)
+                palette[i + 1] = uint8_t((2 * ((7 - i) * a0 + i * a1) + 7) / 14);
+        }
+        else
+        {
+            for (uint32_t i = 1; i < 5; ++i)
+                palette[i + 1] = uint8_t((2 * ((5 - i) * a0 + i * a1) + 5) / 10);
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+
+        uint64_t bits = 0;
+        memcpy(&bits, block + 2, 6);
+
+        for (int i = 0; i < 16; ++i)
+            out[i] = palette[(bits >> (3 * i)) & 7];
+    }
+
+    size_t BlockBytes(DXGI_FORMAT format)
+    {
+        switch (format)
+        {
+        case DXGI_FORMAT_BC1_UNORM:
+        case DXGI_FORMAT_BC1_UNORM_SRGB:
+        case DXGI_FORMAT_BC4_UNORM:
+            return 8;
+        default:
+            return 16;
+        }
+    }
+
+    template <void (*Lerp)(const BC7Block&, uint32_t*)>
+    void DecodeBlocks(DXGI_FORMAT format, const uint8_t* blocks, size_t count, uint32_t (*out)[16])
+    {
+        switch (format)
+        {
+        case DXGI_FORMAT_BC1_UNORM:
+        case DXGI_FORMAT_BC1_UNORM_SRGB:
+            for (size_t i = 0; i < count; ++i)
+                DecodeColorBlock(blocks + i * 8, true, out[i]);
+            break;
+
+        case DXGI_FORMAT_BC3_UNORM:
+        case DXGI_FORMAT_BC3_UNORM_SRGB:
+            for (size_t i = 0; i < count; ++i)
+            {
+                uint8_t alpha[16];
+                DecodeAlphaBlock(blocks + i * 16, alpha);
+                DecodeColorBlock(blocks + i * 16 + 8, false, out[i]);
+                for (int p = 0; p < 16; ++p)
+                    out[i][p] = (out[i][p] & 0x00FFFFFF) | (uint32_t(alpha[p]) << 24);
+            }
+            break;
+
+        case DXGI_FORMAT_BC4_UNORM:
+            for (size_t i = 0; i < count; ++i)
+            {
+                uint8_t red[16];
+                DecodeAlphaBlock(blocks + i * 8, red);
+                for (int p = 0; p < 16; ++p)
+                    out[i][p] = red[p] | 0xFF000000;
+            }
+            break;
+
+        case DXGI_FORMAT_BC5_UNORM:
+            for (size_t i = 0; i < count; ++i)
+            {
+                uint8_t red[16], green[16];
+                DecodeAlphaBlock(blocks + i * 16, red);
+                DecodeAlphaBlock(blocks + i * 16 + 8, green);
+                for (int p = 0; p < 16; ++p)
+                    out[i][p] = red[p] | (uint32_t(green[p]) << 8) | 0xFF000000;
+            }
+            break;
+
+        default:    // BC7
+            for (size_t i = 0; i < count; ++i)
+            {
+                BC7Block b;
+                if (!ParseBC7(blocks + i * 16, b))
+                {
+                    memset(out[i], 0, sizeof(out[i]));
+                    continue;
+                }
+
+                Lerp(b, out[i]);
+                Rotate(b.rotation, out[i]);
+            }
+            break;
+        }
+    }
+
+    const BCDecodeKernels kScalarKernels = { KernelLevel::Scalar, DecodeBlocks<LerpBC7Scalar> };
+    const BCDecodeKernels kSSE2Kernels = { KernelLevel::SSE2, DecodeBlocks<LerpBC7SSE2> };
+    const BCDecodeKernels kAVX2Kernels = { KernelLevel::AVX2, DecodeBlocks<LerpBC7AVX2> };
+
+    // Filas de bloques [by0, by1) de 'bc' a sus pixeles de 'rgba'
+    void DecodeBlockRows(const Image& bc, const Image& rgba, size_t by0, size_t by1, const BCDecodeKernels& k)
+    {
+        size_t blocksW = (bc.width + 3) / 4;
+        std::vector<uint32_t> row(blocksW * 16);
+        auto blocks = reinterpret_cast<uint32_t (*)[16]>(row.data());
+
+        for (size_t by = by0; by < by1; ++by)
+        {
+            k.decode(bc.format, bc.pixels + by * bc.rowPitch, blocksW, blocks);
+
+            size_t rows = std::min<size_t>(4, rgba.height - by * 4);
+            for (size_t py = 0; py < rows; ++py)
+            {
+                uint8_t* dst = rgba.pixels + (by * 4 + py) * rgba.rowPitch;
+                for (size_t bx = 0; bx < blocksW; ++bx)
+                {
+                    size_t cols = std::min<size_t>(4, rgba.width - bx * 4);
+                    memcpy(dst + bx * 16, blocks[bx] + py * 4, cols * 4);
+                }
+            }
+        }
+    }
+}
+
+const BCDecodeKernels* GetBCDecodeKernels(KernelLevel level)
+{
+    if (level > DetectKernelLevel())
+        return nullptr;
+
+    switch (level)
+    {
+    case KernelLevel::AVX2: return &kAVX2Kernels;
+    case KernelLevel::SSE2: return &kSSE2Kernels;
+    default:                return &kScalarKernels;
+    }
+}
+
+const BCDecodeKernels& GetBCDecodeKernels()
+{
+    return *GetBCDecodeKernels(DetectKernelLevel());
+}
+
+bool IsBCDecodeFormat(DXGI_FORMAT format)
+{
+    switch (format)
+    {
+    case DXGI_FORMAT_BC1_UNORM:
+    case DXGI_FORMAT_BC1_UNORM_SRGB:
+    case DXGI_FORMAT_BC3_UNORM:
+    case DXGI_FORMAT_BC3_UNORM_SRGB:
+    case DXGI_FORMAT_BC4_UNORM:
+    case DXGI_FORMAT_BC5_UNORM:
+    case DXGI_FORMAT_BC7_UNORM:
+    case DXGI_FORMAT_BC7_UNORM_SRGB:
+        return true;
+    default:
+        return false;
+    }
+}
+
+HRESULT DecodeBC(const Image& bc, const Image& rgba, bool parallel, const BCDecodeKernels* kernels)
+{
+    if (!bc.pixels || !rgba.pixels || bc.width != rgba.width || bc.height != rgba.height
+        || (rgba.format != DXGI_FORMAT_R8G8B8A8_UNORM && rgba.format != DXGI_FORMAT_R8G8B8A8_UNORM_SRGB))
+        return E_INVALIDARG;
+
+    if (!IsBCDecodeFormat(bc.format))
+        return HRESULT_E_NOT_SUPPORTED;
+
+    if (bc.rowPitch < ((bc.width + 3) / 4) * BlockBytes(bc.format) || rgba.rowPitch < rgba.width * 4)
+        return E_INVALIDARG;
+
+    TraceSpan span("DecodeBC");
+
+    const BCDecodeKernels& k = kernels ? *kernels : GetBCDecodeKernels();
+    size_t blocksH = (bc.height + 3) / 4;
+    size_t bandCount = (blocksH + kBandBlockRows - 1) / kBandBlockRows;
+
+    TileEncodeOptions options = GetDefaultTileEncodeOptions();
+    if (!parallel || bandCount <= 1 || ResolveTileThreads(options) <= 1)
+    {
+        DecodeBlockRows(bc, rgba, 0, blocksH, k);
+        return S_OK;
+    }
+
+    WorkStealingPool* pool = GetTileEncodePool(options);
+    WorkStealingPool::TaskGroup group;
+    TraceContext traceContext = Trace::GetContext();
+
+    for (size_t i = 0; i < bandCount; ++i)
+    {
+        pool->Submit([&, i]()
+            {
+                TraceContextScope traceScope(traceContext);
+                TraceSpan bandSpan("DecodeBCBand");
+                DecodeBlockRows(bc, rgba, i * kBandBlockRows, std::min(blocksH, (i + 1) * kBandBlockRows), k);
+            }, &group);
+    }
+
+    pool->Wait(&group);
+    return S_OK;
+}
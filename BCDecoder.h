@@ -0,0 +1,72 @@
+#pragma once
+
+#include <windows.h>
+#include "DirectXTex.h"
+#include "ImageKernels.h"
+#include <cstddef>
+#include <cstdint>
+
+#ifndef HRESULT_E_NOT_SUPPORTED
+#define HRESULT_E_NOT_SUPPORTED static_cast<HRESULT>(0x80070032L)
+#endif
+
+// -------------------------------------------------------------
+// Decodificador BC1/BC3/BC4/BC5/BC7 (UNORM y SRGB) a RGBA8, para
+// verificar y previsualizar la salida sin pasar por Decompress (que
+// decodifica a float y convierte).
+//
+// BC7: los 8 modos con la interpolacion entera del formato; la mezcla
+// de los 16 pixeles de cada bloque va en SSE2/AVX2 (mismos bytes que
+// DirectXTex). BC1-BC5 son tablas de 4/8 entradas con las formulas
+// float de DirectXTex hechas en enteros; solo el color intermedio de
+// BC1 en modo 3 colores puede diferir en 1 (empate al redondear).
+//
+// BC4 sale como (R, 0, 0, 255) y BC5 como (R, G, 0, 255), igual que
+// Decompress a R8G8B8A8. Un bloque BC7 con modo reservado sale a 0.
+// -------------------------------------------------------------
+
+struct BCDecodeKernels
+{
+    KernelLevel level;
+
+    // 'count' bloques seguidos de 'format' -> 16 pixeles RGBA8 por
+    // bloque (fila a fila)
+    void (*decode)(DXGI_FORMAT format, const uint8_t* blocks, size_t count, uint32_t (*out)[16]);
+};
+
+// nullptr si la CPU no soporta el nivel
+const BCDecodeKernels* GetBCDecodeKernels(KernelLevel level);
+const BCDecodeKernels& GetBCDecodeKernels();
+
+bool IsBCDecodeFormat(DXGI_FORMAT format);
+
+// 'bc' entero a 'rgba' (R8G8B8A8_UNORM o _SRGB, mismo tamano, ya
+// reservado: puede ser un buffer del llamador con cualquier rowPitch).
+// Con 'parallel' reparte bandas de filas de bloques en el pool de
+// CompressTiled; si no, todo en el hilo que llama. 'kernels' fuerza
+// un nivel; nullptr = el de la CPU.
+// Formatos que no estan en IsBCDecodeFormat: HRESULT_E_NOT_SUPPORTED.
+HRESULT DecodeBC(const DirectX::Image& bc, const DirectX::Image& rgba, bool parallel = true,
+    const BCDecodeKernels* kernels = nullptr);
+
+// -------------------------------------------------------------
+// Verificacion de un arbol de salida (VerifyDDSDirectoryW)
+//
+// Se devuelve al llamador (tambien desde la DLL), solo tipos planos
+// -------------------------------------------------------------
+struct VerifyDDSResult
+{
+    HRESULT  hr;                // S_OK o el error de ese archivo
+    int32_t  format;            // DXGI_FORMAT del DDS
+    uint32_t width;
+    uint32_t height;
+    double   psnr;              // mip 0 contra el PNG de origen
+    double   ssim;
+    double   decodeMs;          // solo la decodificacion del DDS
+    wchar_t  source[MAX_PATH];  // ruta relativa del PNG
+};
+
+// Cada *.png de srcRoot contra el .dds con la misma ruta relativa bajo
+// ddsRoot. results == nullptr: solo cuenta los archivos.
+extern "C" HRESULT __stdcall VerifyDDSDirectoryW(const wchar_t* srcRoot, const wchar_t* ddsRoot, unsigned workers,
+    double minPsnr, const wchar_t* reportPath, VerifyDDSResult* results, unsigned capacity, unsigned* fileCount);
@@ -0,0 +1,910 @@
+#include "BCnLaneEncoder.h"
+#include "LaneMath.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    using namespace LaneMath;
+
+    // Pesos del error de color sin TEX_COMPRESS_UNIFORM (los de DirectXTex)
+    const float kLuminanceWeights[3] = { 0.2125f / 0.7154f, 1.0f, 0.0721f / 0.7154f };
+
+    const float kBig = 3.4e38f;
+
+    inline size_t BlockBytes(DXGI_FORMAT format)
+    {
+        return (format == DXGI_FORMAT_BC3_UNORM) ? 16 : 8;
+    }
+
+    // Resultado de un bloque para empaquetar (escalar)
+    struct ColorResult
+    {
+        int code[2][3];     // 5:6:5
+        int idx[16];        // orden interno (ver QuantizeColor)
+        bool punch;         // BC1 de 3 colores + transparente
+    };
+
+    struct AlphaResult
+    {
+        int e0, e1;
+        int idx[16];        // orden interno (ver AlphaPalette)
+        bool six;           // modo de 6 valores + 0/255
+    };
+
+    void PackColor(const ColorResult& r, uint8_t* out)
+    {
+        uint32_t c0 = uint32_t((r.code[0][0] << 11) | (r.code[0][1] << 5) | r.code[0][2]);
+        uint32_t c1 = uint32_t((r.code[1][0] << 11) | (r.code[1][1] << 5) | r.code[1][2]);
+
+        // Orden interno -> indice BC1
+        static const int kMap4[4] = { 0, 2, 3, 1 };
+        static const int kMap3[4] = { 0, 2, 1, 3 };
+
+        int idx[16];
+        for (int i = 0; i < 16; ++i)
+            idx[i] = r.punch ? kMap3[r.idx[i]] : kMap4[r.idx[i]];
+
+        if (!r.punch)
+        {
+            // 4 colores necesita c0 > c1; iguales = todo el bloque c0
+            if (c0 == c1)
+            {
+                for (int i = 0; i < 16; ++i)
+                    idx[i] = 0;
+            }
+            else if (c0 < c1)
+            {
+                std::swap(c0, c1);
+                for (int i = 0; i < 16; ++i)
+                    idx[i] ^= 1;
+            }
+        }
+        else if (c0 > c1)
+        {
+            // 3 colores necesita c0 <= c1 (el 2 es el medio, el 3 transparente)
+            std::swap(c0, c1);
+            for (int i = 0; i < 16; ++i)
+            {
+                if (idx[i] < 2)
+                    idx[i] ^= 1;
+            }
+        }
+
+        uint32_t bits = 0;
+        for (int i = 0; i < 16; ++i)
+            bits |= uint32_t(idx[i]) << (2 * i);
+
+        out[0] = uint8_t(c0);
+        out[1] = uint8_t(c0 >> 8);
+        out[2] = uint8_t(c1);
+        out[3] = uint8_t(c1 >> 8);
+        memcpy(out + 4, &bits, 4);
+    }
+
+    void PackAlpha(const AlphaResult& r, uint8_t* out)
+    {
+        int idx[16];
+        int a0 = r.e0, a1 = r.e1;
+
+        for (int i = 0; i < 16; ++i)
+        {
+            int k = r.idx[i];
+            if (r.six)
+                idx[i] = (k == 0) ? 0 : (k == 5 ? 1 : (k < 5 ? k + 1 : k));
+            else
+                idx[i] = (k == 0) ? 0 : (k == 7 ? 1 : k + 1);
+        }
+
+        // 8 valores necesita a0 > a1; iguales = todo el bloque a0
+        if (!r.six && a0 == a1)
+        {
+            for (int i = 0; i < 16; ++i)
+                idx[i] = 0;
+        }
+
+        uint64_t bits = 0;
+        for (int i = 0; i < 16; ++i)
+            bits |= uint64_t(idx[i]) << (3 * i);
+
+        out[0] = uint8_t(a0);
+        out[1] = uint8_t(a1);
+        for (int b = 0; b < 6; ++b)
+            out[2 + b] = uint8_t(bits >> (8 * b));
+    }
+
+    // =========================================================
+    // Codificador de un lote (un bloque por carril)
+    // =========================================================
+    template <class L>
+    class LaneEncoder
+    {
+        using V = typename L::V;
+        using M = typename L::M;
+        static const size_t N = L::N;
+
+        struct ColorFit
+        {
+            V err;
+            V code[2][3];
+            V pal[4][3];
+            V idx[16];
+        };
+
+        struct AlphaFit
+        {
+            V err;
+            V e0, e1;
+            V six;          // 1 = modo de 6 valores
+            V idx[16];
+        };
+
+    public:
+        LaneEncoder(const uint32_t (*blocks)[16], const BCnLaneParams& params)
+            : m_params(params)
+        {
+            for (size_t l = 0; l < N; ++l)
+            {
+                for (int i = 0; i < 16; ++i)
+                {
+                    uint32_t p = blocks[l][i];
+                    for (int c = 0; c < 4; ++c)
+                        m_scalar[i][c][l] = float((p >> (8 * c)) & 0xFF);
+                }
+            }
+
+            for (int i = 0; i < 16; ++i)
+                for (int c = 0; c < 4; ++c)
+                    m_px[i][c] = L::Load(m_scalar[i][c]);
+
+            for (int c = 0; c < 3; ++c)
+                m_weight[c] = L::Set(params.uniform ? 1.0f : kLuminanceWeights[c]);
+        }
+
+        void Encode(DXGI_FORMAT format, uint8_t* out)
+        {
+            size_t stride = BlockBytes(format);
+
+            if (format == DXGI_FORMAT_BC4_UNORM)
+            {
+                EncodeAlpha(0, out, stride);
+                return;
+            }
+
+            if (format == DXGI_FORMAT_BC3_UNORM)
+            {
+                EncodeAlpha(3, out, stride);
+                EncodeColor(false, out + 8, stride);
+                return;
+            }
+
+            EncodeColor(true, out, stride);
+        }
+
+    private:
+        // ---------------------------------------------------------
+        // Color
+        // ---------------------------------------------------------
+
+        // Eje principal RGB (power iteration desde la columna de mayor diagonal)
+        static void PrincipalAxis(const V cov[3][3], V axis[3])
+        {
+            V dmax = cov[0][0];
+            for (int c = 0; c < 3; ++c)
+                axis[c] = cov[c][0];
+
+            for (int d = 1; d < 3; ++d)
+            {
+                M gt = cov[d][d] > dmax;
+                dmax = Select(gt, cov[d][d], dmax);
+                for (int c = 0; c < 3; ++c)
+                    axis[c] = Select(gt, cov[c][d], axis[c]);
+            }
+
+            for (int it = 0; it < 4; ++it)
+            {
+                V next[3];
+                V scale = L::Set(0.0f);
+                for (int c = 0; c < 3; ++c)
+                {
+                    next[c] = (cov[c][0] * axis[0] + cov[c][1] * axis[1]) + cov[c][2] * axis[2];
+                    scale = Max(scale, Max(next[c], L::Set(0.0f) - next[c]));
+                }
+
+                V inv = L::Set(1.0f) / Max(scale, L::Set(1e-20f));
+                for (int c = 0; c < 3; ++c)
+                    axis[c] = next[c] * inv;
+            }
+
+            V len = Sqrt((axis[0] * axis[0] + axis[1] * axis[1]) + axis[2] * axis[2]);
+            V inv = L::Set(1.0f) / Max(len, L::Set(1e-20f));
+            for (int c = 0; c < 3; ++c)
+                axis[c] = axis[c] * inv;
+        }
+
+        static V Clamp255(V x)
+        {
+            return Min(Max(x, L::Set(0.0f)), L::Set(255.0f));
+        }
+
+        // Extremos (0..255) -> 5:6:5 y paleta en orden interno:
+        // 4 colores: e0, 2/3 e0 + 1/3 e1, 1/3 e0 + 2/3 e1, e1
+        // 3 colores: e0, medio, e1, (transparente)
+        void QuantizeColor(const V e[2][3], M punch, ColorFit& fit) const
+        {
+            static const float kMax[3] = { 31.0f, 63.0f, 31.0f };
+            static const float kShift[3] = { 8.0f, 4.0f, 8.0f };
+            static const float kDown[3] = { 1.0f / 4.0f, 1.0f / 16.0f, 1.0f / 4.0f };
+
+            V expanded[2][3];
+            for (int j = 0; j < 2; ++j)
+            {
+                for (int c = 0; c < 3; ++c)
+                {
+                    V code = Min(Trunc(e[j][c] * L::Set(kMax[c] / 255.0f) + L::Set(0.5f)), L::Set(kMax[c]));
+                    fit.code[j][c] = code;
+                    expanded[j][c] = code * L::Set(kShift[c]) + Trunc(code * L::Set(kDown[c]));
+                }
+            }
+
+            for (int c = 0; c < 3; ++c)
+            {
+                V e0 = expanded[0][c];
+                V e1 = expanded[1][c];
+                V third1 = (e0 * L::Set(2.0f) + e1) / L::Set(3.0f);
+                V third2 = (e0 + e1 * L::Set(2.0f)) / L::Set(3.0f);
+                V half = (e0 + e1) * L::Set(0.5f);
+
+                fit.pal[0][c] = e0;
+                fit.pal[1][c] = Select(punch, half, third1);
+                fit.pal[2][c] = Select(punch, e1, third2);
+                fit.pal[3][c] = Select(punch, L::Set(kBig), e1);
+            }
+        }
+
+        V ColorDistance(const V x[3], const V pal[3]) const
+        {
+            V d0 = x[0] - pal[0];
+            V d1 = x[1] - pal[1];
+            V d2 = x[2] - pal[2];
+            return (d0 * d0 * m_weight[0] + d1 * d1 * m_weight[1]) + d2 * d2 * m_weight[2];
+        }
+
+        // Indice mas cercano de cada pixel y error total (pixeles con W = 0 no cuentan)
+        void EvaluateColor(const V W[16], ColorFit& fit) const
+        {
+            V total = L::Set(0.0f);
+            for (int i = 0; i < 16; ++i)
+            {
+                V best = L::Set(kBig);
+                V bestIdx = L::Set(0.0f);
+                for (int k = 0; k < 4; ++k)
+                {
+                    V d = ColorDistance(m_px[i], fit.pal[k]);
+                    M lt = d < best;
+                    best = Select(lt, d, best);
+                    bestIdx = Select(lt, L::Set(float(k)), bestIdx);
+                }
+
+                fit.idx[i] = bestIdx;
+                total = total + best * W[i];
+            }
+            fit.err = total;
+        }
+
+        static void SelectColor(M m, const ColorFit& a, ColorFit& dst)
+        {
+            dst.err = Select(m, a.err, dst.err);
+            for (int j = 0; j < 2; ++j)
+                for (int c = 0; c < 3; ++c)
+                    dst.code[j][c] = Select(m, a.code[j][c], dst.code[j][c]);
+            for (int k = 0; k < 4; ++k)
+                for (int c = 0; c < 3; ++c)
+                    dst.pal[k][c] = Select(m, a.pal[k][c], dst.pal[k][c]);
+            for (int i = 0; i < 16; ++i)
+                dst.idx[i] = Select(m, a.idx[i], dst.idx[i]);
+        }
+
+        // Todos los repartos ordenados en 4 grupos sobre el eje, con los
+        // extremos por minimos cuadrados (como squish). 'order' es la
+        // posicion de cada pixel ordenado por su proyeccion, por carril.
+        void ClusterFit(const int (*order)[N], V e[2][3]) const
+        {
+            alignas(32) float sorted[16][3][N];
+            for (size_t l = 0; l < N; ++l)
+                for (int m = 0; m < 16; ++m)
+                    for (int c = 0; c < 3; ++c)
+                        sorted[m][c][l] = m_scalar[order[m][l]][c][l];
+
+            // Sumas acumuladas de los pixeles ordenados
+            V prefix[17][3];
+            for (int c = 0; c < 3; ++c)
+                prefix[0][c] = L::Set(0.0f);
+            for (int m = 0; m < 16; ++m)
+                for (int c = 0; c < 3; ++c)
+                    prefix[m + 1][c] = prefix[m][c] + L::Load(sorted[m][c]);
+
+            V best = L::Set(kBig);
+            const float third = 1.0f / 3.0f;
+            const float twoThirds = 2.0f / 3.0f;
+
+            for (int i = 0; i <= 16; ++i)
+            {
+                for (int j = i; j <= 16; ++j)
+                {
+                    for (int k = j; k <= 16; ++k)
+                    {
+                        // Los pesos solo dependen del reparto: iguales en todos los carriles
+                        float n0 = float(i), n1 = float(j - i), n2 = float(k - j), n3 = float(16 - k);
+                        float aa = n0 + (4.0f / 9.0f) * n1 + (1.0f / 9.0f) * n2;
+                        float bb = n3 + (1.0f / 9.0f) * n1 + (4.0f / 9.0f) * n2;
+                        float ab = (2.0f / 9.0f) * (n1 + n2);
+                        float det = aa * bb - ab * ab;
+                        if (det < 1e-6f)
+                            continue;
+
+                        V invDet = L::Set(1.0f / det);
+                        V vaa = L::Set(aa), vbb = L::Set(bb), vab = L::Set(ab);
+
+                        V err = L::Set(0.0f);
+                        V e0[3], e1[3];
+                        for (int c = 0; c < 3; ++c)
+                        {
+                            V s1 = prefix[j][c] - prefix[i][c];
+                            V s2 = prefix[k][c] - prefix[j][c];
+                            V ax = prefix[i][c] + s1 * L::Set(twoThirds) + s2 * L::Set(third);
+                            V bx = (prefix[16][c] - prefix[k][c]) + s1 * L::Set(third) + s2 * L::Set(twoThirds);
+
+                            e0[c] = (vbb * ax - vab * bx) * invDet;
+                            e1[c] = (vaa * bx - vab * ax) * invDet;
+
+                            // En el optimo, error = sum(x^2) - (e0.ax + e1.bx)
+                            err = err - (e0[c] * ax + e1[c] * bx) * m_weight[c];
+                        }
+
+                        M lt = err < best;
+                        best = Select(lt, err, best);
+                        for (int c = 0; c < 3; ++c)
+                        {
+                            e[0][c] = Select(lt, e0[c], e[0][c]);
+                            e[1][c] = Select(lt, e1[c], e[1][c]);
+                        }
+                    }
+                }
+            }
+
+            for (int c = 0; c < 3; ++c)
+            {
+                e[0][c] = Clamp255(e[0][c]);
+                e[1][c] = Clamp255(e[1][c]);
+            }
+        }
+
+        void EncodeColor(bool bc1, uint8_t* out, size_t stride)
+        {
+            V zero = L::Set(0.0f);
+            V one = L::Set(1.0f);
+
+            // BC1 con transparencia: 3 colores, los pixeles con alfa < 128
+            // van al indice transparente y no cuentan para el ajuste
+            M transparent[16];
+            M punch = zero > one;
+            V W[16];
+            for (int i = 0; i < 16; ++i)
+            {
+                transparent[i] = bc1 ? (L::Set(127.5f) > m_px[i][3]) : (zero > one);
+                punch = punch | transparent[i];
+                W[i] = Select(transparent[i], zero, one);
+            }
+
+            // Range fit
+            V count = zero;
+            V mean[3] = { zero, zero, zero };
+            for (int i = 0; i < 16; ++i)
+            {
+                count = count + W[i];
+                for (int c = 0; c < 3; ++c)
+                    mean[c] = mean[c] + m_px[i][c] * W[i];
+            }
+
+            V invCount = one / Max(count, one);
+            for (int c = 0; c < 3; ++c)
+                mean[c] = mean[c] * invCount;
+
+            V cov[3][3];
+            for (int c = 0; c < 3; ++c)
+                for (int d = 0; d < 3; ++d)
+                    cov[c][d] = zero;
+
+            for (int i = 0; i < 16; ++i)
+            {
+                V diff[3];
+                for (int c = 0; c < 3; ++c)
+                    diff[c] = m_px[i][c] - mean[c];
+                for (int c = 0; c < 3; ++c)
+                    for (int d = c; d < 3; ++d)
+                        cov[c][d] = cov[c][d] + diff[c] * diff[d] * W[i];
+            }
+            for (int c = 0; c < 3; ++c)
+                for (int d = 0; d < c; ++d)
+                    cov[c][d] = cov[d][c];
+
+            V axis[3];
+            PrincipalAxis(cov, axis);
+
+            alignas(32) float proj[16][N];
+            V tmin = L::Set(kBig);
+            V tmax = L::Set(-kBig);
+            for (int i = 0; i < 16; ++i)
+            {
+                V t = ((m_px[i][0] - mean[0]) * axis[0] + (m_px[i][1] - mean[1]) * axis[1]) + (m_px[i][2] - mean[2]) * axis[2];
+                L::Store(proj[i], t);
+
+                M in = W[i] > zero;
+                tmin = Select(in, Min(tmin, t), tmin);
+                tmax = Select(in, Max(tmax, t), tmax);
+            }
+
+            M empty = L::Set(0.5f) > count;
+            tmin = Select(empty, zero, tmin);
+            tmax = Select(empty, zero, tmax);
+
+            V e[2][3];
+            for (int c = 0; c < 3; ++c)
+            {
+                e[0][c] = Clamp255(mean[c] + axis[c] * tmin);
+                e[1][c] = Clamp255(mean[c] + axis[c] * tmax);
+            }
+
+            ColorFit fit;
+            QuantizeColor(e, punch, fit);
+            EvaluateColor(W, fit);
+
+            // Cluster fit (los carriles de 3 colores se quedan con el range fit)
+            if (m_params.clusterFit)
+                TryClusterFit(proj, W, punch, fit);
+
+            if (m_params.ditherColor)
+                DitherColor(transparent, punch, fit);
+
+            // Los transparentes siempre al indice 3
+            for (int i = 0; i < 16; ++i)
+                fit.idx[i] = Select(transparent[i], L::Set(3.0f), fit.idx[i]);
+
+            alignas(32) float code[2][3][N];
+            alignas(32) float idx[16][N];
+            alignas(32) float punchLane[N];
+            for (int j = 0; j < 2; ++j)
+                for (int c = 0; c < 3; ++c)
+                    L::Store(code[j][c], fit.code[j][c]);
+            for (int i = 0; i < 16; ++i)
+                L::Store(idx[i], fit.idx[i]);
+            L::Store(punchLane, Select(punch, one, zero));
+
+            for (size_t l = 0; l < N; ++l)
+            {
+                ColorResult r;
+                for (int j = 0; j < 2; ++j)
+                    for (int c = 0; c < 3; ++c)
+                        r.code[j][c] = int(code[j][c][l]);
+                for (int i = 0; i < 16; ++i)
+                    r.idx[i] = int(idx[i][l]);
+                r.punch = punchLane[l] != 0.0f;
+
+                PackColor(r, out + l * stride);
+            }
+        }
+
+        void TryClusterFit(const float (*proj)[N], const V W[16], M punch, ColorFit& fit) const
+        {
+            // Orden de los pixeles por proyeccion, en cada carril
+            int order[16][N];
+            for (size_t l = 0; l < N; ++l)
+            {
+                int perm[16];
+                for (int i = 0; i < 16; ++i)
+                    perm[i] = i;
+
+                std::stable_sort(perm, perm + 16, [&](int a, int b) { return proj[a][l] < proj[b][l]; });
+
+                for (int m = 0; m < 16; ++m)
+                    order[m][l] = perm[m];
+            }
+
+            V e[2][3];
+            for (int j = 0; j < 2; ++j)
+                for (int c = 0; c < 3; ++c)
+                    e[j][c] = L::Set(0.0f);
+
+            ClusterFit(order, e);
+
+            ColorFit candidate;
+            QuantizeColor(e, punch, candidate);
+            EvaluateColor(W, candidate);
+
+            M fourColors = Select(punch, L::Set(0.0f), L::Set(1.0f)) > L::Set(0.5f);
+            SelectColor(fourColors & (candidate.err < fit.err), candidate, fit);
+        }
+
+        // Indices con el error de cada pixel repartido a los vecinos del
+        // bloque (Floyd-Steinberg)
+        void DitherColor(const M transparent[16], M punch, ColorFit& fit) const
+        {
+            V zero = L::Set(0.0f);
+            V carry[16][3];
+            for (int i = 0; i < 16; ++i)
+                for (int c = 0; c < 3; ++c)
+                    carry[i][c] = zero;
+
+            for (int y = 0; y < 4; ++y)
+            {
+                for (int x = 0; x < 4; ++x)
+                {
+                    int i = y * 4 + x;
+
+                    V target[3];
+                    for (int c = 0; c < 3; ++c)
+                        target[c] = Clamp255(m_px[i][c] + carry[i][c]);
+
+                    V best = L::Set(kBig);
+                    V bestIdx = zero;
+                    V chosen[3] = { zero, zero, zero };
+                    for (int k = 0; k < 4; ++k)
+                    {
+                        V d = ColorDistance(target, fit.pal[k]);
+                        if (k == 3)
+                            d = Select(punch, L::Set(kBig), d);
+
+                        M lt = d < best;
+                        best = Select(lt, d, best);
+                        bestIdx = Select(lt, L::Set(float(k)), bestIdx);
+                        for (int c = 0; c < 3; ++c)
+                            chosen[c] = Select(lt, fit.pal[k][c], chosen[c]);
+                    }
+
+                    fit.idx[i] = bestIdx;
+
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        V diff = Select(transparent[i], zero, target[c] - chosen[c]);
+                        Diffuse(carry, x, y, c, diff);
+                    }
+                }
+            }
+        }
+
+        template <size_t C>
+        static void Diffuse(V (*carry)[C], int x, int y, int c, V diff)
+        {
+            if (x < 3)
+                carry[y * 4 + x + 1][c] = carry[y * 4 + x + 1][c] + diff * L::Set(7.0f / 16.0f);
+            if (y < 3)
+            {
+                if (x > 0)
+                    carry[y * 4 + 4 + x - 1][c] = carry[y * 4 + 4 + x - 1][c] + diff * L::Set(3.0f / 16.0f);
+                carry[y * 4 + 4 + x][c] = carry[y * 4 + 4 + x][c] + diff * L::Set(5.0f / 16.0f);
+                if (x < 3)
+                    carry[y * 4 + 4 + x + 1][c] = carry[y * 4 + 4 + x + 1][c] + diff * L::Set(1.0f / 16.0f);
+            }
+        }
+
+        // ---------------------------------------------------------
+        // Alfa de BC3 / canal de BC4
+        // ---------------------------------------------------------
+
+        // Paleta en orden interno:
+        // 8 valores: k = 0..7 -> ((7 - k) e0 + k e1) / 7 (e0 > e1)
+        // 6 valores: k = 0..5 -> ((5 - k) e0 + k e1) / 5 (e0 <= e1), 6 -> 0, 7 -> 255
+        static void AlphaPalette(V e0, V e1, M six, V pal[8])
+        {
+            for (int k = 0; k < 8; ++k)
+            {
+                V eight = (e0 * L::Set(float(7 - k)) + e1 * L::Set(float(k))) / L::Set(7.0f);
+                V interp6 = (k < 6)
+                    ? (e0 * L::Set(float(5 - k)) + e1 * L::Set(float(k))) / L::Set(5.0f)
+                    : L::Set(k == 6 ? 0.0f : 255.0f);
+                pal[k] = Select(six, interp6, eight);
+            }
+        }
+
+        void EvaluateAlpha(int ch, AlphaFit& fit) const
+        {
+            V pal[8];
+            AlphaPalette(fit.e0, fit.e1, fit.six > L::Set(0.5f), pal);
+
+            V total = L::Set(0.0f);
+            for (int i = 0; i < 16; ++i)
+            {
+                V best = L::Set(kBig);
+                V bestIdx = L::Set(0.0f);
+                for (int k = 0; k < 8; ++k)
+                {
+                    V d = m_px[i][ch] - pal[k];
+                    d = d * d;
+                    M lt = d < best;
+                    best = Select(lt, d, best);
+                    bestIdx = Select(lt, L::Set(float(k)), bestIdx);
+                }
+
+                fit.idx[i] = bestIdx;
+                total = total + best;
+            }
+            fit.err = total;
+        }
+
+        static void SelectAlpha(M m, const AlphaFit& a, AlphaFit& dst)
+        {
+            dst.err = Select(m, a.err, dst.err);
+            dst.e0 = Select(m, a.e0, dst.e0);
+            dst.e1 = Select(m, a.e1, dst.e1);
+            dst.six = Select(m, a.six, dst.six);
+            for (int i = 0; i < 16; ++i)
+                dst.idx[i] = Select(m, a.idx[i], dst.idx[i]);
+        }
+
+        // Minimos cuadrados de los extremos de 8 valores con los indices actuales
+        void RefineAlpha(int ch, AlphaFit& fit) const
+        {
+            V zero = L::Set(0.0f);
+            V one = L::Set(1.0f);
+
+            V a00 = zero, a01 = zero, a11 = zero, x0 = zero, x1 = zero;
+            for (int i = 0; i < 16; ++i)
+            {
+                V a = fit.idx[i] * L::Set(1.0f / 7.0f);
+                V b = one - a;
+                a00 = a00 + b * b;
+                a01 = a01 + a * b;
+                a11 = a11 + a * a;
+                x0 = x0 + b * m_px[i][ch];
+                x1 = x1 + a * m_px[i][ch];
+            }
+
+            V det = a00 * a11 - a01 * a01;
+            M ok = det > L::Set(1e-3f);
+            V inv = one / Select(ok, det, one);
+
+            AlphaFit candidate;
+            candidate.six = zero;
+            candidate.e0 = Clamp255(Trunc(Clamp255((a11 * x0 - a01 * x1) * inv) + L::Set(0.5f)));
+            candidate.e1 = Clamp255(Trunc(Clamp255((a00 * x1 - a01 * x0) * inv) + L::Set(0.5f)));
+            EvaluateAlpha(ch, candidate);
+
+            // Solo si sigue siendo el modo de 8 (e0 > e1) y mejora
+            M better = ok & (candidate.e0 > candidate.e1) & (candidate.err < fit.err) & (L::Set(0.5f) > fit.six);
+            SelectAlpha(better, candidate, fit);
+        }
+
+        void EncodeAlpha(int ch, uint8_t* out, size_t stride)
+        {
+            V zero = L::Set(0.0f);
+
+            AlphaFit fit;
+            fit.e0 = zero;
+            fit.e1 = L::Set(255.0f);
+            for (int i = 0; i < 16; ++i)
+            {
+                fit.e0 = Max(fit.e0, m_px[i][ch]);
+                fit.e1 = Min(fit.e1, m_px[i][ch]);
+            }
+            fit.six = zero;
+            EvaluateAlpha(ch, fit);
+
+            if (m_params.clusterFit)
+            {
+                for (int it = 0; it < 2; ++it)
+                    RefineAlpha(ch, fit);
+
+                // 6 valores entre los que no son 0 ni 255, que van aparte
+                AlphaFit six;
+                six.e0 = L::Set(255.0f);
+                six.e1 = zero;
+                for (int i = 0; i < 16; ++i)
+                {
+                    V a = m_px[i][ch];
+                    M inner = (a > zero) & (L::Set(255.0f) > a);
+                    six.e0 = Select(inner, Min(six.e0, a), six.e0);
+                    six.e1 = Select(inner, Max(six.e1, a), six.e1);
+                }
+
+                M none = six.e0 > six.e1;
+                six.e0 = Select(none, zero, six.e0);
+                six.e1 = Select(none, zero, six.e1);
+                six.six = L::Set(1.0f);
+                EvaluateAlpha(ch, six);
+
+                SelectAlpha(six.err < fit.err, six, fit);
+            }
+
+            if (m_params.ditherAlpha)
+                DitherAlpha(ch, fit);
+
+            alignas(32) float e0[N], e1[N], sixLane[N];
+            alignas(32) float idx[16][N];
+            L::Store(e0, fit.e0);
+            L::Store(e1, fit.e1);
+            L::Store(sixLane, fit.six);
+            for (int i = 0; i < 16; ++i)
+                L::Store(idx[i], fit.idx[i]);
+
+            for (size_t l = 0; l < N; ++l)
+            {
+                AlphaResult r;
+                r.e0 = int(e0[l]);
+                r.e1 = int(e1[l]);
+                r.six = sixLane[l] != 0.0f;
+                for (int i = 0; i < 16; ++i)
+                    r.idx[i] = int(idx[i][l]);
+
+                PackAlpha(r, out + l * stride);
+            }
+        }
+
+        void DitherAlpha(int ch, AlphaFit& fit) const
+        {
+            V pal[8];
+            AlphaPalette(fit.e0, fit.e1, fit.six > L::Set(0.5f), pal);
+
+            V carry[16][1];
+            for (int i = 0; i < 16; ++i)
+                carry[i][0] = L::Set(0.0f);
+
+            for (int y = 0; y < 4; ++y)
+            {
+                for (int x = 0; x < 4; ++x)
+                {
+                    int i = y * 4 + x;
+                    V target = Clamp255(m_px[i][ch] + carry[i][0]);
+
+                    V best = L::Set(kBig);
+                    V bestIdx = L::Set(0.0f);
+                    V chosen = L::Set(0.0f);
+                    for (int k = 0; k < 8; ++k)
+                    {
+                        V d = target - pal[k];
+                        d = d * d;
+                        M lt = d < best;
+                        best = Select(lt, d, best);
+                        bestIdx = Select(lt, L::Set(float(k)), bestIdx);
+                        chosen = Select(lt, pal[k], chosen);
+                    }
+
+                    fit.idx[i] = bestIdx;
+                    Diffuse(carry, x, y, 0, target - chosen);
+                }
+            }
+        }
+
+        const BCnLaneParams& m_params;
+        alignas(32) float m_scalar[16][4][N];
+        V m_px[16][4];
+        V m_weight[3];
+    };
+
+    template <class L>
+    void EncodeBlocksLanes(DXGI_FORMAT format, const uint32_t (*blocks)[16], size_t count, uint8_t* out, const BCnLaneParams& params)
+    {
+        const size_t N = L::N;
+        size_t bytes = BlockBytes(format);
+
+        for (size_t b = 0; b < count; b += N)
+        {
+            size_t n = std::min(N, count - b);
+
+            if (n == N)
+            {
+                LaneEncoder<L> encoder(blocks + b, params);
+                encoder.Encode(format, out + b * bytes);
+                continue;
+            }
+
+            // Ultimo lote incompleto: se rellena repitiendo el ultimo bloque
+            uint32_t tail[N][16];
+            uint8_t tailOut[N * 16];
+            for (size_t l = 0; l < N; ++l)
+                memcpy(tail[l], blocks[b + std::min(l, n - 1)], sizeof(tail[l]));
+
+            LaneEncoder<L> encoder(tail, params);
+            encoder.Encode(format, tailOut);
+
+            memcpy(out + b * bytes, tailOut, n * bytes);
+        }
+    }
+
+    const BCnLaneKernels kScalarKernels = { KernelLevel::Scalar, 1, EncodeBlocksLanes<Lanes1> };
+    const BCnLaneKernels kSSE2Kernels = { KernelLevel::SSE2, 4, EncodeBlocksLanes<Lanes4> };
+    const BCnLaneKernels kAVX2Kernels = { KernelLevel::AVX2, 8, EncodeBlocksLanes<Lanes8> };
+
+    std::atomic<int> g_encoder{ BCN_ENCODER_DIRECTXTEX };
+}
+
+bool GetBCnLaneParams(DXGI_FORMAT format, TEX_COMPRESS_FLAGS flags, BCnLaneParams& params)
+{
+    return GetBCnLaneParams(format, flags, BCnEncoder(g_encoder.load(std::memory_order_relaxed)), params);
+}
+
+bool GetBCnLaneParams(DXGI_FORMAT format, TEX_COMPRESS_FLAGS flags, BCnEncoder encoder, BCnLaneParams& params)
+{
+    if (format != DXGI_FORMAT_BC1_UNORM && format != DXGI_FORMAT_BC3_UNORM && format != DXGI_FORMAT_BC4_UNORM)
+        return false;
+
+    if (encoder != BCN_ENCODER_RANGE_FIT && encoder != BCN_ENCODER_CLUSTER_FIT)
+        return false;
+
+    params.clusterFit = (encoder == BCN_ENCODER_CLUSTER_FIT);
+    params.uniform = (flags & TEX_COMPRESS_UNIFORM) != 0;
+    params.ditherColor = (flags & TEX_COMPRESS_RGB_DITHER) != 0;
+    params.ditherAlpha = (flags & TEX_COMPRESS_A_DITHER) != 0;
+    return true;
+}
+
+BCnEncoder SetBCnEncoder(BCnEncoder encoder)
+{
+    return BCnEncoder(g_encoder.exchange(int(encoder)));
+}
+
+BCnEncoder GetBCnEncoder()
+{
+    return BCnEncoder(g_encoder.load());
+}
+
+const BCnLaneKernels* GetBCnLaneKernels(KernelLevel level)
+{
+    if (level > DetectKernelLevel())
+        return nullptr;
+
+    switch (level)
+    {
+    case KernelLevel::AVX2: return &kAVX2Kernels;
+    case KernelLevel::SSE2: return &kSSE2Kernels;
+    default:                return &kScalarKernels;
+    }
+}
+
+const BCnLaneKernels& GetBCnLaneKernels()
+{
+    return *GetBCnLaneKernels(DetectKernelLevel());
+}
+
+HRESULT EncodeBCnLanes(const Image& rgba, const Image& dst, const BCnLaneParams& params, const BCnLaneKernels* kernels)
+{
+    bool supported = dst.format == DXGI_FORMAT_BC1_UNORM || dst.format == DXGI_FORMAT_BC3_UNORM
+        || dst.format == DXGI_FORMAT_BC4_UNORM;
+
+    if (!supported || !rgba.pixels || rgba.format != DXGI_FORMAT_R8G8B8A8_UNORM || !dst.pixels
+        || dst.width != rgba.width || dst.height != rgba.height)
+        return E_INVALIDARG;
+
+    if (!kernels)
+        kernels = &GetBCnLaneKernels();
+
+    size_t blocksW = (rgba.width + 3) / 4;
+    size_t blocksH = (rgba.height + 3) / 4;
+
+    // Una fila de bloques cada vez
+    std::vector<uint32_t> row(blocksW * 16);
+
+    for (size_t by = 0; by < blocksH; ++by)
+    {
+        for (size_t bx = 0; bx < blocksW; ++bx)
+        {
+            for (size_t j = 0; j < 4; ++j)
+            {
+                size_t y = std::min(by * 4 + j, rgba.height - 1);
+                const uint32_t* src = reinterpret_cast<const uint32_t*>(rgba.pixels + y * rgba.rowPitch);
+
+                for (size_t i = 0; i < 4; ++i)
+                    row[bx * 16 + j * 4 + i] = src[std::min(bx * 4 + i, rgba.width - 1)];
+            }
+        }
+
+        kernels->encode(dst.format, reinterpret_cast<const uint32_t (*)[16]>(row.data()), blocksW,
+            dst.pixels + by * dst.rowPitch, params);
+    }
+
+    return S_OK;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <windows.h>
+#include "DirectXTex.h"
+#include "ImageKernels.h"
+#include <cstddef>
+#include <cstdint>
+
+// -------------------------------------------------------------
+// Codificador BC1/BC3/BC4 propio, un bloque por carril SIMD (4 con
+// SSE2, 8 con AVX2, ver LaneMath.h), para las reglas que acaban en BC3
+// (las imagenes mas grandes).
+//
+// Color (BC1 y el color de BC3):
+//   range fit    extremos en los limites del eje principal (rapido)
+//   cluster fit  ademas prueba todos los repartos ordenados de los 16
+//                pixeles en 4 grupos sobre el eje, con los extremos por
+//                minimos cuadrados; se queda con el mejor (calidad)
+// BC1 con algun pixel de alfa < 128 usa el modo de 3 colores +
+// transparente (solo range fit).
+//
+// Alfa de BC3 y BC4 (canal R): extremos en el min/max con 8 valores;
+// con cluster fit ademas refina por minimos cuadrados y prueba el modo
+// de 6 valores + 0/255.
+//
+// El dithering (TEX_COMPRESS_RGB_DITHER / A_DITHER) reparte el error
+// de cada pixel dentro del bloque (Floyd-Steinberg) al elegir indices.
+// Sin TEX_COMPRESS_UNIFORM el error de color usa los mismos pesos de
+// luminancia que DirectXTex.
+//
+// Los tres niveles de kernel dan los mismos bytes.
+// -------------------------------------------------------------
+
+enum BCnEncoder
+{
+    BCN_ENCODER_DIRECTXTEX = 0,     // Compress de DirectXTex (por defecto)
+    BCN_ENCODER_RANGE_FIT = 1,
+    BCN_ENCODER_CLUSTER_FIT = 2,
+};
+
+struct BCnLaneParams
+{
+    bool clusterFit;
+    bool uniform;           // sin pesos de luminancia
+    bool ditherColor;
+    bool ditherAlpha;
+};
+
+// Para BC1/BC3/BC4 UNORM con este codificador puesto: true y 'params'
+// a partir de las flags de Compress
+bool GetBCnLaneParams(DXGI_FORMAT format, DirectX::TEX_COMPRESS_FLAGS flags, BCnLaneParams& params);
+
+// Igual con el codificador de la llamada en vez del de SetBCnEncoder
+bool GetBCnLaneParams(DXGI_FORMAT format, DirectX::TEX_COMPRESS_FLAGS flags, BCnEncoder encoder, BCnLaneParams& params);
+
+// Para todas las codificaciones BC1/BC3/BC4 siguientes. Devuelve el anterior.
+BCnEncoder SetBCnEncoder(BCnEncoder encoder);
+BCnEncoder GetBCnEncoder();
+
+struct BCnLaneKernels
+{
+    KernelLevel level;
+    size_t lanes;
+
+    // 'count' bloques de 16 pixeles RGBA8 (fila a fila) -> bloques de
+    // 'format' seguidos en 'out' (8 bytes BC1/BC4, 16 BC3)
+    void (*encode)(DXGI_FORMAT format, const uint32_t (*blocks)[16], size_t count, uint8_t* out, const BCnLaneParams& params);
+};
+
+// nullptr si la CPU no soporta el nivel
+const BCnLaneKernels* GetBCnLaneKernels(KernelLevel level);
+const BCnLaneKernels& GetBCnLaneKernels();
+
+// Imagen RGBA8 entera a 'dst' (ya reservado, mismo tamano), en el hilo
+// que llama. Los bloques incompletos repiten el borde. 'kernels'
+// fuerza un nivel; nullptr = el de la CPU.
+HRESULT EncodeBCnLanes(const DirectX::Image& rgba, const DirectX::Image& dst, const BCnLaneParams& params,
+    const BCnLaneKernels* kernels = nullptr);
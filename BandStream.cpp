@@ -0,0 +1,96 @@
+#include "BandStream.h"
+#include "Trace.h"
+
+using namespace DirectX;
+
+WICBandReader::~WICBandReader()
+{
+    Close();
+}
+
+void WICBandReader::Close()
+{
+    if (m_converter) { m_converter->Release(); m_converter = nullptr; }
+    if (m_frame) { m_frame->Release(); m_frame = nullptr; }
+    if (m_decoder) { m_decoder->Release(); m_decoder = nullptr; }
+    if (m_factory) { m_factory->Release(); m_factory = nullptr; }
+
+    m_source = nullptr;
+    m_width = 0;
+    m_height = 0;
+    m_format = DXGI_FORMAT_UNKNOWN;
+}
+
+HRESULT WICBandReader::Open(const wchar_t* path)
+{
+    Close();
+
+    HRESULT hr = CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&m_factory));
+    if (FAILED(hr)) return hr;
+
+    hr = m_factory->CreateDecoderFromFilename(path, nullptr, GENERIC_READ, WICDecodeMetadataCacheOnDemand, &m_decoder);
+    if (FAILED(hr)) return hr;
+
+    hr = m_decoder->GetFrame(0, &m_frame);
+    if (FAILED(hr)) return hr;
+
+    UINT w = 0, h = 0;
+    hr = m_frame->GetSize(&w, &h);
+    if (FAILED(hr)) return hr;
+
+    WICPixelFormatGUID pf;
+    hr = m_frame->GetPixelFormat(&pf);
+    if (FAILED(hr)) return hr;
+
+    // Mismo mapeo que LoadFromWICFile: BGRA/RGBA se leen tal cual,
+    // 24 bits y paleta se convierten a RGBA
+    if (pf == GUID_WICPixelFormat32bppBGRA)
+    {
+        m_format = DXGI_FORMAT_B8G8R8A8_UNORM;
+        m_source = m_frame;
+    }
+    else if (pf == GUID_WICPixelFormat32bppRGBA)
+    {
+        m_format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        m_source = m_frame;
+    }
+    else if (pf == GUID_WICPixelFormat24bppBGR
+        || pf == GUID_WICPixelFormat24bppRGB
+        || pf == GUID_WICPixelFormat8bppIndexed
+        || pf == GUID_WICPixelFormat4bppIndexed
+        || pf == GUID_WICPixelFormat2bppIndexed
+        || pf == GUID_WICPixelFormat1bppIndexed)
+    {
+        hr = m_factory->CreateFormatConverter(&m_converter);
+        if (FAILED(hr)) return hr;
+
+        hr = m_converter->Initialize(m_frame, GUID_WICPixelFormat32bppRGBA,
+            WICBitmapDitherTypeNone, nullptr, 0.0, WICBitmapPaletteTypeCustom);
+        if (FAILED(hr)) return hr;
+
+        m_format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        m_source = m_converter;
+    }
+    else
+    {
+        // 16 bits por canal, gris, etc.: mejor el camino normal
+        return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+    }
+
+    m_width = w;
+    m_height = h;
+    return S_OK;
+}
+
+HRESULT WICBandReader::ReadRows(size_t y, size_t count, uint8_t* dst, size_t rowPitch)
+{
+    if (!m_source || !dst || y + count > m_height)
+        return E_INVALIDARG;
+
+    if (count == 0)
+        return S_OK;
+
+    TraceSpan span("WICBandReader::ReadRows");
+    WICRect rc = { 0, INT(y), INT(m_width), INT(count) };
+    return m_source->CopyPixels(&rc, UINT(rowPitch), UINT(rowPitch * count), dst);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <windows.h>
+#include <wincodec.h>
+#include "DirectXTex.h"
+#include <cstdint>
+
+// -------------------------------------------------------------
+// Lectura por bandas de filas.
+//
+// WICBandReader decodifica solo las filas que se piden (CopyPixels
+// con un rectangulo), asi que la memoria depende del alto de la
+// banda y no del de la imagen. El formato de salida es el mismo que
+// daria LoadFromWICFile con WIC_FLAGS_IGNORE_SRGB.
+// -------------------------------------------------------------
+class WICBandReader
+{
+public:
+    WICBandReader() = default;
+    ~WICBandReader();
+
+    WICBandReader(const WICBandReader&) = delete;
+    WICBandReader& operator=(const WICBandReader&) = delete;
+
+    // ERROR_NOT_SUPPORTED si el formato no es de 8 bits por canal
+    HRESULT Open(const wchar_t* path);
+
+    size_t Width() const { return m_width; }
+    size_t Height() const { return m_height; }
+    DXGI_FORMAT Format() const { return m_format; }     // R8G8B8A8 o B8G8R8A8
+
+    // Filas [y, y + count) en 'dst' (4 bytes por pixel)
+    HRESULT ReadRows(size_t y, size_t count, uint8_t* dst, size_t rowPitch);
+
+private:
+    void Close();
+
+    IWICImagingFactory* m_factory = nullptr;
+    IWICBitmapDecoder* m_decoder = nullptr;
+    IWICBitmapFrameDecode* m_frame = nullptr;
+    IWICFormatConverter* m_converter = nullptr;
+    IWICBitmapSource* m_source = nullptr;     // m_frame o m_converter (sin referencia propia)
+
+    size_t m_width = 0;
+    size_t m_height = 0;
+    DXGI_FORMAT m_format = DXGI_FORMAT_UNKNOWN;
+};
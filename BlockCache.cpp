@@ -0,0 +1,325 @@
+#include "BlockCache.h"
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    struct BlockKey
+    {
+        uint32_t px[16];
+        uint32_t format;
+        uint32_t flags;
+    };
+
+    // Tambien es el registro del archivo
+    struct Entry
+    {
+        BlockKey key;
+        uint8_t block[16];
+    };
+
+    static_assert(sizeof(Entry) == 88, "Entry se escribe tal cual en el archivo");
+
+    struct FileHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t entrySize;
+    };
+
+    const char kMagic[8] = { 'B', 'L', 'K', 'C', 'A', 'C', 'H', 'E' };
+
+    // Repartida para que los workers de los tiles no compitan por un lock
+    const size_t kShardBits = 6;
+    const size_t kShardCount = size_t(1) << kShardBits;
+
+    struct Shard
+    {
+        std::mutex lock;
+        std::unordered_map<uint64_t, Entry> map;
+    };
+
+    Shard g_shards[kShardCount];
+    std::atomic<bool> g_enabled{ false };
+    std::atomic<uint64_t> g_maxPerShard{ 0 };
+    std::atomic<uint64_t> g_inserts{ 0 };
+
+    // Coste medio de cada formato/flags, para estimar lo ahorrado.
+    // El coste no se borra con ResetStats: los aciertos de despues
+    // siguen valiendo lo mismo.
+    struct CostSlot
+    {
+        uint32_t format;
+        uint32_t flags;
+        uint64_t hits;
+        uint64_t costBlocks;
+        double costMs;
+    };
+
+    std::mutex g_statsLock;
+    std::vector<CostSlot> g_costs;
+    uint64_t g_lookups = 0;
+    uint64_t g_hits = 0;
+    uint64_t g_encodedBlocks = 0;
+    double g_encodeMs = 0.0;
+    double g_lookupMs = 0.0;
+
+    // TEX_COMPRESS_PARALLEL no cambia el resultado
+    inline uint32_t KeyFlags(TEX_COMPRESS_FLAGS flags)
+    {
+        return uint32_t(flags & ~TEX_COMPRESS_PARALLEL);
+    }
+
+    inline void MakeKey(const uint32_t px[16], DXGI_FORMAT format, TEX_COMPRESS_FLAGS flags, BlockKey& key)
+    {
+        memcpy(key.px, px, sizeof(key.px));
+        key.format = uint32_t(format);
+        key.flags = KeyFlags(flags);
+    }
+
+    inline uint64_t Mix64(uint64_t x)
+    {
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ULL;
+        x ^= x >> 33;
+        return x;
+    }
+
+    uint64_t HashKey(const BlockKey& key)
+    {
+        uint64_t h = (uint64_t(key.format) << 32) | key.flags;
+
+        for (int i = 0; i < 16; i += 2)
+        {
+            uint64_t w = uint64_t(key.px[i]) | (uint64_t(key.px[i + 1]) << 32);
+            h = (h ^ w) * 0x9e3779b97f4a7c15ULL;
+            h = (h << 31) | (h >> 33);
+        }
+
+        return Mix64(h);
+    }
+
+    inline Shard& ShardOf(uint64_t hash)
+    {
+        return g_shards[hash >> (64 - kShardBits)];
+    }
+
+    void InsertEntry(const Entry& entry)
+    {
+        uint64_t hash = HashKey(entry.key);
+        Shard& shard = ShardOf(hash);
+
+        std::lock_guard<std::mutex> lk(shard.lock);
+
+        if (shard.map.size() >= g_maxPerShard.load(std::memory_order_relaxed))
+            return;
+
+        // Si el hash ya esta (mismo bloque u otra colision) se queda el primero
+        if (shard.map.emplace(hash, entry).second)
+            g_inserts.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+namespace BlockCache
+{
+    void Configure(uint64_t maxEntries)
+    {
+        g_enabled = false;
+        g_maxPerShard = (maxEntries + kShardCount - 1) / kShardCount;
+
+        if (!maxEntries)
+        {
+            for (Shard& shard : g_shards)
+            {
+                std::lock_guard<std::mutex> lk(shard.lock);
+                std::unordered_map<uint64_t, Entry>().swap(shard.map);
+            }
+        }
+
+        g_enabled = (maxEntries != 0);
+    }
+
+    bool Enabled()
+    {
+        return g_enabled.load(std::memory_order_relaxed);
+    }
+
+    bool Lookup(const uint32_t px[16], DXGI_FORMAT format, TEX_COMPRESS_FLAGS flags, uint8_t block[16])
+    {
+        if (!Enabled())
+            return false;
+
+        BlockKey key;
+        MakeKey(px, format, flags, key);
+
+        uint64_t hash = HashKey(key);
+        Shard& shard = ShardOf(hash);
+
+        std::lock_guard<std::mutex> lk(shard.lock);
+
+        auto it = shard.map.find(hash);
+        if (it == shard.map.end() || memcmp(&it->second.key, &key, sizeof(key)) != 0)
+            return false;
+
+        memcpy(block, it->second.block, 16);
+        return true;
+    }
+
+    void Insert(const uint32_t px[16], DXGI_FORMAT format, TEX_COMPRESS_FLAGS flags, const uint8_t block[16])
+    {
+        if (!Enabled())
+            return;
+
+        Entry entry;
+        MakeKey(px, format, flags, entry.key);
+        memcpy(entry.block, block, 16);
+
+        InsertEntry(entry);
+    }
+
+    void Record(DXGI_FORMAT format, TEX_COMPRESS_FLAGS flags,
+        uint64_t lookups, uint64_t hits, uint64_t encodedBlocks, double encodeMs, double lookupMs)
+    {
+        std::lock_guard<std::mutex> lk(g_statsLock);
+
+        g_lookups += lookups;
+        g_hits += hits;
+        g_encodedBlocks += encodedBlocks;
+        g_encodeMs += encodeMs;
+        g_lookupMs += lookupMs;
+
+        uint32_t keyFlags = KeyFlags(flags);
+        for (CostSlot& slot : g_costs)
+        {
+            if (slot.format == uint32_t(format) && slot.flags == keyFlags)
+            {
+                slot.hits += hits;
+                slot.costBlocks += encodedBlocks;
+                slot.costMs += encodeMs;
+                return;
+            }
+        }
+
+        g_costs.push_back({ uint32_t(format), keyFlags, hits, encodedBlocks, encodeMs });
+    }
+
+    HRESULT Load(const wchar_t* path)
+    {
+        if (!path)
+            return E_INVALIDARG;
+
+        FILE* f = nullptr;
+        if (_wfopen_s(&f, path, L"rb") != 0 || !f)
+            return S_FALSE;
+
+        FileHeader header = {};
+        if (fread(&header, sizeof(header), 1, f) != 1
+            || memcmp(header.magic, kMagic, sizeof(kMagic)) != 0
+            || header.version != kBlockCacheVersion
+            || header.entrySize != sizeof(Entry))
+        {
+            fclose(f);
+            return S_FALSE;
+        }
+
+        std::vector<Entry> chunk(4096);
+        size_t read;
+        while ((read = fread(chunk.data(), sizeof(Entry), chunk.size(), f)) > 0)
+        {
+            for (size_t i = 0; i < read; ++i)
+                InsertEntry(chunk[i]);
+        }
+
+        fclose(f);
+        return S_OK;
+    }
+
+    HRESULT Save(const wchar_t* path)
+    {
+        if (!path)
+            return E_INVALIDARG;
+
+        // Temporal + rename: un archivo a medias nunca se llega a leer
+        std::wstring tmpPath = std::wstring(path) + L".tmp";
+
+        FILE* f = nullptr;
+        if (_wfopen_s(&f, tmpPath.c_str(), L"wb") != 0 || !f)
+            return E_FAIL;
+
+        FileHeader header = {};
+        memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version = kBlockCacheVersion;
+        header.entrySize = sizeof(Entry);
+
+        bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+
+        for (Shard& shard : g_shards)
+        {
+            std::lock_guard<std::mutex> lk(shard.lock);
+            for (const auto& it : shard.map)
+                ok = ok && fwrite(&it.second, sizeof(Entry), 1, f) == 1;
+        }
+
+        ok = (fclose(f) == 0) && ok;
+
+        if (!ok || !MoveFileExW(tmpPath.c_str(), path, MOVEFILE_REPLACE_EXISTING))
+        {
+            DeleteFileW(tmpPath.c_str());
+            return E_FAIL;
+        }
+
+        return S_OK;
+    }
+
+    void GetStats(BlockCacheStats& stats)
+    {
+        stats = BlockCacheStats();
+
+        for (Shard& shard : g_shards)
+        {
+            std::lock_guard<std::mutex> lk(shard.lock);
+            stats.entries += shard.map.size();
+        }
+
+        stats.inserts = g_inserts.load();
+
+        std::lock_guard<std::mutex> lk(g_statsLock);
+
+        stats.lookups = g_lookups;
+        stats.hits = g_hits;
+        stats.encodedBlocks = g_encodedBlocks;
+        stats.encodeMs = g_encodeMs;
+        stats.lookupMs = g_lookupMs;
+
+        for (const CostSlot& slot : g_costs)
+        {
+            if (slot.costBlocks)
+                stats.savedMs += double(slot.hits) * slot.costMs / double(slot.costBlocks);
+        }
+    }
+
+    void ResetStats()
+    {
+        g_inserts = 0;
+
+        std::lock_guard<std::mutex> lk(g_statsLock);
+
+        for (CostSlot& slot : g_costs)
+            slot.hits = 0;
+
+        g_lookups = 0;
+        g_hits = 0;
+        g_encodedBlocks = 0;
+        g_encodeMs = 0.0;
+        g_lookupMs = 0.0;
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <windows.h>
+#include "DirectXTex.h"
+#include <cstddef>
+#include <cstdint>
+
+// -------------------------------------------------------------
+// Cache de bloques ya codificados, compartida por todas las imagenes
+// (y todos los hilos) del proceso.
+//
+// La clave son los 16 pixeles RGBA del bloque (ya con el borde
+// repetido de GatherBlock) + formato + flags de Compress; se guarda el
+// bloque entero y se compara al buscar, asi una colision de hash nunca
+// da un bloque equivocado. Solo BC7 y BC3 (los de CompressBlocks). Los
+// bloques de un color y transparentes no pasan por aqui: ya son gratis.
+//
+// Cada entrada ocupa unos 130 bytes con el mapa; al llegar a
+// maxEntries ya no se anade nada. Desactivada por defecto.
+//
+// Save/Load guardan las entradas en un archivo binario para la
+// siguiente ejecucion. Subir kBlockCacheVersion si cambia el
+// codificador (otra DirectXTex, otras flags): los archivos viejos se
+// ignoran.
+// -------------------------------------------------------------
+static const uint32_t kBlockCacheVersion = 2;
+
+// Se devuelve al llamador (tambien desde la DLL), solo tipos planos
+struct BlockCacheStats
+{
+    uint64_t lookups;           // bloques buscados
+    uint64_t hits;
+    uint64_t inserts;
+    uint64_t entries;           // en la cache ahora
+    uint64_t encodedBlocks;     // fallos que se han tenido que codificar
+    double   encodeMs;          // tiempo de Compress de esos bloques
+    double   lookupMs;          // buscar + insertar
+    double   savedMs;           // estimado: aciertos x coste medio de su formato/flags
+                                // (0 mientras no se haya codificado ninguno)
+};
+
+namespace BlockCache
+{
+    // maxEntries == 0 la desactiva y la vacia
+    void Configure(uint64_t maxEntries);
+    bool Enabled();
+
+    // true y 'block' (16 bytes) si esta
+    bool Lookup(const uint32_t px[16], DXGI_FORMAT format, DirectX::TEX_COMPRESS_FLAGS flags, uint8_t block[16]);
+    void Insert(const uint32_t px[16], DXGI_FORMAT format, DirectX::TEX_COMPRESS_FLAGS flags, const uint8_t block[16]);
+
+    // Lo que cuesta cada llamada a CompressBlocks con la cache puesta
+    // (para la tasa de aciertos y el tiempo ahorrado)
+    void Record(DXGI_FORMAT format, DirectX::TEX_COMPRESS_FLAGS flags,
+        uint64_t lookups, uint64_t hits, uint64_t encodedBlocks, double encodeMs, double lookupMs);
+
+    // Anade las entradas del archivo (S_FALSE si no existe o es de
+    // otra version)
+    HRESULT Load(const wchar_t* path);
+    HRESULT Save(const wchar_t* path);
+
+    void GetStats(BlockCacheStats& stats);
+    void ResetStats();
+}
@@ -0,0 +1,668 @@
+#include "BlockRDO.h"
+#include "BCDecoder.h"
+#include "TextureEncode.h"
+#include "Trace.h"
+#include "WorkStealingPool.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    // Coste aproximado de un LZ con entropia (deflate, XPRESS, ...): un
+    // tramo corto apenas ahorra frente a literales. Seguir la copia del
+    // trozo anterior con la misma distancia solo alarga el tramo.
+    const float kLiteralBits = 8.0f;
+    const float kMatchBits = 32.0f;
+    const float kExtendBits = 2.0f;
+
+    std::atomic<float> g_lambda{ 0.0f };
+    std::atomic<unsigned> g_window{ kDefaultRDOWindow };
+
+    std::atomic<uint64_t> g_segments{ 0 };
+    std::atomic<uint64_t> g_wholeCopies{ 0 };
+    std::atomic<uint64_t> g_indexCopies{ 0 };
+    std::atomic<uint64_t> g_refits{ 0 };
+
+    enum CandidateKind
+    {
+        KEEP = 0,
+        WHOLE_COPY,
+        INDEX_COPY,
+        REFIT,
+        kCandidateKinds
+    };
+
+    // Trozo del bloque que se decide por separado
+    struct Segment
+    {
+        size_t lo, hi;          // bytes [lo, hi)
+        uint32_t channels;      // bit c = canal c cuenta en el error
+    };
+
+    const Segment kBC7Segment = { 0, 16, 0xF };
+    const Segment kBC3Alpha = { 0, 8, 0x8 };
+    const Segment kBC3Color = { 8, 16, 0x7 };
+
+    // Primer bit de indices de cada modo BC7 (despues de extremos y p-bits)
+    const int kBC7IndexStartBit[8] = { 83, 82, 99, 98, 50, 66, 65, 98 };
+
+    const int kWeights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    int BC7Mode(const uint8_t* block)
+    {
+        for (int m = 0; m < 8; ++m)
+        {
+            if ((block[0] >> m) & 1)
+                return m;
+        }
+        return 8;
+    }
+
+    // Primer byte que solo tiene indices; hi si el bloque no tiene
+    size_t IndexStart(DXGI_FORMAT format, const Segment& seg, const uint8_t* block)
+    {
+        if (format == DXGI_FORMAT_BC3_UNORM)
+            return seg.lo + (seg.lo == 0 ? 2 : 4);
+
+        int mode = BC7Mode(block);
+        return mode < 8 ? size_t(kBC7IndexStartBit[mode] + 7) / 8 : seg.hi;
+    }
+
+    struct BlockSource
+    {
+        uint8_t px[16][4];
+        uint16_t valid;         // bit i: el pixel i esta dentro de la imagen
+    };
+
+    void GatherSource(const Image& img, size_t bx, size_t by, BlockSource& src)
+    {
+        src.valid = 0;
+        for (size_t j = 0; j < 4; ++j)
+        {
+            size_t y = std::min(by * 4 + j, img.height - 1);
+            const uint8_t* row = img.pixels + y * img.rowPitch;
+
+            for (size_t i = 0; i < 4; ++i)
+            {
+                size_t x = std::min(bx * 4 + i, img.width - 1);
+                memcpy(src.px[j * 4 + i], row + x * 4, 4);
+
+                if (by * 4 + j < img.height && bx * 4 + i < img.width)
+                    src.valid |= uint16_t(1u << (j * 4 + i));
+            }
+        }
+    }
+
+    float PixelsError(const uint32_t decoded[16], const BlockSource& src, uint32_t channels)
+    {
+        float err = 0.0f;
+        for (int i = 0; i < 16; ++i)
+        {
+            if (!((src.valid >> i) & 1))
+                continue;
+
+            const uint8_t* d = reinterpret_cast<const uint8_t*>(decoded + i);
+            for (int c = 0; c < 4; ++c)
+            {
+                if ((channels >> c) & 1)
+                {
+                    float e = float(d[c]) - float(src.px[i][c]);
+                    err += e * e;
+                }
+            }
+        }
+        return err;
+    }
+
+    float BlockError(DXGI_FORMAT format, const uint8_t* block, const BlockSource& src, uint32_t channels,
+        const BCDecodeKernels& k)
+    {
+        uint32_t decoded[1][16];
+        k.decode(format, block, 1, decoded);
+        return PixelsError(decoded[0], src, channels);
+    }
+
+    // =========================================================
+    // Extremos por minimos cuadrados para unos indices dados:
+    // pixel = (1 - t) * e0 + t * e1
+    // =========================================================
+    class EndpointFit
+    {
+    public:
+        void Add(float t, const uint8_t px[4])
+        {
+            float s = 1.0f - t;
+            m_aa += s * s;
+            m_ab += s * t;
+            m_bb += t * t;
+            for (int c = 0; c < 4; ++c)
+            {
+                m_xa[c] += s * px[c];
+                m_xb[c] += t * px[c];
+            }
+        }
+
+        // false si todos los pixeles tienen el mismo t
+        bool Solve(float e0[4], float e1[4]) const
+        {
+            float det = m_aa * m_bb - m_ab * m_ab;
+            if (std::fabs(det) < 1e-6f)
+                return false;
+
+            for (int c = 0; c < 4; ++c)
+            {
+                e0[c] = std::min(std::max((m_bb * m_xa[c] - m_ab * m_xb[c]) / det, 0.0f), 255.0f);
+                e1[c] = std::min(std::max((m_aa * m_xb[c] - m_ab * m_xa[c]) / det, 0.0f), 255.0f);
+            }
+            return true;
+        }
+
+    private:
+        float m_aa = 0.0f, m_ab = 0.0f, m_bb = 0.0f;
+        float m_xa[4] = {}, m_xb[4] = {};
+    };
+
+    inline uint32_t Quantize(float v, uint32_t max)
+    {
+        return uint32_t(std::lround(v * float(max) / 255.0f));
+    }
+
+    // Color de BC3 (siempre 4 colores) con los selectores de bytes 12..15
+    bool RefitColor(const BlockSource& src, const uint8_t* block, uint8_t* out)
+    {
+        static const float kT[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+        uint32_t selectors;
+        memcpy(&selectors, block + 12, 4);
+
+        EndpointFit fit;
+        for (int i = 0; i < 16; ++i)
+        {
+            if ((src.valid >> i) & 1)
+                fit.Add(kT[(selectors >> (2 * i)) & 3], src.px[i]);
+        }
+
+        float e0[4], e1[4];
+        if (!fit.Solve(e0, e1))
+            return false;
+
+        uint32_t c0 = (Quantize(e0[0], 31) << 11) | (Quantize(e0[1], 63) << 5) | Quantize(e0[2], 31);
+        uint32_t c1 = (Quantize(e1[0], 31) << 11) | (Quantize(e1[1], 63) << 5) | Quantize(e1[2], 31);
+
+        memcpy(out, block, 16);
+        out[8] = uint8_t(c0);
+        out[9] = uint8_t(c0 >> 8);
+        out[10] = uint8_t(c1);
+        out[11] = uint8_t(c1 >> 8);
+        return true;
+    }
+
+    // Alfa de BC3 con los indices de bytes 2..7. El modo (8 valores o 6
+    // + 0/255) es el que tenian esos indices: se mantiene el orden.
+    bool RefitAlpha(const BlockSource& src, const uint8_t* block, bool eightValues, uint8_t* out)
+    {
+        uint64_t bits = 0;
+        memcpy(&bits, block + 2, 6);
+
+        EndpointFit fit;
+        for (int i = 0; i < 16; ++i)
+        {
+            uint32_t idx = uint32_t(bits >> (3 * i)) & 7;
+            if (!((src.valid >> i) & 1) || (!eightValues && idx >= 6))
+                continue;
+
+            float t = (idx <= 1) ? float(idx) : float(idx - 1) / (eightValues ? 7.0f : 5.0f);
+            uint8_t a[4] = { src.px[i][3], 0, 0, 0 };
+            fit.Add(t, a);
+        }
+
+        float e0[4], e1[4];
+        if (!fit.Solve(e0, e1))
+            return false;
+
+        uint32_t a0 = uint32_t(std::lround(e0[0]));
+        uint32_t a1 = uint32_t(std::lround(e1[0]));
+        if (eightValues ? (a0 <= a1) : (a0 > a1))
+            return false;
+
+        memcpy(out, block, 16);
+        out[0] = uint8_t(a0);
+        out[1] = uint8_t(a1);
+        return true;
+    }
+
+    // =========================================================
+    // BC7 modo 6: 7 bits + p-bit por extremo, indices de 4 bits
+    // =========================================================
+    class BitWriter
+    {
+    public:
+        explicit BitWriter(uint8_t* block) : m_block(block) { memset(block, 0, 16); }
+
+        void Put(uint32_t v, int n)
+        {
+            for (int i = 0; i < n; ++i, ++m_pos)
+                m_block[m_pos >> 3] |= uint8_t(((v >> i) & 1) << (m_pos & 7));
+        }
+
+    private:
+        uint8_t* m_block;
+        int m_pos = 0;
+    };
+
+    uint32_t GetBits(const uint8_t* block, int pos, int n)
+    {
+        uint32_t v = 0;
+        for (int i = 0; i < n; ++i, ++pos)
+            v |= uint32_t((block[pos >> 3] >> (pos & 7)) & 1) << i;
+        return v;
+    }
+
+    inline int Mode6Value(int e0, int e1, int w)
+    {
+        return (e0 * (64 - w) + e1 * w + 32) >> 6;
+    }
+
+    float Mode6PixelError(const int e0[4], const int e1[4], int w, const uint8_t px[4])
+    {
+        float err = 0.0f;
+        for (int c = 0; c < 4; ++c)
+        {
+            float e = float(Mode6Value(e0[c], e1[c], w)) - float(px[c]);
+            err += e * e;
+        }
+        return err;
+    }
+
+    // Bloque de modo 6 con los indices 2..15 de 'candidate' (bytes 9..15
+    // iguales) y extremos, p-bits e indices 0 y 1 nuevos
+    bool RefitBC7Mode6(const BlockSource& src, const uint8_t* candidate, uint8_t* out)
+    {
+        int index[16];
+        index[0] = int(GetBits(candidate, 65, 3));
+        for (int i = 1; i < 16; ++i)
+            index[i] = int(GetBits(candidate, 68 + 4 * (i - 1), 4));
+
+        EndpointFit fit;
+        for (int i = 0; i < 16; ++i)
+        {
+            if ((src.valid >> i) & 1)
+                fit.Add(float(kWeights4[index[i]]) / 64.0f, src.px[i]);
+        }
+
+        float e0[4], e1[4];
+        if (!fit.Solve(e0, e1))
+            return false;
+
+        // Los 4 p-bits posibles; el error solo de los pixeles 2..15 (los
+        // otros dos eligen indice despues)
+        float bestErr = -1.0f;
+        int best0[4] = {}, best1[4] = {};
+        uint32_t bestP0 = 0, bestP1 = 0;
+
+        for (uint32_t p = 0; p < 4; ++p)
+        {
+            uint32_t p0 = p & 1, p1 = p >> 1;
+            int q0[4], q1[4];
+            for (int c = 0; c < 4; ++c)
+            {
+                q0[c] = 2 * std::min(std::max(int(std::lround((e0[c] - float(p0)) / 2.0f)), 0), 127) + int(p0);
+                q1[c] = 2 * std::min(std::max(int(std::lround((e1[c] - float(p1)) / 2.0f)), 0), 127) + int(p1);
+            }
+
+            float err = 0.0f;
+            for (int i = 2; i < 16; ++i)
+            {
+                if ((src.valid >> i) & 1)
+                    err += Mode6PixelError(q0, q1, kWeights4[index[i]], src.px[i]);
+            }
+
+            if (bestErr < 0.0f || err < bestErr)
+            {
+                bestErr = err;
+                memcpy(best0, q0, sizeof(best0));
+                memcpy(best1, q1, sizeof(best1));
+                bestP0 = p0;
+                bestP1 = p1;
+            }
+        }
+
+        // Indices 0 (ancla: 3 bits) y 1, los mejores para esos extremos
+        for (int i = 0; i < 2; ++i)
+        {
+            int count = (i == 0) ? 8 : 16;
+            float bestPixel = -1.0f;
+            for (int idx = 0; idx < count; ++idx)
+            {
+                float err = Mode6PixelError(best0, best1, kWeights4[idx], src.px[i]);
+                if (bestPixel < 0.0f || err < bestPixel)
+                {
+                    bestPixel = err;
+                    index[i] = idx;
+                }
+            }
+        }
+
+        BitWriter w(out);
+        w.Put(1u << 6, 7);
+        for (int c = 0; c < 4; ++c)
+        {
+            w.Put(uint32_t(best0[c]) >> 1, 7);
+            w.Put(uint32_t(best1[c]) >> 1, 7);
+        }
+        w.Put(bestP0, 1);
+        w.Put(bestP1, 1);
+        w.Put(uint32_t(index[0]), 3);
+        w.Put(uint32_t(index[1]), 4);
+
+        memcpy(out + 9, candidate + 9, 7);
+        return true;
+    }
+
+    // =========================================================
+    // Banda de filas de bloques
+    // =========================================================
+    struct BandCounters
+    {
+        uint64_t segments = 0;
+        uint64_t kinds[kCandidateKinds] = {};
+    };
+
+    struct DecodedBlock
+    {
+        uint32_t px[16];
+    };
+
+    class BandRDO
+    {
+    public:
+        BandRDO(const Image& rgba, const Image& dst, const BlockRDOParams& params, const BCDecodeKernels& k)
+            : m_rgba(rgba), m_dst(dst), m_params(params), m_k(k),
+            m_blocksW((rgba.width + 3) / 4),
+            m_decoded(m_blocksW * kRDOBandBlockRows)
+        {
+        }
+
+        void Run(size_t by0, size_t by1, BandCounters& counters)
+        {
+            m_lastOffset = 0;
+            for (size_t by = by0; by < by1; ++by)
+            {
+                for (size_t bx = 0; bx < m_blocksW; ++bx)
+                {
+                    BlockSource src;
+                    GatherSource(m_rgba, bx, by, src);
+
+                    // Bloques ya decididos de la banda: los previos de la
+                    // fila y los 3 de encima
+                    m_window.clear();
+                    for (size_t j = 1; j <= m_params.window && j <= bx; ++j)
+                        m_window.push_back(Window(by0, bx - j, by));
+
+                    if (by > by0)
+                    {
+                        for (size_t x = (bx ? bx - 1 : 0); x <= std::min(bx + 1, m_blocksW - 1); ++x)
+                            m_window.push_back(Window(by0, x, by - 1));
+                    }
+
+                    uint8_t* block = m_dst.pixels + by * m_dst.rowPitch + bx * 16;
+
+                    if (m_dst.format == DXGI_FORMAT_BC3_UNORM)
+                    {
+                        Decide(block, kBC3Alpha, src, counters);
+                        Decide(block, kBC3Color, src, counters);
+                    }
+                    else
+                    {
+                        Decide(block, kBC7Segment, src, counters);
+                    }
+
+                    m_k.decode(m_dst.format, block, 1, &m_decoded[(by - by0) * m_blocksW + bx].px);
+                }
+            }
+        }
+
+    private:
+        struct WindowBlock
+        {
+            const uint8_t* block;
+            const uint32_t* decoded;
+        };
+
+        WindowBlock Window(size_t by0, size_t bx, size_t by) const
+        {
+            WindowBlock w;
+            w.block = m_dst.pixels + by * m_dst.rowPitch + bx * 16;
+            w.decoded = m_decoded[(by - by0) * m_blocksW + bx].px;
+            return w;
+        }
+
+        // Literales de [seg.lo, matchLo) y copia de [matchLo, seg.hi) a
+        // 'offset' bytes hacia atras
+        float MatchBits(const Segment& seg, size_t matchLo, ptrdiff_t offset) const
+        {
+            if (matchLo == seg.lo && offset == m_lastOffset)
+                return kExtendBits;
+
+            return float(matchLo - seg.lo) * kLiteralBits + kMatchBits;
+        }
+
+        // Bits del trozo sin tocar: una copia si ya coincide con algo.
+        // 'offset' = distancia de la copia con la que acaba (0 = literal)
+        float KeepBits(const uint8_t* block, const Segment& seg, size_t indexLo, ptrdiff_t& offset) const
+        {
+            float bits = float(seg.hi - seg.lo) * kLiteralBits;
+            offset = 0;
+
+            for (const auto& w : m_window)
+            {
+                size_t matchLo = seg.hi;
+                if (memcmp(block + seg.lo, w.block + seg.lo, seg.hi - seg.lo) == 0)
+                    matchLo = seg.lo;
+                else if (indexLo < seg.hi && memcmp(block + indexLo, w.block + indexLo, seg.hi - indexLo) == 0)
+                    matchLo = indexLo;
+
+                if (matchLo < seg.hi && MatchBits(seg, matchLo, block - w.block) < bits)
+                {
+                    bits = MatchBits(seg, matchLo, block - w.block);
+                    offset = block - w.block;
+                }
+            }
+            return bits;
+        }
+
+        void Decide(uint8_t* block, const Segment& seg, const BlockSource& src, BandCounters& counters)
+        {
+            DXGI_FORMAT format = m_dst.format;
+            float lambda = m_params.lambda;
+            size_t len = seg.hi - seg.lo;
+            size_t indexLo = IndexStart(format, seg, block);
+
+            uint8_t best[16];
+            memcpy(best, block, 16);
+            ptrdiff_t bestOffset = 0;
+            float bestJ = BlockError(format, block, src, seg.channels, m_k)
+                + lambda * KeepBits(block, seg, indexLo, bestOffset);
+            CandidateKind bestKind = KEEP;
+
+            ++counters.segments;
+
+            uint8_t cand[16];
+            ptrdiff_t offset = 0;
+            auto consider = [&](float bits, CandidateKind kind, const uint32_t* decoded)
+                {
+                    // Ni con error 0 ganaria
+                    if (lambda * bits >= bestJ)
+                        return;
+
+                    float err = decoded ? PixelsError(decoded, src, seg.channels)
+                                        : BlockError(format, cand, src, seg.channels, m_k);
+                    float j = err + lambda * bits;
+                    if (j < bestJ)
+                    {
+                        bestJ = j;
+                        bestKind = kind;
+                        bestOffset = offset;
+                        memcpy(best, cand, 16);
+                    }
+                };
+
+            for (const auto& w : m_window)
+            {
+                offset = block - w.block;
+
+                // Copia entera: el error sale de lo ya decodificado (los
+                // canales de cada mitad de BC3 no dependen de la otra)
+                if (memcmp(block + seg.lo, w.block + seg.lo, len) != 0)
+                {
+                    memcpy(cand, block, 16);
+                    memcpy(cand + seg.lo, w.block + seg.lo, len);
+                    consider(MatchBits(seg, seg.lo, offset), WHOLE_COPY, w.decoded);
+                }
+
+                // Solo los indices, con los extremos propios
+                bool sameLayout = (format == DXGI_FORMAT_BC3_UNORM) || (BC7Mode(block) == BC7Mode(w.block));
+                if (sameLayout && indexLo < seg.hi && memcmp(block + indexLo, w.block + indexLo, seg.hi - indexLo) != 0)
+                {
+                    memcpy(cand, block, 16);
+                    memcpy(cand + indexLo, w.block + indexLo, seg.hi - indexLo);
+                    consider(MatchBits(seg, indexLo, offset), INDEX_COPY, nullptr);
+                }
+
+                // Indices del anterior y extremos reajustados
+                if (format == DXGI_FORMAT_BC3_UNORM)
+                {
+                    uint8_t merged[16];
+                    memcpy(merged, block, 16);
+                    memcpy(merged + (seg.lo == 0 ? 2 : 12), w.block + (seg.lo == 0 ? 2 : 12), seg.lo == 0 ? 6 : 4);
+
+                    bool ok = (seg.lo == 0)
+                        ? RefitAlpha(src, merged, w.block[0] > w.block[1], cand)
+                        : RefitColor(src, merged, cand);
+
+                    if (ok)
+                        consider(MatchBits(seg, seg.lo + (seg.lo == 0 ? 2 : 4), offset), REFIT, nullptr);
+                }
+                else if (BC7Mode(w.block) == 6 && RefitBC7Mode6(src, w.block, cand))
+                {
+                    consider(MatchBits(seg, 9, offset), REFIT, nullptr);
+                }
+            }
+
+            memcpy(block, best, 16);
+            m_lastOffset = bestOffset;
+            ++counters.kinds[bestKind];
+        }
+
+        const Image& m_rgba;
+        const Image& m_dst;
+        BlockRDOParams m_params;
+        const BCDecodeKernels& m_k;
+        size_t m_blocksW;
+        std::vector<DecodedBlock> m_decoded;
+        std::vector<WindowBlock> m_window;
+        ptrdiff_t m_lastOffset = 0;
+    };
+}
+
+void SetBlockRDO(const BlockRDOParams& params)
+{
+    g_lambda = std::max(params.lambda, 0.0f);
+    g_window = params.window;
+}
+
+BlockRDOParams GetBlockRDO()
+{
+    BlockRDOParams params;
+    params.lambda = g_lambda.load(std::memory_order_relaxed);
+    params.window = g_window.load(std::memory_order_relaxed);
+    return params;
+}
+
+bool IsBlockRDOFormat(DXGI_FORMAT format)
+{
+    return format == DXGI_FORMAT_BC7_UNORM || format == DXGI_FORMAT_BC3_UNORM;
+}
+
+HRESULT ApplyBlockRDO(const Image& rgba, const Image& dst, const BlockRDOParams& params, bool parallel)
+{
+    if (!rgba.pixels || !dst.pixels || rgba.format != DXGI_FORMAT_R8G8B8A8_UNORM || !IsBlockRDOFormat(dst.format)
+        || rgba.width != dst.width || rgba.height != dst.height)
+        return E_INVALIDARG;
+
+    if (params.lambda <= 0.0f)
+        return S_OK;
+
+    TraceSpan span("ApplyBlockRDO");
+
+    const BCDecodeKernels& k = GetBCDecodeKernels();
+    size_t blocksH = (rgba.height + 3) / 4;
+    size_t bandCount = (blocksH + kRDOBandBlockRows - 1) / kRDOBandBlockRows;
+    std::vector<BandCounters> counters(bandCount);
+
+    auto band = [&](size_t i)
+        {
+            BandRDO rdo(rgba, dst, params, k);
+            rdo.Run(i * kRDOBandBlockRows, std::min(blocksH, (i + 1) * kRDOBandBlockRows), counters[i]);
+        };
+
+    TileEncodeOptions options = GetDefaultTileEncodeOptions();
+    if (!parallel || bandCount <= 1 || ResolveTileThreads(options) <= 1)
+    {
+        for (size_t i = 0; i < bandCount; ++i)
+            band(i);
+    }
+    else
+    {
+        WorkStealingPool* pool = GetTileEncodePool(options);
+        WorkStealingPool::TaskGroup group;
+        TraceContext traceContext = Trace::GetContext();
+
+        for (size_t i = 0; i < bandCount; ++i)
+        {
+            pool->Submit([&, i]()
+                {
+                    TraceContextScope traceScope(traceContext);
+                    TraceSpan bandSpan("BlockRDOBand");
+                    band(i);
+                }, &group);
+        }
+
+        pool->Wait(&group);
+    }
+
+    BandCounters total;
+    for (const auto& c : counters)
+    {
+        total.segments += c.segments;
+        for (size_t k = 0; k < kCandidateKinds; ++k)
+            total.kinds[k] += c.kinds[k];
+    }
+
+    g_segments.fetch_add(total.segments, std::memory_order_relaxed);
+    g_wholeCopies.fetch_add(total.kinds[WHOLE_COPY], std::memory_order_relaxed);
+    g_indexCopies.fetch_add(total.kinds[INDEX_COPY], std::memory_order_relaxed);
+    g_refits.fetch_add(total.kinds[REFIT], std::memory_order_relaxed);
+    return S_OK;
+}
+
+void GetBlockRDOStats(BlockRDOStats& stats)
+{
+    stats.segments = g_segments.load();
+    stats.wholeCopies = g_wholeCopies.load();
+    stats.indexCopies = g_indexCopies.load();
+    stats.refits = g_refits.load();
+}
+
+void ResetBlockRDOStats()
+{
+    g_segments = 0;
+    g_wholeCopies = 0;
+    g_indexCopies = 0;
+    g_refits = 0;
+}
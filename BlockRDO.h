@@ -0,0 +1,68 @@
+#pragma once
+
+#include <windows.h>
+#include "DirectXTex.h"
+#include <cstddef>
+#include <cstdint>
+
+// -------------------------------------------------------------
+// RDO de bloques BC7/BC3: salida que comprime mejor con LZ.
+//
+// Despues de codificar, cada bloque (en orden de filas) prueba a
+// parecerse a los anteriores: los 'window' bloques previos de la fila
+// y los 3 de encima. Candidatos:
+//
+//   copia entera   el bloque (o la mitad de alfa / color de BC3) igual
+//                  que uno anterior
+//   indices        solo los bytes de indices de uno anterior (BC7 del
+//                  mismo modo), con los extremos propios
+//   reajuste       indices de uno anterior y extremos nuevos por
+//                  minimos cuadrados para esos indices (color y alfa de
+//                  BC3, BC7 modo 6)
+//
+// Se queda con el de menor  J = error cuadratico + lambda * bits, con
+// un coste de LZ aproximado: 8 bits por byte literal, 32 por tramo
+// copiado de un bloque anterior y casi nada si el tramo sigue el del
+// trozo anterior (p.ej. una fila de copias del bloque de encima).
+// lambda 0 desactiva el RDO (salida identica); mas lambda, mas copias
+// y menos PSNR. Las curvas tamano tras LZ / PSNR salen de
+// BenchmarkBlockRDOW.
+//
+// Va por bandas fijas de kRDOBandBlockRows filas de bloques desde la
+// fila 0 (en el pool de CompressTiled): mismo resultado con cualquier
+// numero de hilos o de tiles. Las copias no cruzan bandas, asi que
+// quien codifique la imagen por trozos tiene que cortarla en multiplos
+// de kRDOBandBlockRows para que salga igual que entera.
+// -------------------------------------------------------------
+
+static const unsigned kDefaultRDOWindow = 16;
+static const size_t kRDOBandBlockRows = 16;
+
+struct BlockRDOParams
+{
+    float lambda;           // 0 = desactivado
+    unsigned window;        // bloques previos de la fila a probar
+};
+
+// Para todas las codificaciones BC7/BC3 siguientes
+void SetBlockRDO(const BlockRDOParams& params);
+BlockRDOParams GetBlockRDO();
+
+bool IsBlockRDOFormat(DXGI_FORMAT format);
+
+// 'dst' ya codificado a partir de 'rgba' (RGBA8, mismo tamano)
+HRESULT ApplyBlockRDO(const DirectX::Image& rgba, const DirectX::Image& dst, const BlockRDOParams& params,
+    bool parallel = true);
+
+// Se devuelve al llamador (tambien desde la DLL), solo tipos planos.
+// BC3 cuenta las mitades de alfa y color por separado.
+struct BlockRDOStats
+{
+    uint64_t segments;      // bloques BC7 + mitades BC3 vistos
+    uint64_t wholeCopies;
+    uint64_t indexCopies;
+    uint64_t refits;
+};
+
+void GetBlockRDOStats(BlockRDOStats& stats);
+void ResetBlockRDOStats();
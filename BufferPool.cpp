@@ -0,0 +1,291 @@
+#include "BufferPool.h"
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    const size_t kMinClassBytes = 64 * 1024;
+    const size_t kAlignment = 64;
+
+    struct FreeBuffer
+    {
+        uint8_t* data;
+        bool largePage;
+    };
+
+    std::mutex g_poolLock;
+    std::map<size_t, std::vector<FreeBuffer>> g_free;     // capacidad -> libres
+    BufferPoolStats g_stats = {};
+
+    uint64_t g_maxRetained = 256ull * 1024 * 1024;
+    bool g_useLargePages = false;
+    bool g_largePagesFailed = false;
+
+    // 4 clases por potencia de 2: top + k * top/4
+    size_t ClassSize(size_t bytes)
+    {
+        if (bytes <= kMinClassBytes)
+            return kMinClassBytes;
+
+        size_t top = kMinClassBytes;
+        while (top * 2 < bytes)
+            top *= 2;
+
+        size_t step = top / 4;
+        return (bytes + step - 1) / step * step;
+    }
+
+    // MEM_LARGE_PAGES necesita SeLockMemoryPrivilege activo en el token
+    // del proceso (la cuenta tiene que tenerlo concedido por politica)
+    bool EnableLockMemoryPrivilege()
+    {
+        HANDLE token = nullptr;
+        if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token))
+            return false;
+
+        TOKEN_PRIVILEGES tp = {};
+        tp.PrivilegeCount = 1;
+        tp.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+
+        bool ok = LookupPrivilegeValueW(nullptr, SE_LOCK_MEMORY_NAME, &tp.Privileges[0].Luid)
+            && AdjustTokenPrivileges(token, FALSE, &tp, 0, nullptr, nullptr)
+            && GetLastError() == ERROR_SUCCESS;
+
+        CloseHandle(token);
+        return ok;
+    }
+
+    void FreeToSystem(const FreeBuffer& b)
+    {
+        if (b.largePage)
+            VirtualFree(b.data, 0, MEM_RELEASE);
+        else
+            _aligned_free(b.data);
+    }
+
+    // Con g_poolLock tomado
+    void TrimTo(uint64_t limit)
+    {
+        // Se sueltan primero los mas grandes
+        for (auto it = g_free.rbegin(); it != g_free.rend() && g_stats.bytesRetained > limit; ++it)
+        {
+            while (!it->second.empty() && g_stats.bytesRetained > limit)
+            {
+                FreeToSystem(it->second.back());
+                it->second.pop_back();
+                g_stats.bytesRetained -= it->first;
+                ++g_stats.systemFrees;
+            }
+        }
+    }
+}
+
+PooledBuffer::PooledBuffer(PooledBuffer&& o) noexcept
+    : m_data(o.m_data)
+    , m_capacity(o.m_capacity)
+    , m_largePage(o.m_largePage)
+{
+    o.m_data = nullptr;
+    o.m_capacity = 0;
+    o.m_largePage = false;
+}
+
+PooledBuffer& PooledBuffer::operator=(PooledBuffer&& o) noexcept
+{
+    if (this != &o)
+    {
+        Release();
+        m_data = o.m_data;
+        m_capacity = o.m_capacity;
+        m_largePage = o.m_largePage;
+        o.m_data = nullptr;
+        o.m_capacity = 0;
+        o.m_largePage = false;
+    }
+    return *this;
+}
+
+HRESULT PooledBuffer::Acquire(size_t bytes)
+{
+    Release();
+
+    if (bytes == 0)
+        return E_INVALIDARG;
+
+    size_t capacity = ClassSize(bytes);
+    size_t classCapacity = capacity;
+    bool tryLarge = false;
+
+    {
+        std::lock_guard<std::mutex> lk(g_poolLock);
+
+        ++g_stats.acquires;
+
+        size_t largeMin = (g_useLargePages && !g_largePagesFailed) ? GetLargePageMinimum() : 0;
+        if (largeMin && capacity >= largeMin)
+        {
+            capacity = (capacity + largeMin - 1) / largeMin * largeMin;
+            tryLarge = true;
+        }
+
+        auto it = g_free.find(capacity);
+        if (it != g_free.end() && !it->second.empty())
+        {
+            FreeBuffer b = it->second.back();
+            it->second.pop_back();
+
+            g_stats.bytesRetained -= capacity;
+            g_stats.bytesInUse += capacity;
+            g_stats.peakBytesInUse = std::max(g_stats.peakBytesInUse, g_stats.bytesInUse);
+            ++g_stats.hits;
+
+            m_data = b.data;
+            m_capacity = capacity;
+            m_largePage = b.largePage;
+            return S_OK;
+        }
+    }
+
+    // Fuera del lock: pedir al sistema puede tardar
+    uint8_t* data = nullptr;
+    bool largePage = false;
+
+    if (tryLarge)
+    {
+        data = static_cast<uint8_t*>(VirtualAlloc(nullptr, capacity, MEM_COMMIT | MEM_RESERVE | MEM_LARGE_PAGES, PAGE_READWRITE));
+        largePage = (data != nullptr);
+    }
+
+    // Sin paginas grandes el buffer es de su clase normal, no del
+    // tamano redondeado a pagina grande
+    if (!data)
+    {
+        capacity = classCapacity;
+        data = static_cast<uint8_t*>(_aligned_malloc(capacity, kAlignment));
+    }
+
+    if (!data)
+        return E_OUTOFMEMORY;
+
+    {
+        std::lock_guard<std::mutex> lk(g_poolLock);
+
+        // Sin el privilegio falla siempre: no volver a intentarlo
+        if (tryLarge && !largePage)
+            g_largePagesFailed = true;
+
+        ++g_stats.systemAllocs;
+        if (largePage)
+            ++g_stats.largePageAllocs;
+
+        g_stats.bytesInUse += capacity;
+        g_stats.peakBytesInUse = std::max(g_stats.peakBytesInUse, g_stats.bytesInUse);
+    }
+
+    m_data = data;
+    m_capacity = capacity;
+    m_largePage = largePage;
+    return S_OK;
+}
+
+void PooledBuffer::Release()
+{
+    if (!m_data)
+        return;
+
+    FreeBuffer b = { m_data, m_largePage };
+    bool toSystem = false;
+
+    {
+        std::lock_guard<std::mutex> lk(g_poolLock);
+
+        g_stats.bytesInUse -= m_capacity;
+
+        if (g_stats.bytesRetained + m_capacity <= g_maxRetained)
+        {
+            g_free[m_capacity].push_back(b);
+            g_stats.bytesRetained += m_capacity;
+        }
+        else
+        {
+            ++g_stats.systemFrees;
+            toSystem = true;
+        }
+    }
+
+    if (toSystem)
+        FreeToSystem(b);
+
+    m_data = nullptr;
+    m_capacity = 0;
+    m_largePage = false;
+}
+
+HRESULT PooledImage::Initialize2D(DXGI_FORMAT format, size_t width, size_t height)
+{
+    size_t rowPitch = 0, slicePitch = 0;
+    HRESULT hr = ComputePitch(format, width, height, rowPitch, slicePitch);
+    if (FAILED(hr)) return hr;
+
+    hr = m_buffer.Acquire(slicePitch);
+    if (FAILED(hr)) return hr;
+
+    m_image.width = width;
+    m_image.height = height;
+    m_image.format = format;
+    m_image.rowPitch = rowPitch;
+    m_image.slicePitch = slicePitch;
+    m_image.pixels = m_buffer.Data();
+    return S_OK;
+}
+
+void PooledImage::Release()
+{
+    m_buffer.Release();
+    m_image = Image();
+}
+
+namespace BufferPool
+{
+    void Configure(uint64_t maxRetainedBytes, bool useLargePages)
+    {
+        // Sin el privilegio ni se intenta
+        bool largePages = useLargePages && EnableLockMemoryPrivilege();
+
+        std::lock_guard<std::mutex> lk(g_poolLock);
+
+        g_maxRetained = maxRetainedBytes;
+        g_useLargePages = largePages;
+        g_largePagesFailed = false;
+
+        TrimTo(g_maxRetained);
+    }
+
+    void GetStats(BufferPoolStats& stats)
+    {
+        std::lock_guard<std::mutex> lk(g_poolLock);
+        stats = g_stats;
+    }
+
+    void ResetStats()
+    {
+        std::lock_guard<std::mutex> lk(g_poolLock);
+
+        // Los bytes en uso/retenidos son estado, no contadores
+        BufferPoolStats s = {};
+        s.bytesInUse = g_stats.bytesInUse;
+        s.peakBytesInUse = g_stats.bytesInUse;
+        s.bytesRetained = g_stats.bytesRetained;
+        g_stats = s;
+    }
+
+    void Trim()
+    {
+        std::lock_guard<std::mutex> lk(g_poolLock);
+        TrimTo(0);
+    }
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <windows.h>
+#include "DirectXTex.h"
+#include <cstdint>
+
+// -------------------------------------------------------------
+// Pool de buffers grandes reutilizables entre llamadas.
+//
+// Los tamanos se redondean a clases (4 por potencia de 2, minimo
+// 64 KB) y al soltar un buffer vuelve a la lista libre de su clase
+// en vez de al heap. Todos van alineados a 64 bytes; si se activan
+// las paginas grandes los que pasan de GetLargePageMinimum() se piden
+// con MEM_LARGE_PAGES. Configure activa SeLockMemoryPrivilege en el
+// token; si la cuenta no lo tiene concedido se queda sin ellas.
+//
+// DirectXTex reserva la memoria de ScratchImage por su cuenta, asi
+// que esto solo cubre los buffers intermedios que son nuestros.
+// -------------------------------------------------------------
+
+// Se devuelve al llamador (tambien desde la DLL), solo tipos planos
+struct BufferPoolStats
+{
+    uint64_t acquires;          // peticiones
+    uint64_t hits;              // servidas desde la lista libre
+    uint64_t systemAllocs;      // buffers nuevos pedidos al sistema
+    uint64_t systemFrees;       // devueltos al sistema (por encima del limite)
+    uint64_t largePageAllocs;   // de systemAllocs, con MEM_LARGE_PAGES
+    uint64_t bytesInUse;
+    uint64_t peakBytesInUse;
+    uint64_t bytesRetained;     // en listas libres
+};
+
+class PooledBuffer
+{
+public:
+    PooledBuffer() = default;
+    ~PooledBuffer() { Release(); }
+
+    PooledBuffer(PooledBuffer&& o) noexcept;
+    PooledBuffer& operator=(PooledBuffer&& o) noexcept;
+
+    PooledBuffer(const PooledBuffer&) = delete;
+    PooledBuffer& operator=(const PooledBuffer&) = delete;
+
+    // Suelta el buffer actual y toma uno de al menos 'bytes'
+    HRESULT Acquire(size_t bytes);
+    void Release();
+
+    uint8_t* Data() const { return m_data; }
+    size_t Capacity() const { return m_capacity; }
+
+private:
+    uint8_t* m_data = nullptr;
+    size_t m_capacity = 0;
+    bool m_largePage = false;
+};
+
+// Image 2D (un nivel) sobre un PooledBuffer, con el mismo pitch que
+// daria ScratchImage::Initialize2D
+class PooledImage
+{
+public:
+    HRESULT Initialize2D(DXGI_FORMAT format, size_t width, size_t height);
+    void Release();
+
+    const DirectX::Image& GetImage() const { return m_image; }
+
+private:
+    PooledBuffer m_buffer;
+    DirectX::Image m_image = {};
+};
+
+namespace BufferPool
+{
+    // maxRetainedBytes: lo que se guarda en listas libres como mucho
+    void Configure(uint64_t maxRetainedBytes, bool useLargePages);
+
+    void GetStats(BufferPoolStats& stats);
+    void ResetStats();
+
+    // Devuelve al sistema todo lo que este en listas libres
+    void Trim();
+}
@@ -0,0 +1,335 @@
+#include "ConversionCache.h"
+#include <cstdio>
+#include <cstring>
+#include <cwchar>
+#include <cwctype>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    inline uint64_t Rotl64(uint64_t x, int r)
+    {
+        return (x << r) | (x >> (64 - r));
+    }
+
+    inline uint64_t Mix64(uint64_t x)
+    {
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ULL;
+        x ^= x >> 33;
+        return x;
+    }
+
+    // Hash de 128 bits: dos lanes de 64 bits independientes
+    struct Hasher128
+    {
+        uint64_t h1;
+        uint64_t h2;
+        uint64_t length = 0;
+
+        explicit Hasher128(uint64_t seed)
+            : h1(seed ^ 0x9e3779b97f4a7c15ULL)
+            , h2(Mix64(seed) ^ 0xc2b2ae3d27d4eb4fULL)
+        {
+        }
+
+        void Word(uint64_t w)
+        {
+            h1 = Rotl64(h1 ^ (w * 0x87c37b91114253d5ULL), 31) * 0x4cf5ad432745937fULL;
+            h2 = Rotl64(h2 ^ (w * 0x4cf5ad432745937fULL), 29) * 0x87c37b91114253d5ULL + h1;
+        }
+
+        void Bytes(const uint8_t* p, size_t n)
+        {
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8)
+            {
+                uint64_t w;
+                memcpy(&w, p + i, 8);
+                Word(w);
+            }
+
+            if (i < n)
+            {
+                uint64_t w = 0;
+                memcpy(&w, p + i, n - i);
+                Word(w);
+            }
+
+            length += n;
+        }
+
+        ConversionCache::Key Finish() const
+        {
+            ConversionCache::Key k;
+            k.lo = Mix64(h1 ^ length);
+            k.hi = Mix64(h2 + k.lo);
+            return k;
+        }
+    };
+
+    bool FileExists(const std::wstring& path)
+    {
+        DWORD attr = GetFileAttributesW(path.c_str());
+        return attr != INVALID_FILE_ATTRIBUTES && !(attr & FILE_ATTRIBUTE_DIRECTORY);
+    }
+
+    void CreateDirectoryTree(const std::wstring& dir)
+    {
+        for (size_t pos = dir.find(L'\\', 3); pos != std::wstring::npos; pos = dir.find(L'\\', pos + 1))
+            CreateDirectoryW(dir.substr(0, pos).c_str(), nullptr);
+
+        CreateDirectoryW(dir.c_str(), nullptr);
+    }
+
+    std::wstring KeyToHex(const ConversionCache::Key& key)
+    {
+        wchar_t buf[40];
+        swprintf_s(buf, L"%016llx%016llx", (unsigned long long)key.hi, (unsigned long long)key.lo);
+        return buf;
+    }
+
+    std::mutex g_cachesLock;
+    std::map<std::wstring, std::unique_ptr<ConversionCache>> g_caches;
+}
+
+ConversionCache* ConversionCache::Open(const wchar_t* cacheDir)
+{
+    if (!cacheDir || !*cacheDir)
+        return nullptr;
+
+    std::wstring dir(cacheDir);
+    for (auto& c : dir) if (c == L'/') c = L'\\';
+    while (!dir.empty() && dir.back() == L'\\') dir.pop_back();
+
+    std::wstring id = dir;
+    for (auto& c : id) c = towlower(c);
+
+    std::lock_guard<std::mutex> lk(g_cachesLock);
+
+    auto it = g_caches.find(id);
+    if (it != g_caches.end())
+        return it->second.get();
+
+    CreateDirectoryTree(dir + L"\\objects");
+
+    ConversionCache* cache = new ConversionCache(dir);
+    g_caches[id].reset(cache);
+    return cache;
+}
+
+ConversionCache::ConversionCache(const std::wstring& dir)
+    : m_dir(dir)
+{
+    LoadManifest();
+}
+
+ConversionCache::Key ConversionCache::ComputeKey(const Image& img, uint32_t engineVersion, uint32_t settings)
+{
+    Hasher128 h((uint64_t(engineVersion) << 32) | settings);
+
+    h.Word(img.width);
+    h.Word(img.height);
+    h.Word(uint64_t(img.format));
+
+    // Solo los bytes de pixel de cada fila (sin el relleno del pitch)
+    size_t rowBytes = (img.width * BitsPerPixel(img.format) + 7) / 8;
+    for (size_t y = 0; y < img.height; ++y)
+        h.Bytes(img.pixels + img.rowPitch * y, rowBytes);
+
+    return h.Finish();
+}
+
+bool ConversionCache::GetFileStamp(const wchar_t* path, FileStamp& stamp)
+{
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExW(path, GetFileExInfoStandard, &data))
+        return false;
+
+    stamp.size = (uint64_t(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+    stamp.writeTime = (uint64_t(data.ftLastWriteTime.dwHighDateTime) << 32) | data.ftLastWriteTime.dwLowDateTime;
+    return true;
+}
+
+std::wstring ConversionCache::FileKey(const std::wstring& src, const std::wstring& dst)
+{
+    std::wstring k = src + L"\t" + dst;
+    for (auto& c : k)
+    {
+        if (c == L'/') c = L'\\';
+        c = towlower(c);
+    }
+    return k;
+}
+
+std::wstring ConversionCache::ObjectPath(const Key& key) const
+{
+    return m_dir + L"\\objects\\" + KeyToHex(key) + L".dds";
+}
+
+bool ConversionCache::IsUpToDate(const std::wstring& src, const std::wstring& dst, const FileStamp& stamp,
+    uint32_t engineVersion, uint32_t settings, int& ruleId)
+{
+    std::lock_guard<std::mutex> lk(m_lock);
+
+    auto f = m_files.find(FileKey(src, dst));
+    if (f == m_files.end() || !(f->second.stamp == stamp))
+        return false;
+
+    // Otra version o tabla de reglas: la clave guardada ya no vale
+    if (f->second.engineVersion != engineVersion || f->second.settings != settings)
+        return false;
+
+    auto o = m_objects.find(f->second.key);
+    if (o == m_objects.end() || !FileExists(dst))
+        return false;
+
+    ruleId = o->second;
+    return true;
+}
+
+int ConversionCache::GetOrCreate(const Key& key, const std::function<int(const wchar_t* path)>& encode)
+{
+    std::wstring objectPath = ObjectPath(key);
+    std::shared_ptr<InFlight> flight;
+
+    {
+        std::unique_lock<std::mutex> lk(m_lock);
+
+        auto o = m_objects.find(key);
+        if (o != m_objects.end() && FileExists(objectPath))
+            return o->second;
+
+        // Otro hilo ya esta codificando este mismo contenido
+        auto f = m_inFlight.find(key);
+        if (f != m_inFlight.end())
+        {
+            std::shared_ptr<InFlight> other = f->second;
+            m_encoded.wait(lk, [&]() { return other->done; });
+            return other->result;
+        }
+
+        flight = std::make_shared<InFlight>();
+        m_inFlight[key] = flight;
+    }
+
+    // Escritura atomica: temporal + rename dentro del store
+    wchar_t suffix[32];
+    swprintf_s(suffix, L".%lu.tmp", (unsigned long)GetCurrentProcessId());
+    std::wstring tmpPath = objectPath + suffix;
+
+    int ret = encode(tmpPath.c_str());
+
+    if (ret > 0 && !MoveFileExW(tmpPath.c_str(), objectPath.c_str(), MOVEFILE_REPLACE_EXISTING))
+        ret = HRESULT_FROM_WIN32(GetLastError());
+
+    if (ret <= 0)
+        DeleteFileW(tmpPath.c_str());
+
+    {
+        std::lock_guard<std::mutex> lk(m_lock);
+
+        if (ret > 0)
+        {
+            m_objects[key] = ret;
+
+            wchar_t line[64];
+            swprintf_s(line, L"O %s %d", KeyToHex(key).c_str(), ret);
+            AppendLine(line);
+        }
+
+        flight->done = true;
+        flight->result = ret;
+        m_inFlight.erase(key);
+    }
+
+    m_encoded.notify_all();
+    return ret;
+}
+
+void ConversionCache::RecordFile(const std::wstring& src, const std::wstring& dst, const FileStamp& stamp,
+    uint32_t engineVersion, uint32_t settings, const Key& key)
+{
+    std::lock_guard<std::mutex> lk(m_lock);
+
+    FileEntry& e = m_files[FileKey(src, dst)];
+    e.stamp = stamp;
+    e.engineVersion = engineVersion;
+    e.settings = settings;
+    e.key = key;
+
+    // "v" marca el formato con version y ajustes: las lineas F antiguas
+    // no lo tienen y se ignoran al cargar (se vuelven a comprobar)
+    wchar_t head[128];
+    swprintf_s(head, L"F %s v%x %x %llu %llu ", KeyToHex(key).c_str(), engineVersion, settings,
+        (unsigned long long)stamp.size, (unsigned long long)stamp.writeTime);
+
+    AppendLine(head + src + L"\t" + dst);
+}
+
+void ConversionCache::AppendLine(const std::wstring& line)
+{
+    FILE* f = nullptr;
+    if (_wfopen_s(&f, (m_dir + L"\\manifest.txt").c_str(), L"a, ccs=UTF-8") != 0 || !f)
+        return;
+
+    fwprintf(f, L"%s\n", line.c_str());
+    fclose(f);
+}
+
+void ConversionCache::LoadManifest()
+{
+    FILE* f = nullptr;
+    if (_wfopen_s(&f, (m_dir + L"\\manifest.txt").c_str(), L"r, ccs=UTF-8") != 0 || !f)
+        return;
+
+    std::vector<wchar_t> buf(8192);
+
+    while (fgetws(buf.data(), int(buf.size()), f))
+    {
+        std::wstring line(buf.data());
+        while (!line.empty() && (line.back() == L'\n' || line.back() == L'\r'))
+            line.pop_back();
+
+        unsigned long long hi = 0, lo = 0, size = 0, time = 0;
+        unsigned version = 0, settings = 0;
+        int rule = 0, consumed = 0;
+
+        if (line.size() > 2 && line[0] == L'O')
+        {
+            if (swscanf_s(line.c_str(), L"O %16llx%16llx %d", &hi, &lo, &rule) == 3)
+            {
+                Key k;
+                k.hi = hi;
+                k.lo = lo;
+                m_objects[k] = rule;
+            }
+        }
+        else if (line.size() > 2 && line[0] == L'F')
+        {
+            if (swscanf_s(line.c_str(), L"F %16llx%16llx v%x %x %llu %llu %n", &hi, &lo, &version, &settings, &size, &time,
+                &consumed) == 6 && consumed > 0)
+            {
+                std::wstring paths = line.substr(size_t(consumed));
+                size_t tab = paths.find(L'\t');
+                if (tab == std::wstring::npos)
+                    continue;
+
+                FileEntry e;
+                e.key.hi = hi;
+                e.key.lo = lo;
+                e.engineVersion = version;
+                e.settings = settings;
+                e.stamp.size = size;
+                e.stamp.writeTime = time;
+                m_files[FileKey(paths.substr(0, tab), paths.substr(tab + 1))] = e;
+            }
+        }
+    }
+
+    fclose(f);
+}
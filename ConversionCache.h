@@ -0,0 +1,94 @@
+#pragma once
+
+#include <windows.h>
+#include "DirectXTex.h"
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// -------------------------------------------------------------
+// Cache incremental de conversiones PNG -> DDS.
+//
+// <dir>\manifest.txt       log de entradas (la ultima gana)
+// <dir>\objects\<key>.dds  DDS ya generados, direccionados por contenido
+//
+// La clave es un hash de 128 bits de los pixeles de origen + la
+// version del motor de reglas + los ajustes que afectan al resultado,
+// asi que dos PNG identicos en rutas distintas se codifican una vez.
+// -------------------------------------------------------------
+class ConversionCache
+{
+public:
+    struct Key
+    {
+        uint64_t lo = 0;
+        uint64_t hi = 0;
+
+        bool operator==(const Key& o) const { return lo == o.lo && hi == o.hi; }
+        bool operator<(const Key& o) const { return hi != o.hi ? hi < o.hi : lo < o.lo; }
+    };
+
+    // Tamano + fecha de escritura del archivo de origen
+    struct FileStamp
+    {
+        uint64_t size = 0;
+        uint64_t writeTime = 0;
+
+        bool operator==(const FileStamp& o) const { return size == o.size && writeTime == o.writeTime; }
+    };
+
+    // Instancia compartida por directorio (vive hasta que se descarga la DLL)
+    static ConversionCache* Open(const wchar_t* cacheDir);
+
+    static Key ComputeKey(const DirectX::Image& img, uint32_t engineVersion, uint32_t settings);
+    static bool GetFileStamp(const wchar_t* path, FileStamp& stamp);
+
+    // true si 'dst' ya se genero desde este mismo 'src' sin cambios y con
+    // la misma version y ajustes (los mismos que se pasan a ComputeKey)
+    bool IsUpToDate(const std::wstring& src, const std::wstring& dst, const FileStamp& stamp,
+        uint32_t engineVersion, uint32_t settings, int& ruleId);
+
+    // Devuelve el RuleId del objeto 'key'. Si no existe llama a 'encode'
+    // con una ruta temporal; si otro hilo ya lo esta codificando, espera.
+    // Devuelve un HRESULT (<= 0) si la codificacion falla.
+    int GetOrCreate(const Key& key, const std::function<int(const wchar_t* path)>& encode);
+
+    std::wstring ObjectPath(const Key& key) const;
+
+    void RecordFile(const std::wstring& src, const std::wstring& dst, const FileStamp& stamp,
+        uint32_t engineVersion, uint32_t settings, const Key& key);
+
+private:
+    explicit ConversionCache(const std::wstring& dir);
+
+    struct FileEntry
+    {
+        FileStamp stamp;
+        uint32_t engineVersion = 0;
+        uint32_t settings = 0;
+        Key key;
+    };
+
+    struct InFlight
+    {
+        bool done = false;
+        int result = 0;
+    };
+
+    void LoadManifest();
+    void AppendLine(const std::wstring& line);
+    static std::wstring FileKey(const std::wstring& src, const std::wstring& dst);
+
+    std::wstring m_dir;
+
+    std::mutex m_lock;
+    std::condition_variable m_encoded;
+    std::map<Key, int> m_objects;
+    std::unordered_map<std::wstring, FileEntry> m_files;
+    std::map<Key, std::shared_ptr<InFlight>> m_inFlight;
+};
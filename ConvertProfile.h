@@ -0,0 +1,30 @@
+#pragma once
+
+#include <windows.h>
+#include <cstdint>
+
+// -------------------------------------------------------------
+// Tiempos de una conversion ConvertPNGtoDDSW, por etapa (ms).
+//
+// decode:   LoadFromWICFile o el decodificador PNG propio (SetPNGDecoderW)
+// analysis: eleccion de regla (incluye ImageFeatures si se calcula)
+// convert:  paso a RGBA8 (sin copia si ya lo es)
+// encode:   compresion BC (0 si la regla guarda sin comprimir)
+// save:     cabecera, copia al archivo y cierre/renombrado
+//
+// Se devuelve al llamador (tambien desde la DLL), solo tipos planos
+// -------------------------------------------------------------
+struct ConvertProfile
+{
+    double   decodeMs;
+    double   analysisMs;
+    double   convertMs;
+    double   encodeMs;
+    double   saveMs;
+    int32_t  ruleId;        // 0 si fallo
+    uint32_t width;
+    uint32_t height;
+};
+
+// Lo mismo que ConvertPNGtoDDSW, llenando 'profile' (puede ser null)
+extern "C" int __stdcall ConvertPNGtoDDSProfiledW(const wchar_t* src, const wchar_t* dst, ConvertProfile* profile);
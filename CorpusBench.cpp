@@ -0,0 +1,674 @@
+#include <windows.h>
+#include <psapi.h>
+#include "DirectXTex.h"
+#include "ConvertProfile.h"
+#include "BlockCache.h"
+#include "BCDecoder.h"
+#include "BufferPool.h"
+#include "ImageKernels.h"
+#include "ImageQuality.h"
+#include "PngDecoder.h"
+#include "TextureEncode.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace DirectX;
+
+// -------------------------------------------------------------
+// Benchmark de la conversion completa (ConvertPNGtoDDSW) sobre un
+// corpus de PNG, con el tiempo de cada etapa por archivo y por regla.
+//
+// uso: CorpusBench [corpusDir] [report.json] [repeat] [decoder] [blockCache]
+//   corpusDir    por defecto el directorio actual (1.png ... 11.png,
+//                static.png y Symbol.png del repo)
+//   report.json  por defecto corpus_bench.json
+//   repeat       conversiones por archivo (1); se guarda la mas rapida
+//   decoder      wic (por defecto) o builtin (ver SetPNGDecoderW)
+//   blockCache   sin cache de bloques si no se pasa; '-' = solo en
+//                memoria; si no, archivo que se carga al empezar y se
+//                guarda al terminar (ver BlockCache.h)
+//
+// Los DDS van a %TEMP%\CorpusBench. El JSON tiene la misma forma en
+// todas las ejecuciones para poder compararlas.
+//
+// uso: CorpusBench -decode [corpusDir] [report.json] [repeat]
+//   Solo la decodificacion, desde memoria: WIC contra el decodificador
+//   PNG propio, con MP/s, MB/s y si los pixeles salen iguales.
+//   report.json por defecto decode_bench.json
+//
+// uso: CorpusBench -verify srcDir ddsDir [report.txt] [minPsnr]
+//   Ida y vuelta de un arbol ya convertido (VerifyDDSDirectoryW): cada
+//   DDS decodificado contra su PNG, con PSNR/SSIM por archivo.
+//   report.txt por defecto verify_report.txt; minPsnr 0 = sin minimo
+// -------------------------------------------------------------
+
+namespace
+{
+    struct FileResult
+    {
+        std::wstring file;          // relativo al corpus
+        int result = 0;             // RuleId o HRESULT
+        ConvertProfile profile = {};
+        double wallMs = 0.0;
+        uint64_t inputBytes = 0;
+        uint64_t outputBytes = 0;
+        uint64_t poolPeakBytes = 0;
+        uint64_t processPeakWorkingSetBytes = 0;    // maximo del proceso hasta este archivo
+        int64_t workingSetDeltaBytes = 0;           // working set despues - antes
+    };
+
+    struct Totals
+    {
+        uint32_t files = 0;
+        double megapixels = 0.0;
+        double decodeMs = 0.0;
+        double analysisMs = 0.0;
+        double convertMs = 0.0;
+        double encodeMs = 0.0;
+        double saveMs = 0.0;
+        double wallMs = 0.0;
+        uint64_t inputBytes = 0;
+        uint64_t outputBytes = 0;
+        uint64_t poolPeakBytes = 0;
+
+        void Add(const FileResult& r)
+        {
+            ++files;
+            megapixels += double(r.profile.width) * double(r.profile.height) / 1e6;
+            decodeMs += r.profile.decodeMs;
+            analysisMs += r.profile.analysisMs;
+            convertMs += r.profile.convertMs;
+            encodeMs += r.profile.encodeMs;
+            saveMs += r.profile.saveMs;
+            wallMs += r.wallMs;
+            inputBytes += r.inputBytes;
+            outputBytes += r.outputBytes;
+            poolPeakBytes = std::max(poolPeakBytes, r.poolPeakBytes);
+        }
+    };
+
+    double NowMs()
+    {
+        LARGE_INTEGER t, f;
+        QueryPerformanceCounter(&t);
+        QueryPerformanceFrequency(&f);
+        return double(t.QuadPart) * 1000.0 / double(f.QuadPart);
+    }
+
+    uint64_t GetFileBytes(const std::wstring& path)
+    {
+        WIN32_FILE_ATTRIBUTE_DATA data;
+        if (!GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &data))
+            return 0;
+
+        return (uint64_t(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+    }
+
+    uint64_t GetWorkingSet()
+    {
+        PROCESS_MEMORY_COUNTERS pmc = {};
+        pmc.cb = sizeof(pmc);
+
+        if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+            return 0;
+
+        return pmc.WorkingSetSize;
+    }
+
+    // Maximos de todo el proceso (no bajan nunca)
+    void GetPeakMemory(uint64_t& workingSet, uint64_t& commit)
+    {
+        PROCESS_MEMORY_COUNTERS pmc = {};
+        pmc.cb = sizeof(pmc);
+
+        workingSet = 0;
+        commit = 0;
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        {
+            workingSet = pmc.PeakWorkingSetSize;
+            commit = pmc.PeakPagefileUsage;
+        }
+    }
+
+    // *.png bajo 'root' (recursivo, rutas relativas, ordenadas)
+    void ListPngFiles(const std::wstring& root, const std::wstring& rel, std::vector<std::wstring>& out)
+    {
+        std::wstring pattern = root + L"\\" + (rel.empty() ? L"" : rel + L"\\") + L"*";
+
+        WIN32_FIND_DATAW fd;
+        HANDLE h = FindFirstFileW(pattern.c_str(), &fd);
+        if (h == INVALID_HANDLE_VALUE)
+            return;
+
+        do
+        {
+            std::wstring name = fd.cFileName;
+            if (name == L"." || name == L"..")
+                continue;
+
+            std::wstring path = rel.empty() ? name : rel + L"\\" + name;
+
+            if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            {
+                ListPngFiles(root, path, out);
+            }
+            else if (name.size() > 4 && _wcsicmp(name.c_str() + name.size() - 4, L".png") == 0)
+            {
+                out.push_back(path);
+            }
+        } while (FindNextFileW(h, &fd));
+
+        FindClose(h);
+        std::sort(out.begin(), out.end());
+    }
+
+    std::string Utf8(const std::wstring& s)
+    {
+        if (s.empty())
+            return std::string();
+
+        int n = WideCharToMultiByte(CP_UTF8, 0, s.c_str(), int(s.size()), nullptr, 0, nullptr, nullptr);
+        std::string out(size_t(n), '\0');
+        WideCharToMultiByte(CP_UTF8, 0, s.c_str(), int(s.size()), &out[0], n, nullptr, nullptr);
+        return out;
+    }
+
+    // Cadena JSON con comillas
+    std::string JsonString(const std::wstring& s)
+    {
+        std::string out = "\"";
+        for (char c : Utf8(s))
+        {
+            if (c == '"' || c == '\\')
+                out += '\\';
+            out += c;
+        }
+        return out + "\"";
+    }
+
+    bool ReadFileBytes(const std::wstring& path, std::vector<uint8_t>& data)
+    {
+        FILE* f = nullptr;
+        if (_wfopen_s(&f, path.c_str(), L"rb") != 0 || !f)
+            return false;
+
+        data.clear();
+        uint8_t chunk[65536];
+        size_t n;
+        while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0)
+            data.insert(data.end(), chunk, chunk + n);
+
+        fclose(f);
+        return !data.empty();
+    }
+
+    bool SamePixels(const ScratchImage& a, const ScratchImage& b)
+    {
+        const Image* ia = a.GetImage(0, 0, 0);
+        const Image* ib = b.GetImage(0, 0, 0);
+        if (!ia || !ib || ia->format != ib->format || ia->width != ib->width || ia->height != ib->height)
+            return false;
+
+        size_t rowBytes = std::min(ia->rowPitch, ib->rowPitch);
+        for (size_t y = 0; y < ia->height; ++y)
+        {
+            if (memcmp(ia->pixels + y * ia->rowPitch, ib->pixels + y * ib->rowPitch, rowBytes) != 0)
+                return false;
+        }
+        return true;
+    }
+
+    struct DecodeResult
+    {
+        std::wstring file;
+        HRESULT wicResult = S_OK;
+        HRESULT builtinResult = S_OK;
+        double wicMs = 0.0;             // la mas rapida de 'repeat'
+        double builtinMs = 0.0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint64_t inputBytes = 0;
+        bool samePixels = false;
+    };
+
+    // Decodifica 'repeat' veces con cada decodificador y guarda la mas rapida
+    DecodeResult BenchDecode(const std::wstring& file, const std::vector<uint8_t>& data, int repeat)
+    {
+        DecodeResult r;
+        r.file = file;
+        r.inputBytes = data.size();
+
+        ScratchImage wic;
+        ScratchImage builtin;
+        TexMetadata meta;
+
+        for (int i = 0; i < repeat; ++i)
+        {
+            double t0 = NowMs();
+            r.wicResult = LoadFromWICMemory(data.data(), data.size(), WIC_FLAGS_IGNORE_SRGB, &meta, wic);
+            double t1 = NowMs();
+            r.builtinResult = LoadPNGFromMemory(data.data(), data.size(), true, &meta, builtin);
+            double t2 = NowMs();
+
+            if (i == 0 || t1 - t0 < r.wicMs)
+                r.wicMs = t1 - t0;
+            if (i == 0 || t2 - t1 < r.builtinMs)
+                r.builtinMs = t2 - t1;
+        }
+
+        if (SUCCEEDED(r.builtinResult))
+        {
+            r.width = uint32_t(meta.width);
+            r.height = uint32_t(meta.height);
+        }
+
+        r.samePixels = SUCCEEDED(r.wicResult) && SUCCEEDED(r.builtinResult) && SamePixels(wic, builtin);
+        return r;
+    }
+
+    int RunDecodeBench(const std::wstring& corpus, const std::wstring& reportPath, int repeat)
+    {
+        std::vector<std::wstring> files;
+        ListPngFiles(corpus, L"", files);
+        if (files.empty())
+        {
+            fwprintf(stderr, L"No .png files under %s\n", corpus.c_str());
+            return 1;
+        }
+
+        std::vector<DecodeResult> results;
+        uint32_t failures = 0;
+        uint32_t mismatches = 0;
+        double megapixels = 0.0, wicMs = 0.0, builtinMs = 0.0;
+        uint64_t inputBytes = 0;
+
+        for (const auto& file : files)
+        {
+            std::vector<uint8_t> data;
+            if (!ReadFileBytes(corpus + L"\\" + file, data))
+            {
+                fwprintf(stderr, L"Cannot read %s\n", file.c_str());
+                ++failures;
+                continue;
+            }
+
+            DecodeResult r = BenchDecode(file, data, repeat);
+            if (FAILED(r.wicResult) || FAILED(r.builtinResult))
+            {
+                ++failures;
+            }
+            else
+            {
+                megapixels += double(r.width) * double(r.height) / 1e6;
+                wicMs += r.wicMs;
+                builtinMs += r.builtinMs;
+                inputBytes += r.inputBytes;
+                if (!r.samePixels)
+                    ++mismatches;
+            }
+
+            wprintf(L"%-40s wic %8.3f ms  builtin %8.3f ms  %s\n", file.c_str(), r.wicMs, r.builtinMs,
+                r.samePixels ? L"same" : L"DIFFERENT");
+            results.push_back(r);
+        }
+
+        FILE* f = nullptr;
+        if (_wfopen_s(&f, reportPath.c_str(), L"wb") != 0 || !f)
+        {
+            fwprintf(stderr, L"Cannot write %s\n", reportPath.c_str());
+            return 1;
+        }
+
+        auto perSec = [](double amount, double ms) { return ms > 0.0 ? amount * 1000.0 / ms : 0.0; };
+
+        fprintf(f, "{\n");
+        fprintf(f, "  \"corpus\": %s,\n", JsonString(corpus).c_str());
+        fprintf(f, "  \"repeat\": %d,\n", repeat);
+        fprintf(f, "  \"kernelLevel\": %d,\n", int(GetPngUnfilterKernels().level));
+        fprintf(f, "  \"failures\": %u,\n", failures);
+        fprintf(f, "  \"mismatches\": %u,\n", mismatches);
+
+        fprintf(f, "  \"files\": [\n");
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const DecodeResult& r = results[i];
+            double mp = double(r.width) * double(r.height) / 1e6;
+            double mb = double(r.inputBytes) / 1e6;
+
+            fprintf(f, "    {\n");
+            fprintf(f, "      \"file\": %s,\n", JsonString(r.file).c_str());
+            fprintf(f, "      \"wicResult\": %d,\n", int(r.wicResult));
+            fprintf(f, "      \"builtinResult\": %d,\n", int(r.builtinResult));
+            fprintf(f, "      \"width\": %u,\n", r.width);
+            fprintf(f, "      \"height\": %u,\n", r.height);
+            fprintf(f, "      \"inputBytes\": %llu,\n", (unsigned long long)r.inputBytes);
+            fprintf(f, "      \"wicMs\": %.3f,\n", r.wicMs);
+            fprintf(f, "      \"builtinMs\": %.3f,\n", r.builtinMs);
+            fprintf(f, "      \"wicMegapixelsPerSec\": %.3f,\n", perSec(mp, r.wicMs));
+            fprintf(f, "      \"builtinMegapixelsPerSec\": %.3f,\n", perSec(mp, r.builtinMs));
+            fprintf(f, "      \"wicInputMBPerSec\": %.3f,\n", perSec(mb, r.wicMs));
+            fprintf(f, "      \"builtinInputMBPerSec\": %.3f,\n", perSec(mb, r.builtinMs));
+            fprintf(f, "      \"samePixels\": %s\n", r.samePixels ? "true" : "false");
+            fprintf(f, "    }%s\n", (i + 1 < results.size()) ? "," : "");
+        }
+        fprintf(f, "  ],\n");
+
+        double mb = double(inputBytes) / 1e6;
+        fprintf(f, "  \"total\": {\n");
+        fprintf(f, "    \"megapixels\": %.4f,\n", megapixels);
+        fprintf(f, "    \"inputBytes\": %llu,\n", (unsigned long long)inputBytes);
+        fprintf(f, "    \"wicMs\": %.3f,\n", wicMs);
+        fprintf(f, "    \"builtinMs\": %.3f,\n", builtinMs);
+        fprintf(f, "    \"wicMegapixelsPerSec\": %.3f,\n", perSec(megapixels, wicMs));
+        fprintf(f, "    \"builtinMegapixelsPerSec\": %.3f,\n", perSec(megapixels, builtinMs));
+        fprintf(f, "    \"wicInputMBPerSec\": %.3f,\n", perSec(mb, wicMs));
+        fprintf(f, "    \"builtinInputMBPerSec\": %.3f\n", perSec(mb, builtinMs));
+        fprintf(f, "  }\n");
+        fprintf(f, "}\n");
+        fclose(f);
+
+        wprintf(L"%.2f MP: wic %.1f ms (%.2f MP/s), builtin %.1f ms (%.2f MP/s), %u different, %u failed -> %s\n",
+            megapixels, wicMs, perSec(megapixels, wicMs), builtinMs, perSec(megapixels, builtinMs),
+            mismatches, failures, reportPath.c_str());
+
+        return (failures || mismatches) ? 2 : 0;
+    }
+
+    int RunVerify(const std::wstring& srcDir, const std::wstring& ddsDir, const std::wstring& reportPath, double minPsnr)
+    {
+        unsigned count = 0;
+        HRESULT hr = VerifyDDSDirectoryW(srcDir.c_str(), ddsDir.c_str(), 0, minPsnr, nullptr, nullptr, 0, &count);
+        if (FAILED(hr) || count == 0)
+        {
+            fwprintf(stderr, L"No .png files under %s\n", srcDir.c_str());
+            return 1;
+        }
+
+        std::vector<VerifyDDSResult> results(count);
+
+        double t0 = NowMs();
+        hr = VerifyDDSDirectoryW(srcDir.c_str(), ddsDir.c_str(), 0, minPsnr, reportPath.c_str(), results.data(), count, &count);
+        double wallMs = NowMs() - t0;
+
+        if (FAILED(hr))
+        {
+            fwprintf(stderr, L"VerifyDDSDirectoryW failed 0x%08X\n", unsigned(hr));
+            return 1;
+        }
+
+        unsigned failures = 0;
+        double worst = kMaxPSNR;
+        std::wstring worstFile;
+
+        for (const auto& r : results)
+        {
+            if (FAILED(r.hr))
+            {
+                ++failures;
+                wprintf(L"%-40s FAILED 0x%08X\n", r.source, unsigned(r.hr));
+            }
+            else if (r.psnr < worst)
+            {
+                worst = r.psnr;
+                worstFile = r.source;
+            }
+        }
+
+        wprintf(L"%u files in %.1f ms, %u failed, worst %.2f dB (%s) -> %s\n", count, wallMs, failures, worst,
+            worstFile.c_str(), reportPath.c_str());
+
+        return (hr == S_OK) ? 0 : 2;
+    }
+
+    void WriteTotals(FILE* f, const Totals& t, const char* indent)
+    {
+        double seconds = t.wallMs / 1000.0;
+
+        fprintf(f, "%s\"files\": %u,\n", indent, t.files);
+        fprintf(f, "%s\"megapixels\": %.4f,\n", indent, t.megapixels);
+        fprintf(f, "%s\"decodeMs\": %.3f,\n", indent, t.decodeMs);
+        fprintf(f, "%s\"analysisMs\": %.3f,\n", indent, t.analysisMs);
+        fprintf(f, "%s\"convertMs\": %.3f,\n", indent, t.convertMs);
+        fprintf(f, "%s\"encodeMs\": %.3f,\n", indent, t.encodeMs);
+        fprintf(f, "%s\"saveMs\": %.3f,\n", indent, t.saveMs);
+        fprintf(f, "%s\"wallMs\": %.3f,\n", indent, t.wallMs);
+        fprintf(f, "%s\"megapixelsPerSec\": %.3f,\n", indent, seconds > 0.0 ? t.megapixels / seconds : 0.0);
+        fprintf(f, "%s\"inputBytes\": %llu,\n", indent, (unsigned long long)t.inputBytes);
+        fprintf(f, "%s\"outputBytes\": %llu,\n", indent, (unsigned long long)t.outputBytes);
+        fprintf(f, "%s\"poolPeakBytes\": %llu\n", indent, (unsigned long long)t.poolPeakBytes);
+    }
+}
+
+int wmain(int argc, wchar_t** argv)
+{
+    if (argc > 3 && wcscmp(argv[1], L"-verify") == 0)
+    {
+        std::wstring reportPath = (argc > 4) ? argv[4] : L"verify_report.txt";
+        double minPsnr = (argc > 5) ? _wtof(argv[5]) : 0.0;
+
+        HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+        if (FAILED(hr))
+        {
+            fwprintf(stderr, L"CoInitializeEx failed 0x%08X\n", unsigned(hr));
+            return 1;
+        }
+
+        int rc = RunVerify(argv[2], argv[3], reportPath, minPsnr);
+        CoUninitialize();
+        return rc;
+    }
+
+    bool decodeOnly = (argc > 1 && wcscmp(argv[1], L"-decode") == 0);
+    if (decodeOnly)
+    {
+        --argc;
+        ++argv;
+    }
+
+    std::wstring corpus = (argc > 1) ? argv[1] : L".";
+    std::wstring reportPath = (argc > 2) ? argv[2] : (decodeOnly ? L"decode_bench.json" : L"corpus_bench.json");
+    int repeat = (argc > 3) ? std::max(1, _wtoi(argv[3])) : 1;
+    bool builtinDecoder = (argc > 4) && _wcsicmp(argv[4], L"builtin") == 0;
+    std::wstring blockCachePath = (argc > 5) ? argv[5] : L"";
+
+    HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+    if (FAILED(hr))
+    {
+        fwprintf(stderr, L"CoInitializeEx failed 0x%08X\n", unsigned(hr));
+        return 1;
+    }
+
+    if (decodeOnly)
+    {
+        int rc = RunDecodeBench(corpus, reportPath, repeat);
+        CoUninitialize();
+        return rc;
+    }
+
+    SetPNGDecoderW(builtinDecoder ? PNG_DECODER_BUILTIN : PNG_DECODER_WIC);
+
+    // Unos 130 MB como mucho
+    bool blockCache = !blockCachePath.empty();
+    bool blockCacheFile = blockCache && blockCachePath != L"-";
+    if (blockCache)
+        BlockCache::Configure(uint64_t(1) << 20);
+    if (blockCacheFile)
+        BlockCache::Load(blockCachePath.c_str());
+
+    std::vector<std::wstring> files;
+    ListPngFiles(corpus, L"", files);
+    if (files.empty())
+    {
+        fwprintf(stderr, L"No .png files under %s\n", corpus.c_str());
+        return 1;
+    }
+
+    wchar_t tmp[MAX_PATH];
+    GetTempPathW(MAX_PATH, tmp);
+    std::wstring outDir = std::wstring(tmp) + L"CorpusBench";
+    CreateDirectoryW(outDir.c_str(), nullptr);
+
+    std::vector<FileResult> results;
+
+    for (const auto& file : files)
+    {
+        std::wstring src = corpus + L"\\" + file;
+
+        std::wstring flat = file;
+        std::replace(flat.begin(), flat.end(), L'\\', L'_');
+        std::wstring dst = outDir + L"\\" + flat + L".dds";
+
+        FileResult best;
+        for (int i = 0; i < repeat; ++i)
+        {
+            FileResult r;
+            r.file = file;
+
+            BufferPool::ResetStats();
+            uint64_t workingSet0 = GetWorkingSet();
+
+            double t0 = NowMs();
+            r.result = ConvertPNGtoDDSProfiledW(src.c_str(), dst.c_str(), &r.profile);
+            r.wallMs = NowMs() - t0;
+
+            BufferPoolStats pool;
+            BufferPool::GetStats(pool);
+            r.poolPeakBytes = pool.peakBytesInUse;
+
+            r.workingSetDeltaBytes = int64_t(GetWorkingSet()) - int64_t(workingSet0);
+
+            uint64_t commit;
+            GetPeakMemory(r.processPeakWorkingSetBytes, commit);
+
+            if (i == 0 || r.wallMs < best.wallMs)
+                best = r;
+        }
+
+        best.inputBytes = GetFileBytes(src);
+        best.outputBytes = (best.result > 0) ? GetFileBytes(dst) : 0;
+
+        wprintf(L"%-40s rule %3d  %9.2f ms\n", file.c_str(), best.result > 0 ? best.result : 0, best.wallMs);
+        results.push_back(best);
+    }
+
+    // Totales por regla y de todo el corpus (solo conversiones correctas)
+    std::map<int, Totals> byRule;
+    Totals total;
+    uint32_t failures = 0;
+
+    for (const auto& r : results)
+    {
+        if (r.result <= 0)
+        {
+            ++failures;
+            continue;
+        }
+
+        byRule[r.result].Add(r);
+        total.Add(r);
+    }
+
+    FILE* f = nullptr;
+    if (_wfopen_s(&f, reportPath.c_str(), L"wb") != 0 || !f)
+    {
+        fwprintf(stderr, L"Cannot write %s\n", reportPath.c_str());
+        return 1;
+    }
+
+    uint64_t peakWorkingSet, peakCommit;
+    GetPeakMemory(peakWorkingSet, peakCommit);
+
+    BlockCacheStats cache;
+    BlockCache::GetStats(cache);
+    if (blockCacheFile)
+        BlockCache::Save(blockCachePath.c_str());
+
+    fprintf(f, "{\n");
+    fprintf(f, "  \"corpus\": %s,\n", JsonString(corpus).c_str());
+    fprintf(f, "  \"repeat\": %d,\n", repeat);
+    fprintf(f, "  \"decoder\": \"%s\",\n", builtinDecoder ? "builtin" : "wic");
+    fprintf(f, "  \"threads\": %u,\n", ResolveTileThreads(GetDefaultTileEncodeOptions()));
+    fprintf(f, "  \"kernelLevel\": %d,\n", int(DetectKernelLevel()));
+    fprintf(f, "  \"peakWorkingSetBytes\": %llu,\n", (unsigned long long)peakWorkingSet);
+    fprintf(f, "  \"peakCommitBytes\": %llu,\n", (unsigned long long)peakCommit);
+    fprintf(f, "  \"failures\": %u,\n", failures);
+
+    fprintf(f, "  \"blockCache\": {\n");
+    fprintf(f, "    \"enabled\": %s,\n", blockCache ? "true" : "false");
+    fprintf(f, "    \"lookups\": %llu,\n", (unsigned long long)cache.lookups);
+    fprintf(f, "    \"hits\": %llu,\n", (unsigned long long)cache.hits);
+    fprintf(f, "    \"hitRate\": %.4f,\n", cache.lookups ? double(cache.hits) / double(cache.lookups) : 0.0);
+    fprintf(f, "    \"entries\": %llu,\n", (unsigned long long)cache.entries);
+    fprintf(f, "    \"encodedBlocks\": %llu,\n", (unsigned long long)cache.encodedBlocks);
+    fprintf(f, "    \"encodeMs\": %.3f,\n", cache.encodeMs);
+    fprintf(f, "    \"lookupMs\": %.3f,\n", cache.lookupMs);
+    fprintf(f, "    \"savedMs\": %.3f\n", cache.savedMs);
+    fprintf(f, "  },\n");
+
+    fprintf(f, "  \"files\": [\n");
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const FileResult& r = results[i];
+        const ConvertProfile& p = r.profile;
+        double megapixels = double(p.width) * double(p.height) / 1e6;
+
+        fprintf(f, "    {\n");
+        fprintf(f, "      \"file\": %s,\n", JsonString(r.file).c_str());
+        fprintf(f, "      \"result\": %d,\n", r.result);
+        fprintf(f, "      \"rule\": %d,\n", p.ruleId);
+        fprintf(f, "      \"width\": %u,\n", p.width);
+        fprintf(f, "      \"height\": %u,\n", p.height);
+        fprintf(f, "      \"decodeMs\": %.3f,\n", p.decodeMs);
+        fprintf(f, "      \"analysisMs\": %.3f,\n", p.analysisMs);
+        fprintf(f, "      \"convertMs\": %.3f,\n", p.convertMs);
+        fprintf(f, "      \"encodeMs\": %.3f,\n", p.encodeMs);
+        fprintf(f, "      \"saveMs\": %.3f,\n", p.saveMs);
+        fprintf(f, "      \"wallMs\": %.3f,\n", r.wallMs);
+        fprintf(f, "      \"megapixelsPerSec\": %.3f,\n", r.wallMs > 0.0 ? megapixels * 1000.0 / r.wallMs : 0.0);
+        fprintf(f, "      \"inputBytes\": %llu,\n", (unsigned long long)r.inputBytes);
+        fprintf(f, "      \"outputBytes\": %llu,\n", (unsigned long long)r.outputBytes);
+        fprintf(f, "      \"poolPeakBytes\": %llu,\n", (unsigned long long)r.poolPeakBytes);
+        fprintf(f, "      \"processPeakWorkingSetBytes\": %llu,\n", (unsigned long long)r.processPeakWorkingSetBytes);
+        fprintf(f, "      \"workingSetDeltaBytes\": %lld\n", (long long)r.workingSetDeltaBytes);
+        fprintf(f, "    }%s\n", (i + 1 < results.size()) ? "," : "");
+    }
+    fprintf(f, "  ],\n");
+
+    fprintf(f, "  \"rules\": [\n");
+    size_t n = 0;
+    for (const auto& it : byRule)
+    {
+        fprintf(f, "    {\n");
+        fprintf(f, "      \"rule\": %d,\n", it.first);
+        WriteTotals(f, it.second, "      ");
+        fprintf(f, "    }%s\n", (++n < byRule.size()) ? "," : "");
+    }
+    fprintf(f, "  ],\n");
+
+    fprintf(f, "  \"total\": {\n");
+    WriteTotals(f, total, "    ");
+    fprintf(f, "  }\n");
+    fprintf(f, "}\n");
+
+    fclose(f);
+
+    wprintf(L"%u files, %.2f MP in %.1f ms (%.2f MP/s), %u failed -> %s\n",
+        total.files, total.megapixels, total.wallMs,
+        total.wallMs > 0.0 ? total.megapixels * 1000.0 / total.wallMs : 0.0,
+        failures, reportPath.c_str());
+
+    if (blockCache)
+    {
+        wprintf(L"block cache: %llu/%llu hits (%.1f%%), ~%.1f ms saved, %llu entries\n",
+            (unsigned long long)cache.hits, (unsigned long long)cache.lookups,
+            cache.lookups ? 100.0 * double(cache.hits) / double(cache.lookups) : 0.0,
+            cache.savedMs, (unsigned long long)cache.entries);
+    }
+
+    CoUninitialize();
+    return failures ? 2 : 0;
+}
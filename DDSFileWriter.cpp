@@ -0,0 +1,138 @@
+#include "DDSFileWriter.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cstring>
+#include <cwchar>
+
+using namespace DirectX;
+
+DDSFileWriter::~DDSFileWriter()
+{
+    if (m_file != INVALID_HANDLE_VALUE)
+    {
+        Close();
+        DeleteFileW(m_tmpPath.c_str());
+    }
+}
+
+void DDSFileWriter::Close()
+{
+    if (m_view) { UnmapViewOfFile(m_view); m_view = nullptr; }
+    if (m_mapping) { CloseHandle(m_mapping); m_mapping = nullptr; }
+    if (m_file != INVALID_HANDLE_VALUE) { CloseHandle(m_file); m_file = INVALID_HANDLE_VALUE; }
+
+    m_surfaces.clear();
+}
+
+HRESULT DDSFileWriter::Begin(const wchar_t* path, DXGI_FORMAT format, size_t width, size_t height, size_t mipLevels)
+{
+    if (m_file != INVALID_HANDLE_VALUE || !path || !width || !height || !mipLevels)
+        return E_INVALIDARG;
+
+    TraceSpan span("DDSFileWriter::Begin");
+
+    // Misma cabecera que SaveToDDSFile(const Image&)
+    TexMetadata meta = {};
+    meta.width = width;
+    meta.height = height;
+    meta.depth = 1;
+    meta.arraySize = 1;
+    meta.mipLevels = mipLevels;
+    meta.format = format;
+    meta.dimension = TEX_DIMENSION_TEXTURE2D;
+
+    size_t headerSize = 0;
+    HRESULT hr = EncodeDDSHeader(meta, DDS_FLAGS_NONE, nullptr, 0, headerSize);
+    if (FAILED(hr)) return hr;
+
+    // Superficies de cada nivel (los punteros se fijan al mapear)
+    std::vector<Image> surfaces(mipLevels);
+    uint64_t fileSize = headerSize;
+
+    for (size_t level = 0; level < mipLevels; ++level)
+    {
+        Image& surface = surfaces[level];
+        surface.width = std::max<size_t>(1, width >> level);
+        surface.height = std::max<size_t>(1, height >> level);
+        surface.format = format;
+
+        hr = ComputePitch(format, surface.width, surface.height, surface.rowPitch, surface.slicePitch);
+        if (FAILED(hr)) return hr;
+
+        fileSize += surface.slicePitch;
+    }
+
+    // Temporal unico por proceso e hilo (la cache y los lotes pueden
+    // escribir el mismo destino a la vez)
+    wchar_t suffix[48];
+    swprintf_s(suffix, L".%lu.%lu.tmp", (unsigned long)GetCurrentProcessId(), (unsigned long)GetCurrentThreadId());
+    m_path = path;
+    m_tmpPath = m_path + suffix;
+
+    m_file = CreateFileW(m_tmpPath.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_file == INVALID_HANDLE_VALUE)
+        return HRESULT_FROM_WIN32(GetLastError());
+
+    // El mapping fija el tamano del archivo
+    m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READWRITE, DWORD(fileSize >> 32), DWORD(fileSize), nullptr);
+    if (!m_mapping)
+        return HRESULT_FROM_WIN32(GetLastError());
+
+    m_view = static_cast<uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_WRITE, 0, 0, size_t(fileSize)));
+    if (!m_view)
+        return HRESULT_FROM_WIN32(GetLastError());
+
+    hr = EncodeDDSHeader(meta, DDS_FLAGS_NONE, m_view, headerSize, headerSize);
+    if (FAILED(hr)) return hr;
+
+    uint8_t* pixels = m_view + headerSize;
+    for (Image& surface : surfaces)
+    {
+        surface.pixels = pixels;
+        pixels += surface.slicePitch;
+    }
+
+    m_surfaces = std::move(surfaces);
+    return S_OK;
+}
+
+HRESULT DDSFileWriter::Commit()
+{
+    if (m_file == INVALID_HANDLE_VALUE)
+        return E_UNEXPECTED;
+
+    TraceSpan span("DDSFileWriter::Commit");
+    Close();
+
+    if (!MoveFileExW(m_tmpPath.c_str(), m_path.c_str(), MOVEFILE_REPLACE_EXISTING))
+    {
+        HRESULT hr = HRESULT_FROM_WIN32(GetLastError());
+        DeleteFileW(m_tmpPath.c_str());
+        return hr;
+    }
+
+    return S_OK;
+}
+
+HRESULT SaveImageToDDSFile(const Image& img, const wchar_t* path)
+{
+    if (!img.pixels)
+        return E_INVALIDARG;
+
+    TraceSpan span("SaveImageToDDSFile");
+
+    DDSFileWriter writer;
+    HRESULT hr = writer.Begin(path, img.format, img.width, img.height);
+    if (FAILED(hr)) return hr;
+
+    CopyImageRows(img, writer.GetSurface());
+    return writer.Commit();
+}
+
+void CopyImageRows(const Image& src, const Image& dst)
+{
+    size_t rows = IsCompressed(src.format) ? (src.height + 3) / 4 : src.height;
+    size_t rowBytes = std::min(src.rowPitch, dst.rowPitch);
+    for (size_t y = 0; y < rows; ++y)
+        memcpy(dst.pixels + y * dst.rowPitch, src.pixels + y * src.rowPitch, rowBytes);
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <windows.h>
+#include "DirectXTex.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// -------------------------------------------------------------
+// Escritura de un DDS 2D (con o sin mips) directamente en el archivo.
+//
+// Begin() crea un temporal junto a 'path' con el tamano final, lo
+// mapea en memoria y escribe la cabecera. GetSurface() es una Image
+// que apunta a los datos dentro del archivo: los workers escriben sus
+// filas de bloques ahi y el sistema las va volcando a disco mientras
+// se sigue codificando. Commit() cierra y renombra el temporal sobre
+// 'path'; si no se llama, el destructor lo borra.
+//
+// Con mipLevels > 1 cada nivel es una superficie (GetSurface(level)),
+// seguidas en el archivo como las deja SaveToDDSFile.
+// -------------------------------------------------------------
+class DDSFileWriter
+{
+public:
+    DDSFileWriter() = default;
+    ~DDSFileWriter();
+
+    DDSFileWriter(const DDSFileWriter&) = delete;
+    DDSFileWriter& operator=(const DDSFileWriter&) = delete;
+
+    HRESULT Begin(const wchar_t* path, DXGI_FORMAT format, size_t width, size_t height, size_t mipLevels = 1);
+
+    // Validas entre Begin() y Commit()
+    const DirectX::Image& GetSurface(size_t level = 0) const { return m_surfaces[level]; }
+    size_t LevelCount() const { return m_surfaces.size(); }
+
+    HRESULT Commit();
+
+private:
+    void Close();
+
+    HANDLE m_file = INVALID_HANDLE_VALUE;
+    HANDLE m_mapping = nullptr;
+    uint8_t* m_view = nullptr;
+
+    std::wstring m_path;
+    std::wstring m_tmpPath;
+    std::vector<DirectX::Image> m_surfaces;
+};
+
+// Guarda una Image ya hecha (p.ej. RGBA sin comprimir) con DDSFileWriter
+HRESULT SaveImageToDDSFile(const DirectX::Image& img, const wchar_t* path);
+
+// Copia 'src' en una superficie del mismo formato y tamano
+void CopyImageRows(const DirectX::Image& src, const DirectX::Image& dst);
@@ -1,7 +1,30 @@
 #include <windows.h>
 #include <d3d11.h>
 #include "DirectXTex.h"
+#include "ImageFeatures.h"
+#include "TextureEncode.h"
+#include "BC7LaneEncoder.h"
+#include "BC7Pruning.h"
+#include "BCnLaneEncoder.h"
+#include "BCDecoder.h"
+#include "BlockRDO.h"
+#include "EncodeCostModel.h"
+#include "ConversionCache.h"
+#include "WorkStealingPool.h"
+#include "BandStream.h"
+#include "BlockCache.h"
+#include "BufferPool.h"
+#include "DDSFileWriter.h"
+#include "RuleEngine.h"
+#include "ImageQuality.h"
+#include "ConvertProfile.h"
+#include "Trace.h"
+#include "PngDecoder.h"
+#include "MipChain.h"
 #include <wincodec.h>
+#include <compressapi.h>
+#include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <cstdint>
 #include <vector>
@@ -9,38 +32,6 @@
 
 using namespace DirectX;
 
-enum RuleId
-{
-    RULE_SMALL_ALPHA_ICON = 1,
-    RULE_GLOWFX_UNCOMPRESSED = 2,
-    RULE_DARK_GRADIENT_UNCOMPRESSED = 3,
-    RULE_ANIMATION_BC7 = 4,
-    RULE_JACKPOT_UNCOMPRESSED = 5,
-    RULE_PROGRESSCOUNTERS_UNCOMP = 6,
-    RULE_BIG_750_BC7 = 7,
-    RULE_SMALL_SOLID_SYMBOL_BC3 = 8,
-    RULE_LONG_STRIP_BC7 = 9,
-    RULE_LONG_STRIP_SHEET_UNCOMP = 10,
-    RULE_LONG_STRIP_SHEET_BC3 = 11,
-    RULE_FONTS_BC7 = 12,
-    RULE_FALLBACK_BC3 = 13,
-    RULE_FALLBACK_BC7_BALANCED = 14,
-    RULE_DEFAULT_BC7_HIGH_QUALITY = 15,
-    RULE_BIG_IMAGE_BC3 = 16
-
-};
-
-
-enum class BC7Quality
-{
-    UltraFast = 0,        // QUICK + UNIFORM
-    FastBalanced = 1,     // QUICK + 3SUBSETS + UNIFORM
-    Balanced = 2,         // 3SUBSETS
-    HighQuality = 3,      // Full (solo PARALLEL)
-    HighQualityUniform = 4, // Full + UNIFORM
-    QuickOnly = 5
-};
-
 HRESULT ConvertToRGBA(const ScratchImage& src, ScratchImage& out)
 {
     HRESULT hr = Convert(
@@ -55,84 +46,39 @@ HRESULT ConvertToRGBA(const ScratchImage& src, ScratchImage& out)
     return hr;
 }
 
+// -------------------------------------------------------------
+// DECODIFICADOR PNG
+// -------------------------------------------------------------
+
+static std::atomic<int> g_pngDecoder{ PNG_DECODER_WIC };
 
-HRESULT CompressBC7(const ScratchImage& rgba, ScratchImage& out, BC7Quality quality = BC7Quality::FastBalanced)
+// Carga la imagen de origen con el decodificador elegido. Lo que el
+// propio no soporta (no es PNG, chunk critico desconocido) lo lee WIC.
+HRESULT LoadSourceImage(const wchar_t* src, WIC_FLAGS flags, TexMetadata& meta, ScratchImage& img)
 {
-    TEX_COMPRESS_FLAGS flags = TEX_COMPRESS_DEFAULT;
-
-    switch (quality)
+    if (g_pngDecoder.load() == PNG_DECODER_BUILTIN)
     {
-        case BC7Quality::UltraFast:
-            // Ms rpido de todos (calidad baja-media)
-            flags |= TEX_COMPRESS_BC7_QUICK |
-                TEX_COMPRESS_UNIFORM;
-            break;
-
-        case BC7Quality::QuickOnly:
-            // Intermedio entre UltraFast y FastBalanced
-            // QUICK sin 3SUBSETS ni UNIFORM
-            flags |= TEX_COMPRESS_BC7_QUICK;
-            break;
-
-        case BC7Quality::FastBalanced:
-            // Rpido con buena calidad (recomendado)
-            flags |= TEX_COMPRESS_BC7_QUICK |
-                TEX_COMPRESS_BC7_USE_3SUBSETS;
-            break;
-
-        case BC7Quality::Balanced:
-            // Calidad alta, velocidad media
-            flags |= TEX_COMPRESS_BC7_USE_3SUBSETS;
-            break;
-
-        case BC7Quality::HighQuality:
-            flags |= TEX_COMPRESS_BC7_USE_3SUBSETS |
-                TEX_COMPRESS_BC7_QUICK |
-                TEX_COMPRESS_PARALLEL;
-            break;
-
-        case BC7Quality::HighQualityUniform:
-            // El ms lento de todos (totalmente exhaustivo)
-            flags |= TEX_COMPRESS_UNIFORM |
-                TEX_COMPRESS_BC7_USE_3SUBSETS;
-            break;
-        default:
-            break;
+        TraceSpan span("DecodePNG");
+        HRESULT hr = LoadPNGFile(src, (flags & WIC_FLAGS_IGNORE_SRGB) != 0, &meta, img);
+        if (hr != HRESULT_E_NOT_SUPPORTED)
+            return hr;
     }
 
-    HRESULT hr = Compress(
-        rgba.GetImages(),
-        rgba.GetImageCount(),
-        rgba.GetMetadata(),
-        DXGI_FORMAT_BC7_UNORM,
-        flags,
-        1.0f,
-        out
-    );
-
-    return hr;
+    TraceSpan span("LoadFromWICFile");
+    return LoadFromWICFile(src, flags, &meta, img);
 }
 
-
-
-HRESULT CompressBC3(const ScratchImage& rgba, ScratchImage& out)
+// PNG_DECODER_WIC (por defecto) o PNG_DECODER_BUILTIN
+extern "C" __declspec(dllexport)
+int __stdcall SetPNGDecoderW(int backend)
 {
-    TEX_COMPRESS_FLAGS flags =
-        TEX_COMPRESS_PARALLEL |    // Usa varios cores
-        TEX_COMPRESS_DITHER;       // Suaviza el error (como Squish perceptual)
+    if (backend != PNG_DECODER_WIC && backend != PNG_DECODER_BUILTIN)
+        return E_INVALIDARG;
 
-    HRESULT hr = Compress(
-        rgba.GetImages(),
-        rgba.GetImageCount(),
-        rgba.GetMetadata(),
-        DXGI_FORMAT_BC3_UNORM,
-        flags,
-        1.0f,
-        out
-    );
-    return hr;
+    return g_pngDecoder.exchange(backend);
 }
 
+
 // Clculo de desviacin estndar del color
 float ComputeColorStdDev(const DirectX::Image* img)
 {
@@ -179,20 +125,6 @@ float ComputeColorStdDev(const DirectX::Image* img)
     return (float)std::sqrt(var);
 }
 
-static void LogRule(const char* ruleName, size_t w, size_t h, bool hasAlpha, const char* extra = "")
-{
-    char buffer[512];
-    sprintf_s(buffer,
-        ">>> RULE HIT: %s | size=%zux%zu | alpha=%s %s\n",
-        ruleName,
-        w, h,
-        hasAlpha ? "YES" : "NO",
-        extra
-    );
-    OutputDebugStringA(buffer);
-}
-
-
 // Deteccin de alpha suave
 bool DetectSoftAlpha(const DirectX::Image* img)
 {
@@ -314,7 +246,7 @@ HRESULT __stdcall ConvertToDDS(
     ScratchImage image;
     ScratchImage compressed;
 
-    HRESULT hr = LoadFromWICFile(inputPath, (WIC_FLAGS)wicFlags, &meta, image);
+    HRESULT hr = LoadSourceImage(inputPath, (WIC_FLAGS)wicFlags, meta, image);
     if (FAILED(hr)) return hr;
 
     hr = Compress(
@@ -832,25 +764,66 @@ bool IsGlowFX(const DirectX::Image* img)
     return true;
 }
 
-HRESULT ConvertToRGBAFast(const ScratchImage& src, ScratchImage& out)
+// Vista RGBA8 de la primera imagen de 'src'. Si ya es RGBA8 apunta
+// directamente a sus pixeles (sin copiar); si no, convierte en
+// 'storage' (buffer del pool) y apunta ahi. La vista vale mientras
+// vivan src y storage.
+HRESULT GetRGBAView(const ScratchImage& src, PooledImage& storage, Image& view)
 {
+    TraceSpan span("GetRGBAView");
+
     auto meta = src.GetMetadata();
+    const Image* base = src.GetImage(0, 0, 0);
 
-    // Si ya es RGBA8, solo copia
     if (meta.format == DXGI_FORMAT_R8G8B8A8_UNORM)
     {
-        return out.InitializeFromImage(*src.GetImage(0, 0, 0));
+        view = *base;
+        return S_OK;
+    }
+
+    HRESULT hr = storage.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM, meta.width, meta.height);
+    if (FAILED(hr)) return hr;
+
+    const Image& dstImg = storage.GetImage();
+
+    // BGRA8 (lo normal desde WIC): basta con cambiar R y B
+    if (meta.format == DXGI_FORMAT_B8G8R8A8_UNORM)
+    {
+        for (size_t y = 0; y < meta.height; ++y)
+        {
+            const uint8_t* s = base->pixels + y * base->rowPitch;
+            uint8_t* d = dstImg.pixels + y * dstImg.rowPitch;
+            for (size_t x = 0; x < meta.width; ++x, s += 4, d += 4)
+            {
+                d[0] = s[2];
+                d[1] = s[1];
+                d[2] = s[0];
+                d[3] = s[3];
+            }
+        }
+
+        view = dstImg;
+        return S_OK;
     }
 
-    return Convert(
+    ScratchImage converted;
+    hr = Convert(
         src.GetImages(),
         src.GetImageCount(),
         src.GetMetadata(),
         DXGI_FORMAT_R8G8B8A8_UNORM,
         TEX_FILTER_POINT,
         0.0f,
-        out
+        converted
     );
+    if (FAILED(hr)) return hr;
+
+    const Image* c = converted.GetImage(0, 0, 0);
+    for (size_t y = 0; y < meta.height; ++y)
+        memcpy(dstImg.pixels + y * dstImg.rowPitch, c->pixels + y * c->rowPitch, dstImg.rowPitch);
+
+    view = dstImg;
+    return S_OK;
 }
 bool HasFineGradient(const ScratchImage& img)
 {
@@ -887,402 +860,2166 @@ bool HasFineGradient(const ScratchImage& img)
     return (gradientCount > samples * 0.30f);
 }
 
+// -------------------------------------------------------------
+// MIPMAPS
+// -------------------------------------------------------------
 
-
+// Como ConvertToDDS, pero con 'mipLevels' niveles (0 = hasta 1x1)
+// hechos con EncodeMipChain (MipChain.h): cada nivel se comprime
+// mientras el pool genera el siguiente. Los pixeles se tratan siempre
+// como sRGB; la imagen se carga sin convertir (WIC_FLAGS_IGNORE_SRGB)
+// y outFormat _SRGB o no decide solo la etiqueta del DDS.
 extern "C" __declspec(dllexport)
-int __stdcall ConvertPNGtoDDSW(const wchar_t* src, const wchar_t* dst)
+HRESULT __stdcall ConvertToDDSMips(
+    const wchar_t* inputPath,
+    const wchar_t* outputPath,
+    DXGI_FORMAT outFormat,
+    unsigned long wicFlags,
+    unsigned long compressFlags,
+    float alphaWeight,
+    unsigned mipLevels)
 {
-    TexMetadata meta;
-    ScratchImage img;
+    TraceFileScope traceFile(inputPath);
+
+    TexMetadata meta{};
+    ScratchImage image;
 
-    HRESULT hr = LoadFromWICFile(src, WIC_FLAGS_IGNORE_SRGB, &meta, img);
+    HRESULT hr = LoadSourceImage(inputPath, (WIC_FLAGS)wicFlags | WIC_FLAGS_IGNORE_SRGB, meta, image);
     if (FAILED(hr)) return hr;
 
-    const Image* base = img.GetImage(0, 0, 0);
-    size_t w = meta.width;
-    size_t h = meta.height;
+    PooledImage converted;
+    Image rgba;
+    hr = GetRGBAView(image, converted, rgba);
+    if (FAILED(hr)) return hr;
 
-    // -------------------------------------------------------
-    // DETECTAR SI HAY ALPHA REAL
-    // -------------------------------------------------------
-    bool hasAlpha = false;
+    size_t levels = CountMipLevels(rgba.width, rgba.height);
+    if (mipLevels)
+        levels = std::min<size_t>(levels, mipLevels);
 
-    {
-        const uint8_t* px = base->pixels;
-        size_t pitch = base->rowPitch;
+    DDSFileWriter writer;
+    hr = writer.Begin(outputPath, outFormat, rgba.width, rgba.height, levels);
+    if (FAILED(hr)) return hr;
 
-        for (size_t y = 0; y < h && !hasAlpha; y++)
+    hr = EncodeMipChain(rgba, levels, [&](size_t level, const Image& mip) -> HRESULT
         {
-            const uint8_t* row = px + y * pitch;
-            for (size_t x = 0; x < w; x++)
+            // Misma etiqueta que la salida: Compress/Convert no tocan la gamma
+            Image src = mip;
+            if (IsSRGB(outFormat))
+                src.format = DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+
+            if (src.format == outFormat)
             {
-                uint8_t a = row[x * 4 + 3];
-                if (a < 255)   // cualquier pixel con alpha
-                {
-                    hasAlpha = true;
-                    break;
-                }
+                CopyImageRows(src, writer.GetSurface(level));
+                return S_OK;
             }
-        }
-    }
-
-    if (w < 450 && h < 450 && hasAlpha)
-    {
-        ScratchImage rgba;
-        hr = ConvertToRGBAFast(img, rgba);
-        if (FAILED(hr)) return hr;
 
-        hr = SaveToDDSFile(
-            rgba.GetImages(),
-            rgba.GetImageCount(),
-            rgba.GetMetadata(),
-            DDS_FLAGS_NONE,
-            dst);
+            ScratchImage out;
+            HRESULT levelHr = IsCompressed(outFormat)
+                ? Compress(src, outFormat, (TEX_COMPRESS_FLAGS)compressFlags, alphaWeight, out)
+                : Convert(src, outFormat, TEX_FILTER_DEFAULT, 0.5f, out);
+            if (FAILED(levelHr)) return levelHr;
 
-        if (FAILED(hr)) return hr;
-        return RULE_SMALL_ALPHA_ICON;
-    }
+            CopyImageRows(*out.GetImage(0, 0, 0), writer.GetSurface(level));
+            return S_OK;
+        });
+    if (FAILED(hr)) return hr;
 
+    return writer.Commit();
+}
 
-    if (IsGlowFX(base))
-    {
-        ScratchImage rgba;
-        hr = ConvertToRGBAFast(img, rgba);
-        if (FAILED(hr)) return hr;
+// -------------------------------------------------------------
+// TABLA DE REGLAS
+// -------------------------------------------------------------
 
-        hr = SaveToDDSFile(
-            rgba.GetImages(),
-            rgba.GetImageCount(),
-            rgba.GetMetadata(),
-            DDS_FLAGS_NONE,
-            dst);
+// Carga la cadena de reglas de un archivo de texto (ver RuleEngine.h).
+// path == nullptr vuelve a la tabla por defecto. Si el texto no es
+// valido se queda la tabla anterior y errorLine dice la linea.
+extern "C" __declspec(dllexport)
+HRESULT __stdcall LoadRuleTableW(const wchar_t* path, int* errorLine)
+{
+    if (errorLine)
+        *errorLine = 0;
 
-        if (FAILED(hr)) return hr;
-        return RULE_GLOWFX_UNCOMPRESSED;
+    if (!path)
+    {
+        RuleTable::SetCurrent(nullptr);
+        return S_OK;
     }
 
+    FILE* f = nullptr;
+    if (_wfopen_s(&f, path, L"r, ccs=UTF-8") != 0 || !f)
+        return HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND);
 
-    if (IsDarkGradientBackground(base))
-    {
-        ScratchImage rgba;
-        hr = ConvertToRGBAFast(img, rgba);
-        if (FAILED(hr)) return hr;
+    std::wstring text;
+    std::vector<wchar_t> buf(1024);
+    while (fgetws(buf.data(), int(buf.size()), f))
+        text += buf.data();
 
-        hr = SaveToDDSFile(
-            rgba.GetImages(),
-            rgba.GetImageCount(),
-            rgba.GetMetadata(),
-            DDS_FLAGS_NONE,
-            dst);
+    fclose(f);
 
-        if (FAILED(hr)) return hr;
-        return RULE_DARK_GRADIENT_UNCOMPRESSED;
-    }
+    auto table = RuleTable::Parse(text, errorLine);
+    if (!table)
+        return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
 
+    RuleTable::SetCurrent(table);
+    return S_OK;
+}
 
-    std::wstring srcPath(src);
+// Como se guarda la imagen de cada regla
+struct RuleAction
+{
+    enum Kind
+    {
+        Uncompressed,       // RGBA tal cual
+        BC7,
+        BC3,
+        FinalBC7            // BC7 con modelo de coste + limite de tiempo
+    };
+
+    Kind kind;
+    BC7Quality quality;     // solo BC7
+    const char* debug;
+};
 
-    // Normalizamos la ruta (por si viene con / o \ mezclado)
-    for (auto& c : srcPath)
+static RuleAction GetRuleAction(int ruleId)
+{
+    switch (ruleId)
     {
-        if (c == L'/') c = L'\\';
+    case RULE_SMALL_ALPHA_ICON:           return { RuleAction::Uncompressed, BC7Quality::UltraFast, nullptr };
+    case RULE_GLOWFX_UNCOMPRESSED:        return { RuleAction::Uncompressed, BC7Quality::UltraFast, nullptr };
+    case RULE_DARK_GRADIENT_UNCOMPRESSED: return { RuleAction::Uncompressed, BC7Quality::UltraFast, nullptr };
+    case RULE_ANIMATION_BC7:              return { RuleAction::BC7, BC7Quality::HighQualityUniform, ">>> RULE: ANIMATION = BC7 QuickOnly\n" };
+    case RULE_JACKPOT_UNCOMPRESSED:       return { RuleAction::Uncompressed, BC7Quality::UltraFast, ">>> RULE: JACKPOT FOLDER (UNCOMPRESSED)\n" };
+    case RULE_PROGRESSCOUNTERS_UNCOMP:    return { RuleAction::Uncompressed, BC7Quality::UltraFast, nullptr };
+    case RULE_BIG_750_BC7:                return { RuleAction::BC7, BC7Quality::UltraFast, ">>> RULE: BIG_750 = BC7 UltraFast\n" };
+    case RULE_SMALL_SOLID_SYMBOL_BC3:     return { RuleAction::BC3, BC7Quality::UltraFast, ">>> RULE 3: Small solid symbol BC3\n" };
+    // Fonts se guarda sin comprimir (el BC7 que se calculaba antes se descartaba)
+    case RULE_FONTS_BC7:                  return { RuleAction::Uncompressed, BC7Quality::HighQuality, nullptr };
+    case RULE_LONG_STRIP_BC7:             return { RuleAction::BC7, BC7Quality::QuickOnly, ">>> RULE 4: Long strip BC7 QuickOnly\n" };
+    case RULE_LONG_STRIP_SHEET_UNCOMP:    return { RuleAction::Uncompressed, BC7Quality::UltraFast, ">>> RULE 4B: Long strip sheet (gradient) UNCOMPRESSED\n" };
+    case RULE_LONG_STRIP_SHEET_BC3:       return { RuleAction::BC3, BC7Quality::UltraFast, ">>> RULE 4C: Long strip sheet (solid) BC3\n" };
+    case RULE_BIG_IMAGE_BC3:              return { RuleAction::BC3, BC7Quality::UltraFast, ">>> RULE: BIG_IMAGE_OVERRIDE_BC3\n" };
+    default:                              return { RuleAction::FinalBC7, BC7Quality::HighQualityUniform, nullptr };
     }
+}
 
-    std::wstring lower = srcPath;
- // pasar a minsculas para comparar
-    for (auto& c : lower)
-        c = towlower(c);
+static double BenchmarkNowMs()
+{
+    LARGE_INTEGER t, f;
+    QueryPerformanceCounter(&t);
+    QueryPerformanceFrequency(&f);
+    return double(t.QuadPart) * 1000.0 / double(f.QuadPart);
+}
 
-    if (lower.find(L"animation") != std::wstring::npos)
-    {
-        ScratchImage rgba;
-        hr = ConvertToRGBAFast(img, rgba);
-        if (FAILED(hr)) return hr;
+// Ajustes de una conversion que no salen de la imagen ni de la ruta
+struct ConvertOptions
+{
+    // Tiempo maximo para el BC7 HighQualityUniform de la regla final
+    uint32_t bc7BudgetMs = 120000;
 
-        ScratchImage bc7;
-        hr = CompressBC7(rgba, bc7, BC7Quality::HighQualityUniform);
-        if (FAILED(hr)) return hr;
+    // Si no es null, se llena cuando se usa la regla final
+    BC7DeadlineStats* bc7Stats = nullptr;
 
-        OutputDebugStringA(">>> RULE: ANIMATION = BC7 QuickOnly\n");
+    // Si no es null, se le suman los tiempos de cada etapa
+    ConvertProfile* profile = nullptr;
+};
 
-        hr = SaveToDDSFile(
-            bc7.GetImages(),
-            bc7.GetImageCount(),
-            bc7.GetMetadata(),
-            DDS_FLAGS_NONE,
-            dst);
+// Reparte el tiempo entre marcas en las etapas de un ConvertProfile
+class ProfileTimer
+{
+public:
+    explicit ProfileTimer(ConvertProfile* profile) : m_profile(profile), m_last(BenchmarkNowMs()) {}
 
-        if (FAILED(hr)) return hr;
-        return RULE_ANIMATION_BC7;
+    // Lo transcurrido desde la marca anterior va a 'stage'
+    void Mark(double ConvertProfile::* stage)
+    {
+        double now = BenchmarkNowMs();
+        if (m_profile)
+            m_profile->*stage += now - m_last;
+        m_last = now;
     }
 
-    if (lower.find(L"jackpot") != std::wstring::npos)
-    {
-        ScratchImage rgba;
-        hr = ConvertToRGBAFast(img, rgba);
-        if (FAILED(hr)) return hr;
+private:
+    ConvertProfile* m_profile;
+    double m_last;
+};
 
-        OutputDebugStringA(">>> RULE: JACKPOT FOLDER (UNCOMPRESSED)\n");
+// -----------------------------------------------------------
+// REGLA 10: FALLBACK AUTOMTICO SI BC7 TARDA MUCHO
+// -----------------------------------------------------------
+static int EncodeFinalBC7(const Image& rgbaFinal, const ImageFeatures& features, const wchar_t* dst,
+    const ConvertOptions& options, size_t mipLevels = 1)
+{
+    ProfileTimer timer(options.profile);
+
+    float colorStdDev = ComputeColorStdDev(features);
+    bool softAlpha = DetectSoftAlpha(features);
+
+    // La calidad de partida se elige con el modelo de coste: la mejor
+    // cuyo tiempo estimado cabe en el presupuesto. Si aun asi se pasa,
+    // lo que quede se codifica en la misma pasada con un tier mas
+    // barato. Para imagenes planas (antes iban a BC3) basta UltraFast.
+    EncodeCostFeatures cost;
+    ExtractEncodeCostFeatures(rgbaFinal, features, cost);
+
+    uint64_t budget = options.bc7BudgetMs;
+    BC7Quality first = PickBC7Quality(cost, double(budget));
+    BC7Quality cheaper = (!softAlpha && colorStdDev < 22.0f)
+        ? BC7Quality::UltraFast
+        : BC7Quality::Balanced;
+
+    BC7Tier tiers[3];
+    size_t tierCount = 0;
+    tiers[tierCount++] = { first, budget };
+    if (BC7QualityRank(cheaper) > BC7QualityRank(first) && cheaper != BC7Quality::UltraFast)
+        tiers[tierCount++] = { cheaper, budget + budget / 4 };
+    if (first != BC7Quality::UltraFast)
+        tiers[tierCount++] = { BC7Quality::UltraFast, UINT64_MAX };
+
+    BC7DeadlineStats stats = {};
+    timer.Mark(&ConvertProfile::analysisMs);
+
+    // Los bloques se escriben directamente en el archivo final
+    DDSFileWriter writer;
+    HRESULT hr = writer.Begin(dst, DXGI_FORMAT_BC7_UNORM, rgbaFinal.width, rgbaFinal.height, mipLevels);
+    timer.Mark(&ConvertProfile::saveMs);
+    if (FAILED(hr)) return hr;
 
-        hr = SaveToDDSFile(
-            rgba.GetImages(),
-            rgba.GetImageCount(),
-            rgba.GetMetadata(),
-            DDS_FLAGS_NONE,
-            dst);
+    // El limite de tiempo es para el nivel 0; los mips (un tercio de
+    // los pixeles) van con el tier mas barato que haya usado
+    hr = EncodeMipChain(rgbaFinal, mipLevels, [&](size_t level, const Image& mip) -> HRESULT
+        {
+            if (level == 0)
+                return CompressBC7WithDeadline(mip, writer.GetSurface(), tiers, tierCount, &stats);
 
-        if (FAILED(hr)) return hr;
-        return RULE_JACKPOT_UNCOMPRESSED;
-    }
+            size_t used = 0;
+            for (size_t t = 0; t < tierCount; ++t)
+                if (stats.tierBlocks[t]) used = t;
 
+            return CompressTiled(mip, DXGI_FORMAT_BC7_UNORM, GetBC7CompressFlags(tiers[used].quality),
+                writer.GetSurface(level), GetDefaultTileEncodeOptions());
+        });
+    timer.Mark(&ConvertProfile::encodeMs);
+    if (FAILED(hr)) return hr;
 
-    if (srcPath.find(L"\\ProgressCounters\\") != std::wstring::npos)
-    {
-        ScratchImage rgba;
-        hr = ConvertToRGBAFast(img, rgba);
-        if (FAILED(hr)) return hr;
+    if (options.bc7Stats)
+        *options.bc7Stats = stats;
 
-        hr = SaveToDDSFile(
-            rgba.GetImages(),
-            rgba.GetImageCount(),
-            rgba.GetMetadata(),
-            DDS_FLAGS_NONE,
-            dst);
+    // Fallback solo si se paso del limite (algun bloque fuera del
+    // primer tier); empezar mas barato por el modelo no lo es
+    bool deadlineHit = false;
+    for (size_t t = 1; t < tierCount; ++t)
+        if (stats.tierBlocks[t]) deadlineHit = true;
 
-        if (FAILED(hr)) return hr;
-        return RULE_PROGRESSCOUNTERS_UNCOMP;
-    }
+    int ruleId = deadlineHit ? RULE_FALLBACK_BC7_BALANCED
+        : (first == BC7Quality::HighQualityUniform) ? RULE_DEFAULT_BC7_HIGH_QUALITY
+        : RULE_COST_MODEL_BC7;
+    Trace::SetRule(ruleId);
 
+    hr = writer.Commit();
+    timer.Mark(&ConvertProfile::saveMs);
 
+    if (FAILED(hr)) return hr;
+    return ruleId;
+}
 
-    if (w > 750 && h > 750)
-    {
-        ScratchImage rgba;
-        hr = ConvertToRGBAFast(img, rgba);
-        if (FAILED(hr)) return hr;
+// Cadena de reglas sobre una imagen ya cargada.
+// 'src' solo se usa para las reglas que miran la ruta.
+// La imagen no se modifica ni se copia: solo se crea una imagen nueva
+// si hay que cambiar el formato a RGBA8. El DDS conserva el tamano
+// original; los bloques incompletos del borde los completa el
+// codificador repitiendo el ultimo texel (GatherBlock). Si la regla
+// lleva +mips en la tabla, el DDS lleva la cadena completa.
+static int ConvertImageToDDS(const ScratchImage& img, const wchar_t* src, const wchar_t* dst,
+    const ConvertOptions& options = ConvertOptions())
+{
+    HRESULT hr = S_OK;
+    ProfileTimer timer(options.profile);
 
-        ScratchImage bc7;
-        hr = CompressBC7(rgba, bc7, BC7Quality::UltraFast);
-        if (FAILED(hr)) return hr;
+    const Image* base = img.GetImage(0, 0, 0);
 
-        OutputDebugStringA(">>> RULE: BIG_750 = BC7 UltraFast\n");
+    // Las estadisticas se calculan (una sola pasada) solo si alguna
+    // regla las necesita antes de que otra se cumpla
+    RuleInputs inputs(base, src);
 
-        hr = SaveToDDSFile(
-            bc7.GetImages(),
-            bc7.GetImageCount(),
-            bc7.GetMetadata(),
-            DDS_FLAGS_NONE,
-            dst);
+    auto table = RuleTable::Current();
+    int ruleId = table->Select(inputs);
+    RuleAction action = GetRuleAction(ruleId);
+    Trace::SetRule(ruleId);
 
-        if (FAILED(hr)) return hr;
-        return RULE_BIG_750_BC7;
-    }
+    // La regla final necesita las estadisticas aunque ninguna regla
+    // las haya pedido: tambien es analisis
+    if (action.kind == RuleAction::FinalBC7)
+        inputs.Features();
 
+    timer.Mark(&ConvertProfile::analysisMs);
 
-    // -----------------------------------------------------------
-// REGLA 3: SMBOLOS PEQUEOS  BC3 (muy rpido)
-// -----------------------------------------------------------
-    float colorStdDev = ComputeColorStdDev(base);
+    PooledImage converted;
+    Image rgba;
+    hr = GetRGBAView(img, converted, rgba);
+    timer.Mark(&ConvertProfile::convertMs);
+    if (FAILED(hr)) return hr;
 
-    if (h <= 100 && !DetectSoftAlpha(base) && colorStdDev < 18.0f)
-    {
-        ScratchImage rgbaLocal;
-        hr = ConvertToRGBAFast(img, rgbaLocal);
-        if (FAILED(hr)) return hr;
+    size_t mipLevels = table->WantsMips(ruleId) ? CountMipLevels(rgba.width, rgba.height) : 1;
 
-        ScratchImage bc3;
-        hr = CompressBC3(rgbaLocal, bc3);
-        if (FAILED(hr)) return hr;
+    if (action.kind == RuleAction::FinalBC7)
+        return EncodeFinalBC7(rgba, inputs.Features(), dst, options, mipLevels);
 
-        OutputDebugStringA(">>> RULE 3: Small solid symbol BC3\n");
+    if (action.kind == RuleAction::Uncompressed && mipLevels == 1)
+    {
+        if (action.debug)
+            OutputDebugStringA(action.debug);
 
-        hr = SaveToDDSFile(
-            bc3.GetImages(),
-            bc3.GetImageCount(),
-            bc3.GetMetadata(),
-            DDS_FLAGS_NONE,
-            dst);
+        hr = SaveImageToDDSFile(rgba, dst);
+        timer.Mark(&ConvertProfile::saveMs);
 
         if (FAILED(hr)) return hr;
-        return RULE_SMALL_SOLID_SYMBOL_BC3;
+        return ruleId;
     }
 
-    if ((w % 4) != 0 || (h % 4) != 0)
+    // Los workers escriben sus filas de bloques directamente en el archivo
+    DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    TEX_COMPRESS_FLAGS flags = TEX_COMPRESS_DEFAULT;
+    if (action.kind == RuleAction::BC7)
+    {
+        format = DXGI_FORMAT_BC7_UNORM;
+        flags = GetBC7CompressFlags(action.quality);
+    }
+    else if (action.kind == RuleAction::BC3)
     {
-        size_t newW = (w + 3) & ~3;
-        size_t newH = (h + 3) & ~3;
+        format = DXGI_FORMAT_BC3_UNORM;
+        flags = GetBC3CompressFlags();
+    }
 
-        ScratchImage resized;
-        hr = Resize(img.GetImages(), img.GetImageCount(), meta,
-            newW, newH, TEX_FILTER_DEFAULT, resized);
+    DDSFileWriter writer;
+    hr = writer.Begin(dst, format, rgba.width, rgba.height, mipLevels);
+    timer.Mark(&ConvertProfile::saveMs);
+    if (FAILED(hr)) return hr;
 
-        if (FAILED(hr)) return hr;
+    // Cada nivel se codifica mientras el pool genera el siguiente
+    hr = EncodeMipChain(rgba, mipLevels, [&](size_t level, const Image& mip) -> HRESULT
+        {
+            if (action.kind == RuleAction::Uncompressed)
+            {
+                CopyImageRows(mip, writer.GetSurface(level));
+                return S_OK;
+            }
 
-        img.Release();
-        img.InitializeFromImage(*resized.GetImage(0, 0, 0));
-        meta = resized.GetMetadata();
+            return CompressTiled(mip, format, flags, writer.GetSurface(level), GetDefaultTileEncodeOptions());
+        });
+    timer.Mark(&ConvertProfile::encodeMs);
+    if (FAILED(hr)) return hr;
 
-        w = newW;
-        h = newH;
-    }
+    if (action.debug)
+        OutputDebugStringA(action.debug);
 
-    if (lower.find(L"fonts") != std::wstring::npos)
-    {
-        ScratchImage rgbaFonts;
-        hr = ConvertToRGBAFast(img, rgbaFonts);
-        if (FAILED(hr)) return hr;
+    hr = writer.Commit();
+    timer.Mark(&ConvertProfile::saveMs);
 
+    if (FAILED(hr)) return hr;
+    return ruleId;
+}
 
-        ScratchImage bc;
-        hr = CompressBC7(rgbaFonts, bc, BC7Quality::HighQuality);
+extern "C" __declspec(dllexport)
+int __stdcall ConvertPNGtoDDSW(const wchar_t* src, const wchar_t* dst)
+{
+    TraceFileScope traceFile(src);
 
-        hr = SaveToDDSFile(
-            rgbaFonts.GetImages(),
-            rgbaFonts.GetImageCount(),
-            rgbaFonts.GetMetadata(),
-            DDS_FLAGS_NONE,
-            dst
-        );
-        if (FAILED(hr)) return hr;
+    TexMetadata meta;
+    ScratchImage img;
 
-        return RULE_FONTS_BC7;   
-    }
+    HRESULT hr = LoadSourceImage(src, WIC_FLAGS_IGNORE_SRGB, meta, img);
+    if (FAILED(hr)) return hr;
 
-    if (IsLongStrip(w, h))
-    {
-        ScratchImage rgbaLocal;
-        hr = ConvertToRGBAFast(img, rgbaLocal);
-        if (FAILED(hr)) return hr;
+    return ConvertImageToDDS(img, src, dst);
+}
 
-        ScratchImage bc7local;
-        hr = CompressBC7(rgbaLocal, bc7local, BC7Quality::QuickOnly);
-        if (FAILED(hr)) return hr;
+// Igual que ConvertPNGtoDDSW, con el tiempo de cada etapa (ver
+// ConvertProfile.h). Lo usa CorpusBench.
+extern "C" __declspec(dllexport)
+int __stdcall ConvertPNGtoDDSProfiledW(const wchar_t* src, const wchar_t* dst, ConvertProfile* profile)
+{
+    TraceFileScope traceFile(src);
 
-        OutputDebugStringA(">>> RULE 4: Long strip BC7 QuickOnly\n");
+    if (profile)
+        *profile = ConvertProfile();
 
-        hr = SaveToDDSFile(
-            bc7local.GetImages(),
-            bc7local.GetImageCount(),
-            bc7local.GetMetadata(),
-            DDS_FLAGS_NONE,
-            dst);
+    ConvertOptions options;
+    options.profile = profile;
 
-        if (FAILED(hr)) return hr;
-        return RULE_LONG_STRIP_BC7;
-    }
+    TexMetadata meta;
+    ScratchImage img;
 
+    ProfileTimer timer(profile);
+    HRESULT hr = LoadSourceImage(src, WIC_FLAGS_IGNORE_SRGB, meta, img);
+    timer.Mark(&ConvertProfile::decodeMs);
+    if (FAILED(hr)) return hr;
 
-    if (IsLongStripSheet(base))
+    if (profile)
     {
-        ScratchImage rgbaLocal;
-        hr = ConvertToRGBAFast(img, rgbaLocal);
-        if (FAILED(hr)) return hr;
+        profile->width = uint32_t(meta.width);
+        profile->height = uint32_t(meta.height);
+    }
 
-        if (DetectSoftAlpha(base) || colorStdDev > 25.0f)
-        {
-            OutputDebugStringA(">>> RULE 4B: Long strip sheet (gradient) UNCOMPRESSED\n");
+    int result = ConvertImageToDDS(img, src, dst, options);
 
-            hr = SaveToDDSFile(
-                rgbaLocal.GetImages(),
-                rgbaLocal.GetImageCount(),
-                rgbaLocal.GetMetadata(),
-                DDS_FLAGS_NONE,
-                dst);
+    if (profile)
+        profile->ruleId = (result > 0) ? result : 0;
 
-            if (FAILED(hr)) return hr;
-            return RULE_LONG_STRIP_SHEET_UNCOMP;
-        }
+    return result;
+}
 
-        ScratchImage bc3;
-        hr = CompressBC3(rgbaLocal, bc3);
-        if (FAILED(hr)) return hr;
+// Igual que ConvertPNGtoDDSW pero con presupuesto propio para el BC7 final.
+// 'stats' (opcional) indica que fraccion de bloques salio en cada tier;
+// stats->totalBlocks == 0 si la imagen la resolvio otra regla.
+extern "C" __declspec(dllexport)
+int __stdcall ConvertPNGtoDDSDeadlineW(const wchar_t* src, const wchar_t* dst, unsigned budgetMs, BC7DeadlineStats* stats)
+{
+    TraceFileScope traceFile(src);
+
+    TexMetadata meta;
+    ScratchImage img;
 
-        OutputDebugStringA(">>> RULE 4C: Long strip sheet (solid) BC3\n");
+    if (stats)
+        *stats = BC7DeadlineStats();
 
-        hr = SaveToDDSFile(
-            bc3.GetImages(),
-            bc3.GetImageCount(),
-            bc3.GetMetadata(),
-            DDS_FLAGS_NONE,
-            dst);
+    HRESULT hr = LoadSourceImage(src, WIC_FLAGS_IGNORE_SRGB, meta, img);
+    if (FAILED(hr)) return hr;
 
-        if (FAILED(hr)) return hr;
-        return RULE_LONG_STRIP_SHEET_BC3;
-    }
+    ConvertOptions options;
+    options.bc7BudgetMs = budgetMs;
+    options.bc7Stats = stats;
 
-    // [ANTES DEL FALLBACK INICIAL]
+    return ConvertImageToDDS(img, src, dst, options);
+}
 
 // -------------------------------------------------------------
-// REGLA NUEVA: Imgenes gigantes = BC3 (antes del fallback)
+// Misma conversion que ConvertPNGtoDDSW, pero por bandas de
+// 'bandRows' filas (0 = 256; se redondea a multiplo de 64, las
+// bandas del RDO de bloques, ver BlockRDO.h): la imagen nunca esta
+// entera en memoria y el DDS sale igual que con la imagen entera.
+//
+// Pasada 1: decodificar banda a banda -> estadisticas -> regla.
+// Pasada 2: decodificar otra vez y guardar/comprimir cada banda
+// directamente en el DDS.
+//
+// Usa ConvertPNGtoDDSW (imagen completa) cuando la regla lo necesita:
+// la regla final (limite de tiempo sobre toda la imagen) y formatos
+// que no son de 8 bits por canal, y las reglas con mips (cada nivel
+// sale del anterior entero). Tambien con el decodificador PNG propio,
+// que no lee por bandas.
 // -------------------------------------------------------------
-    if (w > 600 || h > 600)
-    {
-        ScratchImage rgbaLarge;
-        hr = ConvertToRGBAFast(img, rgbaLarge);
-        if (FAILED(hr)) return hr;
+extern "C" __declspec(dllexport)
+int __stdcall ConvertPNGtoDDSStreamW(const wchar_t* src, const wchar_t* dst, unsigned bandRows)
+{
+    TraceFileScope traceFile(src);
 
-        ScratchImage bc3Large;
-        hr = CompressBC3(rgbaLarge, bc3Large);
-        if (FAILED(hr)) return hr;
+    // Cada banda acaba donde acaba una banda del RDO
+    const size_t rdoRows = kRDOBandBlockRows * 4;
+    size_t band = bandRows ? bandRows : 256;
+    band = (band + rdoRows - 1) / rdoRows * rdoRows;
+
+    if (g_pngDecoder.load() == PNG_DECODER_BUILTIN)
+        return ConvertPNGtoDDSW(src, dst);
+
+    WICBandReader reader;
+    HRESULT hr = reader.Open(src);
+    if (hr == HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED))
+        return ConvertPNGtoDDSW(src, dst);
+    if (FAILED(hr)) return hr;
+
+    size_t w = reader.Width();
+    size_t h = reader.Height();
+    size_t rowPitch = w * 4;
+
+    PooledBuffer rowBuffer;
+    hr = rowBuffer.Acquire(rowPitch * std::min(band, h));
+    if (FAILED(hr)) return hr;
 
-        OutputDebugStringA(">>> RULE: BIG_IMAGE_OVERRIDE_BC3\n");
+    uint8_t* rows = rowBuffer.Data();
 
-        hr = SaveToDDSFile(
-            bc3Large.GetImages(),
-            bc3Large.GetImageCount(),
-            bc3Large.GetMetadata(),
-            DDS_FLAGS_NONE,
-            dst);
+    // Pasada 1: estadisticas de las reglas
+    ImageFeatureAccumulator accumulator;
+    accumulator.Begin(w, h);
 
+    for (size_t y = 0; y < h; y += band)
+    {
+        size_t count = std::min(band, h - y);
+
+        hr = reader.ReadRows(y, count, rows, rowPitch);
         if (FAILED(hr)) return hr;
 
-        return RULE_BIG_IMAGE_BC3;
+        TraceSpan span("AccumulateFeatures");
+        accumulator.AddRows(rows, rowPitch, count);
     }
 
+    ImageFeatures features;
+    accumulator.Finish(features);
 
-// -----------------------------------------------------------
-// REGLA 10: FALLBACK AUTOMTICO SI BC7 TARDA MUCHO
-// -----------------------------------------------------------
-    ScratchImage rgbaFinal;
-    hr = ConvertToRGBAFast(img, rgbaFinal);
-    if (FAILED(hr)) return hr;
+    RuleInputs inputs(features, src);
 
-    uint64_t t0 = GetTickCount64();
+    auto table = RuleTable::Current();
+    int ruleId = table->Select(inputs);
+    RuleAction action = GetRuleAction(ruleId);
+    Trace::SetRule(ruleId);
 
-    ScratchImage bc7Final;
+    if (action.kind == RuleAction::FinalBC7 || table->WantsMips(ruleId))
+        return ConvertPNGtoDDSW(src, dst);
+
+    // Pasada 2: cada banda va directa a su sitio en el DDS
+    DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    TEX_COMPRESS_FLAGS flags = TEX_COMPRESS_DEFAULT;
+    if (action.kind == RuleAction::BC7)
+    {
+        format = DXGI_FORMAT_BC7_UNORM;
+        flags = GetBC7CompressFlags(action.quality);
+    }
+    else if (action.kind == RuleAction::BC3)
+    {
+        format = DXGI_FORMAT_BC3_UNORM;
+        flags = GetBC3CompressFlags();
+    }
 
-    // Arrancamos en Balanced
-    hr = CompressBC7(rgbaFinal, bc7Final, BC7Quality::HighQualityUniform);
+    DDSFileWriter writer;
+    hr = writer.Begin(dst, format, w, h);
     if (FAILED(hr)) return hr;
 
-    uint64_t elapsed = GetTickCount64() - t0;
-    int ruleId = RULE_DEFAULT_BC7_HIGH_QUALITY;
+    const Image& surface = writer.GetSurface();
+    TileEncodeOptions tileOptions = GetDefaultTileEncodeOptions();
+    bool swapRB = (reader.Format() == DXGI_FORMAT_B8G8R8A8_UNORM);
 
-    if (elapsed > 120000)
+    for (size_t y = 0; y < h; y += band)
     {
-        if (!DetectSoftAlpha(base) && colorStdDev < 22.0f)
+        size_t count = std::min(band, h - y);
+
+        hr = reader.ReadRows(y, count, rows, rowPitch);
+        if (FAILED(hr)) return hr;
+
+        // Igual que GetRGBAView: BGRA -> RGBA
+        if (swapRB)
         {
-            hr = CompressBC3(rgbaFinal, bc7Final);
-            ruleId = RULE_FALLBACK_BC3;
+            uint8_t* p = rows;
+            for (size_t i = 0; i < w * count; ++i, p += 4)
+                std::swap(p[0], p[2]);
         }
-        else
+
+        if (action.kind == RuleAction::Uncompressed)
         {
-            hr = CompressBC7(rgbaFinal, bc7Final, BC7Quality::Balanced);
-            ruleId = RULE_FALLBACK_BC7_BALANCED;
+            for (size_t r = 0; r < count; ++r)
+                memcpy(surface.pixels + (y + r) * surface.rowPitch, rows + r * rowPitch, rowPitch);
+            continue;
         }
+
+        Image bandImage = {};
+        bandImage.width = w;
+        bandImage.height = count;
+        bandImage.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        bandImage.rowPitch = rowPitch;
+        bandImage.slicePitch = rowPitch * count;
+        bandImage.pixels = rows;
+
+        // Filas de bloques de la banda (y es multiplo de 4)
+        Image bandDst = surface;
+        bandDst.height = count;
+        bandDst.pixels = surface.pixels + (y / 4) * surface.rowPitch;
+        bandDst.slicePitch = surface.rowPitch * ((count + 3) / 4);
+
+        hr = CompressTiled(bandImage, format, flags, bandDst, tileOptions);
+        if (FAILED(hr)) return hr;
     }
 
+    hr = writer.Commit();
     if (FAILED(hr)) return hr;
 
-    hr = SaveToDDSFile(
-        bc7Final.GetImages(),
-        bc7Final.GetImageCount(),
-        bc7Final.GetMetadata(),
-        DDS_FLAGS_NONE,
-        dst);
+    if (action.debug)
+        OutputDebugStringA(action.debug);
 
-    if (FAILED(hr)) return hr;
     return ruleId;
+}
+
+// -------------------------------------------------------------
+// MODELO DE COSTE BC7
+// -------------------------------------------------------------
+
+// Tiempo estimado de CompressBC7 para cada BC7Quality (msOut[quality]).
+// Sirve para repartir un presupuesto entre los archivos de un lote.
+extern "C" __declspec(dllexport)
+HRESULT __stdcall PredictBC7EncodeMsW(const wchar_t* src, double* msOut, unsigned count)
+{
+    if (!msOut || count == 0)
+        return E_INVALIDARG;
+
+    TexMetadata meta;
+    ScratchImage img;
+
+    HRESULT hr = LoadSourceImage(src, WIC_FLAGS_IGNORE_SRGB, meta, img);
+    if (FAILED(hr)) return hr;
+
+    PooledImage converted;
+    Image rgba;
+    hr = GetRGBAView(img, converted, rgba);
+    if (FAILED(hr)) return hr;
 
+    ImageFeatures features;
+    ExtractImageFeatures(&rgba, features);
 
+    EncodeCostFeatures cost;
+    ExtractEncodeCostFeatures(rgba, features, cost);
+
+    for (unsigned q = 0; q < count; ++q)
+        msOut[q] = (q < kBC7QualityCount) ? PredictBC7EncodeMs(cost, BC7Quality(q)) : 0.0;
+
+    return S_OK;
+}
+
+extern "C" __declspec(dllexport)
+HRESULT __stdcall LoadEncodeCostTableW(const wchar_t* tablePath)
+{
+    return LoadEncodeCostTable(tablePath);
+}
+
+// Herramienta de calibracion: mide el corpus, ajusta la tabla y
+// escribe el informe de precision. qualityMask = bits 1 << BC7Quality.
+extern "C" __declspec(dllexport)
+HRESULT __stdcall CalibrateEncodeCostW(const wchar_t* const* files, unsigned count, unsigned qualityMask,
+    const wchar_t* tablePath, const wchar_t* reportPath)
+{
+    return CalibrateEncodeCost(files, count, qualityMask, tablePath, reportPath);
+}
+
+// -------------------------------------------------------------
+// CODIFICACION POR TILES
+// -------------------------------------------------------------
+
+// Hilos y afinidad que usan CompressBC7/CompressBC3 (0 = por defecto)
+extern "C" __declspec(dllexport)
+void __stdcall SetEncodeThreadingW(unsigned threads, unsigned long long affinityMask)
+{
+    TileEncodeOptions options;
+    options.threads = threads;
+    options.affinityMask = affinityMask;
+    SetDefaultTileEncodeOptions(options);
+}
+
+// Benchmark: para cada BC7Quality y BC3 mide la misma imagen con
+// 1 hilo, con 'threads' hilos por tiles y con TEX_COMPRESS_PARALLEL
+// de DirectXTex, y escribe los tiempos y el speedup en reportPath.
+extern "C" __declspec(dllexport)
+HRESULT __stdcall BenchmarkTiledEncodeW(const wchar_t* src, unsigned threads, unsigned long long affinityMask, const wchar_t* reportPath)
+{
+    TexMetadata meta;
+    ScratchImage img;
+
+    HRESULT hr = LoadSourceImage(src, WIC_FLAGS_IGNORE_SRGB, meta, img);
+    if (FAILED(hr)) return hr;
+
+    PooledImage converted;
+    Image base;
+    hr = GetRGBAView(img, converted, base);
+    if (FAILED(hr)) return hr;
+
+    FILE* f = nullptr;
+    if (!reportPath || _wfopen_s(&f, reportPath, L"w, ccs=UTF-8") != 0 || !f)
+        return E_INVALIDARG;
+
+    TileEncodeOptions serial;
+    serial.threads = 1;
+
+    TileEncodeOptions tiled;
+    tiled.threads = threads;
+    tiled.affinityMask = affinityMask;
+
+    fwprintf(f, L"# %s  %ux%u  threads %u\n", src, unsigned(meta.width), unsigned(meta.height), ResolveTileThreads(tiled));
+    fwprintf(f, L"%-20s %12s %12s %12s %9s\n", L"quality", L"serial ms", L"tiled ms", L"dxtex par ms", L"speedup");
+
+    static const wchar_t* names[] =
+    {
+        L"UltraFast", L"FastBalanced", L"Balanced", L"HighQuality", L"HighQualityUniform", L"QuickOnly", L"BC3"
+    };
+
+    for (int q = 0; q < 7; ++q)
+    {
+        DXGI_FORMAT format = (q < 6) ? DXGI_FORMAT_BC7_UNORM : DXGI_FORMAT_BC3_UNORM;
+        TEX_COMPRESS_FLAGS flags = (q < 6) ? GetBC7CompressFlags(BC7Quality(q)) : GetBC3CompressFlags();
+
+        ScratchImage out;
+        double t0 = BenchmarkNowMs();
+        hr = CompressTiled(base, format, flags, out, serial);
+        double serialMs = BenchmarkNowMs() - t0;
+        if (FAILED(hr)) break;
+
+        t0 = BenchmarkNowMs();
+        hr = CompressTiled(base, format, flags, out, tiled);
+        double tiledMs = BenchmarkNowMs() - t0;
+        if (FAILED(hr)) break;
+
+        t0 = BenchmarkNowMs();
+        hr = Compress(base, format, flags | TEX_COMPRESS_PARALLEL, 1.0f, out);
+        double dxtexMs = BenchmarkNowMs() - t0;
+        if (FAILED(hr)) break;
+
+        fwprintf(f, L"%-20s %12.1f %12.1f %12.1f %8.2fx\n", names[q], serialMs, tiledMs, dxtexMs,
+            tiledMs > 0.0 ? serialMs / tiledMs : 0.0);
+    }
+
+    fclose(f);
+    return hr;
+}
+
+// Benchmark de los bloques incompletos del borde: recorta 'src' (sin
+// copiarla) a un tamano que no es multiplo de 4 y compara lo de antes,
+// Resize al tamano con relleno y codificar, con codificar el recorte
+// tal cual. Escribe los tiempos en reportPath.
+extern "C" __declspec(dllexport)
+HRESULT __stdcall BenchmarkEdgePaddingW(const wchar_t* src, const wchar_t* reportPath)
+{
+    TexMetadata meta;
+    ScratchImage img;
+
+    HRESULT hr = LoadSourceImage(src, WIC_FLAGS_IGNORE_SRGB, meta, img);
+    if (FAILED(hr)) return hr;
+
+    PooledImage converted;
+    Image base;
+    hr = GetRGBAView(img, converted, base);
+    if (FAILED(hr)) return hr;
+
+    Image odd = base;
+    if (odd.width % 4 == 0 && odd.width > 1)
+        --odd.width;
+    if (odd.height % 4 == 0 && odd.height > 1)
+        --odd.height;
+    odd.slicePitch = odd.rowPitch * odd.height;
+
+    if (odd.width % 4 == 0 && odd.height % 4 == 0)
+        return E_INVALIDARG;
+
+    size_t paddedW = (odd.width + 3) & ~size_t(3);
+    size_t paddedH = (odd.height + 3) & ~size_t(3);
+
+    FILE* f = nullptr;
+    if (!reportPath || _wfopen_s(&f, reportPath, L"w, ccs=UTF-8") != 0 || !f)
+        return E_INVALIDARG;
+
+    fwprintf(f, L"# %s  %ux%u -> %ux%u (padded %ux%u)\n", src, unsigned(meta.width), unsigned(meta.height),
+        unsigned(odd.width), unsigned(odd.height), unsigned(paddedW), unsigned(paddedH));
+    fwprintf(f, L"%-16s %12s %12s %12s %12s %9s\n", L"format", L"resize ms", L"encode ms", L"before ms", L"edge ms", L"saved");
+
+    struct Case
+    {
+        const wchar_t* name;
+        DXGI_FORMAT format;
+        TEX_COMPRESS_FLAGS flags;
+    };
+
+    // Los formatos de las reglas que antes rellenaban
+    const Case cases[] =
+    {
+        { L"BC7 QuickOnly", DXGI_FORMAT_BC7_UNORM, GetBC7CompressFlags(BC7Quality::QuickOnly) },
+        { L"BC7 UltraFast", DXGI_FORMAT_BC7_UNORM, GetBC7CompressFlags(BC7Quality::UltraFast) },
+        { L"BC3", DXGI_FORMAT_BC3_UNORM, GetBC3CompressFlags() },
+    };
+
+    TileEncodeOptions tiled = GetDefaultTileEncodeOptions();
+
+    for (const Case& c : cases)
+    {
+        ScratchImage resized;
+        ScratchImage out;
+
+        double t0 = BenchmarkNowMs();
+        hr = Resize(odd, paddedW, paddedH, TEX_FILTER_DEFAULT, resized);
+        double resizeMs = BenchmarkNowMs() - t0;
+        if (FAILED(hr)) break;
+
+        t0 = BenchmarkNowMs();
+        hr = CompressTiled(*resized.GetImage(0, 0, 0), c.format, c.flags, out, tiled);
+        double paddedEncodeMs = BenchmarkNowMs() - t0;
+        if (FAILED(hr)) break;
+
+        t0 = BenchmarkNowMs();
+        hr = CompressTiled(odd, c.format, c.flags, out, tiled);
+        double edgeMs = BenchmarkNowMs() - t0;
+        if (FAILED(hr)) break;
+
+        double beforeMs = resizeMs + paddedEncodeMs;
+        fwprintf(f, L"%-16s %12.2f %12.2f %12.2f %12.2f %8.1f%%\n", c.name, resizeMs, paddedEncodeMs, beforeMs, edgeMs,
+            beforeMs > 0.0 ? 100.0 * (beforeMs - edgeMs) / beforeMs : 0.0);
+    }
+
+    fclose(f);
+    return hr;
+}
+
+// -------------------------------------------------------------
+// CODIFICADOR BC7 POR CARRILES
+// -------------------------------------------------------------
+
+extern "C" __declspec(dllexport)
+int __stdcall SetBC7BackendW(int quality, int backend)
+{
+    if (backend != BC7_BACKEND_DIRECTXTEX && backend != BC7_BACKEND_LANES)
+        return E_INVALIDARG;
+
+    if (quality >= 0)
+        return SetBC7Backend(BC7Quality(quality), BC7Backend(backend));
+
+    int previous = GetBC7Backend(BC7Quality::UltraFast);
+    for (int q = 0; q < 6; ++q)
+        SetBC7Backend(BC7Quality(q), BC7Backend(backend));
+    return previous;
+}
+
+// Prueba de paridad + benchmark: para cada BC7Quality codifica 'src'
+// con DirectXTex y con el codificador por carriles (mismos tiles e
+// hilos) y compara tiempo y PSNR. Una calidad pasa si el PSNR de los
+// carriles no baja mas de maxPsnrLossDb. Ademas comprueba que todos
+// los niveles de kernel disponibles dan los mismos bytes. El
+// codificador va en las opciones de cada llamada (sin cache de
+// bloques, poda ni RDO): las conversiones de otros hilos no cambian.
+// S_OK si todo pasa, S_FALSE si algo falla (ver reportPath).
+extern "C" __declspec(dllexport)
+HRESULT __stdcall BenchmarkBC7BackendsW(const wchar_t* src, const wchar_t* reportPath, double maxPsnrLossDb)
+{
+    TexMetadata meta;
+    ScratchImage img;
+
+    HRESULT hr = LoadSourceImage(src, WIC_FLAGS_IGNORE_SRGB, meta, img);
+    if (FAILED(hr)) return hr;
+
+    PooledImage converted;
+    Image base;
+    hr = GetRGBAView(img, converted, base);
+    if (FAILED(hr)) return hr;
+
+    FILE* f = nullptr;
+    if (!reportPath || _wfopen_s(&f, reportPath, L"w, ccs=UTF-8") != 0 || !f)
+        return E_INVALIDARG;
+
+    TileEncodeOptions tiled = GetDefaultTileEncodeOptions();
+    double mpix = double(base.width) * double(base.height) / 1e6;
+    bool pass = true;
+
+    fwprintf(f, L"# %s  %ux%u  threads %u  lanes %u  max loss %.2f dB\n", src, unsigned(meta.width), unsigned(meta.height),
+        ResolveTileThreads(tiled), unsigned(GetBC7LaneKernels().lanes), maxPsnrLossDb);
+    fwprintf(f, L"%-20s %10s %10s %10s %10s %9s %9s %8s %5s\n", L"quality", L"dxtex ms", L"lanes ms", L"dxtex MP/s", L"lanes MP/s",
+        L"dxtex dB", L"lanes dB", L"speedup", L"ok");
+
+    static const wchar_t* names[] =
+    {
+        L"UltraFast", L"FastBalanced", L"Balanced", L"HighQuality", L"HighQualityUniform", L"QuickOnly"
+    };
+
+    PooledImage encoded;
+    hr = encoded.Initialize2D(DXGI_FORMAT_BC7_UNORM, base.width, base.height);
+
+    for (int q = 0; q < 6 && SUCCEEDED(hr); ++q)
+    {
+        TEX_COMPRESS_FLAGS flags = GetBC7CompressFlags(BC7Quality(q));
+        double ms[2] = {};
+        QualityScore score[2] = {};
+
+        for (int b = 0; b < 2 && SUCCEEDED(hr); ++b)
+        {
+            TileEncodeOptions run = tiled;
+            run.bc7Backend = b;
+            run.encoderOnly = true;
+
+            double t0 = BenchmarkNowMs();
+            hr = CompressTiled(base, DXGI_FORMAT_BC7_UNORM, flags, encoded.GetImage(), run);
+            ms[b] = BenchmarkNowMs() - t0;
+
+            if (SUCCEEDED(hr))
+                hr = MeasureEncodedQuality(base, encoded.GetImage(), score[b]);
+        }
+
+        if (FAILED(hr)) break;
+
+        bool ok = score[1].psnr >= score[0].psnr - maxPsnrLossDb;
+        pass = pass && ok;
+
+        fwprintf(f, L"%-20s %10.1f %10.1f %10.2f %10.2f %9.2f %9.2f %7.2fx %5s\n", names[q], ms[0], ms[1],
+            ms[0] > 0.0 ? mpix * 1000.0 / ms[0] : 0.0, ms[1] > 0.0 ? mpix * 1000.0 / ms[1] : 0.0,
+            score[0].psnr, score[1].psnr, ms[1] > 0.0 ? ms[0] / ms[1] : 0.0, ok ? L"yes" : L"NO");
+    }
+
+    // Niveles de kernel: todos tienen que dar los mismos bytes que el escalar
+    if (SUCCEEDED(hr))
+    {
+        BC7LaneParams params = GetBC7LaneParams(BC7Quality::HighQualityUniform);
+        PooledImage reference;
+        hr = reference.Initialize2D(DXGI_FORMAT_BC7_UNORM, base.width, base.height);
+        if (SUCCEEDED(hr))
+            hr = EncodeBC7Lanes(base, reference.GetImage(), params, GetBC7LaneKernels(KernelLevel::Scalar));
+
+        const KernelLevel levels[] = { KernelLevel::SSE2, KernelLevel::AVX2 };
+        for (KernelLevel level : levels)
+        {
+            const BC7LaneKernels* kernels = GetBC7LaneKernels(level);
+            if (!kernels || FAILED(hr))
+                continue;
+
+            hr = EncodeBC7Lanes(base, encoded.GetImage(), params, kernels);
+            if (FAILED(hr)) break;
+
+            const Image& a = reference.GetImage();
+            const Image& b = encoded.GetImage();
+            bool same = memcmp(a.pixels, b.pixels, a.slicePitch) == 0;
+            pass = pass && same;
+
+            fwprintf(f, L"kernels %u lanes vs scalar: %s\n", unsigned(kernels->lanes), same ? L"identical" : L"DIFFERENT");
+        }
+    }
+
+    fclose(f);
+
+    if (FAILED(hr)) return hr;
+    return pass ? S_OK : S_FALSE;
+}
+
+// -------------------------------------------------------------
+// PODA DE BC7
+// -------------------------------------------------------------
+
+// Agresividad de la poda (ver BC7Pruning.h) para todas las
+// codificaciones BC7 siguientes: 0 = desactivada, 1 = maxima
+extern "C" __declspec(dllexport)
+void __stdcall SetBC7PruningW(double aggressiveness)
+{
+    SetBC7Pruning(float(aggressiveness));
+}
+
+// Bloques que han ido a cada nivel desde el ultimo reset. Con
+// reset != 0 los contadores vuelven a 0 despues de leerlos.
+extern "C" __declspec(dllexport)
+HRESULT __stdcall GetBC7PruningStatsW(BC7PruningStats* stats, int reset)
+{
+    if (!stats)
+        return E_INVALIDARG;
+
+    GetBC7PruningStats(*stats);
+
+    if (reset)
+        ResetBC7PruningStats();
+
+    return S_OK;
+}
+
+// Benchmark de la poda: Balanced y HighQualityUniform sin poda como
+// referencia y HighQualityUniform con varias agresividades. Escribe
+// tiempo, PSNR, lo que se pierde frente a HighQualityUniform y el
+// reparto de bloques por nivel en reportPath.
+extern "C" __declspec(dllexport)
+HRESULT __stdcall BenchmarkBC7PruningW(const wchar_t* src, const wchar_t* reportPath)
+{
+    TexMetadata meta;
+    ScratchImage img;
+
+    HRESULT hr = LoadSourceImage(src, WIC_FLAGS_IGNORE_SRGB, meta, img);
+    if (FAILED(hr)) return hr;
+
+    PooledImage converted;
+    Image base;
+    hr = GetRGBAView(img, converted, base);
+    if (FAILED(hr)) return hr;
+
+    FILE* f = nullptr;
+    if (!reportPath || _wfopen_s(&f, reportPath, L"w, ccs=UTF-8") != 0 || !f)
+        return E_INVALIDARG;
+
+    struct Case
+    {
+        const wchar_t* name;
+        BC7Quality quality;
+        float aggressiveness;
+    };
+
+    const Case cases[] =
+    {
+        { L"Balanced",          BC7Quality::Balanced,           0.0f },
+        { L"HQUniform",         BC7Quality::HighQualityUniform, 0.0f },
+        { L"HQUniform p=0.25",  BC7Quality::HighQualityUniform, 0.25f },
+        { L"HQUniform p=0.5",   BC7Quality::HighQualityUniform, 0.5f },
+        { L"HQUniform p=0.75",  BC7Quality::HighQualityUniform, 0.75f },
+        { L"HQUniform p=1",     BC7Quality::HighQualityUniform, 1.0f },
+    };
+
+    TileEncodeOptions tiled = GetDefaultTileEncodeOptions();
+
+    fwprintf(f, L"# %s  %ux%u  threads %u\n", src, unsigned(meta.width), unsigned(meta.height), ResolveTileThreads(tiled));
+    fwprintf(f, L"%-18s %10s %9s %9s %9s %9s %9s\n", L"case", L"ms", L"dB", L"loss dB", L"full", L"2 subs", L"line");
+
+    float saved = GetBC7Pruning();
+    double referencePsnr = 0.0;
+
+    PooledImage encoded;
+    hr = encoded.Initialize2D(DXGI_FORMAT_BC7_UNORM, base.width, base.height);
+
+    for (const Case& c : cases)
+    {
+        if (FAILED(hr)) break;
+
+        SetBC7Pruning(c.aggressiveness);
+        ResetBC7PruningStats();
+
+        double t0 = BenchmarkNowMs();
+        hr = CompressTiled(base, DXGI_FORMAT_BC7_UNORM, GetBC7CompressFlags(c.quality), encoded.GetImage(), tiled);
+        double ms = BenchmarkNowMs() - t0;
+        if (FAILED(hr)) break;
+
+        QualityScore score;
+        hr = MeasureEncodedQuality(base, encoded.GetImage(), score);
+        if (FAILED(hr)) break;
+
+        if (c.quality == BC7Quality::HighQualityUniform && c.aggressiveness == 0.0f)
+            referencePsnr = score.psnr;
+
+        BC7PruningStats pruning;
+        GetBC7PruningStats(pruning);
+
+        fwprintf(f, L"%-18s %10.1f %9.2f %9.2f %9llu %9llu %9llu\n", c.name, ms, score.psnr,
+            referencePsnr > 0.0 ? referencePsnr - score.psnr : 0.0,
+            pruning.blocks[BC7_TIER_FULL], pruning.blocks[BC7_TIER_TWO_SUBSETS], pruning.blocks[BC7_TIER_LINE]);
+    }
+
+    SetBC7Pruning(saved);
+    ResetBC7PruningStats();
+
+    fclose(f);
+    return hr;
+}
+
+// -------------------------------------------------------------
+// CODIFICADOR BC1/BC3/BC4 PROPIO
+// -------------------------------------------------------------
+
+// BCnEncoder para todas las codificaciones BC1/BC3/BC4 siguientes
+// (0 = DirectXTex, 1 = range fit, 2 = cluster fit). Devuelve el anterior.
+extern "C" __declspec(dllexport)
+int __stdcall SetBCnEncoderW(int encoder)
+{
+    if (encoder < BCN_ENCODER_DIRECTXTEX || encoder > BCN_ENCODER_CLUSTER_FIT)
+        return E_INVALIDARG;
+
+    return SetBCnEncoder(BCnEncoder(encoder));
+}
+
+// Benchmark: BC1, BC3 y BC4 de 'src' con DirectXTex, range fit y
+// cluster fit (flags de CompressBC3, con dithering), con 1 hilo y por
+// tiles. Escribe tiempos, MP/s y PSNR (BC4 contra el canal R) en
+// reportPath, y si los niveles de kernel dan los mismos bytes.
+// S_FALSE si algun nivel no coincide. Como BenchmarkBC7BackendsW, el
+// codificador va en las opciones de cada llamada.
+extern "C" __declspec(dllexport)
+HRESULT __stdcall BenchmarkBCnEncodersW(const wchar_t* src, const wchar_t* reportPath)
+{
+    TexMetadata meta;
+    ScratchImage img;
+
+    HRESULT hr = LoadSourceImage(src, WIC_FLAGS_IGNORE_SRGB, meta, img);
+    if (FAILED(hr)) return hr;
+
+    PooledImage converted;
+    Image base;
+    hr = GetRGBAView(img, converted, base);
+    if (FAILED(hr)) return hr;
+
+    // Referencia de BC4: lo que da al decodificarlo a RGBA (R, 0, 0, 255)
+    PooledImage redOnly;
+    hr = redOnly.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM, base.width, base.height);
+    if (FAILED(hr)) return hr;
+
+    const Image& red = redOnly.GetImage();
+    for (size_t y = 0; y < base.height; ++y)
+    {
+        const uint8_t* s = base.pixels + y * base.rowPitch;
+        uint8_t* d = red.pixels + y * red.rowPitch;
+        for (size_t x = 0; x < base.width; ++x)
+        {
+            d[x * 4 + 0] = s[x * 4 + 0];
+            d[x * 4 + 1] = 0;
+            d[x * 4 + 2] = 0;
+            d[x * 4 + 3] = 255;
+        }
+    }
+
+    FILE* f = nullptr;
+    if (!reportPath || _wfopen_s(&f, reportPath, L"w, ccs=UTF-8") != 0 || !f)
+        return E_INVALIDARG;
+
+    TileEncodeOptions serial;
+    serial.threads = 1;
+    TileEncodeOptions tiled = GetDefaultTileEncodeOptions();
+
+    double mpix = double(base.width) * double(base.height) / 1e6;
+    bool pass = true;
+
+    fwprintf(f, L"# %s  %ux%u  threads %u  lanes %u\n", src, unsigned(meta.width), unsigned(meta.height),
+        ResolveTileThreads(tiled), unsigned(GetBCnLaneKernels().lanes));
+    fwprintf(f, L"%-6s %-12s %10s %10s %10s %9s %8s\n", L"format", L"encoder", L"serial ms", L"tiled ms", L"MP/s", L"dB", L"speedup");
+
+    const DXGI_FORMAT formats[] = { DXGI_FORMAT_BC1_UNORM, DXGI_FORMAT_BC3_UNORM, DXGI_FORMAT_BC4_UNORM };
+    const wchar_t* formatNames[] = { L"BC1", L"BC3", L"BC4" };
+    const wchar_t* encoderNames[] = { L"DirectXTex", L"RangeFit", L"ClusterFit" };
+
+    TEX_COMPRESS_FLAGS flags = GetBC3CompressFlags();
+
+    for (int fi = 0; fi < 3 && SUCCEEDED(hr); ++fi)
+    {
+        DXGI_FORMAT format = formats[fi];
+        const Image& ref = (format == DXGI_FORMAT_BC4_UNORM) ? red : base;
+        double dxtexMs = 0.0;
+
+        PooledImage encoded;
+        hr = encoded.Initialize2D(format, base.width, base.height);
+
+        for (int e = BCN_ENCODER_DIRECTXTEX; e <= BCN_ENCODER_CLUSTER_FIT && SUCCEEDED(hr); ++e)
+        {
+            TileEncodeOptions serialRun = serial;
+            TileEncodeOptions tiledRun = tiled;
+            serialRun.bcnEncoder = tiledRun.bcnEncoder = e;
+            serialRun.encoderOnly = tiledRun.encoderOnly = true;
+
+            double t0 = BenchmarkNowMs();
+            hr = CompressTiled(base, format, flags, encoded.GetImage(), serialRun);
+            double serialMs = BenchmarkNowMs() - t0;
+            if (FAILED(hr)) break;
+
+            t0 = BenchmarkNowMs();
+            hr = CompressTiled(base, format, flags, encoded.GetImage(), tiledRun);
+            double tiledMs = BenchmarkNowMs() - t0;
+            if (FAILED(hr)) break;
+
+            QualityScore score;
+            hr = MeasureEncodedQuality(ref, encoded.GetImage(), score);
+            if (FAILED(hr)) break;
+
+            if (e == BCN_ENCODER_DIRECTXTEX)
+                dxtexMs = tiledMs;
+
+            fwprintf(f, L"%-6s %-12s %10.1f %10.1f %10.2f %9.2f %7.2fx\n", formatNames[fi], encoderNames[e], serialMs, tiledMs,
+                tiledMs > 0.0 ? mpix * 1000.0 / tiledMs : 0.0, score.psnr, tiledMs > 0.0 ? dxtexMs / tiledMs : 0.0);
+        }
+
+        // Niveles de kernel: todos tienen que dar los mismos bytes que el escalar
+        BCnLaneParams params = {};
+        GetBCnLaneParams(format, flags, BCN_ENCODER_CLUSTER_FIT, params);
+
+        PooledImage reference;
+        if (SUCCEEDED(hr))
+            hr = reference.Initialize2D(format, base.width, base.height);
+        if (SUCCEEDED(hr))
+            hr = EncodeBCnLanes(base, reference.GetImage(), params, GetBCnLaneKernels(KernelLevel::Scalar));
+
+        const KernelLevel levels[] = { KernelLevel::SSE2, KernelLevel::AVX2 };
+        for (KernelLevel level : levels)
+        {
+            const BCnLaneKernels* kernels = GetBCnLaneKernels(level);
+            if (!kernels || FAILED(hr))
+                continue;
+
+            hr = EncodeBCnLanes(base, encoded.GetImage(), params, kernels);
+            if (FAILED(hr)) break;
+
+            const Image& a = reference.GetImage();
+            const Image& b = encoded.GetImage();
+            bool same = memcmp(a.pixels, b.pixels, a.slicePitch) == 0;
+            pass = pass && same;
+
+            fwprintf(f, L"%-6s kernels %u lanes vs scalar: %s\n", formatNames[fi], unsigned(kernels->lanes),
+                same ? L"identical" : L"DIFFERENT");
+        }
+    }
+
+    fclose(f);
+
+    if (FAILED(hr)) return hr;
+    return pass ? S_OK : S_FALSE;
+}
+
+// -------------------------------------------------------------
+// TRAZAS
+// -------------------------------------------------------------
+
+// Activa/desactiva las trazas (ver Trace.h). eventsPerThread: tamano
+// del buffer circular de cada hilo nuevo (0 = sin cambios).
+extern "C" __declspec(dllexport)
+HRESULT __stdcall SetTracingW(int enabled, unsigned eventsPerThread)
+{
+    if (!kTraceCompiled)
+        return enabled ? E_NOTIMPL : S_OK;
+
+    Trace::Configure(enabled != 0, eventsPerThread);
+    return S_OK;
+}
+
+// Vuelca los spans guardados como JSON de Chrome trace (chrome://tracing
+// o Perfetto). Con clear != 0 los buffers se vacian despues.
+extern "C" __declspec(dllexport)
+HRESULT __stdcall WriteChromeTraceW(const wchar_t* path, int clear)
+{
+    HRESULT hr = Trace::WriteChromeTrace(path);
+
+    if (SUCCEEDED(hr) && clear)
+        Trace::Clear();
+
+    return hr;
+}
+
+// -------------------------------------------------------------
+// POOL DE BUFFERS
+// -------------------------------------------------------------
+
+// Limite de lo que se guarda entre llamadas y paginas grandes (0/1)
+extern "C" __declspec(dllexport)
+void __stdcall SetBufferPoolW(unsigned long long maxRetainedBytes, int useLargePages)
+{
+    BufferPool::Configure(maxRetainedBytes, useLargePages != 0);
+}
+
+// Contadores del pool (aciertos, reservas al sistema, bytes en uso...).
+// Con reset != 0 los contadores vuelven a 0 despues de leerlos.
+extern "C" __declspec(dllexport)
+HRESULT __stdcall GetBufferPoolStatsW(BufferPoolStats* stats, int reset)
+{
+    if (!stats)
+        return E_INVALIDARG;
+
+    BufferPool::GetStats(*stats);
+
+    if (reset)
+        BufferPool::ResetStats();
+
+    return S_OK;
+}
+
+// -------------------------------------------------------------
+// CACHE DE BLOQUES
+// -------------------------------------------------------------
+
+// Activa la cache de bloques codificados (ver BlockCache.h) para todas
+// las conversiones siguientes, con hasta maxEntries bloques (0 = la
+// desactiva y la vacia). loadPath (opcional) anade los de un archivo
+// de SaveBlockCacheW; S_FALSE si no existe o es de otra version.
+extern "C" __declspec(dllexport)
+HRESULT __stdcall SetBlockCacheW(unsigned long long maxEntries, const wchar_t* loadPath)
+{
+    BlockCache::Configure(maxEntries);
+
+    if (!maxEntries || !loadPath)
+        return S_OK;
+
+    return BlockCache::Load(loadPath);
+}
+
+extern "C" __declspec(dllexport)
+HRESULT __stdcall SaveBlockCacheW(const wchar_t* path)
+{
+    return BlockCache::Save(path);
+}
+
+// Aciertos, bloques codificados y tiempo ahorrado (estimado) desde el
+// ultimo reset. Con reset != 0 los contadores vuelven a 0 despues.
+extern "C" __declspec(dllexport)
+HRESULT __stdcall GetBlockCacheStatsW(BlockCacheStats* stats, int reset)
+{
+    if (!stats)
+        return E_INVALIDARG;
+
+    BlockCache::GetStats(*stats);
+
+    if (reset)
+        BlockCache::ResetStats();
+
+    return S_OK;
+}
+
+// -------------------------------------------------------------
+// CALIDAD OBJETIVO
+// -------------------------------------------------------------
+
+struct QualityCandidateInfo
+{
+    QualityCandidate id;
+    DXGI_FORMAT format;
+    BC7Quality quality;     // solo BC7
+};
+
+// Orden de coste: tiempo de codificacion y, al final, tamano (4 B/px)
+static const QualityCandidateInfo kQualityCandidates[] =
+{
+    { QUALITY_BC3,              DXGI_FORMAT_BC3_UNORM,      BC7Quality::UltraFast },
+    { QUALITY_BC7_ULTRAFAST,    DXGI_FORMAT_BC7_UNORM,      BC7Quality::UltraFast },
+    { QUALITY_BC7_QUICKONLY,    DXGI_FORMAT_BC7_UNORM,      BC7Quality::QuickOnly },
+    { QUALITY_BC7_FASTBALANCED, DXGI_FORMAT_BC7_UNORM,      BC7Quality::FastBalanced },
+    { QUALITY_BC7_BALANCED,     DXGI_FORMAT_BC7_UNORM,      BC7Quality::Balanced },
+    { QUALITY_BC7_HIGHQUALITY,  DXGI_FORMAT_BC7_UNORM,      BC7Quality::HighQualityUniform },
+    { QUALITY_UNCOMPRESSED,     DXGI_FORMAT_R8G8B8A8_UNORM, BC7Quality::UltraFast },
+};
+
+// En vez de la cadena de reglas: el primer candidato cuya calidad
+// (metric: 0 = PSNR en dB, 1 = SSIM, sobre RGBA premultiplicado) llega
+// a minQuality. Cada candidato se decodifica y compara antes de probar
+// el siguiente; sin comprimir siempre cumple.
+// Devuelve el QualityCandidate (> 0) o un HRESULT de error.
+extern "C" __declspec(dllexport)
+int __stdcall ConvertPNGtoDDSQualityW(const wchar_t* src, const wchar_t* dst, int metric, double minQuality, QualityTargetStats* stats)
+{
+    TraceFileScope traceFile(src);
+
+    if (stats)
+        *stats = QualityTargetStats();
+
+    if (metric != int(QualityMetric::PSNR) && metric != int(QualityMetric::SSIM))
+        return E_INVALIDARG;
+
+    TexMetadata meta;
+    ScratchImage img;
+
+    HRESULT hr = LoadSourceImage(src, WIC_FLAGS_IGNORE_SRGB, meta, img);
+    if (FAILED(hr)) return hr;
+
+    PooledImage converted;
+    Image rgba;
+    hr = GetRGBAView(img, converted, rgba);
+    if (FAILED(hr)) return hr;
+
+    QualityTargetStats local = {};
+    double encodeMs = 0.0;
+    double verifyMs = 0.0;
+
+    PooledImage encoded;
+
+    for (const auto& c : kQualityCandidates)
+    {
+        ++local.tried;
+
+        if (!IsCompressed(c.format))
+        {
+            // Sin perdida: no hay nada que comparar
+            hr = SaveImageToDDSFile(rgba, dst);
+            if (FAILED(hr)) return hr;
+
+            local.candidate = c.id;
+            local.psnr = kMaxPSNR;
+            local.ssim = 1.0;
+            break;
+        }
+
+        hr = encoded.Initialize2D(c.format, rgba.width, rgba.height);
+        if (FAILED(hr)) return hr;
+
+        TEX_COMPRESS_FLAGS flags = (c.format == DXGI_FORMAT_BC7_UNORM) ? GetBC7CompressFlags(c.quality) : GetBC3CompressFlags();
+
+        double t0 = BenchmarkNowMs();
+        hr = CompressTiled(rgba, c.format, flags, encoded.GetImage(), GetDefaultTileEncodeOptions());
+        double t1 = BenchmarkNowMs();
+        encodeMs += t1 - t0;
+        if (FAILED(hr)) return hr;
+
+        QualityScore score;
+        hr = MeasureEncodedQuality(rgba, encoded.GetImage(), score);
+        verifyMs += BenchmarkNowMs() - t1;
+        if (FAILED(hr)) return hr;
+
+        if (GetQualityValue(score, QualityMetric(metric)) >= minQuality)
+        {
+            hr = SaveImageToDDSFile(encoded.GetImage(), dst);
+            if (FAILED(hr)) return hr;
+
+            local.candidate = c.id;
+            local.psnr = score.psnr;
+            local.ssim = score.ssim;
+            break;
+        }
+    }
+
+    local.encodeMs = uint32_t(encodeMs + 0.5);
+    local.verifyMs = uint32_t(verifyMs + 0.5);
+
+    if (stats)
+        *stats = local;
+
+    return local.candidate;
+}
+
+// -------------------------------------------------------------
+// CACHE INCREMENTAL
+// -------------------------------------------------------------
+
+// Subir cada vez que cambie la cadena de reglas o algun umbral:
+// invalida todas las entradas del cache.
+static const uint32_t kRuleEngineVersion = 7;
+
+static uint32_t HashSettings(uint32_t h, const void* data, size_t size)
+{
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i)
+        h = (h ^ p[i]) * 16777619u;
+    return h;
+}
+
+// Ajustes globales del codificador que cambian los bytes de salida
+// sin pasar por las reglas: entran en la clave junto a la firma
+static uint32_t EncoderSettingsWord()
+{
+    uint32_t h = 2166136261u;
+
+    for (int q = int(BC7Quality::UltraFast); q <= int(BC7Quality::QuickOnly); ++q)
+    {
+        int32_t backend = int32_t(GetBC7Backend(BC7Quality(q)));
+        h = HashSettings(h, &backend, sizeof(backend));
+    }
+
+    float pruning = GetBC7Pruning();
+    h = HashSettings(h, &pruning, sizeof(pruning));
+
+    int32_t bcn = int32_t(GetBCnEncoder());
+    h = HashSettings(h, &bcn, sizeof(bcn));
+
+    // Con lambda 0 la ventana no cambia nada
+    BlockRDOParams rdo = GetBlockRDO();
+    if (!(rdo.lambda > 0.0f))
+        rdo = BlockRDOParams{ 0.0f, 0 };
+    h = HashSettings(h, &rdo.lambda, sizeof(rdo.lambda));
+    h = HashSettings(h, &rdo.window, sizeof(rdo.window));
+
+    // La calidad de partida de la regla final sale del modelo de coste,
+    // que divide por los hilos de CompressTiled
+    double cost[kBC7QualityCount][kEncodeCostTerms];
+    GetEncodeCostTable(cost);
+    h = HashSettings(h, cost, sizeof(cost));
+
+    uint32_t threads = ResolveTileThreads(GetDefaultTileEncodeOptions());
+    h = HashSettings(h, &threads, sizeof(threads));
+
+    return h;
+}
+
+extern "C" __declspec(dllexport)
+int __stdcall ConvertPNGtoDDSCachedW(const wchar_t* src, const wchar_t* dst, const wchar_t* cacheDir)
+{
+    TraceFileScope traceFile(src);
+
+    ConversionCache* cache = ConversionCache::Open(cacheDir);
+    if (!cache)
+        return ConvertPNGtoDDSW(src, dst);
+
+    // Version del motor + tabla de reglas y lo que la ruta cumple de ella
+    // + ajustes del codificador
+    uint32_t encoder = EncoderSettingsWord();
+    uint32_t settings = HashSettings(RuleTable::Current()->Signature(src), &encoder, sizeof(encoder));
+
+    // 1. Mismo archivo, misma fecha y tamano, mismos ajustes -> no hay nada que hacer
+    ConversionCache::FileStamp stamp;
+    bool hasStamp = ConversionCache::GetFileStamp(src, stamp);
+
+    int ruleId = 0;
+    if (hasStamp && cache->IsUpToDate(src, dst, stamp, kRuleEngineVersion, settings, ruleId))
+        return ruleId;
+
+    // 2. Clave por contenido: pixeles + version + ajustes
+    TexMetadata meta;
+    ScratchImage img;
+
+    HRESULT hr = LoadSourceImage(src, WIC_FLAGS_IGNORE_SRGB, meta, img);
+    if (FAILED(hr)) return hr;
+
+    ConversionCache::Key key = ConversionCache::ComputeKey(*img.GetImage(0, 0, 0), kRuleEngineVersion, settings);
+
+    // 3. Se codifica solo si nadie lo hizo antes (en esta u otra ruta)
+    ruleId = cache->GetOrCreate(key, [&](const wchar_t* objectPath)
+        {
+            return ConvertImageToDDS(img, src, objectPath);
+        });
+
+    if (ruleId <= 0)
+        return ruleId;
+
+    if (!CopyFileW(cache->ObjectPath(key).c_str(), dst, FALSE))
+        return HRESULT_FROM_WIN32(GetLastError());
+
+    if (hasStamp)
+        cache->RecordFile(src, dst, stamp, kRuleEngineVersion, settings, key);
+
+    return ruleId;
+}
+
+// -------------------------------------------------------------
+// CONVERSION POR LOTES
+// -------------------------------------------------------------
+struct ConvertBatchResult
+{
+    int     ruleId;             // RuleId si termino bien, 0 si fallo
+    HRESULT hr;                 // S_OK o el error de ese archivo
+    wchar_t source[MAX_PATH];   // ruta de origen (relativa en modo directorio)
+};
+
+static void SetBatchResult(ConvertBatchResult& r, int ret, const wchar_t* source)
+{
+    // ConvertPNGtoDDSW devuelve el RuleId (> 0) o un HRESULT de error
+    r.ruleId = (ret > 0) ? ret : 0;
+    r.hr = (ret > 0) ? S_OK : (ret == 0 ? E_UNEXPECTED : HRESULT(ret));
+    wcsncpy_s(r.source, source, _TRUNCATE);
+}
+
+static HRESULT RunConvertBatch(
+    const std::vector<std::wstring>& srcs,
+    const std::vector<std::wstring>& dsts,
+    const std::vector<std::wstring>& names,
+    unsigned workers,
+    const wchar_t* cacheDir,
+    ConvertBatchResult* results)
+{
+    // Cada worker necesita COM para WIC
+    WorkStealingPool pool(
+        workers,
+        []() { CoInitializeEx(nullptr, COINIT_MULTITHREADED); },
+        []() { CoUninitialize(); });
+
+    for (size_t i = 0; i < srcs.size(); ++i)
+    {
+        pool.Submit([&, i]()
+            {
+                int ret = ConvertPNGtoDDSCachedW(srcs[i].c_str(), dsts[i].c_str(), cacheDir);
+                SetBatchResult(results[i], ret, names[i].c_str());
+            });
+    }
+
+    pool.Wait();
+
+    for (size_t i = 0; i < srcs.size(); ++i)
+    {
+        if (FAILED(results[i].hr))
+            return S_FALSE;
+    }
+
+    return S_OK;
+}
+
+extern "C" __declspec(dllexport)
+HRESULT __stdcall ConvertPNGtoDDSBatchW(
+    const wchar_t* const* srcs,
+    const wchar_t* const* dsts,
+    unsigned count,
+    unsigned workers,               // 0 = un worker por core
+    const wchar_t* cacheDir,        // nullptr = sin cache incremental
+    ConvertBatchResult* results)    // 'count' elementos
+{
+    if (!srcs || !dsts || !results)
+        return E_INVALIDARG;
+
+    std::vector<std::wstring> srcList, dstList;
+    srcList.reserve(count);
+    dstList.reserve(count);
+
+    for (unsigned i = 0; i < count; ++i)
+    {
+        if (!srcs[i] || !dsts[i])
+            return E_INVALIDARG;
+
+        srcList.emplace_back(srcs[i]);
+        dstList.emplace_back(dsts[i]);
+    }
+
+    return RunConvertBatch(srcList, dstList, srcList, workers, cacheDir, results);
+}
+
+// Lista recursiva de *.png bajo 'root' (rutas relativas, ordenadas)
+static void CollectPNGFiles(const std::wstring& root, const std::wstring& rel, std::vector<std::wstring>& out)
+{
+    std::wstring pattern = root + L"\\" + rel + (rel.empty() ? L"*" : L"\\*");
+
+    WIN32_FIND_DATAW fd;
+    HANDLE hFind = FindFirstFileW(pattern.c_str(), &fd);
+    if (hFind == INVALID_HANDLE_VALUE)
+        return;
+
+    do
+    {
+        std::wstring name = fd.cFileName;
+        if (name == L"." || name == L"..")
+            continue;
+
+        std::wstring childRel = rel.empty() ? name : rel + L"\\" + name;
+
+        if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+        {
+            CollectPNGFiles(root, childRel, out);
+        }
+        else if (name.size() > 4 && _wcsicmp(name.c_str() + name.size() - 4, L".png") == 0)
+        {
+            out.push_back(childRel);
+        }
+    } while (FindNextFileW(hFind, &fd));
+
+    FindClose(hFind);
+}
+
+// Crea todos los directorios intermedios de 'path' (sin el nombre de archivo)
+static void EnsureParentDirectories(const std::wstring& path)
+{
+    for (size_t pos = path.find(L'\\', 3); pos != std::wstring::npos; pos = path.find(L'\\', pos + 1))
+    {
+        CreateDirectoryW(path.substr(0, pos).c_str(), nullptr);
+    }
+}
+
+extern "C" __declspec(dllexport)
+HRESULT __stdcall ConvertPNGDirectoryToDDSW(
+    const wchar_t* srcRoot,
+    const wchar_t* dstRoot,
+    unsigned workers,               // 0 = un worker por core
+    const wchar_t* cacheDir,        // nullptr = sin cache incremental
+    ConvertBatchResult* results,    // nullptr = solo contar archivos
+    unsigned capacity,
+    unsigned* fileCount)
+{
+    if (!srcRoot || !dstRoot || !fileCount)
+        return E_INVALIDARG;
+
+    std::wstring src(srcRoot), dst(dstRoot);
+    for (auto& c : src) if (c == L'/') c = L'\\';
+    for (auto& c : dst) if (c == L'/') c = L'\\';
+    while (!src.empty() && src.back() == L'\\') src.pop_back();
+    while (!dst.empty() && dst.back() == L'\\') dst.pop_back();
+
+    std::vector<std::wstring> rel;
+    CollectPNGFiles(src, L"", rel);
+    std::sort(rel.begin(), rel.end());
+
+    *fileCount = unsigned(rel.size());
+
+    if (!results)
+        return S_OK;
+
+    if (capacity < rel.size())
+        return HRESULT_FROM_WIN32(ERROR_INSUFFICIENT_BUFFER);
+
+    std::vector<std::wstring> srcList, dstList;
+    srcList.reserve(rel.size());
+    dstList.reserve(rel.size());
+
+    for (const auto& r : rel)
+    {
+        std::wstring out = dst + L"\\" + r.substr(0, r.size() - 4) + L".dds";
+        EnsureParentDirectories(out);
+
+        srcList.push_back(src + L"\\" + r);
+        dstList.push_back(out);
+    }
+
+    return RunConvertBatch(srcList, dstList, rel, workers, cacheDir, results);
+}
+
+// -------------------------------------------------------------
+// DECODIFICADOR BC Y VERIFICACION
+// -------------------------------------------------------------
+
+// Primera imagen de un DDS a 'rgba' (R8G8B8A8, mismo tamano, ya
+// reservado). BC1/BC3/BC4/BC5/BC7 con DecodeBC; el resto con
+// Decompress/Convert y copia.
+static HRESULT DecodeToRGBA(const Image& src, const Image& rgba, bool parallel)
+{
+    if (IsBCDecodeFormat(src.format))
+        return DecodeBC(src, rgba, parallel);
+
+    if (src.width != rgba.width || src.height != rgba.height)
+        return E_INVALIDARG;
+
+    ScratchImage tmp;
+    const Image* rows = &src;
+
+    if (src.format != DXGI_FORMAT_R8G8B8A8_UNORM && src.format != DXGI_FORMAT_R8G8B8A8_UNORM_SRGB)
+    {
+        HRESULT hr = IsCompressed(src.format)
+            ? Decompress(src, DXGI_FORMAT_R8G8B8A8_UNORM, tmp)
+            : Convert(src, DXGI_FORMAT_R8G8B8A8_UNORM, TEX_FILTER_DEFAULT, 0.0f, tmp);
+        if (FAILED(hr)) return hr;
+
+        rows = tmp.GetImage(0, 0, 0);
+    }
+
+    for (size_t y = 0; y < src.height; ++y)
+        memcpy(rgba.pixels + y * rgba.rowPitch, rows->pixels + y * rows->rowPitch, src.width * 4);
+
+    return S_OK;
+}
+
+// Bloques BC1/BC3/BC4/BC5/BC7 (DXGI_FORMAT) a RGBA8 en 'dst', del
+// llamador. srcRowPitch 0 = filas de bloques seguidas.
+extern "C" __declspec(dllexport)
+HRESULT __stdcall DecodeBCW(
+    const uint8_t* blocks,
+    unsigned width,
+    unsigned height,
+    int format,
+    unsigned srcRowPitch,
+    uint8_t* dst,
+    unsigned dstRowPitch)
+{
+    if (!blocks || !dst || !width || !height)
+        return E_INVALIDARG;
+
+    DXGI_FORMAT fmt = DXGI_FORMAT(format);
+    if (!IsBCDecodeFormat(fmt))
+        return HRESULT_E_NOT_SUPPORTED;
+
+    Image bc = {};
+    bc.width = width;
+    bc.height = height;
+    bc.format = fmt;
+    bc.pixels = const_cast<uint8_t*>(blocks);
+
+    HRESULT hr = ComputePitch(fmt, width, height, bc.rowPitch, bc.slicePitch);
+    if (FAILED(hr)) return hr;
+
+    if (srcRowPitch)
+    {
+        bc.rowPitch = srcRowPitch;
+        bc.slicePitch = size_t(srcRowPitch) * ((size_t(height) + 3) / 4);
+    }
+
+    Image rgba = {};
+    rgba.width = width;
+    rgba.height = height;
+    rgba.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    rgba.rowPitch = dstRowPitch;
+    rgba.slicePitch = size_t(dstRowPitch) * height;
+    rgba.pixels = dst;
+
+    return DecodeBC(bc, rgba, true);
+}
+
+// Mip 0 de un DDS a RGBA8 en 'dst' (height * dstRowPitch bytes).
+// dst == nullptr: solo devuelve width/height.
+extern "C" __declspec(dllexport)
+HRESULT __stdcall DecodeDDSFileW(
+    const wchar_t* ddsPath,
+    uint8_t* dst,
+    unsigned dstRowPitch,
+    unsigned* width,
+    unsigned* height)
+{
+    if (!ddsPath || !width || !height)
+        return E_INVALIDARG;
+
+    TexMetadata meta;
+    ScratchImage dds;
+    HRESULT hr = LoadFromDDSFile(ddsPath, DDS_FLAGS_NONE, &meta, dds);
+    if (FAILED(hr)) return hr;
+
+    *width = unsigned(meta.width);
+    *height = unsigned(meta.height);
+
+    if (!dst)
+        return S_OK;
+
+    if (dstRowPitch < meta.width * 4)
+        return HRESULT_FROM_WIN32(ERROR_INSUFFICIENT_BUFFER);
+
+    Image rgba = {};
+    rgba.width = meta.width;
+    rgba.height = meta.height;
+    rgba.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    rgba.rowPitch = dstRowPitch;
+    rgba.slicePitch = size_t(dstRowPitch) * meta.height;
+    rgba.pixels = dst;
+
+    return DecodeToRGBA(*dds.GetImage(0, 0, 0), rgba, true);
+}
+
+// Un par PNG / DDS: decodifica el DDS en el hilo que llama (el
+// paralelismo va por archivos) y lo compara con el PNG
+static void VerifyDDSFile(const std::wstring& png, const std::wstring& dds, VerifyDDSResult& r)
+{
+    TexMetadata meta;
+    ScratchImage img;
+    r.hr = LoadSourceImage(png.c_str(), WIC_FLAGS_IGNORE_SRGB, meta, img);
+    if (FAILED(r.hr)) return;
+
+    PooledImage converted;
+    Image ref;
+    r.hr = GetRGBAView(img, converted, ref);
+    if (FAILED(r.hr)) return;
+
+    TexMetadata ddsMeta;
+    ScratchImage encoded;
+    r.hr = LoadFromDDSFile(dds.c_str(), DDS_FLAGS_NONE, &ddsMeta, encoded);
+    if (FAILED(r.hr)) return;
+
+    r.format = int32_t(ddsMeta.format);
+    r.width = uint32_t(ddsMeta.width);
+    r.height = uint32_t(ddsMeta.height);
+
+    if (ddsMeta.width != ref.width || ddsMeta.height != ref.height)
+    {
+        r.hr = HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+        return;
+    }
+
+    PooledImage decoded;
+    r.hr = decoded.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM, ref.width, ref.height);
+    if (FAILED(r.hr)) return;
+
+    double t0 = BenchmarkNowMs();
+    r.hr = DecodeToRGBA(*encoded.GetImage(0, 0, 0), decoded.GetImage(), false);
+    r.decodeMs = BenchmarkNowMs() - t0;
+    if (FAILED(r.hr)) return;
+
+    QualityScore score;
+    r.hr = CompareImages(ref, decoded.GetImage(), score);
+    r.psnr = score.psnr;
+    r.ssim = score.ssim;
+}
+
+// Verificacion de ida y vuelta de un arbol de salida: cada *.png de
+// srcRoot contra el .dds con la misma ruta relativa bajo ddsRoot (lo
+// que genera ConvertPNGDirectoryToDDSW). Escribe PSNR/SSIM por archivo
+// en reportPath (puede ser null) y en 'results'. S_FALSE si algun
+// archivo fallo o su PSNR es menor que minPsnr (0 = sin minimo).
+extern "C" __declspec(dllexport)
+HRESULT __stdcall VerifyDDSDirectoryW(
+    const wchar_t* srcRoot,
+    const wchar_t* ddsRoot,
+    unsigned workers,               // 0 = un worker por core
+    double minPsnr,
+    const wchar_t* reportPath,
+    VerifyDDSResult* results,       // nullptr = solo contar archivos
+    unsigned capacity,
+    unsigned* fileCount)
+{
+    if (!srcRoot || !ddsRoot || !fileCount)
+        return E_INVALIDARG;
+
+    std::wstring src(srcRoot), dds(ddsRoot);
+    for (auto& c : src) if (c == L'/') c = L'\\';
+    for (auto& c : dds) if (c == L'/') c = L'\\';
+    while (!src.empty() && src.back() == L'\\') src.pop_back();
+    while (!dds.empty() && dds.back() == L'\\') dds.pop_back();
+
+    std::vector<std::wstring> rel;
+    CollectPNGFiles(src, L"", rel);
+    std::sort(rel.begin(), rel.end());
+
+    *fileCount = unsigned(rel.size());
+
+    if (!results)
+        return S_OK;
+
+    if (capacity < rel.size())
+        return HRESULT_FROM_WIN32(ERROR_INSUFFICIENT_BUFFER);
+
+    TraceSpan span("VerifyDDSDirectory");
+    double t0 = BenchmarkNowMs();
+
+    {
+        // Cada worker necesita COM para WIC
+        WorkStealingPool pool(
+            workers,
+            []() { CoInitializeEx(nullptr, COINIT_MULTITHREADED); },
+            []() { CoUninitialize(); });
+
+        for (size_t i = 0; i < rel.size(); ++i)
+        {
+            pool.Submit([&, i]()
+                {
+                    VerifyDDSResult& r = results[i];
+                    r = {};
+                    wcsncpy_s(r.source, rel[i].c_str(), _TRUNCATE);
+                    VerifyDDSFile(src + L"\\" + rel[i], dds + L"\\" + rel[i].substr(0, rel[i].size() - 4) + L".dds", r);
+                });
+        }
+
+        pool.Wait();
+    }
+
+    double wallMs = BenchmarkNowMs() - t0;
+
+    unsigned failed = 0, belowMin = 0;
+    double decodeMs = 0.0, mpix = 0.0;
+    for (size_t i = 0; i < rel.size(); ++i)
+    {
+        if (FAILED(results[i].hr))
+        {
+            ++failed;
+            continue;
+        }
+
+        if (minPsnr > 0.0 && results[i].psnr < minPsnr)
+            ++belowMin;
+        decodeMs += results[i].decodeMs;
+        mpix += double(results[i].width) * double(results[i].height) / 1e6;
+    }
+
+    FILE* f = nullptr;
+    if (reportPath && _wfopen_s(&f, reportPath, L"w, ccs=UTF-8") == 0 && f)
+    {
+        fwprintf(f, L"# %s -> %s  %u files  %u failed  %u below %.2f dB  wall %.1f ms  decode %.1f ms (%.1f MP/s)\n",
+            src.c_str(), dds.c_str(), unsigned(rel.size()), failed, belowMin, minPsnr, wallMs, decodeMs,
+            decodeMs > 0.0 ? mpix * 1000.0 / decodeMs : 0.0);
+        fwprintf(f, L"%-48s %6s %11s %9s %8s %10s %s\n", L"file", L"format", L"size", L"dB", L"SSIM", L"decode ms", L"result");
+
+        for (size_t i = 0; i < rel.size(); ++i)
+        {
+            const VerifyDDSResult& r = results[i];
+            wchar_t size[32];
+            swprintf_s(size, L"%ux%u", r.width, r.height);
+
+            if (FAILED(r.hr))
+                fwprintf(f, L"%-48s %6d %11s %9s %8s %10s 0x%08X\n", r.source, r.format, size, L"-", L"-", L"-", unsigned(r.hr));
+            else
+                fwprintf(f, L"%-48s %6d %11s %9.2f %8.4f %10.2f %s\n", r.source, r.format, size, r.psnr, r.ssim, r.decodeMs,
+                    (minPsnr > 0.0 && r.psnr < minPsnr) ? L"LOW" : L"ok");
+        }
+
+        fclose(f);
+    }
+
+    return (failed || belowMin) ? S_FALSE : S_OK;
+}
+
+// Benchmark: 'src' codificado en BC1/BC3/BC4/BC5/BC7 (BC7 FastBalanced)
+// y decodificado con Decompress y con DecodeBC (1 hilo y por bandas).
+// Escribe tiempos, MP/s y la diferencia maxima contra Decompress en
+// reportPath, y si los niveles de kernel dan los mismos bytes.
+// S_FALSE si algun nivel no coincide.
+extern "C" __declspec(dllexport)
+HRESULT __stdcall BenchmarkBCDecoderW(const wchar_t* src, const wchar_t* reportPath)
+{
+    TexMetadata meta;
+    ScratchImage img;
+
+    HRESULT hr = LoadSourceImage(src, WIC_FLAGS_IGNORE_SRGB, meta, img);
+    if (FAILED(hr)) return hr;
+
+    PooledImage converted;
+    Image base;
+    hr = GetRGBAView(img, converted, base);
+    if (FAILED(hr)) return hr;
+
+    FILE* f = nullptr;
+    if (!reportPath || _wfopen_s(&f, reportPath, L"w, ccs=UTF-8") != 0 || !f)
+        return E_INVALIDARG;
+
+    TileEncodeOptions tiled = GetDefaultTileEncodeOptions();
+    double mpix = double(base.width) * double(base.height) / 1e6;
+    bool pass = true;
+
+    fwprintf(f, L"# %s  %ux%u  threads %u  kernels %d\n", src, unsigned(meta.width), unsigned(meta.height),
+        ResolveTileThreads(tiled), int(GetBCDecodeKernels().level));
+    fwprintf(f, L"%-6s %14s %10s %10s %10s %8s %9s\n", L"format", L"Decompress ms", L"serial ms", L"tiled ms", L"MP/s", L"speedup", L"max diff");
+
+    const DXGI_FORMAT formats[] = { DXGI_FORMAT_BC1_UNORM, DXGI_FORMAT_BC3_UNORM, DXGI_FORMAT_BC4_UNORM, DXGI_FORMAT_BC5_UNORM, DXGI_FORMAT_BC7_UNORM };
+    const wchar_t* formatNames[] = { L"BC1", L"BC3", L"BC4", L"BC5", L"BC7" };
+
+    PooledImage decoded, other;
+    hr = decoded.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM, base.width, base.height);
+    if (SUCCEEDED(hr))
+        hr = other.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM, base.width, base.height);
+
+    for (int fi = 0; fi < 5 && SUCCEEDED(hr); ++fi)
+    {
+        DXGI_FORMAT format = formats[fi];
+        TEX_COMPRESS_FLAGS flags = (format == DXGI_FORMAT_BC7_UNORM)
+            ? GetBC7CompressFlags(BC7Quality::FastBalanced) : GetBC3CompressFlags();
+
+        PooledImage encoded;
+        hr = encoded.Initialize2D(format, base.width, base.height);
+        if (SUCCEEDED(hr))
+            hr = CompressTiled(base, format, flags, encoded.GetImage(), tiled);
+        if (FAILED(hr)) break;
+
+        const Image& bc = encoded.GetImage();
+        const Image& a = decoded.GetImage();
+        const Image& b = other.GetImage();
+
+        double t0 = BenchmarkNowMs();
+        ScratchImage reference;
+        hr = Decompress(bc, DXGI_FORMAT_R8G8B8A8_UNORM, reference);
+        double decompressMs = BenchmarkNowMs() - t0;
+        if (FAILED(hr)) break;
+
+        t0 = BenchmarkNowMs();
+        hr = DecodeBC(bc, a, false);
+        double serialMs = BenchmarkNowMs() - t0;
+        if (FAILED(hr)) break;
+
+        t0 = BenchmarkNowMs();
+        hr = DecodeBC(bc, a, true);
+        double tiledMs = BenchmarkNowMs() - t0;
+        if (FAILED(hr)) break;
+
+        const Image* r = reference.GetImage(0, 0, 0);
+        int maxDiff = 0;
+        for (size_t y = 0; y < base.height; ++y)
+        {
+            const uint8_t* pa = a.pixels + y * a.rowPitch;
+            const uint8_t* pr = r->pixels + y * r->rowPitch;
+            for (size_t x = 0; x < base.width * 4; ++x)
+                maxDiff = std::max(maxDiff, std::abs(int(pa[x]) - int(pr[x])));
+        }
+
+        fwprintf(f, L"%-6s %14.1f %10.1f %10.1f %10.2f %7.2fx %9d\n", formatNames[fi], decompressMs, serialMs, tiledMs,
+            tiledMs > 0.0 ? mpix * 1000.0 / tiledMs : 0.0, tiledMs > 0.0 ? decompressMs / tiledMs : 0.0, maxDiff);
+
+        // Niveles de kernel: todos tienen que dar los mismos bytes
+        const KernelLevel levels[] = { KernelLevel::Scalar, KernelLevel::SSE2 };
+        for (KernelLevel level : levels)
+        {
+            const BCDecodeKernels* kernels = GetBCDecodeKernels(level);
+            if (!kernels || kernels->level == GetBCDecodeKernels().level)
+                continue;
+
+            hr = DecodeBC(bc, b, true, kernels);
+            if (FAILED(hr)) break;
+
+            bool same = true;
+            for (size_t y = 0; y < base.height && same; ++y)
+                same = memcmp(a.pixels + y * a.rowPitch, b.pixels + y * b.rowPitch, base.width * 4) == 0;
+            pass = pass && same;
+
+            fwprintf(f, L"%-6s kernels %d vs %d: %s\n", formatNames[fi], int(level), int(GetBCDecodeKernels().level),
+                same ? L"identical" : L"DIFFERENT");
+        }
+    }
+
+    fclose(f);
+
+    if (FAILED(hr)) return hr;
+    return pass ? S_OK : S_FALSE;
+}
+
+// -------------------------------------------------------------
+// RDO DE BLOQUES
+// -------------------------------------------------------------
+
+// RDO de bloques (ver BlockRDO.h) para todas las codificaciones BC7/BC3
+// siguientes: lambda 0 = desactivado; window 0 = kDefaultRDOWindow
+extern "C" __declspec(dllexport)
+void __stdcall SetBlockRDOW(double lambda, unsigned window)
+{
+    BlockRDOParams params;
+    params.lambda = float(lambda);
+    params.window = window ? window : kDefaultRDOWindow;
+    SetBlockRDO(params);
+}
+
+// Copias y reajustes desde el ultimo reset. Con reset != 0 los
+// contadores vuelven a 0 despues de leerlos.
+extern "C" __declspec(dllexport)
+HRESULT __stdcall GetBlockRDOStatsW(BlockRDOStats* stats, int reset)
+{
+    if (!stats)
+        return E_INVALIDARG;
+
+    GetBlockRDOStats(*stats);
+
+    if (reset)
+        ResetBlockRDOStats();
+
+    return S_OK;
+}
+
+// Bytes de 'bc' tras el LZ del sistema (XPRESS + Huffman), como en un
+// paquete comprimido; 0 si falla
+static size_t CompressedBlockBytes(const Image& bc)
+{
+    COMPRESSOR_HANDLE compressor = nullptr;
+    if (!CreateCompressor(COMPRESS_ALGORITHM_XPRESS_HUFF, nullptr, &compressor))
+        return 0;
+
+    std::vector<uint8_t> packed(bc.slicePitch + bc.slicePitch / 8 + 4096);
+    SIZE_T size = 0;
+    BOOL ok = ::Compress(compressor, bc.pixels, bc.slicePitch, packed.data(), packed.size(), &size);
+
+    CloseCompressor(compressor);
+    return ok ? size_t(size) : 0;
+}
+
+// Curvas tamano / calidad del RDO: 'src' en BC7 FastBalanced y BC3 con
+// varios lambda, y BC7 FastBalanced por la ruta con limite de tiempo
+// (un solo tier sin limite). Escribe bytes tras LZ, lo que queda frente
+// a lambda 0, PSNR, SSIM, tiempo y el reparto de copias en reportPath.
+extern "C" __declspec(dllexport)
+HRESULT __stdcall BenchmarkBlockRDOW(const wchar_t* src, const wchar_t* reportPath)
+{
+    TexMetadata meta;
+    ScratchImage img;
+
+    HRESULT hr = LoadSourceImage(src, WIC_FLAGS_IGNORE_SRGB, meta, img);
+    if (FAILED(hr)) return hr;
+
+    PooledImage converted;
+    Image base;
+    hr = GetRGBAView(img, converted, base);
+    if (FAILED(hr)) return hr;
+
+    FILE* f = nullptr;
+    if (!reportPath || _wfopen_s(&f, reportPath, L"w, ccs=UTF-8") != 0 || !f)
+        return E_INVALIDARG;
+
+    TileEncodeOptions tiled = GetDefaultTileEncodeOptions();
+    BlockRDOParams saved = GetBlockRDO();
+
+    fwprintf(f, L"# %s  %ux%u  threads %u  window %u\n", src, unsigned(meta.width), unsigned(meta.height),
+        ResolveTileThreads(tiled), saved.window);
+    fwprintf(f, L"%-6s %8s %10s %10s %7s %8s %8s %10s %8s %8s %8s\n", L"format", L"lambda", L"bytes", L"LZ bytes",
+        L"LZ %", L"dB", L"SSIM", L"ms", L"whole", L"indices", L"refit");
+
+    // La ultima ruta es CompressBC7WithDeadline
+    const DXGI_FORMAT formats[] = { DXGI_FORMAT_BC7_UNORM, DXGI_FORMAT_BC3_UNORM, DXGI_FORMAT_BC7_UNORM };
+    const wchar_t* formatNames[] = { L"BC7", L"BC3", L"BC7 DL" };
+    const float lambdas[] = { 0.0f, 2.0f, 8.0f, 32.0f, 128.0f, 512.0f };
+    const BC7Tier deadlineTier = { BC7Quality::FastBalanced, UINT64_MAX };
+
+    for (int fi = 0; fi < 3 && SUCCEEDED(hr); ++fi)
+    {
+        DXGI_FORMAT format = formats[fi];
+        TEX_COMPRESS_FLAGS flags = (format == DXGI_FORMAT_BC7_UNORM)
+            ? GetBC7CompressFlags(BC7Quality::FastBalanced) : GetBC3CompressFlags();
+
+        PooledImage encoded;
+        hr = encoded.Initialize2D(format, base.width, base.height);
+
+        size_t referenceBytes = 0;
+        for (float lambda : lambdas)
+        {
+            if (FAILED(hr)) break;
+
+            BlockRDOParams params = saved;
+            params.lambda = lambda;
+            SetBlockRDO(params);
+            ResetBlockRDOStats();
+
+            double t0 = BenchmarkNowMs();
+            if (fi == 2)
+                hr = CompressBC7WithDeadline(base, encoded.GetImage(), &deadlineTier, 1);
+            else
+                hr = CompressTiled(base, format, flags, encoded.GetImage(), tiled);
+            double ms = BenchmarkNowMs() - t0;
+            if (FAILED(hr)) break;
+
+            QualityScore score;
+            hr = MeasureEncodedQuality(base, encoded.GetImage(), score);
+            if (FAILED(hr)) break;
+
+            size_t bytes = CompressedBlockBytes(encoded.GetImage());
+            if (lambda == 0.0f)
+                referenceBytes = bytes;
+
+            BlockRDOStats stats;
+            GetBlockRDOStats(stats);
+
+            fwprintf(f, L"%-6s %8.1f %10llu %10llu %6.1f%% %8.2f %8.4f %10.1f %8llu %8llu %8llu\n", formatNames[fi], lambda,
+                uint64_t(encoded.GetImage().slicePitch), uint64_t(bytes), referenceBytes ? 100.0 * double(bytes) / double(referenceBytes) : 0.0,
+                score.psnr, score.ssim, ms, stats.wholeCopies, stats.indexCopies, stats.refits);
+        }
+    }
+
+    SetBlockRDO(saved);
+    ResetBlockRDOStats();
+
+    fclose(f);
+    return hr;
 }
@@ -0,0 +1,490 @@
+#include "EncodeCostModel.h"
+#include "PngDecoder.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    struct CostRow
+    {
+        double c[kEncodeCostTerms];
+    };
+
+    // Valores iniciales (ms de un core por 1000 bloques) hasta que se
+    // calibre con el corpus; solo importa que el orden entre calidades
+    // sea el real. Todas van por tiles sin PARALLEL, asi que HighQuality
+    // cuesta lo mismo que FastBalanced.
+    const CostRow kDefaultCost[kBC7QualityCount] =
+    {
+        { {  20.0,  15.0,  35.0,   60.0,  20.0,  2.0 } },   // UltraFast
+        { {  40.0,  35.0,  90.0,  150.0,  50.0,  5.0 } },   // FastBalanced
+        { { 300.0, 250.0, 700.0, 1200.0, 400.0, 40.0 } },   // Balanced
+        { {  40.0,  35.0,  90.0,  150.0,  50.0,  5.0 } },   // HighQuality
+        { { 350.0, 300.0, 800.0, 1400.0, 450.0, 45.0 } },   // HighQualityUniform
+        { {  25.0,  20.0,  50.0,   80.0,  30.0,  3.0 } }    // QuickOnly
+    };
+
+    std::mutex g_costLock;
+    CostRow g_cost[kBC7QualityCount] =
+    {
+        kDefaultCost[0], kDefaultCost[1], kDefaultCost[2],
+        kDefaultCost[3], kDefaultCost[4], kDefaultCost[5]
+    };
+
+    void FeatureTerms(const EncodeCostFeatures& f, double x[kEncodeCostTerms])
+    {
+        x[0] = 1.0;
+        x[1] = f.fracLow;
+        x[2] = f.fracMid;
+        x[3] = f.fracHigh;
+        x[4] = f.alpha;
+        x[5] = f.laplacian;
+    }
+
+    double Dot(const double* c, const double* x)
+    {
+        double s = 0.0;
+        for (size_t i = 0; i < kEncodeCostTerms; ++i)
+            s += c[i] * x[i];
+        return s;
+    }
+
+    // Hilos de CompressBC7 (tiles): la tabla va en ms de un core
+    double EncodeThreads()
+    {
+        return double(std::max(1u, ResolveTileThreads(GetDefaultTileEncodeOptions())));
+    }
+
+    double Now()
+    {
+        LARGE_INTEGER t, f;
+        QueryPerformanceCounter(&t);
+        QueryPerformanceFrequency(&f);
+        return double(t.QuadPart) * 1000.0 / double(f.QuadPart);
+    }
+
+    // Una muestra de calibracion: caracteristicas + ms medidos por calidad
+    struct CostSample
+    {
+        std::wstring file;
+        EncodeCostFeatures features;
+        double ms[kBC7QualityCount];
+    };
+
+    // Minimos cuadrados ponderados (peso = miles de bloques) con un
+    // poco de ridge para que no explote con pocas muestras.
+    // 'skip' excluye una muestra (leave-one-out).
+    bool FitCost(const std::vector<CostSample>& samples, size_t q, size_t skip, double out[kEncodeCostTerms])
+    {
+        const size_t n = kEncodeCostTerms;
+        double a[kEncodeCostTerms][kEncodeCostTerms + 1] = {};
+        size_t used = 0;
+
+        for (size_t s = 0; s < samples.size(); ++s)
+        {
+            if (s == skip || samples[s].ms[q] < 0.0)
+                continue;
+
+            double kblocks = samples[s].features.blocks / 1000.0;
+            if (kblocks <= 0.0)
+                continue;
+
+            double x[kEncodeCostTerms];
+            FeatureTerms(samples[s].features, x);
+            double y = samples[s].ms[q] / kblocks;
+
+            for (size_t i = 0; i < n; ++i)
+            {
+                for (size_t j = 0; j < n; ++j)
+                    a[i][j] += kblocks * x[i] * x[j];
+                a[i][n] += kblocks * x[i] * y;
+            }
+            ++used;
+        }
+
+        if (used == 0)
+            return false;
+
+        double trace = 0.0;
+        for (size_t i = 0; i < n; ++i)
+            trace += a[i][i];
+        for (size_t i = 0; i < n; ++i)
+            a[i][i] += trace * 1e-4 + 1e-9;
+
+        // Gauss con pivoteo parcial
+        for (size_t col = 0; col < n; ++col)
+        {
+            size_t pivot = col;
+            for (size_t r = col + 1; r < n; ++r)
+                if (fabs(a[r][col]) > fabs(a[pivot][col])) pivot = r;
+
+            if (fabs(a[pivot][col]) < 1e-12)
+                return false;
+
+            for (size_t k = 0; k <= n; ++k)
+                std::swap(a[col][k], a[pivot][k]);
+
+            for (size_t r = 0; r < n; ++r)
+            {
+                if (r == col) continue;
+                double m = a[r][col] / a[col][col];
+                for (size_t k = col; k <= n; ++k)
+                    a[r][k] -= m * a[col][k];
+            }
+        }
+
+        for (size_t i = 0; i < n; ++i)
+            out[i] = a[i][n] / a[i][i];
+
+        return true;
+    }
+
+    const wchar_t* QualityName(size_t q)
+    {
+        static const wchar_t* names[kBC7QualityCount] =
+        {
+            L"UltraFast", L"FastBalanced", L"Balanced", L"HighQuality", L"HighQualityUniform", L"QuickOnly"
+        };
+        return q < kBC7QualityCount ? names[q] : L"?";
+    }
+
+    HRESULT WriteCostTable(const wchar_t* path, const CostRow* rows, const bool* valid)
+    {
+        FILE* f = nullptr;
+        if (_wfopen_s(&f, path, L"w") != 0 || !f)
+            return E_FAIL;
+
+        fprintf(f, "# BC7 encode cost: ms de un core por 1000 bloques\n");
+        fprintf(f, "# quality c0 low mid high alpha laplacian\n");
+        for (size_t q = 0; q < kBC7QualityCount; ++q)
+        {
+            if (!valid[q]) continue;
+
+            fprintf(f, "%u", unsigned(q));
+            for (size_t i = 0; i < kEncodeCostTerms; ++i)
+                fprintf(f, " %.6g", rows[q].c[i]);
+            fprintf(f, "\n");
+        }
+
+        fclose(f);
+        return S_OK;
+    }
+}
+
+void ExtractEncodeCostFeatures(const Image& img, const ImageFeatures& f, EncodeCostFeatures& out)
+{
+    TraceSpan span("ExtractEncodeCostFeatures");
+
+    out = EncodeCostFeatures();
+
+    size_t w = img.width;
+    size_t h = img.height;
+    size_t bw = (w + 3) / 4;
+    size_t bh = (h + 3) / 4;
+    if (!bw || !bh)
+        return;
+
+    size_t low = 0, mid = 0, high = 0;
+
+    for (size_t by = 0; by < bh; ++by)
+    {
+        size_t y0 = by * 4;
+        size_t y1 = std::min(y0 + 4, h);
+
+        for (size_t bx = 0; bx < bw; ++bx)
+        {
+            size_t x0 = bx * 4;
+            size_t x1 = std::min(x0 + 4, w);
+
+            uint32_t sum[4] = {};
+            uint32_t sumSq[4] = {};
+
+            for (size_t y = y0; y < y1; ++y)
+            {
+                const uint8_t* p = img.pixels + y * img.rowPitch + x0 * 4;
+                for (size_t x = x0; x < x1; ++x, p += 4)
+                {
+                    for (int c = 0; c < 4; ++c)
+                    {
+                        sum[c] += p[c];
+                        sumSq[c] += uint32_t(p[c]) * p[c];
+                    }
+                }
+            }
+
+            // n^2 * varianza total (suma de los 4 canales), en enteros
+            uint64_t n = (y1 - y0) * (x1 - x0);
+            uint64_t var = 0;
+            for (int c = 0; c < 4; ++c)
+                var += n * sumSq[c] - uint64_t(sum[c]) * sum[c];
+
+            uint64_t n2 = n * n;
+            if (var == 0)
+                continue;
+            else if (var <= 16 * n2)
+                ++low;
+            else if (var <= 256 * n2)
+                ++mid;
+            else
+                ++high;
+        }
+    }
+
+    double blocks = double(bw * bh);
+    out.blocks = blocks;
+    out.fracLow = low / blocks;
+    out.fracMid = mid / blocks;
+    out.fracHigh = high / blocks;
+
+    double pixels = double(w * h);
+    out.alpha = pixels > 0.0 ? f.alphaSoft / pixels : 0.0;
+    out.laplacian = LaplacianEnergy(f) / 1000.0;
+}
+
+double PredictBC7EncodeMs(const EncodeCostFeatures& f, BC7Quality quality)
+{
+    size_t q = size_t(quality);
+    if (q >= kBC7QualityCount)
+        return 0.0;
+
+    double x[kEncodeCostTerms];
+    FeatureTerms(f, x);
+
+    CostRow row;
+    {
+        std::lock_guard<std::mutex> lk(g_costLock);
+        row = g_cost[q];
+    }
+
+    return std::max(0.0, Dot(row.c, x)) * f.blocks / 1000.0 / EncodeThreads();
+}
+
+int BC7QualityRank(BC7Quality quality)
+{
+    switch (quality)
+    {
+        case BC7Quality::HighQualityUniform: return 0;
+        case BC7Quality::Balanced:           return 1;
+        case BC7Quality::HighQuality:
+        case BC7Quality::FastBalanced:       return 2;
+        case BC7Quality::QuickOnly:          return 3;
+        case BC7Quality::UltraFast:          return 4;
+        default:                             return 5;
+    }
+}
+
+BC7Quality PickBC7Quality(const EncodeCostFeatures& f, double budgetMs)
+{
+    static const BC7Quality ladder[] =
+    {
+        BC7Quality::HighQualityUniform,
+        BC7Quality::Balanced,
+        BC7Quality::FastBalanced,
+        BC7Quality::QuickOnly
+    };
+
+    for (BC7Quality q : ladder)
+    {
+        if (PredictBC7EncodeMs(f, q) <= budgetMs)
+            return q;
+    }
+
+    return BC7Quality::UltraFast;
+}
+
+HRESULT LoadEncodeCostTable(const wchar_t* path)
+{
+    FILE* f = nullptr;
+    if (!path || _wfopen_s(&f, path, L"r") != 0 || !f)
+        return HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND);
+
+    CostRow table[kBC7QualityCount];
+    {
+        std::lock_guard<std::mutex> lk(g_costLock);
+        std::copy(g_cost, g_cost + kBC7QualityCount, table);
+    }
+
+    char line[512];
+    size_t loaded = 0;
+
+    while (fgets(line, sizeof(line), f))
+    {
+        if (line[0] == '#' || line[0] == '\n' || line[0] == '\r')
+            continue;
+
+        unsigned q = 0;
+        double c[kEncodeCostTerms];
+        if (sscanf_s(line, "%u %lf %lf %lf %lf %lf %lf", &q, &c[0], &c[1], &c[2], &c[3], &c[4], &c[5]) != 7
+            || q >= kBC7QualityCount)
+            continue;
+
+        std::copy(c, c + kEncodeCostTerms, table[q].c);
+        ++loaded;
+    }
+
+    fclose(f);
+
+    if (!loaded)
+        return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+
+    std::lock_guard<std::mutex> lk(g_costLock);
+    std::copy(table, table + kBC7QualityCount, g_cost);
+    return S_OK;
+}
+
+void GetEncodeCostTable(double table[kBC7QualityCount][kEncodeCostTerms])
+{
+    std::lock_guard<std::mutex> lk(g_costLock);
+    for (size_t q = 0; q < kBC7QualityCount; ++q)
+        std::copy(g_cost[q].c, g_cost[q].c + kEncodeCostTerms, table[q]);
+}
+
+HRESULT CalibrateEncodeCost(
+    const wchar_t* const* files,
+    size_t count,
+    uint32_t qualityMask,
+    const wchar_t* tablePath,
+    const wchar_t* reportPath)
+{
+    if (!files || count == 0 || (qualityMask & ((1u << kBC7QualityCount) - 1)) == 0)
+        return E_INVALIDARG;
+
+    // 1. Medir
+    std::vector<CostSample> samples;
+    samples.reserve(count);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        TexMetadata meta;
+        ScratchImage img;
+        if (FAILED(LoadSourceImage(files[i], WIC_FLAGS_IGNORE_SRGB, meta, img)))
+            continue;
+
+        // Si ya es RGBA8 se mide sobre la imagen cargada, sin copia
+        ScratchImage converted;
+        HRESULT hr = (meta.format == DXGI_FORMAT_R8G8B8A8_UNORM)
+            ? S_OK
+            : Convert(img.GetImages(), img.GetImageCount(), meta, DXGI_FORMAT_R8G8B8A8_UNORM, TEX_FILTER_POINT, 0.0f, converted);
+        if (FAILED(hr))
+            continue;
+
+        const Image* base = (meta.format == DXGI_FORMAT_R8G8B8A8_UNORM)
+            ? img.GetImage(0, 0, 0)
+            : converted.GetImage(0, 0, 0);
+
+        ImageFeatures features;
+        ExtractImageFeatures(base, features);
+
+        CostSample s;
+        s.file = files[i];
+        ExtractEncodeCostFeatures(*base, features, s.features);
+
+        for (size_t q = 0; q < kBC7QualityCount; ++q)
+        {
+            s.ms[q] = -1.0;
+            if (!(qualityMask & (1u << q)))
+                continue;
+
+            ScratchImage bc7;
+            double t0 = Now();
+            if (SUCCEEDED(CompressBC7(*base, bc7, BC7Quality(q))))
+                s.ms[q] = (Now() - t0) * EncodeThreads();
+        }
+
+        samples.push_back(s);
+    }
+
+    if (samples.empty())
+        return E_FAIL;
+
+    // 2. Ajustar
+    CostRow fitted[kBC7QualityCount];
+    bool valid[kBC7QualityCount] = {};
+    {
+        std::lock_guard<std::mutex> lk(g_costLock);
+        std::copy(g_cost, g_cost + kBC7QualityCount, fitted);
+    }
+
+    for (size_t q = 0; q < kBC7QualityCount; ++q)
+    {
+        if (qualityMask & (1u << q))
+            valid[q] = FitCost(samples, q, size_t(-1), fitted[q].c);
+    }
+
+    // 3. Informe de precision
+    if (reportPath)
+    {
+        FILE* f = nullptr;
+        if (_wfopen_s(&f, reportPath, L"w, ccs=UTF-8") == 0 && f)
+        {
+            fwprintf(f, L"# BC7 encode cost calibration: %u images\n\n", unsigned(samples.size()));
+
+            for (size_t q = 0; q < kBC7QualityCount; ++q)
+            {
+                if (!valid[q])
+                    continue;
+
+                double sumErr = 0.0, maxErr = 0.0, sumLoo = 0.0;
+                size_t n = 0, nLoo = 0;
+
+                fwprintf(f, L"[%s]\n", QualityName(q));
+                fwprintf(f, L"%-40s %10s %10s %8s %10s\n", L"file", L"measured", L"predicted", L"err%", L"loo err%");
+
+                for (size_t s = 0; s < samples.size(); ++s)
+                {
+                    const CostSample& cs = samples[s];
+                    if (cs.ms[q] < 0.0)
+                        continue;
+
+                    double x[kEncodeCostTerms];
+                    FeatureTerms(cs.features, x);
+                    double kblocks = cs.features.blocks / 1000.0;
+
+                    double predicted = std::max(0.0, Dot(fitted[q].c, x)) * kblocks;
+                    double err = fabs(predicted - cs.ms[q]) / std::max(cs.ms[q], 1.0) * 100.0;
+
+                    double loo[kEncodeCostTerms];
+                    double looErr = -1.0;
+                    if (FitCost(samples, q, s, loo))
+                    {
+                        double p = std::max(0.0, Dot(loo, x)) * kblocks;
+                        looErr = fabs(p - cs.ms[q]) / std::max(cs.ms[q], 1.0) * 100.0;
+                        sumLoo += looErr;
+                        ++nLoo;
+                    }
+
+                    sumErr += err;
+                    maxErr = std::max(maxErr, err);
+                    ++n;
+
+                    fwprintf(f, L"%-40s %10.1f %10.1f %8.1f %10.1f\n", cs.file.c_str(), cs.ms[q], predicted, err, looErr);
+                }
+
+                fwprintf(f, L"mean err %.1f%%  max err %.1f%%  leave-one-out mean err %.1f%%\n\n",
+                    n ? sumErr / n : 0.0, maxErr, nLoo ? sumLoo / nLoo : 0.0);
+            }
+
+            fclose(f);
+        }
+    }
+
+    // 4. Guardar y activar
+    if (tablePath)
+    {
+        HRESULT hr = WriteCostTable(tablePath, fitted, valid);
+        if (FAILED(hr)) return hr;
+
+        std::lock_guard<std::mutex> lk(g_costLock);
+        for (size_t q = 0; q < kBC7QualityCount; ++q)
+            if (valid[q]) g_cost[q] = fitted[q];
+    }
+
+    return S_OK;
+}
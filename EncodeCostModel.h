@@ -0,0 +1,67 @@
+#pragma once
+
+#include <windows.h>
+#include "DirectXTex.h"
+#include "ImageFeatures.h"
+#include "TextureEncode.h"
+
+// -------------------------------------------------------------
+// Prediccion del tiempo de CompressBC7 ANTES de codificar.
+//
+// Modelo lineal por BC7Quality:
+//   ms de un core por 1000 bloques = c0 + c1*low + c2*mid + c3*high
+//                                  + c4*alpha + c5*laplacian
+//
+// CompressBC7 va por tiles (TextureEncode.h): la prediccion divide por
+// los hilos de las opciones por defecto y la calibracion multiplica lo
+// medido por ellos, asi una tabla vale para cualquier numero de hilos.
+//
+// low/mid/high = fraccion de bloques 4x4 en cada tramo de varianza
+// (el resto son bloques constantes), alpha = fraccion de pixeles con
+// alpha suave, laplacian = LaplacianEnergy / 1000.
+//
+// La tabla se calibra con CalibrateEncodeCost sobre el corpus y se
+// carga con LoadEncodeCostTable; sin tabla se usan valores iniciales.
+// -------------------------------------------------------------
+static const size_t kEncodeCostTerms = 6;
+static const size_t kBC7QualityCount = 6;
+
+struct EncodeCostFeatures
+{
+    double blocks = 0.0;
+    double fracLow = 0.0;       // varianza del bloque en (0, 16]
+    double fracMid = 0.0;       // (16, 256]
+    double fracHigh = 0.0;      // > 256
+    double alpha = 0.0;
+    double laplacian = 0.0;
+};
+
+// 'img' en RGBA/BGRA 8 bits, 'f' calculado sobre la misma imagen
+void ExtractEncodeCostFeatures(const DirectX::Image& img, const ImageFeatures& f, EncodeCostFeatures& out);
+
+double PredictBC7EncodeMs(const EncodeCostFeatures& f, BC7Quality quality);
+
+// La mejor calidad cuyo tiempo estimado cabe en budgetMs.
+// Si ninguna cabe devuelve la mas rapida.
+BC7Quality PickBC7Quality(const EncodeCostFeatures& f, double budgetMs);
+
+// Orden de calidad (0 = la mejor). HighQuality comparte flags con
+// FastBalanced (mas PARALLEL) y queda al mismo nivel.
+int BC7QualityRank(BC7Quality quality);
+
+HRESULT LoadEncodeCostTable(const wchar_t* path);
+
+// Coeficientes de la tabla activa, kBC7QualityCount filas de
+// kEncodeCostTerms (para la clave del cache de conversiones)
+void GetEncodeCostTable(double table[kBC7QualityCount][kEncodeCostTerms]);
+
+// Mide CompressBC7 en cada archivo para las calidades de qualityMask
+// (bit = 1 << BC7Quality), ajusta la tabla por minimos cuadrados y
+// escribe la tabla y un informe de precision (error en muestra y
+// leave-one-out). Si tablePath no es null la tabla nueva queda activa.
+HRESULT CalibrateEncodeCost(
+    const wchar_t* const* files,
+    size_t count,
+    uint32_t qualityMask,
+    const wchar_t* tablePath,
+    const wchar_t* reportPath);
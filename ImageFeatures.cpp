@@ -0,0 +1,400 @@
+#include "ImageFeatures.h"
+#include "ImageKernels.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+using namespace DirectX;
+
+namespace
+{
+    // Rejillas de muestreo (mismos pasos que los detectores originales)
+    const size_t kGradStep = 2;
+    const size_t kLumaStep = 4;
+    const size_t kHalo = ImageFeatureAccumulator::kHalo;
+
+    // Entero de 128 bits sin signo, solo para la varianza exacta
+    struct UInt128
+    {
+        uint64_t hi;
+        uint64_t lo;
+    };
+
+    UInt128 Mul64(uint64_t a, uint64_t b)
+    {
+        uint64_t ll = uint64_t(uint32_t(a)) * uint32_t(b);
+        uint64_t lh = uint64_t(uint32_t(a)) * (b >> 32);
+        uint64_t hl = (a >> 32) * uint32_t(b);
+        uint64_t hh = (a >> 32) * (b >> 32);
+
+        uint64_t mid = (ll >> 32) + uint32_t(lh) + uint32_t(hl);
+
+        UInt128 r;
+        r.lo = (mid << 32) | uint32_t(ll);
+        r.hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+        return r;
+    }
+
+    UInt128 Add128(UInt128 a, UInt128 b)
+    {
+        UInt128 r;
+        r.lo = a.lo + b.lo;
+        r.hi = a.hi + b.hi + (r.lo < a.lo ? 1 : 0);
+        return r;
+    }
+
+    UInt128 Sub128(UInt128 a, UInt128 b)
+    {
+        UInt128 r;
+        r.lo = a.lo - b.lo;
+        r.hi = a.hi - b.hi - (a.lo < b.lo ? 1 : 0);
+        return r;
+    }
+
+    inline double Luma(const uint8_t* p)
+    {
+        // p[0] = B, p[1] = G, p[2] = R
+        return 0.2126 * p[2] + 0.7152 * p[1] + 0.0722 * p[0];
+    }
+
+    void BeginFeatures(ImageFeatures& out, size_t w, size_t h)
+    {
+        out = ImageFeatures();
+        out.width = w;
+        out.height = h;
+        out.rowNonZero.assign(h, 0);
+        out.rowMinX.assign(h, int32_t(w));
+        out.rowMaxX.assign(h, -1);
+    }
+
+    // Todo lo que aporta la fila y. rows[kHalo + d] es la fila y + d
+    // (d en [-kHalo, kHalo]); solo se leen las que existen.
+    void AccumulateRow(ImageFeatures& out, AlphaRowCounts& alpha, ColorRowSums& color,
+        const AnalysisKernels& k, size_t y, const uint8_t* const* rows)
+    {
+        size_t w = out.width;
+        size_t h = out.height;
+        const uint8_t* row = rows[kHalo];
+
+        // --------------------------------------------------
+        // Fila completa: alpha, color y contenido de la fila
+        // --------------------------------------------------
+        k.alphaCounts(row, w, alpha);
+        k.colorSums(row, w, color);
+
+        if (y > 0)
+            out.alphaVertChanges += size_t(k.alphaVertChanges(rows[kHalo - 1], row, w));
+
+        RowContent content;
+        k.rowContent(row, w, content);
+
+        out.rowNonZero[y] = content.nonZero;
+        if (content.nonZero)
+        {
+            out.rowMinX[y] = content.minX;
+            out.rowMaxX[y] = content.maxX;
+        }
+
+        // Laplaciano (canal 0) con las filas vecinas
+        if (y > 0 && y + 1 < h)
+            out.laplacianSum += k.laplacianRow(rows[kHalo - 1], row, rows[kHalo + 1], w);
+
+        // --------------------------------------------------
+        // Rejilla 2x2 (filas pares): saturacion + alpha medio
+        // y gradiente del alpha (paso 2)
+        // --------------------------------------------------
+        if ((y % kGradStep) == 0)
+        {
+            out.satMid += size_t(k.satMidEven(row, w));
+
+            if (y >= kGradStep && y + kGradStep < h)
+            {
+                uint64_t samples = 0;
+                out.alphaGradSum4 += k.alphaGradEven(rows[kHalo - kGradStep], row, rows[kHalo + kGradStep], w, samples);
+                out.alphaGradSamples += size_t(samples);
+            }
+        }
+
+        // --------------------------------------------------
+        // Gradiente de luma (paso 4), mismo orden de suma que
+        // IsDarkGradientBackground para obtener el mismo double
+        // --------------------------------------------------
+        if (y >= kLumaStep && y + kLumaStep < h && (y % kLumaStep) == 0)
+        {
+            const uint8_t* rowUp = rows[kHalo - kLumaStep];
+            const uint8_t* rowDown = rows[kHalo + kLumaStep];
+
+            for (size_t x = kLumaStep; x + kLumaStep < w; x += kLumaStep)
+            {
+                double c = Luma(row + x * 4);
+                double dL = fabs(c - Luma(row + (x - kLumaStep) * 4));
+                double dR = fabs(c - Luma(row + (x + kLumaStep) * 4));
+                double dU = fabs(c - Luma(rowUp + x * 4));
+                double dD = fabs(c - Luma(rowDown + x * 4));
+
+                out.lumaDiffSum += (dL + dR + dU + dD) * 0.25;
+                ++out.lumaSamples;
+            }
+        }
+    }
+
+    void FinishFeatures(ImageFeatures& out, const AlphaRowCounts& alpha, const ColorRowSums& color)
+    {
+        out.hasAlpha = alpha.notOpaque != 0;
+        out.alphaTransparent = size_t(alpha.transparent);
+        out.alphaOpaque = size_t(alpha.opaque);
+        out.alphaMid = out.width * out.height - out.alphaTransparent - out.alphaOpaque;
+        out.alphaSoft = size_t(alpha.soft);
+
+        for (int c = 0; c < 3; ++c)
+        {
+            out.colorSum[c] = color.sum[c];
+            out.colorSumSq[c] = color.sumSq[c];
+        }
+    }
+}
+
+void ExtractImageFeatures(const DirectX::Image* img, ImageFeatures& out)
+{
+    out = ImageFeatures();
+
+    if (!img || !img->pixels)
+        return;
+
+    const uint8_t* px = img->pixels;
+    size_t pitch = img->rowPitch;
+    size_t w = img->width;
+    size_t h = img->height;
+
+    BeginFeatures(out, w, h);
+
+    const AnalysisKernels& k = GetAnalysisKernels();
+
+    AlphaRowCounts alpha;
+    ColorRowSums color;
+
+    const uint8_t* rows[2 * kHalo + 1];
+
+    for (size_t y = 0; y < h; ++y)
+    {
+        for (size_t d = 0; d <= 2 * kHalo; ++d)
+        {
+            size_t yy = y + d - kHalo;
+            rows[d] = (yy < h) ? px + pitch * yy : nullptr;
+        }
+
+        AccumulateRow(out, alpha, color, k, y, rows);
+    }
+
+    FinishFeatures(out, alpha, color);
+}
+
+// -------------------------------------------------------------
+// Version incremental
+// -------------------------------------------------------------
+void ImageFeatureAccumulator::Begin(size_t width, size_t height)
+{
+    BeginFeatures(m_features, width, height);
+    m_alpha = AlphaRowCounts();
+    m_color = ColorRowSums();
+    m_rowBytes = width * 4;
+    m_window.assign(m_rowBytes * kWindowRows, 0);
+    m_received = 0;
+    m_processed = 0;
+}
+
+void ImageFeatureAccumulator::AddRows(const uint8_t* rows, size_t rowPitch, size_t count)
+{
+    size_t h = m_features.height;
+
+    for (size_t i = 0; i < count && m_received < h; ++i)
+    {
+        memcpy(&m_window[(m_received % kWindowRows) * m_rowBytes], rows + rowPitch * i, m_rowBytes);
+        ++m_received;
+
+        // La fila y ya tiene todas sus vecinas de abajo
+        while (m_processed + kHalo < m_received)
+            ProcessRow(m_processed++);
+    }
+}
+
+void ImageFeatureAccumulator::Finish(ImageFeatures& out)
+{
+    // Las ultimas filas no tienen vecinas abajo
+    while (m_processed < m_received)
+        ProcessRow(m_processed++);
+
+    FinishFeatures(m_features, m_alpha, m_color);
+    out = std::move(m_features);
+    m_window.clear();
+}
+
+void ImageFeatureAccumulator::ProcessRow(size_t y)
+{
+    const uint8_t* rows[kWindowRows];
+
+    for (size_t d = 0; d < kWindowRows; ++d)
+    {
+        size_t yy = y + d - kHalo;
+        rows[d] = (yy < m_received) ? &m_window[(yy % kWindowRows) * m_rowBytes] : nullptr;
+    }
+
+    AccumulateRow(m_features, m_alpha, m_color, GetAnalysisKernels(), y, rows);
+}
+
+float ComputeColorStdDev(const ImageFeatures& f)
+{
+    size_t count = f.width * f.height;
+    if (!count)
+        return 0.0f;
+
+    // n^2 * varianza de cada canal = n * sumSq - sum^2, exacto en 128
+    // bits (nunca negativo). Solo se redondea al final, asi sale lo
+    // mismo que la version de dos pasadas sobre la imagen.
+    UInt128 num = { 0, 0 };
+    for (int c = 0; c < 3; ++c)
+        num = Add128(num, Sub128(Mul64(count, f.colorSumSq[c]), Mul64(f.colorSum[c], f.colorSum[c])));
+
+    double n = double(count);
+    double var = (double(num.hi) * 18446744073709551616.0 + double(num.lo)) / (3.0 * n * n);
+
+    return (float)std::sqrt(var);
+}
+
+float LaplacianEnergy(const ImageFeatures& f)
+{
+    size_t count = f.width * f.height;
+    return count ? (float)(double(f.laplacianSum) / double(count)) : 0.0f;
+}
+
+bool DetectSoftAlpha(const ImageFeatures& f)
+{
+    // Hay alpha suave si hay muchos cambios
+    return f.alphaVertChanges > (size_t)(int)(f.width * f.height * 0.01);
+}
+
+float AlphaSoftRatio(const ImageFeatures& f)
+{
+    size_t total = f.width * f.height;
+    return total ? float(f.alphaSoft) / float(total) : 0.0f;
+}
+
+float SatMidRatio(const ImageFeatures& f)
+{
+    size_t total = f.width * f.height;
+    return total ? float(f.satMid) / float(total) : 0.0f;
+}
+
+double AlphaGradAverage(const ImageFeatures& f)
+{
+    return f.alphaGradSamples ? ((double(f.alphaGradSum4) * 0.25) / f.alphaGradSamples) : 999.0;
+}
+
+double LumaDiffAverage(const ImageFeatures& f)
+{
+    return f.lumaSamples ? (f.lumaDiffSum / f.lumaSamples) : 999.0;
+}
+
+bool IsGlowFX(const ImageFeatures& f)
+{
+    size_t total = f.width * f.height;
+    if (total == 0)
+        return false;
+
+    if (f.width < 700 || f.height < 200)
+        return false;
+
+    // JackpotLevels = 0.09, Major/Mega = 0.31?0.36
+    if (AlphaSoftRatio(f) < 0.08f)
+        return false;
+
+    // JackpotLevels = 0.086, Major/Mega = 0.31+
+    if (SatMidRatio(f) < 0.08f)
+        return false;
+
+    // JackpotLevels = 1.17, Major = 2.41, Mega = 1.89
+    if (AlphaGradAverage(f) > 3.0)
+        return false;
+
+    return true;
+}
+
+bool IsDarkGradientBackground(const ImageFeatures& f)
+{
+    if (f.width < 400 && f.height < 400)
+        return false;
+
+    // Mismo corte que IsDarkGradientBackground(const Image*)
+    return LumaDiffAverage(f) < 4.5;
+}
+
+bool IsLongStripSheet(const ImageFeatures& f)
+{
+    return LongBandRatio(f) >= 0.60;
+}
+
+double LongBandRatio(const ImageFeatures& f)
+{
+    size_t w = f.width;
+    size_t h = f.height;
+
+    if (w < 64 || h < 64 || f.rowNonZero.size() != h)
+        return 0.0;
+
+    const int MAX_BANDS = 32;
+    const double rowThreshold = 0.03;
+
+    int bandCount = 0;
+    int longCount = 0;
+
+    bool inBand = false;
+    size_t yStart = 0;
+
+    // Ancho util de la banda [y0, y1] a partir del rango de cada fila
+    auto CloseBand = [&](size_t y0, size_t y1)
+        {
+            size_t bandH = (y1 >= y0) ? (y1 - y0 + 1) : 1;
+            if (bandH < 4 || bandCount >= MAX_BANDS)
+                return;
+
+            ++bandCount;
+
+            int32_t xMin = int32_t(w), xMax = -1;
+            for (size_t y = y0; y <= y1; ++y)
+            {
+                if (f.rowMinX[y] < xMin) xMin = f.rowMinX[y];
+                if (f.rowMaxX[y] > xMax) xMax = f.rowMaxX[y];
+            }
+
+            if (xMax < xMin)
+                return;
+
+            size_t bandW = size_t(xMax - xMin + 1);
+            if (double(bandW) / double(bandH) >= 6.0)
+                ++longCount;
+        };
+
+    for (size_t y = 0; y < h; ++y)
+    {
+        double ratio = double(f.rowNonZero[y]) / double(w);
+
+        if (!inBand && ratio >= rowThreshold)
+        {
+            inBand = true;
+            yStart = y;
+        }
+        else if (inBand && ratio < rowThreshold)
+        {
+            CloseBand(yStart, y - 1);
+            inBand = false;
+        }
+    }
+
+    if (inBand)
+        CloseBand(yStart, h - 1);
+
+    if (bandCount == 0)
+        return 0.0;
+
+    return double(longCount) / double(bandCount);
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <windows.h>
+#include "DirectXTex.h"
+#include "ImageKernels.h"
+#include <cstdint>
+#include <vector>
+
+// -------------------------------------------------------------
+// Estadisticas de la imagen calculadas en UNA sola pasada.
+// Todas las reglas de ConvertPNGtoDDSW se evaluan sobre esto
+// en vez de recorrer el buffer RGBA una y otra vez.
+// -------------------------------------------------------------
+struct ImageFeatures
+{
+    size_t width = 0;
+    size_t height = 0;
+
+    bool hasAlpha = false;          // algun pixel con a < 255
+
+    // Histograma de alpha (mismos cortes que AnalyzeAlpha)
+    size_t alphaTransparent = 0;    // a <= 5
+    size_t alphaMid = 0;            // 5 < a < 250
+    size_t alphaOpaque = 0;         // a >= 250
+
+    size_t alphaSoft = 0;           // 0 < a < 255
+    size_t satMid = 0;              // rejilla 2x2: 20 < a < 235 y algun canal > 200
+    size_t alphaVertChanges = 0;    // |a(y) - a(y-1)| > 10
+
+    // Gradiente del alpha en rejilla de paso 2 (suma de las 4 diferencias)
+    uint64_t alphaGradSum4 = 0;
+    size_t alphaGradSamples = 0;
+
+    // Gradiente de luma en rejilla de paso 4
+    double lumaDiffSum = 0.0;
+    size_t lumaSamples = 0;
+
+    // Energia laplaciana del canal 0 (suma de lap^2)
+    uint64_t laplacianSum = 0;
+
+    // Suma y suma de cuadrados por canal (p[0], p[1], p[2])
+    uint64_t colorSum[3] = {};
+    uint64_t colorSumSq[3] = {};
+
+    // Por fila: pixeles con color visible (> 8) y su rango horizontal
+    std::vector<uint32_t> rowNonZero;
+    std::vector<int32_t> rowMinX;   // w si la fila esta vacia
+    std::vector<int32_t> rowMaxX;   // -1 si la fila esta vacia
+};
+
+// Recorre la imagen (RGBA/BGRA 8 bits) una sola vez y llena 'out'
+void ExtractImageFeatures(const DirectX::Image* img, ImageFeatures& out);
+
+// Lo mismo por bandas: se le pasan las filas en orden (en trozos de
+// cualquier tamano) y da exactamente el mismo resultado que
+// ExtractImageFeatures. Solo guarda una ventana de 2*kHalo+1 filas.
+class ImageFeatureAccumulator
+{
+public:
+    // Filas vecinas que necesita cada fila (gradiente de luma, paso 4)
+    static const size_t kHalo = 4;
+
+    void Begin(size_t width, size_t height);
+    void AddRows(const uint8_t* rows, size_t rowPitch, size_t count);
+    void Finish(ImageFeatures& out);
+
+private:
+    static const size_t kWindowRows = 2 * kHalo + 1;
+
+    void ProcessRow(size_t y);
+
+    ImageFeatures m_features;
+    AlphaRowCounts m_alpha;
+    ColorRowSums m_color;
+    std::vector<uint8_t> m_window;
+    size_t m_rowBytes = 0;
+    size_t m_received = 0;
+    size_t m_processed = 0;
+};
+
+// Predicados baratos sobre las estadisticas ya calculadas
+float ComputeColorStdDev(const ImageFeatures& f);
+float LaplacianEnergy(const ImageFeatures& f);
+bool DetectSoftAlpha(const ImageFeatures& f);
+bool IsGlowFX(const ImageFeatures& f);
+bool IsDarkGradientBackground(const ImageFeatures& f);
+bool IsLongStripSheet(const ImageFeatures& f);
+
+// Valores en los que se basan los predicados (para RuleEngine). Los
+// float se calculan y comparan en float, como la cadena original.
+float AlphaSoftRatio(const ImageFeatures& f);       // 0 < a < 255
+float SatMidRatio(const ImageFeatures& f);
+double AlphaGradAverage(const ImageFeatures& f);    // 999 sin muestras
+double LumaDiffAverage(const ImageFeatures& f);     // 999 sin muestras
+double LongBandRatio(const ImageFeatures& f);       // bandas alargadas / bandas
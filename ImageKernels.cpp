@@ -0,0 +1,720 @@
+#include "ImageKernels.h"
+#include <intrin.h>
+#include <emmintrin.h>
+#include <immintrin.h>
+#include <cstdlib>
+
+namespace
+{
+    // =========================================================
+    // Escalar (referencia)
+    // =========================================================
+    void AlphaCountsScalar(const uint8_t* row, size_t w, AlphaRowCounts& acc)
+    {
+        for (size_t x = 0; x < w; ++x)
+        {
+            uint8_t a = row[x * 4 + 3];
+
+            if (a <= 5) ++acc.transparent;
+            if (a >= 250) ++acc.opaque;
+            if (a != 255)
+            {
+                ++acc.notOpaque;
+                if (a != 0) ++acc.soft;
+            }
+        }
+    }
+
+    void ColorSumsScalar(const uint8_t* row, size_t w, ColorRowSums& acc)
+    {
+        for (size_t x = 0; x < w; ++x)
+        {
+            const uint8_t* p = row + x * 4;
+            for (int c = 0; c < 3; ++c)
+            {
+                uint32_t v = p[c];
+                acc.sum[c] += v;
+                acc.sumSq[c] += v * v;
+            }
+        }
+    }
+
+    uint64_t AlphaVertChangesScalar(const uint8_t* prev, const uint8_t* row, size_t w)
+    {
+        uint64_t changes = 0;
+        for (size_t x = 0; x < w; ++x)
+        {
+            if (std::abs(int(prev[x * 4 + 3]) - int(row[x * 4 + 3])) > 10)
+                ++changes;
+        }
+        return changes;
+    }
+
+    uint64_t SatMidEvenScalar(const uint8_t* row, size_t w)
+    {
+        uint64_t count = 0;
+        for (size_t x = 0; x < w; x += 2)
+        {
+            const uint8_t* p = row + x * 4;
+            uint8_t a = p[3];
+
+            if (a > 20 && a < 235 && (p[0] > 200 || p[1] > 200 || p[2] > 200))
+                ++count;
+        }
+        return count;
+    }
+
+    uint64_t AlphaGradEvenScalar(const uint8_t* rowU, const uint8_t* row, const uint8_t* rowD, size_t w, uint64_t& samples)
+    {
+        uint64_t sum = 0;
+        for (size_t x = 2; x + 2 < w; x += 2)
+        {
+            int a = row[x * 4 + 3];
+            sum += uint64_t(std::abs(a - row[(x - 2) * 4 + 3]) +
+                std::abs(a - row[(x + 2) * 4 + 3]) +
+                std::abs(a - rowU[x * 4 + 3]) +
+                std::abs(a - rowD[x * 4 + 3]));
+            ++samples;
+        }
+        return sum;
+    }
+
+    uint64_t LaplacianRowScalar(const uint8_t* rowU, const uint8_t* row, const uint8_t* rowD, size_t w)
+    {
+        uint64_t energy = 0;
+        for (size_t x = 1; x + 1 < w; ++x)
+        {
+            int lap = 4 * row[x * 4] - row[(x - 1) * 4] - row[(x + 1) * 4] - rowU[x * 4] - rowD[x * 4];
+            energy += uint64_t(lap * lap);
+        }
+        return energy;
+    }
+
+    void RowContentScalar(const uint8_t* row, size_t w, RowContent& out)
+    {
+        out = RowContent();
+        for (size_t x = 0; x < w; ++x)
+        {
+            const uint8_t* p = row + x * 4;
+            if (p[0] > 8 || p[1] > 8 || p[2] > 8)
+            {
+                ++out.nonZero;
+                if (out.minX < 0) out.minX = int32_t(x);
+                out.maxX = int32_t(x);
+            }
+        }
+    }
+
+    // =========================================================
+    // Utilidades comunes SIMD
+    // =========================================================
+    const int8_t kLowBit4[16] = { -1, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0 };
+    const int8_t kHighBit4[16] = { -1, 0, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3 };
+    const uint8_t kPopCount4[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+
+    inline int PopCount8(unsigned bits)
+    {
+        return kPopCount4[bits & 0xF] + kPopCount4[(bits >> 4) & 0xF];
+    }
+
+    inline int LowBit8(unsigned bits)
+    {
+        return (bits & 0xF) ? kLowBit4[bits & 0xF] : 4 + kLowBit4[(bits >> 4) & 0xF];
+    }
+
+    inline int HighBit8(unsigned bits)
+    {
+        return (bits & 0xF0) ? 4 + kHighBit4[(bits >> 4) & 0xF] : kHighBit4[bits & 0xF];
+    }
+
+    // Mascara de pixeles con contenido del bloque (bit i = pixel x + i)
+    inline void AccumulateContent(unsigned bits, size_t x, RowContent& out)
+    {
+        if (!bits)
+            return;
+
+        out.nonZero += uint32_t(PopCount8(bits));
+        if (out.minX < 0) out.minX = int32_t(x) + LowBit8(bits);
+        out.maxX = int32_t(x) + HighBit8(bits);
+    }
+
+    inline uint64_t HSum64(__m128i v)
+    {
+        alignas(16) uint64_t t[2];
+        _mm_store_si128(reinterpret_cast<__m128i*>(t), v);
+        return t[0] + t[1];
+    }
+
+    inline uint64_t HSum32(__m128i v)
+    {
+        alignas(16) uint32_t t[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(t), v);
+        return uint64_t(t[0]) + t[1] + t[2] + t[3];
+    }
+
+    // Contadores por byte: como maximo 255 iteraciones antes de volcar
+    const size_t kByteFlush = 255;
+
+    // Contadores 32 bits de sumas de cuadrados: volcar antes de 2^31
+    const size_t kSqFlush = 4096;
+
+    // =========================================================
+    // SSE2: 4 pixeles por iteracion
+    // =========================================================
+    void AlphaCountsSSE2(const uint8_t* row, size_t w, AlphaRowCounts& acc)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i aMask = _mm_set1_epi32(int(0xFF000000));
+        const __m128i k5 = _mm_set1_epi8(5);
+        const __m128i k250 = _mm_set1_epi8(char(250));
+        const __m128i k255 = _mm_set1_epi8(char(255));
+
+        __m128i sumT = zero, sumO = zero, sumS = zero, sumN = zero;
+        size_t x = 0;
+
+        while (x + 4 <= w)
+        {
+            __m128i cT = zero, cO = zero, cS = zero, cN = zero;
+
+            for (size_t i = 0; i < kByteFlush && x + 4 <= w; ++i, x += 4)
+            {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x * 4));
+
+                __m128i le5 = _mm_cmpeq_epi8(_mm_min_epu8(v, k5), v);
+                __m128i ge250 = _mm_cmpeq_epi8(_mm_max_epu8(v, k250), v);
+                __m128i is255 = _mm_cmpeq_epi8(v, k255);
+                __m128i is0 = _mm_cmpeq_epi8(v, zero);
+
+                cT = _mm_sub_epi8(cT, _mm_and_si128(le5, aMask));
+                cO = _mm_sub_epi8(cO, _mm_and_si128(ge250, aMask));
+                cN = _mm_sub_epi8(cN, _mm_andnot_si128(is255, aMask));
+                cS = _mm_sub_epi8(cS, _mm_andnot_si128(_mm_or_si128(is0, is255), aMask));
+            }
+
+            sumT = _mm_add_epi64(sumT, _mm_sad_epu8(cT, zero));
+            sumO = _mm_add_epi64(sumO, _mm_sad_epu8(cO, zero));
+            sumS = _mm_add_epi64(sumS, _mm_sad_epu8(cS, zero));
+            sumN = _mm_add_epi64(sumN, _mm_sad_epu8(cN, zero));
+        }
+
+        acc.transparent += HSum64(sumT);
+        acc.opaque += HSum64(sumO);
+        acc.soft += HSum64(sumS);
+        acc.notOpaque += HSum64(sumN);
+
+        AlphaCountsScalar(row + x * 4, w - x, acc);
+    }
+
+    void ColorSumsSSE2(const uint8_t* row, size_t w, ColorRowSums& acc)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i ones = _mm_set1_epi16(1);
+
+        // Lanes 64 bits: [c0, c1] y [c2, c3]
+        __m128i sumLo = zero, sumHi = zero, sqLo = zero, sqHi = zero;
+        size_t x = 0;
+
+        while (x + 4 <= w)
+        {
+            __m128i s32 = zero, q32 = zero;
+
+            for (size_t i = 0; i < kSqFlush && x + 4 <= w; ++i, x += 4)
+            {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x * 4));
+
+                // [p0c0 p1c0 p0c1 p1c1 p0c2 p1c2 p0c3 p1c3] en 16 bits
+                __m128i lo = _mm_unpacklo_epi8(v, zero);
+                __m128i hi = _mm_unpackhi_epi8(v, zero);
+                __m128i t0 = _mm_unpacklo_epi16(lo, _mm_srli_si128(lo, 8));
+                __m128i t1 = _mm_unpacklo_epi16(hi, _mm_srli_si128(hi, 8));
+
+                s32 = _mm_add_epi32(s32, _mm_add_epi32(_mm_madd_epi16(t0, ones), _mm_madd_epi16(t1, ones)));
+                q32 = _mm_add_epi32(q32, _mm_add_epi32(_mm_madd_epi16(t0, t0), _mm_madd_epi16(t1, t1)));
+            }
+
+            sumLo = _mm_add_epi64(sumLo, _mm_unpacklo_epi32(s32, zero));
+            sumHi = _mm_add_epi64(sumHi, _mm_unpackhi_epi32(s32, zero));
+            sqLo = _mm_add_epi64(sqLo, _mm_unpacklo_epi32(q32, zero));
+            sqHi = _mm_add_epi64(sqHi, _mm_unpackhi_epi32(q32, zero));
+        }
+
+        alignas(16) uint64_t s[4], q[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(s), sumLo);
+        _mm_store_si128(reinterpret_cast<__m128i*>(s + 2), sumHi);
+        _mm_store_si128(reinterpret_cast<__m128i*>(q), sqLo);
+        _mm_store_si128(reinterpret_cast<__m128i*>(q + 2), sqHi);
+
+        for (int c = 0; c < 3; ++c)
+        {
+            acc.sum[c] += s[c];
+            acc.sumSq[c] += q[c];
+        }
+
+        ColorSumsScalar(row + x * 4, w - x, acc);
+    }
+
+    uint64_t AlphaVertChangesSSE2(const uint8_t* prev, const uint8_t* row, size_t w)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i aMask = _mm_set1_epi32(int(0xFF000000));
+        const __m128i k10 = _mm_set1_epi8(10);
+
+        __m128i sum = zero;
+        size_t x = 0;
+
+        while (x + 4 <= w)
+        {
+            __m128i c8 = zero;
+
+            for (size_t i = 0; i < kByteFlush && x + 4 <= w; ++i, x += 4)
+            {
+                __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev + x * 4));
+                __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x * 4));
+
+                __m128i d = _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a));
+                __m128i small = _mm_cmpeq_epi8(_mm_subs_epu8(d, k10), zero);
+                c8 = _mm_sub_epi8(c8, _mm_andnot_si128(small, aMask));
+            }
+
+            sum = _mm_add_epi64(sum, _mm_sad_epu8(c8, zero));
+        }
+
+        return HSum64(sum) + AlphaVertChangesScalar(prev + x * 4, row + x * 4, w - x);
+    }
+
+    uint64_t SatMidEvenSSE2(const uint8_t* row, size_t w)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i aMask = _mm_set1_epi32(int(0xFF000000));
+        const __m128i rgbMask = _mm_set1_epi32(0x00FFFFFF);
+        const __m128i evenMask = _mm_set_epi32(0, -1, 0, -1);
+        const __m128i k20 = _mm_set1_epi8(20);
+        const __m128i k234 = _mm_set1_epi8(char(234));
+        const __m128i k200 = _mm_set1_epi8(char(200));
+
+        __m128i acc = zero;
+        size_t x = 0;
+
+        for (; x + 4 <= w; x += 4)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x * 4));
+
+            __m128i le20 = _mm_cmpeq_epi8(_mm_subs_epu8(v, k20), zero);
+            __m128i le234 = _mm_cmpeq_epi8(_mm_min_epu8(v, k234), v);
+            __m128i aOk = _mm_cmpeq_epi32(_mm_and_si128(_mm_andnot_si128(le20, le234), aMask), aMask);
+
+            __m128i hot = _mm_and_si128(_mm_subs_epu8(v, k200), rgbMask);
+            __m128i cOk = _mm_andnot_si128(_mm_cmpeq_epi32(hot, zero), evenMask);
+
+            acc = _mm_sub_epi32(acc, _mm_and_si128(aOk, cOk));
+        }
+
+        // x es multiplo de 4, asi que la cola sigue en pixeles pares
+        return HSum32(acc) + SatMidEvenScalar(row + x * 4, w - x);
+    }
+
+    inline __m128i AbsDiffAlpha(__m128i a, __m128i b)
+    {
+        // Valores 0..255 en lanes de 32 bits: max/min de 16 bits basta
+        return _mm_sub_epi16(_mm_max_epi16(a, b), _mm_min_epi16(a, b));
+    }
+
+    uint64_t AlphaGradEvenSSE2(const uint8_t* rowU, const uint8_t* row, const uint8_t* rowD, size_t w, uint64_t& samples)
+    {
+        const __m128i evenMask = _mm_set_epi32(0, -1, 0, -1);
+
+        __m128i acc = _mm_setzero_si128();
+        size_t x = 2;
+
+        for (; x + 6 <= w; x += 4)
+        {
+            __m128i c = _mm_srli_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x * 4)), 24);
+            __m128i l = _mm_srli_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + (x - 2) * 4)), 24);
+            __m128i r = _mm_srli_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + (x + 2) * 4)), 24);
+            __m128i u = _mm_srli_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(rowU + x * 4)), 24);
+            __m128i d = _mm_srli_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(rowD + x * 4)), 24);
+
+            __m128i g = _mm_add_epi32(_mm_add_epi32(AbsDiffAlpha(c, l), AbsDiffAlpha(c, r)),
+                _mm_add_epi32(AbsDiffAlpha(c, u), AbsDiffAlpha(c, d)));
+
+            acc = _mm_add_epi32(acc, _mm_and_si128(g, evenMask));
+            samples += 2;
+        }
+
+        // La cola empieza en un x par: se reubica para que sea el centro 2
+        return HSum32(acc) + AlphaGradEvenScalar(rowU + (x - 2) * 4, row + (x - 2) * 4, rowD + (x - 2) * 4, w - (x - 2), samples);
+    }
+
+    uint64_t LaplacianRowSSE2(const uint8_t* rowU, const uint8_t* row, const uint8_t* rowD, size_t w)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i lowMask = _mm_set1_epi32(0xFF);
+
+        __m128i acc = zero;
+        size_t x = 1;
+
+        for (; x + 5 <= w; x += 4)
+        {
+            __m128i c = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x * 4)), lowMask);
+            __m128i l = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + (x - 1) * 4)), lowMask);
+            __m128i r = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + (x + 1) * 4)), lowMask);
+            __m128i u = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(rowU + x * 4)), lowMask);
+            __m128i d = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(rowD + x * 4)), lowMask);
+
+            __m128i lap = _mm_sub_epi32(_mm_slli_epi32(c, 2),
+                _mm_add_epi32(_mm_add_epi32(l, r), _mm_add_epi32(u, d)));
+
+            // |lap| <= 1020 cabe en 16 bits: madd da lap0^2 + lap1^2, lap2^2 + lap3^2
+            __m128i p = _mm_packs_epi32(lap, zero);
+            __m128i sq = _mm_madd_epi16(p, p);
+
+            acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(sq, zero));
+        }
+
+        return HSum64(acc) + LaplacianRowScalar(rowU + (x - 1) * 4, row + (x - 1) * 4, rowD + (x - 1) * 4, w - (x - 1));
+    }
+
+    void RowContentSSE2(const uint8_t* row, size_t w, RowContent& out)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i rgbMask = _mm_set1_epi32(0x00FFFFFF);
+        const __m128i k8 = _mm_set1_epi8(8);
+
+        out = RowContent();
+        size_t x = 0;
+
+        for (; x + 4 <= w; x += 4)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x * 4));
+            __m128i hot = _mm_and_si128(_mm_subs_epu8(v, k8), rgbMask);
+            unsigned empty = unsigned(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(hot, zero))));
+
+            AccumulateContent(~empty & 0xF, x, out);
+        }
+
+        RowContent tail;
+        RowContentScalar(row + x * 4, w - x, tail);
+        if (tail.nonZero)
+        {
+            out.nonZero += tail.nonZero;
+            if (out.minX < 0) out.minX = int32_t(x) + tail.minX;
+            out.maxX = int32_t(x) + tail.maxX;
+        }
+    }
+
+    // =========================================================
+    // AVX2: 8 pixeles por iteracion
+    // =========================================================
+    inline __m128i Fold256(__m256i v)
+    {
+        return _mm_add_epi64(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    }
+
+    inline __m128i Fold256x32(__m256i v)
+    {
+        return _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    }
+
+    void AlphaCountsAVX2(const uint8_t* row, size_t w, AlphaRowCounts& acc)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i aMask = _mm256_set1_epi32(int(0xFF000000));
+        const __m256i k5 = _mm256_set1_epi8(5);
+        const __m256i k250 = _mm256_set1_epi8(char(250));
+        const __m256i k255 = _mm256_set1_epi8(char(255));
+
+        __m256i sumT = zero, sumO = zero, sumS = zero, sumN = zero;
+        size_t x = 0;
+
+        while (x + 8 <= w)
+        {
+            __m256i cT = zero, cO = zero, cS = zero, cN = zero;
+
+            for (size_t i = 0; i < kByteFlush && x + 8 <= w; ++i, x += 8)
+            {
+                __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + x * 4));
+
+                __m256i le5 = _mm256_cmpeq_epi8(_mm256_min_epu8(v, k5), v);
+                __m256i ge250 = _mm256_cmpeq_epi8(_mm256_max_epu8(v, k250), v);
+                __m256i is255 = _mm256_cmpeq_epi8(v, k255);
+                __m256i is0 = _mm256_cmpeq_epi8(v, zero);
+
+                cT = _mm256_sub_epi8(cT, _mm256_and_si256(le5, aMask));
+                cO = _mm256_sub_epi8(cO, _mm256_and_si256(ge250, aMask));
+                cN = _mm256_sub_epi8(cN, _mm256_andnot_si256(is255, aMask));
+                cS = _mm256_sub_epi8(cS, _mm256_andnot_si256(_mm256_or_si256(is0, is255), aMask));
+            }
+
+            sumT = _mm256_add_epi64(sumT, _mm256_sad_epu8(cT, zero));
+            sumO = _mm256_add_epi64(sumO, _mm256_sad_epu8(cO, zero));
+            sumS = _mm256_add_epi64(sumS, _mm256_sad_epu8(cS, zero));
+            sumN = _mm256_add_epi64(sumN, _mm256_sad_epu8(cN, zero));
+        }
+
+        acc.transparent += HSum64(Fold256(sumT));
+        acc.opaque += HSum64(Fold256(sumO));
+        acc.soft += HSum64(Fold256(sumS));
+        acc.notOpaque += HSum64(Fold256(sumN));
+
+        AlphaCountsSSE2(row + x * 4, w - x, acc);
+    }
+
+    void ColorSumsAVX2(const uint8_t* row, size_t w, ColorRowSums& acc)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i ones = _mm256_set1_epi16(1);
+
+        __m256i sumLo = zero, sumHi = zero, sqLo = zero, sqHi = zero;
+        size_t x = 0;
+
+        while (x + 8 <= w)
+        {
+            __m256i s32 = zero, q32 = zero;
+
+            for (size_t i = 0; i < kSqFlush && x + 8 <= w; ++i, x += 8)
+            {
+                __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + x * 4));
+
+                __m256i lo = _mm256_unpacklo_epi8(v, zero);
+                __m256i hi = _mm256_unpackhi_epi8(v, zero);
+                __m256i t0 = _mm256_unpacklo_epi16(lo, _mm256_srli_si256(lo, 8));
+                __m256i t1 = _mm256_unpacklo_epi16(hi, _mm256_srli_si256(hi, 8));
+
+                s32 = _mm256_add_epi32(s32, _mm256_add_epi32(_mm256_madd_epi16(t0, ones), _mm256_madd_epi16(t1, ones)));
+                q32 = _mm256_add_epi32(q32, _mm256_add_epi32(_mm256_madd_epi16(t0, t0), _mm256_madd_epi16(t1, t1)));
+            }
+
+            sumLo = _mm256_add_epi64(sumLo, _mm256_unpacklo_epi32(s32, zero));
+            sumHi = _mm256_add_epi64(sumHi, _mm256_unpackhi_epi32(s32, zero));
+            sqLo = _mm256_add_epi64(sqLo, _mm256_unpacklo_epi32(q32, zero));
+            sqHi = _mm256_add_epi64(sqHi, _mm256_unpackhi_epi32(q32, zero));
+        }
+
+        alignas(16) uint64_t s[4], q[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(s), Fold256(sumLo));
+        _mm_store_si128(reinterpret_cast<__m128i*>(s + 2), Fold256(sumHi));
+        _mm_store_si128(reinterpret_cast<__m128i*>(q), Fold256(sqLo));
+        _mm_store_si128(reinterpret_cast<__m128i*>(q + 2), Fold256(sqHi));
+
+        for (int c = 0; c < 3; ++c)
+        {
+            acc.sum[c] += s[c];
+            acc.sumSq[c] += q[c];
+        }
+
+        ColorSumsSSE2(row + x * 4, w - x, acc);
+    }
+
+    uint64_t AlphaVertChangesAVX2(const uint8_t* prev, const uint8_t* row, size_t w)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i aMask = _mm256_set1_epi32(int(0xFF000000));
+        const __m256i k10 = _mm256_set1_epi8(10);
+
+        __m256i sum = zero;
+        size_t x = 0;
+
+        while (x + 8 <= w)
+        {
+            __m256i c8 = zero;
+
+            for (size_t i = 0; i < kByteFlush && x + 8 <= w; ++i, x += 8)
+            {
+                __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(prev + x * 4));
+                __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + x * 4));
+
+                __m256i d = _mm256_or_si256(_mm256_subs_epu8(a, b), _mm256_subs_epu8(b, a));
+                __m256i small = _mm256_cmpeq_epi8(_mm256_subs_epu8(d, k10), zero);
+                c8 = _mm256_sub_epi8(c8, _mm256_andnot_si256(small, aMask));
+            }
+
+            sum = _mm256_add_epi64(sum, _mm256_sad_epu8(c8, zero));
+        }
+
+        return HSum64(Fold256(sum)) + AlphaVertChangesSSE2(prev + x * 4, row + x * 4, w - x);
+    }
+
+    uint64_t SatMidEvenAVX2(const uint8_t* row, size_t w)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i aMask = _mm256_set1_epi32(int(0xFF000000));
+        const __m256i rgbMask = _mm256_set1_epi32(0x00FFFFFF);
+        const __m256i evenMask = _mm256_set_epi32(0, -1, 0, -1, 0, -1, 0, -1);
+        const __m256i k20 = _mm256_set1_epi8(20);
+        const __m256i k234 = _mm256_set1_epi8(char(234));
+        const __m256i k200 = _mm256_set1_epi8(char(200));
+
+        __m256i acc = zero;
+        size_t x = 0;
+
+        for (; x + 8 <= w; x += 8)
+        {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + x * 4));
+
+            __m256i le20 = _mm256_cmpeq_epi8(_mm256_subs_epu8(v, k20), zero);
+            __m256i le234 = _mm256_cmpeq_epi8(_mm256_min_epu8(v, k234), v);
+            __m256i aOk = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_andnot_si256(le20, le234), aMask), aMask);
+
+            __m256i hot = _mm256_and_si256(_mm256_subs_epu8(v, k200), rgbMask);
+            __m256i cOk = _mm256_andnot_si256(_mm256_cmpeq_epi32(hot, zero), evenMask);
+
+            acc = _mm256_sub_epi32(acc, _mm256_and_si256(aOk, cOk));
+        }
+
+        return HSum32(Fold256x32(acc)) + SatMidEvenSSE2(row + x * 4, w - x);
+    }
+
+    inline __m256i AbsDiffAlpha256(__m256i a, __m256i b)
+    {
+        return _mm256_sub_epi16(_mm256_max_epi16(a, b), _mm256_min_epi16(a, b));
+    }
+
+    uint64_t AlphaGradEvenAVX2(const uint8_t* rowU, const uint8_t* row, const uint8_t* rowD, size_t w, uint64_t& samples)
+    {
+        const __m256i evenMask = _mm256_set_epi32(0, -1, 0, -1, 0, -1, 0, -1);
+
+        __m256i acc = _mm256_setzero_si256();
+        size_t x = 2;
+
+        for (; x + 10 <= w; x += 8)
+        {
+            __m256i c = _mm256_srli_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + x * 4)), 24);
+            __m256i l = _mm256_srli_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + (x - 2) * 4)), 24);
+            __m256i r = _mm256_srli_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + (x + 2) * 4)), 24);
+            __m256i u = _mm256_srli_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(rowU + x * 4)), 24);
+            __m256i d = _mm256_srli_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(rowD + x * 4)), 24);
+
+            __m256i g = _mm256_add_epi32(_mm256_add_epi32(AbsDiffAlpha256(c, l), AbsDiffAlpha256(c, r)),
+                _mm256_add_epi32(AbsDiffAlpha256(c, u), AbsDiffAlpha256(c, d)));
+
+            acc = _mm256_add_epi32(acc, _mm256_and_si256(g, evenMask));
+            samples += 4;
+        }
+
+        return HSum32(Fold256x32(acc)) + AlphaGradEvenSSE2(rowU + (x - 2) * 4, row + (x - 2) * 4, rowD + (x - 2) * 4, w - (x - 2), samples);
+    }
+
+    uint64_t LaplacianRowAVX2(const uint8_t* rowU, const uint8_t* row, const uint8_t* rowD, size_t w)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i lowMask = _mm256_set1_epi32(0xFF);
+
+        __m256i acc = zero;
+        size_t x = 1;
+
+        for (; x + 9 <= w; x += 8)
+        {
+            __m256i c = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + x * 4)), lowMask);
+            __m256i l = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + (x - 1) * 4)), lowMask);
+            __m256i r = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + (x + 1) * 4)), lowMask);
+            __m256i u = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(rowU + x * 4)), lowMask);
+            __m256i d = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(rowD + x * 4)), lowMask);
+
+            __m256i lap = _mm256_sub_epi32(_mm256_slli_epi32(c, 2),
+                _mm256_add_epi32(_mm256_add_epi32(l, r), _mm256_add_epi32(u, d)));
+
+            __m256i p = _mm256_packs_epi32(lap, zero);
+            __m256i sq = _mm256_madd_epi16(p, p);
+
+            acc = _mm256_add_epi64(acc, _mm256_unpacklo_epi32(sq, zero));
+        }
+
+        return HSum64(Fold256(acc)) + LaplacianRowSSE2(rowU + (x - 1) * 4, row + (x - 1) * 4, rowD + (x - 1) * 4, w - (x - 1));
+    }
+
+    void RowContentAVX2(const uint8_t* row, size_t w, RowContent& out)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i rgbMask = _mm256_set1_epi32(0x00FFFFFF);
+        const __m256i k8 = _mm256_set1_epi8(8);
+
+        out = RowContent();
+        size_t x = 0;
+
+        for (; x + 8 <= w; x += 8)
+        {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + x * 4));
+            __m256i hot = _mm256_and_si256(_mm256_subs_epu8(v, k8), rgbMask);
+            unsigned empty = unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(hot, zero))));
+
+            AccumulateContent(~empty & 0xFF, x, out);
+        }
+
+        RowContent tail;
+        RowContentSSE2(row + x * 4, w - x, tail);
+        if (tail.nonZero)
+        {
+            out.nonZero += tail.nonZero;
+            if (out.minX < 0) out.minX = int32_t(x) + tail.minX;
+            out.maxX = int32_t(x) + tail.maxX;
+        }
+    }
+
+    const AnalysisKernels kScalarKernels =
+    {
+        KernelLevel::Scalar,
+        AlphaCountsScalar, ColorSumsScalar, AlphaVertChangesScalar,
+        SatMidEvenScalar, AlphaGradEvenScalar, LaplacianRowScalar, RowContentScalar
+    };
+
+    const AnalysisKernels kSSE2Kernels =
+    {
+        KernelLevel::SSE2,
+        AlphaCountsSSE2, ColorSumsSSE2, AlphaVertChangesSSE2,
+        SatMidEvenSSE2, AlphaGradEvenSSE2, LaplacianRowSSE2, RowContentSSE2
+    };
+
+    const AnalysisKernels kAVX2Kernels =
+    {
+        KernelLevel::AVX2,
+        AlphaCountsAVX2, ColorSumsAVX2, AlphaVertChangesAVX2,
+        SatMidEvenAVX2, AlphaGradEvenAVX2, LaplacianRowAVX2, RowContentAVX2
+    };
+
+    KernelLevel QueryCpu()
+    {
+        int info[4] = {};
+
+        __cpuid(info, 0);
+        int maxLeaf = info[0];
+
+        __cpuid(info, 1);
+        bool sse2 = (info[3] & (1 << 26)) != 0;
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+
+        // AVX2 necesita tambien que el SO guarde los registros YMM
+        if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 0x6) == 0x6)
+        {
+            __cpuidex(info, 7, 0);
+            if (info[1] & (1 << 5))
+                return KernelLevel::AVX2;
+        }
+
+        return sse2 ? KernelLevel::SSE2 : KernelLevel::Scalar;
+    }
+}
+
+KernelLevel DetectKernelLevel()
+{
+    static const KernelLevel level = QueryCpu();
+    return level;
+}
+
+const AnalysisKernels* GetAnalysisKernels(KernelLevel level)
+{
+    if (level > DetectKernelLevel())
+        return nullptr;
+
+    switch (level)
+    {
+    case KernelLevel::AVX2: return &kAVX2Kernels;
+    case KernelLevel::SSE2: return &kSSE2Kernels;
+    default:                return &kScalarKernels;
+    }
+}
+
+const AnalysisKernels& GetAnalysisKernels()
+{
+    return *GetAnalysisKernels(DetectKernelLevel());
+}
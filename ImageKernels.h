@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// -------------------------------------------------------------
+// Kernels de analisis por fila (RGBA/BGRA 8 bits, 4 bytes/pixel)
+// con version escalar (referencia), SSE2 y AVX2.
+// Todos acumulan en enteros, asi que las tres versiones dan
+// exactamente el mismo resultado.
+// -------------------------------------------------------------
+enum class KernelLevel
+{
+    Scalar = 0,
+    SSE2 = 1,
+    AVX2 = 2
+};
+
+struct AlphaRowCounts
+{
+    uint64_t transparent = 0;   // a <= 5
+    uint64_t opaque = 0;        // a >= 250
+    uint64_t soft = 0;          // 0 < a < 255
+    uint64_t notOpaque = 0;     // a != 255
+};
+
+struct ColorRowSums
+{
+    uint64_t sum[3] = {};       // p[0], p[1], p[2]
+    uint64_t sumSq[3] = {};
+};
+
+struct RowContent
+{
+    uint32_t nonZero = 0;       // pixeles con algun canal de color > 8
+    int32_t minX = -1;          // -1 si la fila esta vacia
+    int32_t maxX = -1;
+};
+
+struct AnalysisKernels
+{
+    KernelLevel level;
+
+    // Acumulan sobre 'acc'
+    void (*alphaCounts)(const uint8_t* row, size_t w, AlphaRowCounts& acc);
+    void (*colorSums)(const uint8_t* row, size_t w, ColorRowSums& acc);
+
+    // |a(prev) - a(row)| > 10
+    uint64_t (*alphaVertChanges)(const uint8_t* prev, const uint8_t* row, size_t w);
+
+    // Solo x pares: 20 < a < 235 y algun canal > 200
+    uint64_t (*satMidEven)(const uint8_t* row, size_t w);
+
+    // Solo x pares en [2, w - 2): suma de |a - vecino| con vecinos a distancia 2.
+    // rowU / rowD son las filas y - 2 / y + 2.
+    uint64_t (*alphaGradEven)(const uint8_t* rowU, const uint8_t* row, const uint8_t* rowD, size_t w, uint64_t& samples);
+
+    // x en [1, w - 1): suma de (4c - l - r - u - d)^2 sobre el canal 0
+    uint64_t (*laplacianRow)(const uint8_t* rowU, const uint8_t* row, const uint8_t* rowD, size_t w);
+
+    void (*rowContent)(const uint8_t* row, size_t w, RowContent& out);
+};
+
+// Mejor nivel que soporta la CPU actual (se detecta una vez)
+KernelLevel DetectKernelLevel();
+
+// Kernels para el nivel detectado
+const AnalysisKernels& GetAnalysisKernels();
+
+// Kernels para un nivel concreto; nullptr si la CPU no lo soporta
+const AnalysisKernels* GetAnalysisKernels(KernelLevel level);
@@ -0,0 +1,388 @@
+#include "ImageQuality.h"
+#include "BCDecoder.h"
+#include "TextureEncode.h"
+#include "Trace.h"
+#include "WorkStealingPool.h"
+#include <emmintrin.h>
+#include <immintrin.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    // Multiplo de la ventana (8) y de la altura de bloque (4)
+    const size_t kBandRows = 64;
+
+    // c * a / 255 redondeado (exacto para c, a de 8 bits)
+    inline uint32_t Premultiply(uint32_t c, uint32_t a)
+    {
+        uint32_t t = c * a + 128;
+        return (t + (t >> 8)) >> 8;
+    }
+
+    // =========================================================
+    // Escalar (referencia)
+    // =========================================================
+    void WindowRowScalar(const uint8_t* a, const uint8_t* b, size_t w, QualityWindowSums* windows)
+    {
+        for (size_t x = 0; x < w; ++x)
+        {
+            QualityWindowSums& s = windows[x / kQualityWindow];
+            const uint8_t* pa = a + x * 4;
+            const uint8_t* pb = b + x * 4;
+
+            for (int c = 0; c < 4; ++c)
+            {
+                // Alpha: Premultiply(a, 255) == a
+                uint32_t va = Premultiply(pa[c], (c == 3) ? 255 : pa[3]);
+                uint32_t vb = Premultiply(pb[c], (c == 3) ? 255 : pb[3]);
+
+                s.sx[c] += va;
+                s.sy[c] += vb;
+                s.sxx[c] += va * va;
+                s.syy[c] += vb * vb;
+                s.sxy[c] += va * vb;
+            }
+
+            ++s.count;
+        }
+    }
+
+    inline void AddWindow(QualityWindowSums& s, __m128i sx, __m128i sy, __m128i sxx, __m128i syy, __m128i sxy)
+    {
+        auto add = [](uint32_t* dst, __m128i v)
+            {
+                __m128i* p = reinterpret_cast<__m128i*>(dst);
+                _mm_storeu_si128(p, _mm_add_epi32(_mm_loadu_si128(p), v));
+            };
+
+        add(s.sx, sx);
+        add(s.sy, sy);
+        add(s.sxx, sxx);
+        add(s.syy, syy);
+        add(s.sxy, sxy);
+        s.count += uint32_t(kQualityWindow);
+    }
+
+    // =========================================================
+    // SSE2: 4 pixeles por carga, un pixel por registro de 32 bits
+    // =========================================================
+    inline __m128i Premultiply16(__m128i v)
+    {
+        const __m128i alphaLanes = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+        const __m128i k255 = _mm_set1_epi16(255);
+        const __m128i k128 = _mm_set1_epi16(128);
+
+        __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xFF), 0xFF);
+        __m128i m = _mm_or_si128(_mm_andnot_si128(alphaLanes, a), _mm_and_si128(alphaLanes, k255));
+
+        __m128i t = _mm_add_epi16(_mm_mullo_epi16(v, m), k128);
+        return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+    }
+
+    void WindowRowSSE2(const uint8_t* a, const uint8_t* b, size_t w, QualityWindowSums* windows)
+    {
+        const __m128i zero = _mm_setzero_si128();
+
+        size_t x = 0;
+        for (; x + kQualityWindow <= w; x += kQualityWindow)
+        {
+            __m128i sx = zero, sy = zero, sxx = zero, syy = zero, sxy = zero;
+
+            for (size_t i = 0; i < kQualityWindow; i += 4)
+            {
+                __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + (x + i) * 4));
+                __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + (x + i) * 4));
+
+                __m128i pa[2] = { Premultiply16(_mm_unpacklo_epi8(va, zero)), Premultiply16(_mm_unpackhi_epi8(va, zero)) };
+                __m128i pb[2] = { Premultiply16(_mm_unpacklo_epi8(vb, zero)), Premultiply16(_mm_unpackhi_epi8(vb, zero)) };
+
+                for (int k = 0; k < 2; ++k)
+                {
+                    // Con la mitad alta a 0, madd da el producto por canal
+                    __m128i a0 = _mm_unpacklo_epi16(pa[k], zero);
+                    __m128i a1 = _mm_unpackhi_epi16(pa[k], zero);
+                    __m128i b0 = _mm_unpacklo_epi16(pb[k], zero);
+                    __m128i b1 = _mm_unpackhi_epi16(pb[k], zero);
+
+                    sx = _mm_add_epi32(sx, _mm_add_epi32(a0, a1));
+                    sy = _mm_add_epi32(sy, _mm_add_epi32(b0, b1));
+                    sxx = _mm_add_epi32(sxx, _mm_add_epi32(_mm_madd_epi16(a0, a0), _mm_madd_epi16(a1, a1)));
+                    syy = _mm_add_epi32(syy, _mm_add_epi32(_mm_madd_epi16(b0, b0), _mm_madd_epi16(b1, b1)));
+                    sxy = _mm_add_epi32(sxy, _mm_add_epi32(_mm_madd_epi16(a0, b0), _mm_madd_epi16(a1, b1)));
+                }
+            }
+
+            AddWindow(windows[x / kQualityWindow], sx, sy, sxx, syy, sxy);
+        }
+
+        if (x < w)
+            WindowRowScalar(a + x * 4, b + x * 4, w - x, windows + x / kQualityWindow);
+    }
+
+    // =========================================================
+    // AVX2: una ventana (8 pixeles) por carga
+    // =========================================================
+    inline __m256i Premultiply16(__m256i v)
+    {
+        const __m256i alphaLanes = _mm256_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0);
+        const __m256i k255 = _mm256_set1_epi16(255);
+        const __m256i k128 = _mm256_set1_epi16(128);
+
+        __m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(v, 0xFF), 0xFF);
+        __m256i m = _mm256_or_si256(_mm256_andnot_si256(alphaLanes, a), _mm256_and_si256(alphaLanes, k255));
+
+        __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(v, m), k128);
+        return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+    }
+
+    inline __m128i Fold(__m256i v)
+    {
+        return _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    }
+
+    void WindowRowAVX2(const uint8_t* a, const uint8_t* b, size_t w, QualityWindowSums* windows)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+
+        size_t x = 0;
+        for (; x + kQualityWindow <= w; x += kQualityWindow)
+        {
+            __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + x * 4));
+            __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + x * 4));
+
+            __m256i pa[2] = { Premultiply16(_mm256_unpacklo_epi8(va, zero)), Premultiply16(_mm256_unpackhi_epi8(va, zero)) };
+            __m256i pb[2] = { Premultiply16(_mm256_unpacklo_epi8(vb, zero)), Premultiply16(_mm256_unpackhi_epi8(vb, zero)) };
+
+            __m256i sx = zero, sy = zero, sxx = zero, syy = zero, sxy = zero;
+
+            for (int k = 0; k < 2; ++k)
+            {
+                __m256i a0 = _mm256_unpacklo_epi16(pa[k], zero);
+                __m256i a1 = _mm256_unpackhi_epi16(pa[k], zero);
+                __m256i b0 = _mm256_unpacklo_epi16(pb[k], zero);
+                __m256i b1 = _mm256_unpackhi_epi16(pb[k], zero);
+
+                sx = _mm256_add_epi32(sx, _mm256_add_epi32(a0, a1));
+                sy = _mm256_add_epi32(sy, _mm256_add_epi32(b0, b1));
+                sxx = _mm256_add_epi32(sxx, _mm256_add_epi32(_mm256_madd_epi16(a0, a0), _mm256_madd_epi16(a1, a1)));
+                syy = _mm256_add_epi32(syy, _mm256_add_epi32(_mm256_madd_epi16(b0, b0), _mm256_madd_epi16(b1, b1)));
+                sxy = _mm256_add_epi32(sxy, _mm256_add_epi32(_mm256_madd_epi16(a0, b0), _mm256_madd_epi16(a1, b1)));
+            }
+
+            AddWindow(windows[x / kQualityWindow], Fold(sx), Fold(sy), Fold(sxx), Fold(syy), Fold(sxy));
+        }
+
+        if (x < w)
+            WindowRowScalar(a + x * 4, b + x * 4, w - x, windows + x / kQualityWindow);
+    }
+
+    const QualityKernels kScalarKernels = { KernelLevel::Scalar, WindowRowScalar };
+    const QualityKernels kSSE2Kernels = { KernelLevel::SSE2, WindowRowSSE2 };
+    const QualityKernels kAVX2Kernels = { KernelLevel::AVX2, WindowRowAVX2 };
+
+    // =========================================================
+    // Metricas
+    // =========================================================
+    double WindowSSIM(const QualityWindowSums& s)
+    {
+        const double C1 = (0.01 * 255.0) * (0.01 * 255.0);
+        const double C2 = (0.03 * 255.0) * (0.03 * 255.0);
+
+        double n = double(s.count);
+        double sum = 0.0;
+
+        for (int c = 0; c < 4; ++c)
+        {
+            double mx = s.sx[c] / n;
+            double my = s.sy[c] / n;
+            double vx = s.sxx[c] / n - mx * mx;
+            double vy = s.syy[c] / n - my * my;
+            double cxy = s.sxy[c] / n - mx * my;
+
+            sum += ((2.0 * mx * my + C1) * (2.0 * cxy + C2))
+                / ((mx * mx + my * my + C1) * (vx + vy + C2));
+        }
+
+        return sum / 4.0;
+    }
+
+    struct BandResult
+    {
+        uint64_t sse = 0;
+        uint64_t windows = 0;
+        double ssimSum = 0.0;
+        HRESULT hr = S_OK;
+    };
+
+    void CompareRows(const uint8_t* ref, size_t refPitch, const uint8_t* test, size_t testPitch,
+        size_t w, size_t rows, BandResult& out)
+    {
+        const QualityKernels& k = GetQualityKernels();
+        std::vector<QualityWindowSums> windows((w + kQualityWindow - 1) / kQualityWindow);
+
+        for (size_t y0 = 0; y0 < rows; y0 += kQualityWindow)
+        {
+            std::fill(windows.begin(), windows.end(), QualityWindowSums());
+
+            size_t y1 = std::min(y0 + kQualityWindow, rows);
+            for (size_t y = y0; y < y1; ++y)
+                k.windowRow(ref + y * refPitch, test + y * testPitch, w, windows.data());
+
+            for (const auto& s : windows)
+            {
+                for (int c = 0; c < 4; ++c)
+                    out.sse += uint64_t(s.sxx[c]) + s.syy[c] - 2ull * s.sxy[c];
+
+                out.ssimSum += WindowSSIM(s);
+                ++out.windows;
+            }
+        }
+    }
+
+    // Reparte las bandas en el pool de CompressTiled y junta los
+    // resultados en orden (mismo resultado con cualquier numero de hilos)
+    template <class BandFn>
+    HRESULT RunBands(size_t w, size_t h, QualityScore& score, BandFn&& band)
+    {
+        size_t bandCount = (h + kBandRows - 1) / kBandRows;
+        std::vector<BandResult> results(bandCount);
+
+        TileEncodeOptions options = GetDefaultTileEncodeOptions();
+        if (bandCount <= 1 || ResolveTileThreads(options) <= 1)
+        {
+            for (size_t i = 0; i < bandCount; ++i)
+                band(i * kBandRows, std::min(kBandRows, h - i * kBandRows), results[i]);
+        }
+        else
+        {
+            WorkStealingPool* pool = GetTileEncodePool(options);
+            WorkStealingPool::TaskGroup group;
+            TraceContext traceContext = Trace::GetContext();
+
+            for (size_t i = 0; i < bandCount; ++i)
+            {
+                pool->Submit([&, i]()
+                    {
+                        TraceContextScope traceScope(traceContext);
+                        TraceSpan span("QualityBand");
+                        band(i * kBandRows, std::min(kBandRows, h - i * kBandRows), results[i]);
+                    }, &group);
+            }
+
+            pool->Wait(&group);
+        }
+
+        BandResult total;
+        for (const auto& r : results)
+        {
+            if (FAILED(r.hr))
+                return r.hr;
+
+            total.sse += r.sse;
+            total.windows += r.windows;
+            total.ssimSum += r.ssimSum;
+        }
+
+        double mse = double(total.sse) / (double(w) * double(h) * 4.0);
+        score.psnr = (mse > 0.0) ? std::min(kMaxPSNR, 10.0 * std::log10(255.0 * 255.0 / mse)) : kMaxPSNR;
+        score.ssim = total.windows ? total.ssimSum / double(total.windows) : 1.0;
+        return S_OK;
+    }
+
+    bool IsQualityFormat(DXGI_FORMAT format)
+    {
+        switch (format)
+        {
+        case DXGI_FORMAT_R8G8B8A8_UNORM:
+        case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+        case DXGI_FORMAT_B8G8R8A8_UNORM:
+        case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+            return true;
+        default:
+            return false;
+        }
+    }
+}
+
+double GetQualityValue(const QualityScore& score, QualityMetric metric)
+{
+    return (metric == QualityMetric::SSIM) ? score.ssim : score.psnr;
+}
+
+const QualityKernels* GetQualityKernels(KernelLevel level)
+{
+    if (level > DetectKernelLevel())
+        return nullptr;
+
+    switch (level)
+    {
+    case KernelLevel::AVX2: return &kAVX2Kernels;
+    case KernelLevel::SSE2: return &kSSE2Kernels;
+    default:                return &kScalarKernels;
+    }
+}
+
+const QualityKernels& GetQualityKernels()
+{
+    return *GetQualityKernels(DetectKernelLevel());
+}
+
+HRESULT CompareImages(const Image& ref, const Image& test, QualityScore& score)
+{
+    score = { kMaxPSNR, 1.0 };
+
+    if (!ref.pixels || !test.pixels || !IsQualityFormat(ref.format) || test.format != ref.format
+        || test.width != ref.width || test.height != ref.height)
+        return E_INVALIDARG;
+
+    TraceSpan span("CompareImages");
+    return RunBands(ref.width, ref.height, score, [&](size_t y, size_t rows, BandResult& out)
+        {
+            CompareRows(ref.pixels + y * ref.rowPitch, ref.rowPitch,
+                test.pixels + y * test.rowPitch, test.rowPitch, ref.width, rows, out);
+        });
+}
+
+HRESULT MeasureEncodedQuality(const Image& ref, const Image& encoded, QualityScore& score)
+{
+    score = { kMaxPSNR, 1.0 };
+
+    if (!ref.pixels || !encoded.pixels || !IsQualityFormat(ref.format) || !IsCompressed(encoded.format)
+        || encoded.width != ref.width || encoded.height != ref.height)
+        return E_INVALIDARG;
+
+    TraceSpan span("MeasureEncodedQuality");
+    return RunBands(ref.width, ref.height, score, [&](size_t y, size_t rows, BandResult& out)
+        {
+            // Las filas de bloques de la banda, como imagen propia
+            Image band = encoded;
+            band.height = rows;
+            band.pixels = encoded.pixels + (y / 4) * encoded.rowPitch;
+            band.slicePitch = encoded.rowPitch * ((rows + 3) / 4);
+
+            // A RGBA8 con DecodeBC si puede (ya va por bandas: en este hilo)
+            if (IsBCDecodeFormat(encoded.format)
+                && (ref.format == DXGI_FORMAT_R8G8B8A8_UNORM || ref.format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB))
+            {
+                std::vector<uint8_t> pixels(ref.width * 4 * rows);
+                Image d = { ref.width, rows, ref.format, ref.width * 4, pixels.size(), pixels.data() };
+
+                out.hr = DecodeBC(band, d, false);
+                if (SUCCEEDED(out.hr))
+                    CompareRows(ref.pixels + y * ref.rowPitch, ref.rowPitch, d.pixels, d.rowPitch, ref.width, rows, out);
+                return;
+            }
+
+            ScratchImage decoded;
+            out.hr = Decompress(band, ref.format, decoded);
+            if (FAILED(out.hr))
+                return;
+
+            const Image* d = decoded.GetImage(0, 0, 0);
+            CompareRows(ref.pixels + y * ref.rowPitch, ref.rowPitch, d->pixels, d->rowPitch, ref.width, rows, out);
+        });
+}
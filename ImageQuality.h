@@ -0,0 +1,90 @@
+#pragma once
+
+#include <windows.h>
+#include "DirectXTex.h"
+#include "ImageKernels.h"
+#include <cstdint>
+
+// -------------------------------------------------------------
+// Calidad de una codificacion frente al original.
+//
+// Se compara RGBA premultiplicado (c * a / 255, redondeado), asi los
+// errores de color bajo alpha 0 no cuentan. PSNR sale del error
+// cuadratico medio de los 4 canales; SSIM es la media de ventanas 8x8
+// sin solapar, por canal. Las dos metricas salen de las mismas sumas
+// por ventana, calculadas con kernels SIMD y por bandas en el pool de
+// CompressTiled.
+// -------------------------------------------------------------
+enum class QualityMetric
+{
+    PSNR = 0,       // dB, kMaxPSNR si no hay error
+    SSIM = 1        // 0..1
+};
+
+static const double kMaxPSNR = 100.0;
+static const size_t kQualityWindow = 8;
+
+struct QualityScore
+{
+    double psnr;
+    double ssim;
+};
+
+double GetQualityValue(const QualityScore& score, QualityMetric metric);
+
+// Sumas de una ventana por canal, sobre valores premultiplicados
+struct QualityWindowSums
+{
+    uint32_t sx[4];
+    uint32_t sy[4];
+    uint32_t sxx[4];
+    uint32_t syy[4];
+    uint32_t sxy[4];
+    uint32_t count;         // pixeles
+};
+
+struct QualityKernels
+{
+    KernelLevel level;
+
+    // Suma la fila en windows[x / kQualityWindow] (a y b: 4 bytes/pixel)
+    void (*windowRow)(const uint8_t* a, const uint8_t* b, size_t w, QualityWindowSums* windows);
+};
+
+// nullptr si la CPU no soporta el nivel
+const QualityKernels* GetQualityKernels(KernelLevel level);
+const QualityKernels& GetQualityKernels();
+
+// Dos imagenes del mismo formato de 8 bits por canal y mismo tamano
+HRESULT CompareImages(const DirectX::Image& ref, const DirectX::Image& test, QualityScore& score);
+
+// 'encoded' (BC, mismo tamano que ref) se decodifica por bandas y cada
+// banda se compara en cuanto esta decodificada: la imagen decodificada
+// nunca esta entera en memoria. Con ref RGBA8 y un formato de
+// IsBCDecodeFormat decodifica DecodeBC (BCDecoder.h); si no, Decompress.
+HRESULT MeasureEncodedQuality(const DirectX::Image& ref, const DirectX::Image& encoded, QualityScore& score);
+
+// -------------------------------------------------------------
+// Modo calidad objetivo: candidatos de mas barato a mas caro
+// -------------------------------------------------------------
+enum QualityCandidate
+{
+    QUALITY_BC3 = 1,
+    QUALITY_BC7_ULTRAFAST = 2,
+    QUALITY_BC7_QUICKONLY = 3,
+    QUALITY_BC7_FASTBALANCED = 4,
+    QUALITY_BC7_BALANCED = 5,
+    QUALITY_BC7_HIGHQUALITY = 6,        // HighQualityUniform
+    QUALITY_UNCOMPRESSED = 7
+};
+
+// Se devuelve al llamador (tambien desde la DLL), solo tipos planos
+struct QualityTargetStats
+{
+    int32_t  candidate;     // QualityCandidate elegido
+    uint32_t tried;         // candidatos probados, incluido el elegido
+    double   psnr;          // del elegido
+    double   ssim;
+    uint32_t encodeMs;      // todas las codificaciones
+    uint32_t verifyMs;      // todas las decodificaciones + comparaciones
+};
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <emmintrin.h>
+#include <immintrin.h>
+#include <cmath>
+#include <cstddef>
+
+// -------------------------------------------------------------
+// Vectores de carriles para los codificadores por bloques (un bloque
+// por carril): escalar (referencia), SSE2 (4) y AVX2 (8).
+//
+// Solo operaciones que dan el mismo float en los tres (nada de FMA ni
+// aproximaciones como rcp/rsqrt): con el mismo codigo plantilla y el
+// mismo orden de operaciones, los tres niveles dan los mismos bytes.
+// Trunc solo vale para valores que caben en int32.
+// -------------------------------------------------------------
+namespace LaneMath
+{
+    struct F1 { float v; };
+    struct M1 { bool v; };
+
+    inline F1 operator+(F1 a, F1 b) { return { a.v + b.v }; }
+    inline F1 operator-(F1 a, F1 b) { return { a.v - b.v }; }
+    inline F1 operator*(F1 a, F1 b) { return { a.v * b.v }; }
+    inline F1 operator/(F1 a, F1 b) { return { a.v / b.v }; }
+    inline M1 operator<(F1 a, F1 b) { return { a.v < b.v }; }
+    inline M1 operator>(F1 a, F1 b) { return { a.v > b.v }; }
+    inline M1 operator&(M1 a, M1 b) { return { a.v && b.v }; }
+    inline M1 operator|(M1 a, M1 b) { return { a.v || b.v }; }
+    inline F1 Min(F1 a, F1 b) { return { a.v < b.v ? a.v : b.v }; }
+    inline F1 Max(F1 a, F1 b) { return { a.v > b.v ? a.v : b.v }; }
+    inline F1 Sqrt(F1 a) { return { std::sqrt(a.v) }; }
+    inline F1 Trunc(F1 a) { return { float(int(a.v)) }; }
+    inline F1 Select(M1 m, F1 a, F1 b) { return m.v ? a : b; }
+    inline bool Any(M1 m) { return m.v; }
+
+    struct Lanes1
+    {
+        using V = F1;
+        using M = M1;
+        static const size_t N = 1;
+
+        static V Set(float x) { return { x }; }
+        static V Load(const float* p) { return { *p }; }
+        static void Store(float* p, V a) { *p = a.v; }
+    };
+
+    struct F4 { __m128 v; };
+    struct M4 { __m128 v; };
+
+    inline F4 operator+(F4 a, F4 b) { return { _mm_add_ps(a.v, b.v) }; }
+    inline F4 operator-(F4 a, F4 b) { return { _mm_sub_ps(a.v, b.v) }; }
+    inline F4 operator*(F4 a, F4 b) { return { _mm_mul_ps(a.v, b.v) }; }
+    inline F4 operator/(F4 a, F4 b) { return { _mm_div_ps(a.v, b.v) }; }
+    inline M4 operator<(F4 a, F4 b) { return { _mm_cmplt_ps(a.v, b.v) }; }
+    inline M4 operator>(F4 a, F4 b) { return { _mm_cmpgt_ps(a.v, b.v) }; }
+    inline M4 operator&(M4 a, M4 b) { return { _mm_and_ps(a.v, b.v) }; }
+    inline M4 operator|(M4 a, M4 b) { return { _mm_or_ps(a.v, b.v) }; }
+    inline F4 Min(F4 a, F4 b) { return { _mm_min_ps(a.v, b.v) }; }
+    inline F4 Max(F4 a, F4 b) { return { _mm_max_ps(a.v, b.v) }; }
+    inline F4 Sqrt(F4 a) { return { _mm_sqrt_ps(a.v) }; }
+    inline F4 Trunc(F4 a) { return { _mm_cvtepi32_ps(_mm_cvttps_epi32(a.v)) }; }
+    inline F4 Select(M4 m, F4 a, F4 b) { return { _mm_or_ps(_mm_and_ps(m.v, a.v), _mm_andnot_ps(m.v, b.v)) }; }
+    inline bool Any(M4 m) { return _mm_movemask_ps(m.v) != 0; }
+
+    struct Lanes4
+    {
+        using V = F4;
+        using M = M4;
+        static const size_t N = 4;
+
+        static V Set(float x) { return { _mm_set1_ps(x) }; }
+        static V Load(const float* p) { return { _mm_loadu_ps(p) }; }
+        static void Store(float* p, V a) { _mm_storeu_ps(p, a.v); }
+    };
+
+    struct F8 { __m256 v; };
+    struct M8 { __m256 v; };
+
+    inline F8 operator+(F8 a, F8 b) { return { _mm256_add_ps(a.v, b.v) }; }
+    inline F8 operator-(F8 a, F8 b) { return { _mm256_sub_ps(a.v, b.v) }; }
+    inline F8 operator*(F8 a, F8 b) { return { _mm256_mul_ps(a.v, b.v) }; }
+    inline F8 operator/(F8 a, F8 b) { return { _mm256_div_ps(a.v, b.v) }; }
+    inline M8 operator<(F8 a, F8 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ) }; }
+    inline M8 operator>(F8 a, F8 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ) }; }
+    inline M8 operator&(M8 a, M8 b) { return { _mm256_and_ps(a.v, b.v) }; }
+    inline M8 operator|(M8 a, M8 b) { return { _mm256_or_ps(a.v, b.v) }; }
+    inline F8 Min(F8 a, F8 b) { return { _mm256_min_ps(a.v, b.v) }; }
+    inline F8 Max(F8 a, F8 b) { return { _mm256_max_ps(a.v, b.v) }; }
+    inline F8 Sqrt(F8 a) { return { _mm256_sqrt_ps(a.v) }; }
+    inline F8 Trunc(F8 a) { return { _mm256_cvtepi32_ps(_mm256_cvttps_epi32(a.v)) }; }
+    inline F8 Select(M8 m, F8 a, F8 b) { return { _mm256_blendv_ps(b.v, a.v, m.v) }; }
+    inline bool Any(M8 m) { return _mm256_movemask_ps(m.v) != 0; }
+
+    struct Lanes8
+    {
+        using V = F8;
+        using M = M8;
+        static const size_t N = 8;
+
+        static V Set(float x) { return { _mm256_set1_ps(x) }; }
+        static V Load(const float* p) { return { _mm256_loadu_ps(p) }; }
+        static void Store(float* p, V a) { _mm256_storeu_ps(p, a.v); }
+    };
+}
@@ -0,0 +1,324 @@
+#include "MipChain.h"
+#include "TextureEncode.h"
+#include "Trace.h"
+#include "WorkStealingPool.h"
+#include <emmintrin.h>
+#include <immintrin.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    // sRGB 8 bits -> lineal 16 bits y lineal (12 bits altos) -> sRGB 8 bits
+    struct ColorTables
+    {
+        uint16_t toLinear[256];
+        uint8_t toSRGB[4096];
+    };
+
+    const ColorTables& GetColorTables()
+    {
+        static const ColorTables tables = []()
+            {
+                ColorTables t;
+                for (int i = 0; i < 256; ++i)
+                {
+                    double s = i / 255.0;
+                    double l = (s <= 0.04045) ? s / 12.92 : std::pow((s + 0.055) / 1.055, 2.4);
+                    t.toLinear[i] = uint16_t(std::lround(l * 65535.0));
+                }
+                for (int i = 0; i < 4096; ++i)
+                {
+                    double l = (i + 0.5) / 4096.0;
+                    double s = (l <= 0.0031308) ? l * 12.92 : 1.055 * std::pow(l, 1.0 / 2.4) - 0.055;
+                    t.toSRGB[i] = uint8_t(std::lround(std::min(1.0, s) * 255.0));
+                }
+                return t;
+            }();
+        return tables;
+    }
+
+    // RGBA8 sRGB -> RGBA16 lineal premultiplicado
+    void LinearizeRow(const uint8_t* src, uint16_t* dst, size_t width, const ColorTables& t)
+    {
+        for (size_t x = 0; x < width; ++x, src += 4, dst += 4)
+        {
+            uint32_t a = src[3];
+            for (int c = 0; c < 3; ++c)
+                dst[c] = uint16_t((t.toLinear[src[c]] * a + 127) / 255);
+            dst[3] = uint16_t(a * 257);
+        }
+    }
+
+    // =========================================================
+    // Escalar (referencia)
+    // =========================================================
+    inline uint32_t Avg(uint32_t a, uint32_t b)
+    {
+        return (a + b + 1) >> 1;
+    }
+
+    void DownsampleRowScalar(const uint16_t* row0, const uint16_t* row1, size_t srcWidth, uint16_t* out, size_t dstWidth)
+    {
+        for (size_t x = 0; x < dstWidth; ++x)
+        {
+            size_t x0 = x * 2;
+            size_t x1 = std::min(x0 + 1, srcWidth - 1);
+
+            for (int c = 0; c < 4; ++c)
+            {
+                uint32_t v0 = Avg(row0[x0 * 4 + c], row1[x0 * 4 + c]);
+                uint32_t v1 = Avg(row0[x1 * 4 + c], row1[x1 * 4 + c]);
+                out[x * 4 + c] = uint16_t(Avg(v0, v1));
+            }
+        }
+    }
+
+    // =========================================================
+    // SSE2: 2 pixeles de salida por iteracion
+    // =========================================================
+    void DownsampleRowSSE2(const uint16_t* row0, const uint16_t* row1, size_t srcWidth, uint16_t* out, size_t dstWidth)
+    {
+        size_t x = 0;
+
+        // Solo con srcWidth >= 2 los 4 pixeles de origen existen siempre
+        if (srcWidth >= 2)
+        {
+            for (; x + 2 <= dstWidth; x += 2)
+            {
+                const __m128i* a = reinterpret_cast<const __m128i*>(row0 + x * 8);
+                const __m128i* b = reinterpret_cast<const __m128i*>(row1 + x * 8);
+
+                __m128i v0 = _mm_avg_epu16(_mm_loadu_si128(a), _mm_loadu_si128(b));            // px 0, 1
+                __m128i v1 = _mm_avg_epu16(_mm_loadu_si128(a + 1), _mm_loadu_si128(b + 1));    // px 2, 3
+
+                __m128i even = _mm_unpacklo_epi64(v0, v1);
+                __m128i odd = _mm_unpackhi_epi64(v0, v1);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x * 4), _mm_avg_epu16(even, odd));
+            }
+        }
+
+        if (x < dstWidth)
+            DownsampleRowScalar(row0 + x * 8, row1 + x * 8, srcWidth - x * 2, out + x * 4, dstWidth - x);
+    }
+
+    // =========================================================
+    // AVX2: 4 pixeles de salida por iteracion
+    // =========================================================
+    void DownsampleRowAVX2(const uint16_t* row0, const uint16_t* row1, size_t srcWidth, uint16_t* out, size_t dstWidth)
+    {
+        size_t x = 0;
+
+        if (srcWidth >= 2)
+        {
+            for (; x + 4 <= dstWidth; x += 4)
+            {
+                const __m256i* a = reinterpret_cast<const __m256i*>(row0 + x * 8);
+                const __m256i* b = reinterpret_cast<const __m256i*>(row1 + x * 8);
+
+                __m256i v0 = _mm256_avg_epu16(_mm256_loadu_si256(a), _mm256_loadu_si256(b));          // px 0..3
+                __m256i v1 = _mm256_avg_epu16(_mm256_loadu_si256(a + 1), _mm256_loadu_si256(b + 1));  // px 4..7
+
+                // Por carril: (0,4)/(1,5) y (2,6)/(3,7) -> salida 0 2 1 3
+                __m256i even = _mm256_unpacklo_epi64(v0, v1);
+                __m256i odd = _mm256_unpackhi_epi64(v0, v1);
+                __m256i r = _mm256_permute4x64_epi64(_mm256_avg_epu16(even, odd), 0xD8);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x * 4), r);
+            }
+        }
+
+        if (x < dstWidth)
+            DownsampleRowSSE2(row0 + x * 8, row1 + x * 8, srcWidth - x * 2, out + x * 4, dstWidth - x);
+    }
+
+    const MipKernels kScalarKernels = { KernelLevel::Scalar, DownsampleRowScalar };
+    const MipKernels kSSE2Kernels = { KernelLevel::SSE2, DownsampleRowSSE2 };
+    const MipKernels kAVX2Kernels = { KernelLevel::AVX2, DownsampleRowAVX2 };
+
+    inline const uint16_t* LinearRow(const Image& img, size_t y)
+    {
+        return reinterpret_cast<const uint16_t*>(img.pixels + y * img.rowPitch);
+    }
+}
+
+size_t CountMipLevels(size_t width, size_t height)
+{
+    size_t levels = 1;
+    while (width > 1 || height > 1)
+    {
+        width = std::max<size_t>(1, width / 2);
+        height = std::max<size_t>(1, height / 2);
+        ++levels;
+    }
+    return levels;
+}
+
+const MipKernels* GetMipKernels(KernelLevel level)
+{
+    if (level > DetectKernelLevel())
+        return nullptr;
+
+    switch (level)
+    {
+    case KernelLevel::AVX2: return &kAVX2Kernels;
+    case KernelLevel::SSE2: return &kSSE2Kernels;
+    default:                return &kScalarKernels;
+    }
+}
+
+const MipKernels& GetMipKernels()
+{
+    return *GetMipKernels(DetectKernelLevel());
+}
+
+// -------------------------------------------------------------
+// MipLevel
+// -------------------------------------------------------------
+
+HRESULT MipLevel::Allocate(size_t width, size_t height)
+{
+    HRESULT hr = m_linear.Initialize2D(DXGI_FORMAT_R16G16B16A16_UNORM, width, height);
+    if (FAILED(hr)) return hr;
+
+    return m_rgba.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM, width, height);
+}
+
+// Deshace el premultiplicado y vuelve a sRGB
+void MipLevel::ResolveRow(size_t y)
+{
+    const ColorTables& t = GetColorTables();
+    const Image& linear = m_linear.GetImage();
+    const Image& rgba = m_rgba.GetImage();
+
+    const uint16_t* src = LinearRow(linear, y);
+    uint8_t* dst = rgba.pixels + y * rgba.rowPitch;
+
+    for (size_t x = 0; x < linear.width; ++x, src += 4, dst += 4)
+    {
+        uint32_t a = src[3];
+        dst[3] = uint8_t((a + 128) / 257);
+
+        for (int c = 0; c < 3; ++c)
+        {
+            uint32_t l = a ? std::min<uint32_t>(65535, uint32_t((uint64_t(src[c]) * 65535 + a / 2) / a)) : 0;
+            dst[c] = t.toSRGB[l >> 4];
+        }
+    }
+}
+
+HRESULT MipLevel::InitializeFromRGBA(const Image& rgba)
+{
+    if (!rgba.pixels || rgba.format != DXGI_FORMAT_R8G8B8A8_UNORM)
+        return E_INVALIDARG;
+
+    size_t w = std::max<size_t>(1, rgba.width / 2);
+    size_t h = std::max<size_t>(1, rgba.height / 2);
+
+    HRESULT hr = Allocate(w, h);
+    if (FAILED(hr)) return hr;
+
+    const ColorTables& t = GetColorTables();
+    const MipKernels& k = GetMipKernels();
+    const Image& linear = m_linear.GetImage();
+
+    // Las dos filas de origen, ya en lineal
+    std::vector<uint16_t> rows(rgba.width * 8);
+    uint16_t* row0 = rows.data();
+    uint16_t* row1 = rows.data() + rgba.width * 4;
+
+    for (size_t y = 0; y < h; ++y)
+    {
+        size_t y0 = y * 2;
+        size_t y1 = std::min(y0 + 1, rgba.height - 1);
+
+        LinearizeRow(rgba.pixels + y0 * rgba.rowPitch, row0, rgba.width, t);
+        LinearizeRow(rgba.pixels + y1 * rgba.rowPitch, row1, rgba.width, t);
+
+        k.downsampleRow(row0, row1, rgba.width, const_cast<uint16_t*>(LinearRow(linear, y)), w);
+        ResolveRow(y);
+    }
+
+    return S_OK;
+}
+
+HRESULT MipLevel::InitializeFromLevel(const MipLevel& src)
+{
+    const Image& from = src.GetLinear();
+    if (!from.pixels)
+        return E_INVALIDARG;
+
+    size_t w = std::max<size_t>(1, from.width / 2);
+    size_t h = std::max<size_t>(1, from.height / 2);
+
+    HRESULT hr = Allocate(w, h);
+    if (FAILED(hr)) return hr;
+
+    const MipKernels& k = GetMipKernels();
+    const Image& linear = m_linear.GetImage();
+
+    for (size_t y = 0; y < h; ++y)
+    {
+        size_t y0 = y * 2;
+        size_t y1 = std::min(y0 + 1, from.height - 1);
+
+        k.downsampleRow(LinearRow(from, y0), LinearRow(from, y1), from.width,
+            const_cast<uint16_t*>(LinearRow(linear, y)), w);
+        ResolveRow(y);
+    }
+
+    return S_OK;
+}
+
+// -------------------------------------------------------------
+// Cadena completa
+// -------------------------------------------------------------
+
+HRESULT EncodeMipChain(const Image& base, size_t levels, const MipEncodeFn& encode)
+{
+    if (!base.pixels || base.format != DXGI_FORMAT_R8G8B8A8_UNORM || !levels)
+        return E_INVALIDARG;
+
+    TraceSpan span("EncodeMipChain");
+
+    WorkStealingPool* pool = GetTileEncodePool(GetDefaultTileEncodeOptions());
+    TraceContext traceContext = Trace::GetContext();
+
+    // El nivel n (n >= 1) vive en slots[n & 1]
+    MipLevel slots[2];
+    const Image* current = &base;
+
+    for (size_t level = 0; level < levels; ++level)
+    {
+        MipLevel& next = slots[(level + 1) & 1];
+        const MipLevel* from = (level > 0) ? &slots[level & 1] : nullptr;
+
+        HRESULT nextHr = S_OK;
+        WorkStealingPool::TaskGroup group;
+
+        // El siguiente nivel se genera en el pool mientras se codifica este
+        if (level + 1 < levels)
+        {
+            pool->Submit([&]()
+                {
+                    TraceContextScope traceScope(traceContext);
+                    TraceSpan mipSpan("GenerateMip");
+                    nextHr = from ? next.InitializeFromLevel(*from) : next.InitializeFromRGBA(base);
+                }, &group);
+        }
+
+        HRESULT hr = encode(level, *current);
+
+        // Siempre: la tarea usa variables de este bucle
+        pool->Wait(&group);
+
+        if (FAILED(hr)) return hr;
+        if (FAILED(nextHr)) return nextHr;
+
+        current = &next.GetRGBA();
+    }
+
+    return S_OK;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <windows.h>
+#include "DirectXTex.h"
+#include "BufferPool.h"
+#include "ImageKernels.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+// -------------------------------------------------------------
+// Cadena de mips para los DDS.
+//
+// Cada nivel sale del anterior con una caja 2x2 separable (vertical y
+// luego horizontal) en luz lineal y con alfa premultiplicado: los
+// bordes de los recortes no se oscurecen ni se tinen con el color de
+// los texels transparentes. Los niveles intermedios se guardan en
+// lineal a 16 bits por canal; cada uno se pasa a RGBA8 sRGB (sin
+// premultiplicar) al generarlo.
+//
+// Con tamanos impares la ultima columna/fila del nivel anterior se
+// ignora, como la caja de D3DX. El tamano del nivel n es
+// max(1, w >> n) x max(1, h >> n).
+// -------------------------------------------------------------
+
+// Niveles de la cadena completa hasta 1x1 (incluye el nivel 0)
+size_t CountMipLevels(size_t width, size_t height);
+
+struct MipKernels
+{
+    KernelLevel level;
+
+    // Una fila del nivel siguiente a partir de dos del actual (RGBA
+    // lineal de 16 bits). Cada canal: media redondeada de la vertical
+    // y luego de la horizontal, igual en todos los niveles.
+    void (*downsampleRow)(const uint16_t* row0, const uint16_t* row1, size_t srcWidth, uint16_t* out, size_t dstWidth);
+};
+
+// nullptr si la CPU no soporta el nivel
+const MipKernels* GetMipKernels(KernelLevel level);
+const MipKernels& GetMipKernels();
+
+// Nivel de la cadena: lineal premultiplicado y su version RGBA8
+class MipLevel
+{
+public:
+    // Primer nivel a partir de la imagen original (RGBA8, sRGB)
+    HRESULT InitializeFromRGBA(const DirectX::Image& rgba);
+
+    // Siguiente nivel de 'src'
+    HRESULT InitializeFromLevel(const MipLevel& src);
+
+    const DirectX::Image& GetLinear() const { return m_linear.GetImage(); }
+    const DirectX::Image& GetRGBA() const { return m_rgba.GetImage(); }
+
+private:
+    HRESULT Allocate(size_t width, size_t height);
+    void ResolveRow(size_t y);
+
+    PooledImage m_linear;       // R16G16B16A16_UNORM, premultiplicado
+    PooledImage m_rgba;         // R8G8B8A8_UNORM
+};
+
+// Se llama con cada nivel ya listo, en orden (0 = la imagen original)
+using MipEncodeFn = std::function<HRESULT(size_t level, const DirectX::Image& rgba)>;
+
+// Genera los niveles 1..levels-1 de 'base' (RGBA8) y llama a 'encode'
+// con todos. Mientras se codifica un nivel, el siguiente se genera en
+// el pool de CompressTiled; nunca hay mas de dos niveles en memoria.
+HRESULT EncodeMipChain(const DirectX::Image& base, size_t levels, const MipEncodeFn& encode);
@@ -0,0 +1,1106 @@
+#include "PngDecoder.h"
+#include <emmintrin.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cwchar>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    const HRESULT kInvalidData = static_cast<HRESULT>(0x8007000DL);     // ERROR_INVALID_DATA
+    const HRESULT kOverflow = static_cast<HRESULT>(0x80070216L);        // ERROR_ARITHMETIC_OVERFLOW
+
+    const uint8_t kSignature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+    // Limite de pixeles (la imagen RGBA8 ocupa 4 veces esto)
+    const uint64_t kMaxPixels = 1ull << 28;
+
+    inline uint32_t ReadBE32(const uint8_t* p)
+    {
+        return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+    }
+
+    inline uint32_t ChunkType(const char (&s)[5])
+    {
+        return ReadBE32(reinterpret_cast<const uint8_t*>(s));
+    }
+
+    // ---------------------------------------------------------
+    // Inflate (RFC 1951)
+    // ---------------------------------------------------------
+    const int kFastBits = 9;
+    const uint32_t kFastMask = (1u << kFastBits) - 1;
+
+    struct HuffmanTable
+    {
+        uint16_t fast[1 << kFastBits];      // (longitud << 9) | simbolo; 0 = codigo largo
+        uint16_t firstCode[16];
+        int32_t  maxCode[17];               // desplazado a 16 bits
+        uint16_t firstSymbol[16];
+        uint8_t  size[288];
+        uint16_t value[288];
+    };
+
+    const uint16_t kLengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+        35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    const uint8_t kLengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+        3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    const uint16_t kDistBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+        257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+    const uint8_t kDistExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+        7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+    const uint8_t kCodeLengthOrder[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+    inline uint32_t ReverseBits(uint32_t v, int bits)
+    {
+        uint32_t r = 0;
+        for (int i = 0; i < bits; ++i, v >>= 1)
+            r = (r << 1) | (v & 1);
+        return r;
+    }
+
+    bool BuildHuffman(HuffmanTable& t, const uint8_t* lengths, int count)
+    {
+        int sizes[17] = {};
+        int nextCode[16];
+
+        memset(t.fast, 0, sizeof(t.fast));
+        for (int i = 0; i < count; ++i)
+            ++sizes[lengths[i]];
+        sizes[0] = 0;
+
+        for (int i = 1; i < 16; ++i)
+        {
+            if (sizes[i] > (1 << i))
+                return false;
+        }
+
+        int code = 0;
+        int k = 0;
+        for (int i = 1; i < 16; ++i)
+        {
+            nextCode[i] = code;
+            t.firstCode[i] = uint16_t(code);
+            t.firstSymbol[i] = uint16_t(k);
+            code += sizes[i];
+            if (sizes[i] && code - 1 >= (1 << i))
+                return false;
+            t.maxCode[i] = code << (16 - i);
+            code <<= 1;
+            k += sizes[i];
+        }
+        t.maxCode[16] = 0x10000;
+
+        for (int i = 0; i < count; ++i)
+        {
+            int s = lengths[i];
+            if (!s)
+                continue;
+
+            int c = nextCode[s] - t.firstCode[s] + t.firstSymbol[s];
+            t.size[c] = uint8_t(s);
+            t.value[c] = uint16_t(i);
+
+            if (s <= kFastBits)
+            {
+                uint16_t entry = uint16_t((s << kFastBits) | i);
+                for (uint32_t j = ReverseBits(uint32_t(nextCode[s]), s); j < (1u << kFastBits); j += (1u << s))
+                    t.fast[j] = entry;
+            }
+            ++nextCode[s];
+        }
+
+        return true;
+    }
+
+    class Inflater
+    {
+    public:
+        Inflater(const uint8_t* in, size_t inSize, uint8_t* out, size_t outSize)
+            : m_in(in), m_inSize(inSize), m_out(out), m_outEnd(out + outSize), m_begin(out)
+        {
+        }
+
+        // Stream zlib completo (cabecera de 2 bytes, sin diccionario)
+        HRESULT Run()
+        {
+            if (m_inSize < 2)
+                return kInvalidData;
+
+            uint8_t cmf = m_in[0];
+            uint8_t flg = m_in[1];
+            if ((cmf & 0x0F) != 8 || ((cmf << 8) | flg) % 31 != 0 || (flg & 0x20))
+                return kInvalidData;
+            m_pos = 2;
+
+            bool final = false;
+            while (!final)
+            {
+                Refill();
+                final = Bits(1) != 0;
+                uint32_t type = Bits(2);
+
+                bool ok;
+                switch (type)
+                {
+                case 0: ok = Stored(); break;
+                case 1: ok = Codes(FixedTables()[0], FixedTables()[1]); break;
+                case 2: ok = Dynamic(); break;
+                default: ok = false; break;
+                }
+
+                if (!ok || Overrun())
+                    return kInvalidData;
+            }
+
+            return (m_out == m_outEnd) ? S_OK : kInvalidData;
+        }
+
+    private:
+        // Deja 56 bits o mas en el buffer. Pasado el final se leen ceros
+        // (Overrun() lo detecta).
+        void Refill()
+        {
+            if (m_pos + 8 <= m_inSize)
+            {
+                uint64_t v;
+                memcpy(&v, m_in + m_pos, 8);
+                m_buffer |= v << m_bits;
+                m_pos += (63 - m_bits) >> 3;
+                m_bits |= 56;
+                return;
+            }
+
+            while (m_bits <= 56)
+            {
+                uint64_t b = (m_pos < m_inSize) ? m_in[m_pos] : 0;
+                m_buffer |= b << m_bits;
+                m_bits += 8;
+                ++m_pos;
+            }
+        }
+
+        bool Overrun() const
+        {
+            return m_pos - (m_bits >> 3) > m_inSize;
+        }
+
+        uint32_t Bits(uint32_t n)
+        {
+            uint32_t v = uint32_t(m_buffer & ((1ull << n) - 1));
+            m_buffer >>= n;
+            m_bits -= n;
+            return v;
+        }
+
+        // Necesita 15 bits en el buffer; -1 si el codigo no existe
+        int Decode(const HuffmanTable& t)
+        {
+            uint32_t entry = t.fast[m_buffer & kFastMask];
+            if (entry)
+            {
+                uint32_t s = entry >> kFastBits;
+                m_buffer >>= s;
+                m_bits -= s;
+                return int(entry & kFastMask);
+            }
+
+            uint32_t k = ReverseBits(uint32_t(m_buffer & 0xFFFF), 16);
+            int s = kFastBits + 1;
+            while (int32_t(k) >= t.maxCode[s])
+                ++s;
+            if (s >= 16)
+                return -1;
+
+            int b = int(k >> (16 - s)) - t.firstCode[s] + t.firstSymbol[s];
+            if (b >= 288 || t.size[b] != s)
+                return -1;
+
+            m_buffer >>= s;
+            m_bits -= uint32_t(s);
+            return t.value[b];
+        }
+
+        bool Stored()
+        {
+            // Al byte y devuelve al stream lo que quede en el buffer
+            Bits(m_bits & 7);
+            m_pos -= m_bits >> 3;
+            m_buffer = 0;
+            m_bits = 0;
+
+            if (m_pos + 4 > m_inSize)
+                return false;
+
+            uint32_t len = m_in[m_pos] | (uint32_t(m_in[m_pos + 1]) << 8);
+            uint32_t nlen = m_in[m_pos + 2] | (uint32_t(m_in[m_pos + 3]) << 8);
+            m_pos += 4;
+
+            if ((len ^ 0xFFFF) != nlen || len > m_inSize - m_pos || len > size_t(m_outEnd - m_out))
+                return false;
+
+            memcpy(m_out, m_in + m_pos, len);
+            m_out += len;
+            m_pos += len;
+            return true;
+        }
+
+        static const HuffmanTable* FixedTables()
+        {
+            static const HuffmanTable* tables = []()
+                {
+                    static HuffmanTable t[2];
+                    uint8_t lengths[288];
+
+                    memset(lengths, 8, 144);
+                    memset(lengths + 144, 9, 112);
+                    memset(lengths + 256, 7, 24);
+                    memset(lengths + 280, 8, 8);
+                    BuildHuffman(t[0], lengths, 288);
+
+                    memset(lengths, 5, 30);
+                    BuildHuffman(t[1], lengths, 30);
+                    return t;
+                }();
+            return tables;
+        }
+
+        bool Dynamic()
+        {
+            Refill();
+            int hlit = int(Bits(5)) + 257;
+            int hdist = int(Bits(5)) + 1;
+            int hclen = int(Bits(4)) + 4;
+
+            uint8_t codeLengths[19] = {};
+            for (int i = 0; i < hclen; ++i)
+            {
+                Refill();
+                codeLengths[kCodeLengthOrder[i]] = uint8_t(Bits(3));
+            }
+
+            HuffmanTable lengthTable;
+            if (!BuildHuffman(lengthTable, codeLengths, 19))
+                return false;
+
+            uint8_t lengths[288 + 32];
+            int n = 0;
+            while (n < hlit + hdist)
+            {
+                Refill();
+                int sym = Decode(lengthTable);
+                if (sym < 0)
+                    return false;
+
+                if (sym < 16)
+                {
+                    lengths[n++] = uint8_t(sym);
+                    continue;
+                }
+
+                int repeat;
+                uint8_t fill = 0;
+                if (sym == 16)
+                {
+                    if (n == 0)
+                        return false;
+                    repeat = 3 + int(Bits(2));
+                    fill = lengths[n - 1];
+                }
+                else if (sym == 17)
+                {
+                    repeat = 3 + int(Bits(3));
+                }
+                else
+                {
+                    repeat = 11 + int(Bits(7));
+                }
+
+                if (n + repeat > hlit + hdist)
+                    return false;
+                memset(lengths + n, fill, size_t(repeat));
+                n += repeat;
+            }
+
+            if (hlit > 286 || lengths[256] == 0)
+                return false;
+
+            if (!BuildHuffman(m_lit, lengths, hlit) || !BuildHuffman(m_dist, lengths + hlit, hdist))
+                return false;
+
+            return Codes(m_lit, m_dist);
+        }
+
+        bool Codes(const HuffmanTable& lit, const HuffmanTable& dist)
+        {
+            for (;;)
+            {
+                // Un simbolo completo (15 + 5 + 15 + 13 bits) cabe en un refill
+                Refill();
+
+                int sym = Decode(lit);
+                if (sym < 256)
+                {
+                    if (sym < 0 || m_out == m_outEnd)
+                        return false;
+                    *m_out++ = uint8_t(sym);
+                    continue;
+                }
+
+                if (sym == 256)
+                    return true;
+
+                sym -= 257;
+                if (sym >= 29)
+                    return false;
+                size_t len = kLengthBase[sym] + Bits(kLengthExtra[sym]);
+
+                int d = Decode(dist);
+                if (d < 0 || d >= 30)
+                    return false;
+                size_t distance = kDistBase[d] + Bits(kDistExtra[d]);
+
+                if (distance > size_t(m_out - m_begin) || len > size_t(m_outEnd - m_out))
+                    return false;
+
+                Copy(m_out, distance, len);
+                m_out += len;
+            }
+        }
+
+        // Copia solapada de una referencia. El buffer de salida tiene
+        // holgura para escribir 8 bytes de mas.
+        void Copy(uint8_t* out, size_t distance, size_t len)
+        {
+            const uint8_t* src = out - distance;
+
+            if (distance == 1)
+            {
+                memset(out, *src, len);
+            }
+            else if (distance >= 8)
+            {
+                for (size_t i = 0; i < len; i += 8)
+                {
+                    uint64_t v;
+                    memcpy(&v, src + i, 8);
+                    memcpy(out + i, &v, 8);
+                }
+            }
+            else
+            {
+                for (size_t i = 0; i < len; ++i)
+                    out[i] = src[i];
+            }
+        }
+
+        const uint8_t* m_in;
+        size_t m_inSize;
+        size_t m_pos = 0;
+        uint64_t m_buffer = 0;
+        uint32_t m_bits = 0;
+
+        uint8_t* m_out;
+        uint8_t* m_outEnd;
+        uint8_t* m_begin;
+
+        HuffmanTable m_lit;
+        HuffmanTable m_dist;
+    };
+
+    // Bytes que escribe Copy() despues del final como mucho
+    const size_t kInflateSlack = 8;
+
+    // ---------------------------------------------------------
+    // Filtros
+    // ---------------------------------------------------------
+    inline uint8_t Paeth(int a, int b, int c)
+    {
+        int p = a + b - c;
+        int pa = abs(p - a);
+        int pb = abs(p - b);
+        int pc = abs(p - c);
+        if (pa <= pb && pa <= pc)
+            return uint8_t(a);
+        return uint8_t((pb <= pc) ? b : c);
+    }
+
+    void SubScalar(uint8_t* row, size_t bytes, size_t bpp)
+    {
+        for (size_t i = bpp; i < bytes; ++i)
+            row[i] = uint8_t(row[i] + row[i - bpp]);
+    }
+
+    void UpScalar(uint8_t* row, const uint8_t* prev, size_t bytes)
+    {
+        for (size_t i = 0; i < bytes; ++i)
+            row[i] = uint8_t(row[i] + prev[i]);
+    }
+
+    void AvgScalar(uint8_t* row, const uint8_t* prev, size_t bytes, size_t bpp)
+    {
+        for (size_t i = 0; i < bpp && i < bytes; ++i)
+            row[i] = uint8_t(row[i] + (prev[i] >> 1));
+        for (size_t i = bpp; i < bytes; ++i)
+            row[i] = uint8_t(row[i] + ((row[i - bpp] + prev[i]) >> 1));
+    }
+
+    void PaethScalar(uint8_t* row, const uint8_t* prev, size_t bytes, size_t bpp)
+    {
+        for (size_t i = 0; i < bpp && i < bytes; ++i)
+            row[i] = uint8_t(row[i] + prev[i]);
+        for (size_t i = bpp; i < bytes; ++i)
+            row[i] = uint8_t(row[i] + Paeth(row[i - bpp], prev[i], prev[i - bpp]));
+    }
+
+    // SSE2, un pixel de 3 o 4 bytes por iteracion (como libpng).
+    // Load lee 4 bytes tambien con bpp 3; Store solo escribe bpp.
+    template<size_t Bpp>
+    inline __m128i LoadPixel(const uint8_t* p)
+    {
+        int32_t v;
+        memcpy(&v, p, 4);
+        return _mm_cvtsi32_si128(v);
+    }
+
+    template<size_t Bpp>
+    inline void StorePixel(uint8_t* p, __m128i v)
+    {
+        int32_t x = _mm_cvtsi128_si32(v);
+        memcpy(p, &x, Bpp);
+    }
+
+    void UpSSE2(uint8_t* row, const uint8_t* prev, size_t bytes)
+    {
+        size_t i = 0;
+        for (; i + 16 <= bytes; i += 16)
+        {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(row + i), _mm_add_epi8(a, b));
+        }
+        for (; i < bytes; ++i)
+            row[i] = uint8_t(row[i] + prev[i]);
+    }
+
+    // Suma prefija de 4 pixeles por iteracion
+    void Sub4SSE2(uint8_t* row, size_t bytes)
+    {
+        __m128i last = _mm_setzero_si128();
+        size_t i = 0;
+        for (; i + 16 <= bytes; i += 16)
+        {
+            __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+            d = _mm_add_epi8(d, _mm_slli_si128(d, 4));
+            d = _mm_add_epi8(d, _mm_slli_si128(d, 8));
+            d = _mm_add_epi8(d, last);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(row + i), d);
+            last = _mm_shuffle_epi32(d, 0xFF);
+        }
+        for (; i + 4 <= bytes; i += 4)
+        {
+            last = _mm_add_epi8(LoadPixel<4>(row + i), last);
+            StorePixel<4>(row + i, last);
+        }
+    }
+
+    void Sub3SSE2(uint8_t* row, size_t bytes)
+    {
+        __m128i d = _mm_setzero_si128();
+        for (size_t i = 0; i + 3 <= bytes; i += 3)
+        {
+            d = _mm_add_epi8(LoadPixel<3>(row + i), d);
+            StorePixel<3>(row + i, d);
+        }
+    }
+
+    template<size_t Bpp>
+    void AvgSSE2(uint8_t* row, const uint8_t* prev, size_t bytes)
+    {
+        const __m128i one = _mm_set1_epi8(1);
+        __m128i d = _mm_setzero_si128();
+        for (size_t i = 0; i + Bpp <= bytes; i += Bpp)
+        {
+            __m128i a = d;
+            __m128i b = LoadPixel<Bpp>(prev + i);
+            d = LoadPixel<Bpp>(row + i);
+
+            // (a + b) >> 1 sin desbordar: avg redondea hacia arriba
+            __m128i avg = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one));
+            d = _mm_add_epi8(d, avg);
+            StorePixel<Bpp>(row + i, d);
+        }
+    }
+
+    inline __m128i Abs16(__m128i v)
+    {
+        return _mm_max_epi16(v, _mm_sub_epi16(_mm_setzero_si128(), v));
+    }
+
+    inline __m128i Select(__m128i mask, __m128i a, __m128i b)
+    {
+        return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+    }
+
+    template<size_t Bpp>
+    void PaethSSE2(uint8_t* row, const uint8_t* prev, size_t bytes)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        __m128i b = zero;
+        __m128i d = zero;
+        for (size_t i = 0; i + Bpp <= bytes; i += Bpp)
+        {
+            __m128i c = b;
+            __m128i a = d;
+            b = _mm_unpacklo_epi8(LoadPixel<Bpp>(prev + i), zero);
+            d = _mm_unpacklo_epi8(LoadPixel<Bpp>(row + i), zero);
+
+            // p - a = b - c, p - b = a - c, p - c = (b - c) + (a - c)
+            __m128i pa = _mm_sub_epi16(b, c);
+            __m128i pb = _mm_sub_epi16(a, c);
+            __m128i pc = _mm_add_epi16(pa, pb);
+            pa = Abs16(pa);
+            pb = Abs16(pb);
+            pc = Abs16(pc);
+
+            // Empates: a, luego b, luego c
+            __m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+            __m128i nearest = Select(_mm_cmpeq_epi16(smallest, pa), a,
+                Select(_mm_cmpeq_epi16(smallest, pb), b, c));
+
+            // epi8 para que sume modulo 256 sin tocar el byte alto
+            d = _mm_add_epi8(d, nearest);
+            StorePixel<Bpp>(row + i, _mm_packus_epi16(d, d));
+        }
+    }
+
+    void SubSSE2(uint8_t* row, size_t bytes, size_t bpp)
+    {
+        switch (bpp)
+        {
+        case 4: Sub4SSE2(row, bytes); break;
+        case 3: Sub3SSE2(row, bytes); break;
+        default: SubScalar(row, bytes, bpp); break;
+        }
+    }
+
+    void AvgDispatchSSE2(uint8_t* row, const uint8_t* prev, size_t bytes, size_t bpp)
+    {
+        switch (bpp)
+        {
+        case 4: AvgSSE2<4>(row, prev, bytes); break;
+        case 3: AvgSSE2<3>(row, prev, bytes); break;
+        default: AvgScalar(row, prev, bytes, bpp); break;
+        }
+    }
+
+    void PaethDispatchSSE2(uint8_t* row, const uint8_t* prev, size_t bytes, size_t bpp)
+    {
+        switch (bpp)
+        {
+        case 4: PaethSSE2<4>(row, prev, bytes); break;
+        case 3: PaethSSE2<3>(row, prev, bytes); break;
+        default: PaethScalar(row, prev, bytes, bpp); break;
+        }
+    }
+
+    const PngUnfilterKernels kScalarKernels = { KernelLevel::Scalar, SubScalar, UpScalar, AvgScalar, PaethScalar };
+    const PngUnfilterKernels kSSE2Kernels = { KernelLevel::SSE2, SubSSE2, UpSSE2, AvgDispatchSSE2, PaethDispatchSSE2 };
+
+    // ---------------------------------------------------------
+    // Cabecera y chunks
+    // ---------------------------------------------------------
+    struct PngInfo
+    {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint8_t depth = 0;
+        uint8_t colorType = 0;
+        bool interlaced = false;
+
+        uint32_t channels = 0;
+        bool sRGB = false;
+
+        uint8_t palette[256][4] = {};       // RGBA (alfa de tRNS)
+        uint32_t paletteSize = 0;
+
+        bool hasKey = false;                // tRNS de gris o RGB
+        uint16_t key[3] = {};
+
+        std::vector<const uint8_t*> idat;
+        std::vector<size_t> idatSize;
+    };
+
+    bool ValidHeader(const PngInfo& info)
+    {
+        switch (info.colorType)
+        {
+        case 0: return info.depth == 1 || info.depth == 2 || info.depth == 4 || info.depth == 8 || info.depth == 16;
+        case 3: return info.depth == 1 || info.depth == 2 || info.depth == 4 || info.depth == 8;
+        case 2:
+        case 4:
+        case 6: return info.depth == 8 || info.depth == 16;
+        default: return false;
+        }
+    }
+
+    HRESULT ParseChunks(const uint8_t* data, size_t size, bool ignoreSRGB, PngInfo& info)
+    {
+        if (!IsPNGSignature(data, size))
+            return HRESULT_E_NOT_SUPPORTED;
+
+        bool haveHeader = false;
+        bool haveEnd = false;
+        bool gamma22 = false;
+        size_t pos = 8;
+
+        while (!haveEnd)
+        {
+            if (size - pos < 12)
+                return kInvalidData;
+
+            uint32_t length = ReadBE32(data + pos);
+            uint32_t type = ReadBE32(data + pos + 4);
+            if (length > size - pos - 12)
+                return kInvalidData;
+
+            const uint8_t* chunk = data + pos + 8;
+            pos += size_t(length) + 12;
+
+            if (!haveHeader && type != ChunkType("IHDR"))
+                return kInvalidData;
+
+            if (type == ChunkType("IHDR"))
+            {
+                if (haveHeader || length != 13)
+                    return kInvalidData;
+
+                info.width = ReadBE32(chunk);
+                info.height = ReadBE32(chunk + 4);
+                info.depth = chunk[8];
+                info.colorType = chunk[9];
+                if (chunk[10] != 0 || chunk[11] != 0 || chunk[12] > 1)
+                    return HRESULT_E_NOT_SUPPORTED;
+                info.interlaced = (chunk[12] == 1);
+
+                if (!ValidHeader(info))
+                    return HRESULT_E_NOT_SUPPORTED;
+                if (!info.width || !info.height)
+                    return kInvalidData;
+                if (uint64_t(info.width) * info.height > kMaxPixels)
+                    return kOverflow;
+
+                static const uint32_t kChannels[7] = { 1, 0, 3, 1, 2, 0, 4 };
+                info.channels = kChannels[info.colorType];
+                haveHeader = true;
+            }
+            else if (type == ChunkType("PLTE"))
+            {
+                if (length % 3 || length > 768 || !length)
+                    return kInvalidData;
+
+                info.paletteSize = length / 3;
+                for (uint32_t i = 0; i < info.paletteSize; ++i)
+                {
+                    info.palette[i][0] = chunk[i * 3];
+                    info.palette[i][1] = chunk[i * 3 + 1];
+                    info.palette[i][2] = chunk[i * 3 + 2];
+                    info.palette[i][3] = 255;
+                }
+            }
+            else if (type == ChunkType("tRNS"))
+            {
+                if (info.colorType == 3)
+                {
+                    if (length > info.paletteSize)
+                        return kInvalidData;
+                    for (uint32_t i = 0; i < length; ++i)
+                        info.palette[i][3] = chunk[i];
+                }
+                else if (info.colorType == 0 && length == 2)
+                {
+                    info.hasKey = true;
+                    info.key[0] = uint16_t((chunk[0] << 8) | chunk[1]);
+                }
+                else if (info.colorType == 2 && length == 6)
+                {
+                    info.hasKey = true;
+                    for (int c = 0; c < 3; ++c)
+                        info.key[c] = uint16_t((chunk[c * 2] << 8) | chunk[c * 2 + 1]);
+                }
+            }
+            else if (type == ChunkType("IDAT"))
+            {
+                info.idat.push_back(chunk);
+                info.idatSize.push_back(length);
+            }
+            else if (type == ChunkType("sRGB"))
+            {
+                info.sRGB = true;
+            }
+            else if (type == ChunkType("gAMA"))
+            {
+                gamma22 = (length == 4 && ReadBE32(chunk) == 45455);
+            }
+            else if (type == ChunkType("IEND"))
+            {
+                haveEnd = true;
+            }
+            else if (!(chunk[-4] & 0x20))
+            {
+                // Chunk critico que no conocemos
+                return HRESULT_E_NOT_SUPPORTED;
+            }
+        }
+
+        if (info.idat.empty() || (info.colorType == 3 && !info.paletteSize))
+            return kInvalidData;
+
+        info.sRGB = !ignoreSRGB && (info.sRGB || gamma22);
+        return S_OK;
+    }
+
+    // ---------------------------------------------------------
+    // Pasadas (Adam7) y conversion a RGBA8
+    // ---------------------------------------------------------
+    struct Pass
+    {
+        uint32_t x0, y0, dx, dy;
+    };
+
+    const Pass kSinglePass[1] = { { 0, 0, 1, 1 } };
+    const Pass kAdam7[7] = {
+        { 0, 0, 8, 8 }, { 4, 0, 8, 8 }, { 0, 4, 4, 8 }, { 2, 0, 4, 4 },
+        { 0, 2, 2, 4 }, { 1, 0, 2, 2 }, { 0, 1, 1, 2 } };
+
+    inline size_t PassSize(uint32_t full, uint32_t start, uint32_t step)
+    {
+        return (full > start) ? (size_t(full - start) + step - 1) / step : 0;
+    }
+
+    inline size_t RowBytes(const PngInfo& info, size_t width)
+    {
+        return (width * info.channels * info.depth + 7) / 8;
+    }
+
+    // Muestra 'i' de una fila de 1, 2 o 4 bits
+    inline uint32_t PackedSample(const uint8_t* row, size_t i, uint32_t depth)
+    {
+        size_t bit = i * depth;
+        return (row[bit >> 3] >> (8 - depth - (bit & 7))) & ((1u << depth) - 1);
+    }
+
+    // RGBA8 <-> BGRA8 (cambia los bytes 0 y 2)
+    void SwapRedBlue(const uint8_t* src, uint8_t* dst, size_t width)
+    {
+        const __m128i ga = _mm_set1_epi32(int(0xFF00FF00));
+        const __m128i low = _mm_set1_epi32(0xFF);
+
+        size_t x = 0;
+        for (; x + 4 <= width; x += 4)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * 4));
+            __m128i r = _mm_slli_epi32(_mm_and_si128(v, low), 16);
+            __m128i b = _mm_and_si128(_mm_srli_epi32(v, 16), low);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4),
+                _mm_or_si128(_mm_and_si128(v, ga), _mm_or_si128(r, b)));
+        }
+        for (; x < width; ++x)
+        {
+            dst[x * 4] = src[x * 4 + 2];
+            dst[x * 4 + 1] = src[x * 4 + 1];
+            dst[x * 4 + 2] = src[x * 4];
+            dst[x * 4 + 3] = src[x * 4 + 3];
+        }
+    }
+
+    // Fila sin filtro -> pixeles de 4 bytes en el orden de 'bgra'
+    void ExpandRow(const PngInfo& info, bool bgra, const uint8_t* src, uint8_t* dst, size_t width)
+    {
+        const uint32_t depth = info.depth;
+        const int r = bgra ? 2 : 0;
+        const int b = bgra ? 0 : 2;
+
+        // 16 bits -> 8 bits redondeando
+        auto sample16 = [&](size_t i) -> uint32_t { return (uint32_t(src[i * 2]) << 8) | src[i * 2 + 1]; };
+        auto to8 = [](uint32_t v) -> uint8_t { return uint8_t((v * 255 + 32767) / 65535); };
+
+        switch (info.colorType)
+        {
+        case 6:
+            if (depth == 8)
+            {
+                if (bgra)
+                    SwapRedBlue(src, dst, width);
+                else
+                    memcpy(dst, src, width * 4);
+                return;
+            }
+            for (size_t x = 0; x < width; ++x, dst += 4)
+            {
+                dst[r] = to8(sample16(x * 4));
+                dst[1] = to8(sample16(x * 4 + 1));
+                dst[b] = to8(sample16(x * 4 + 2));
+                dst[3] = to8(sample16(x * 4 + 3));
+            }
+            return;
+
+        case 4:
+            for (size_t x = 0; x < width; ++x, dst += 4)
+            {
+                uint8_t g = (depth == 8) ? src[x * 2] : to8(sample16(x * 2));
+                uint8_t a = (depth == 8) ? src[x * 2 + 1] : to8(sample16(x * 2 + 1));
+                dst[0] = dst[1] = dst[2] = g;
+                dst[3] = a;
+            }
+            return;
+
+        case 2:
+            for (size_t x = 0; x < width; ++x, dst += 4)
+            {
+                uint32_t s[3];
+                for (int c = 0; c < 3; ++c)
+                    s[c] = (depth == 8) ? src[x * 3 + c] : sample16(x * 3 + c);
+
+                bool transparent = info.hasKey && s[0] == info.key[0] && s[1] == info.key[1] && s[2] == info.key[2];
+                dst[r] = (depth == 8) ? uint8_t(s[0]) : to8(s[0]);
+                dst[1] = (depth == 8) ? uint8_t(s[1]) : to8(s[1]);
+                dst[b] = (depth == 8) ? uint8_t(s[2]) : to8(s[2]);
+                dst[3] = transparent ? 0 : 255;
+            }
+            return;
+
+        case 3:
+            for (size_t x = 0; x < width; ++x, dst += 4)
+            {
+                uint32_t index = (depth == 8) ? src[x] : PackedSample(src, x, depth);
+                if (index >= info.paletteSize)
+                    index = 0;      // fuera de la paleta: como libpng, negro/primer color
+
+                const uint8_t* p = info.palette[index];
+                dst[r] = p[0];
+                dst[1] = p[1];
+                dst[b] = p[2];
+                dst[3] = p[3];
+            }
+            return;
+
+        default:
+            {
+                // Gris: se escala al rango completo (1 bit -> 0/255, ...)
+                const uint32_t scale = (depth < 8) ? 255 / ((1u << depth) - 1) : 1;
+                for (size_t x = 0; x < width; ++x, dst += 4)
+                {
+                    uint32_t s;
+                    uint8_t g;
+                    if (depth == 16)
+                    {
+                        s = sample16(x);
+                        g = to8(s);
+                    }
+                    else
+                    {
+                        s = (depth == 8) ? src[x] : PackedSample(src, x, depth);
+                        g = uint8_t(s * scale);
+                    }
+
+                    dst[0] = dst[1] = dst[2] = g;
+                    dst[3] = (info.hasKey && s == info.key[0]) ? 0 : 255;
+                }
+            }
+            return;
+        }
+    }
+
+    HRESULT DecodeImage(const PngInfo& info, const PngUnfilterKernels& k, ScratchImage& image, DXGI_FORMAT format)
+    {
+        const bool bgra = (format == DXGI_FORMAT_B8G8R8A8_UNORM || format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB);
+        const Pass* passes = info.interlaced ? kAdam7 : kSinglePass;
+        const int passCount = info.interlaced ? 7 : 1;
+
+        // Tamano exacto de los datos filtrados
+        size_t filteredSize = 0;
+        size_t maxRow = 0;
+        for (int p = 0; p < passCount; ++p)
+        {
+            size_t pw = PassSize(info.width, passes[p].x0, passes[p].dx);
+            size_t ph = PassSize(info.height, passes[p].y0, passes[p].dy);
+            if (!pw || !ph)
+                continue;
+
+            size_t rowBytes = RowBytes(info, pw);
+            filteredSize += ph * (rowBytes + 1);
+            maxRow = std::max(maxRow, rowBytes);
+        }
+
+        // Varios IDAT se juntan en un solo stream
+        std::vector<uint8_t> joined;
+        const uint8_t* zdata = info.idat[0];
+        size_t zsize = info.idatSize[0];
+        if (info.idat.size() > 1)
+        {
+            size_t total = 0;
+            for (size_t s : info.idatSize)
+                total += s;
+
+            joined.resize(total);
+            size_t offset = 0;
+            for (size_t i = 0; i < info.idat.size(); ++i)
+            {
+                memcpy(joined.data() + offset, info.idat[i], info.idatSize[i]);
+                offset += info.idatSize[i];
+            }
+            zdata = joined.data();
+            zsize = total;
+        }
+
+        // Holgura para Copy() y para las lecturas de 4 bytes de los filtros
+        std::vector<uint8_t> filtered(filteredSize + kInflateSlack);
+        {
+            Inflater inflater(zdata, zsize, filtered.data(), filteredSize);
+            HRESULT hr = inflater.Run();
+            if (FAILED(hr))
+                return hr;
+        }
+
+        HRESULT hr = image.Initialize2D(format, info.width, info.height, 1, 1);
+        if (FAILED(hr))
+            return hr;
+
+        const Image* dst = image.GetImage(0, 0, 0);
+        const size_t bpp = std::max<size_t>(1, info.channels * info.depth / 8);
+
+        std::vector<uint8_t> zeroRow(maxRow + 4, 0);
+        std::vector<uint8_t> passRow(info.interlaced ? size_t(info.width) * 4 : 0);
+
+        uint8_t* rowData = filtered.data();
+        for (int p = 0; p < passCount; ++p)
+        {
+            const Pass& pass = passes[p];
+            size_t pw = PassSize(info.width, pass.x0, pass.dx);
+            size_t ph = PassSize(info.height, pass.y0, pass.dy);
+            if (!pw || !ph)
+                continue;
+
+            const size_t rowBytes = RowBytes(info, pw);
+            const uint8_t* prev = zeroRow.data();
+
+            for (size_t y = 0; y < ph; ++y)
+            {
+                uint8_t filter = rowData[0];
+                uint8_t* row = rowData + 1;
+
+                switch (filter)
+                {
+                case 0: break;
+                case 1: k.sub(row, rowBytes, bpp); break;
+                case 2: k.up(row, prev, rowBytes); break;
+                case 3: k.avg(row, prev, rowBytes, bpp); break;
+                case 4: k.paeth(row, prev, rowBytes, bpp); break;
+                default: return kInvalidData;
+                }
+
+                size_t outY = pass.y0 + y * pass.dy;
+                uint8_t* outRow = dst->pixels + outY * dst->rowPitch;
+
+                if (!info.interlaced)
+                {
+                    ExpandRow(info, bgra, row, outRow, pw);
+                }
+                else
+                {
+                    ExpandRow(info, bgra, row, passRow.data(), pw);
+                    for (size_t x = 0; x < pw; ++x)
+                        memcpy(outRow + (pass.x0 + x * pass.dx) * 4, passRow.data() + x * 4, 4);
+                }
+
+                prev = row;
+                rowData += rowBytes + 1;
+            }
+        }
+
+        return S_OK;
+    }
+}
+
+bool IsPNGSignature(const uint8_t* data, size_t size)
+{
+    return data && size >= sizeof(kSignature) && memcmp(data, kSignature, sizeof(kSignature)) == 0;
+}
+
+const PngUnfilterKernels* GetPngUnfilterKernels(KernelLevel level)
+{
+    if (level > DetectKernelLevel())
+        return nullptr;
+
+    return (level == KernelLevel::Scalar) ? &kScalarKernels : &kSSE2Kernels;
+}
+
+const PngUnfilterKernels& GetPngUnfilterKernels()
+{
+    return *GetPngUnfilterKernels(DetectKernelLevel());
+}
+
+HRESULT LoadPNGFromMemory(const uint8_t* data, size_t size, bool ignoreSRGB,
+    TexMetadata* metadata, ScratchImage& image)
+{
+    image.Release();
+
+    PngInfo info;
+    HRESULT hr = ParseChunks(data, size, ignoreSRGB, info);
+    if (FAILED(hr))
+        return hr;
+
+    // Mismo formato que LoadFromWICFile con 8 bits y alfa
+    bool wicBGRA = (info.colorType == 6 || info.colorType == 4) && info.depth == 8;
+    DXGI_FORMAT format = wicBGRA ? DXGI_FORMAT_B8G8R8A8_UNORM : DXGI_FORMAT_R8G8B8A8_UNORM;
+    if (info.sRGB)
+        format = MakeSRGB(format);
+
+    hr = DecodeImage(info, GetPngUnfilterKernels(), image, format);
+    if (FAILED(hr))
+    {
+        image.Release();
+        return hr;
+    }
+
+    if (metadata)
+        *metadata = image.GetMetadata();
+
+    return S_OK;
+}
+
+HRESULT LoadPNGFile(const wchar_t* path, bool ignoreSRGB, TexMetadata* metadata, ScratchImage& image)
+{
+    if (!path)
+        return E_INVALIDARG;
+
+    FILE* f = nullptr;
+#ifdef _WIN32
+    if (_wfopen_s(&f, path, L"rb") != 0)
+        f = nullptr;
+#else
+    std::vector<char> narrow(wcslen(path) * 4 + 1);
+    if (wcstombs(narrow.data(), path, narrow.size()) != size_t(-1))
+        f = fopen(narrow.data(), "rb");
+#endif
+    if (!f)
+        return E_FAIL;
+
+    std::vector<uint8_t> data;
+    uint8_t chunk[65536];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0)
+        data.insert(data.end(), chunk, chunk + n);
+
+    bool readError = ferror(f) != 0;
+    fclose(f);
+    if (readError)
+        return E_FAIL;
+
+    return LoadPNGFromMemory(data.data(), data.size(), ignoreSRGB, metadata, image);
+}
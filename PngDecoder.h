@@ -0,0 +1,75 @@
+#pragma once
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include "DirectXTex.h"
+#include "ImageKernels.h"
+#include <cstddef>
+#include <cstdint>
+
+// -------------------------------------------------------------
+// Decodificador PNG propio, sin WIC/COM (para compilar fuera de
+// Windows). Inflate con tablas rapidas de Huffman y los cuatro
+// filtros de PNG en SSE2 para 3 y 4 bytes por pixel.
+//
+// Deja la imagen en el mismo formato que LoadFromWICFile para los PNG
+// de 8 bits con alfa (RGBA y gris+alfa -> B8G8R8A8_UNORM), asi el
+// analisis, la cache y el DDS salen iguales con los dos decodificadores.
+// El resto (RGB, paleta, gris, 16 bits) sale en R8G8B8A8_UNORM, que es
+// lo que usa el analisis; WIC daria R8/R16/R16G16B16A16 y se
+// convertiria despues.
+//
+// No comprueba CRC ni Adler-32. Lo que no soporta (otro tipo de PNG,
+// chunks criticos desconocidos) devuelve HRESULT_E_NOT_SUPPORTED.
+// -------------------------------------------------------------
+enum PngDecoderBackend
+{
+    PNG_DECODER_WIC = 0,
+    PNG_DECODER_BUILTIN = 1,
+};
+
+#ifndef HRESULT_E_NOT_SUPPORTED
+#define HRESULT_E_NOT_SUPPORTED static_cast<HRESULT>(0x80070032L)
+#endif
+
+// ignoreSRGB: como WIC_FLAGS_IGNORE_SRGB (si no, chunk sRGB o gAMA de
+// 1/2.2 dan el formato _SRGB)
+HRESULT LoadPNGFromMemory(const uint8_t* data, size_t size, bool ignoreSRGB,
+    DirectX::TexMetadata* metadata, DirectX::ScratchImage& image);
+
+HRESULT LoadPNGFile(const wchar_t* path, bool ignoreSRGB,
+    DirectX::TexMetadata* metadata, DirectX::ScratchImage& image);
+
+// true si empieza por la firma de PNG
+bool IsPNGSignature(const uint8_t* data, size_t size);
+
+// Filtros de una fila ya inflada (sin el byte de tipo), in situ.
+// bpp: bytes por pixel (1 como minimo); prev es la fila anterior ya
+// reconstruida (ceros en la primera). Pueden leer hasta 3 bytes
+// despues de la fila, pero no escriben fuera.
+struct PngUnfilterKernels
+{
+    KernelLevel level;
+
+    void (*sub)(uint8_t* row, size_t bytes, size_t bpp);
+    void (*up)(uint8_t* row, const uint8_t* prev, size_t bytes);
+    void (*avg)(uint8_t* row, const uint8_t* prev, size_t bytes, size_t bpp);
+    void (*paeth)(uint8_t* row, const uint8_t* prev, size_t bytes, size_t bpp);
+};
+
+// nullptr si la CPU no soporta el nivel. AVX2 usa los de SSE2: cada
+// pixel depende del anterior y no hay mas que ganar con 32 bytes.
+const PngUnfilterKernels* GetPngUnfilterKernels(KernelLevel level);
+const PngUnfilterKernels& GetPngUnfilterKernels();
+
+#ifdef _WIN32
+// Decodificador que usan ConvertPNGtoDDSW, ConvertToDDS y el resto de
+// conversiones (PngDecoderBackend). Devuelve el anterior.
+extern "C" int __stdcall SetPNGDecoderW(int backend);
+
+// Carga con el decodificador elegido; lo que el propio no soporta lo
+// lee WIC. Todas las entradas de la DLL cargan por aqui.
+HRESULT LoadSourceImage(const wchar_t* src, DirectX::WIC_FLAGS flags,
+    DirectX::TexMetadata& meta, DirectX::ScratchImage& img);
+#endif
@@ -0,0 +1,551 @@
+#include "RuleEngine.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cstring>
+#include <cwchar>
+#include <cwctype>
+#include <mutex>
+
+using namespace DirectX;
+
+namespace
+{
+    enum RuleValue
+    {
+        VALUE_PATH,
+        VALUE_PATH_CASE,
+        VALUE_W,
+        VALUE_H,
+        VALUE_PW,
+        VALUE_PH,
+        VALUE_PADDED_ASPECT,
+        VALUE_HAS_ALPHA,
+        VALUE_SOFT_ALPHA,
+        VALUE_ALPHA_SOFT_RATIO,
+        VALUE_SAT_MID_RATIO,
+        VALUE_ALPHA_GRAD_AVG,
+        VALUE_LUMA_DIFF_AVG,
+        VALUE_COLOR_STDDEV,
+        VALUE_LAPLACIAN,
+        VALUE_LONG_BAND_RATIO
+    };
+
+    enum RuleOp
+    {
+        OP_LT,
+        OP_LE,
+        OP_GT,
+        OP_GE,
+        OP_EQ,
+        OP_NE
+    };
+
+    struct NamedValue
+    {
+        const wchar_t* name;
+        RuleValue value;
+        int cost;               // 0 = gratis, 1 = barrido con salida temprana, 2 = ImageFeatures
+    };
+
+    const NamedValue kValues[] =
+    {
+        { L"w",              VALUE_W,                0 },
+        { L"h",              VALUE_H,                0 },
+        { L"pw",             VALUE_PW,               0 },
+        { L"ph",             VALUE_PH,               0 },
+        { L"paddedAspect",   VALUE_PADDED_ASPECT,    0 },
+        { L"hasAlpha",       VALUE_HAS_ALPHA,        1 },
+        { L"softAlpha",      VALUE_SOFT_ALPHA,       2 },
+        { L"alphaSoftRatio", VALUE_ALPHA_SOFT_RATIO, 2 },
+        { L"satMidRatio",    VALUE_SAT_MID_RATIO,    2 },
+        { L"alphaGradAvg",   VALUE_ALPHA_GRAD_AVG,   2 },
+        { L"lumaDiffAvg",    VALUE_LUMA_DIFF_AVG,    2 },
+        { L"colorStdDev",    VALUE_COLOR_STDDEV,     2 },
+        { L"laplacian",      VALUE_LAPLACIAN,        2 },
+        { L"longBandRatio",  VALUE_LONG_BAND_RATIO,  2 },
+    };
+
+    struct NamedRule
+    {
+        const wchar_t* name;
+        RuleId id;
+    };
+
+    // RULE_FALLBACK_* y RULE_COST_MODEL_BC7 no se eligen por tabla:
+    // salen de la regla final
+    const NamedRule kRules[] =
+    {
+        { L"SMALL_ALPHA_ICON",           RULE_SMALL_ALPHA_ICON },
+        { L"GLOWFX_UNCOMPRESSED",        RULE_GLOWFX_UNCOMPRESSED },
+        { L"DARK_GRADIENT_UNCOMPRESSED", RULE_DARK_GRADIENT_UNCOMPRESSED },
+        { L"ANIMATION_BC7",              RULE_ANIMATION_BC7 },
+        { L"JACKPOT_UNCOMPRESSED",       RULE_JACKPOT_UNCOMPRESSED },
+        { L"PROGRESSCOUNTERS_UNCOMP",    RULE_PROGRESSCOUNTERS_UNCOMP },
+        { L"BIG_750_BC7",                RULE_BIG_750_BC7 },
+        { L"SMALL_SOLID_SYMBOL_BC3",     RULE_SMALL_SOLID_SYMBOL_BC3 },
+        { L"LONG_STRIP_BC7",             RULE_LONG_STRIP_BC7 },
+        { L"LONG_STRIP_SHEET_UNCOMP",    RULE_LONG_STRIP_SHEET_UNCOMP },
+        { L"LONG_STRIP_SHEET_BC3",       RULE_LONG_STRIP_SHEET_BC3 },
+        { L"FONTS_BC7",                  RULE_FONTS_BC7 },
+        { L"DEFAULT_BC7_HIGH_QUALITY",   RULE_DEFAULT_BC7_HIGH_QUALITY },
+        { L"BIG_IMAGE_BC3",              RULE_BIG_IMAGE_BC3 },
+    };
+
+    // La cadena de siempre, en el mismo orden
+    const wchar_t kDefaultRules[] =
+        L"# Gana la primera regla que se cumple\n"
+        L"SMALL_ALPHA_ICON            w<450 h<450 hasAlpha\n"
+        L"GLOWFX_UNCOMPRESSED         w>=700 h>=200 alphaSoftRatio>=0.08 satMidRatio>=0.08 alphaGradAvg<=3.0\n"
+        L"DARK_GRADIENT_UNCOMPRESSED  w>=400|h>=400 lumaDiffAvg<4.5\n"
+        L"ANIMATION_BC7               path~animation\n"
+        L"JACKPOT_UNCOMPRESSED        path~jackpot\n"
+        L"PROGRESSCOUNTERS_UNCOMP     pathcase~\\ProgressCounters\\\n"
+        L"BIG_750_BC7                 w>750 h>750\n"
+        L"SMALL_SOLID_SYMBOL_BC3      h<=100 !softAlpha colorStdDev<18\n"
+        L"# Desde aqui la imagen se rellena a multiplo de 4\n"
+        L"FONTS_BC7                   path~fonts\n"
+        L"LONG_STRIP_BC7              paddedAspect>=3.5\n"
+        L"LONG_STRIP_SHEET_UNCOMP     longBandRatio>=0.6 softAlpha|colorStdDev>25\n"
+        L"LONG_STRIP_SHEET_BC3        longBandRatio>=0.6\n"
+        L"BIG_IMAGE_BC3               pw>600|ph>600\n"
+        L"DEFAULT_BC7_HIGH_QUALITY\n";
+
+    std::mutex g_tableLock;
+    std::shared_ptr<const RuleTable> g_table;
+
+    inline uint32_t HashBytes(uint32_t h, const void* data, size_t size)
+    {
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; ++i)
+            h = (h ^ p[i]) * 16777619u;
+        return h;
+    }
+
+    template <typename T>
+    bool Compare(int op, T v, T number)
+    {
+        switch (op)
+        {
+        case OP_LT: return v < number;
+        case OP_LE: return v <= number;
+        case OP_GT: return v > number;
+        case OP_GE: return v >= number;
+        case OP_EQ: return v == number;
+        case OP_NE: return v != number;
+        default:    return false;
+        }
+    }
+
+    std::wstring ToLower(std::wstring s)
+    {
+        for (auto& c : s)
+            c = towlower(c);
+        return s;
+    }
+
+    std::wstring NormalizePath(const wchar_t* src)
+    {
+        std::wstring path(src ? src : L"");
+        for (auto& c : path)
+        {
+            if (c == L'/') c = L'\\';
+        }
+        return path;
+    }
+
+    const NamedValue* FindValue(const std::wstring& name)
+    {
+        for (const auto& v : kValues)
+        {
+            if (name == v.name)
+                return &v;
+        }
+        return nullptr;
+    }
+
+    bool FindRule(std::wstring name, RuleId& id)
+    {
+        if (name.compare(0, 5, L"RULE_") == 0)
+            name = name.substr(5);
+
+        for (const auto& r : kRules)
+        {
+            if (name == r.name)
+            {
+                id = r.id;
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+// -------------------------------------------------------------
+// RuleInputs
+// -------------------------------------------------------------
+
+RuleInputs::RuleInputs(const Image* img, const wchar_t* src)
+    : m_img(img)
+    , m_width(img ? img->width : 0)
+    , m_height(img ? img->height : 0)
+    , m_path(NormalizePath(src))
+{
+    m_lower = ToLower(m_path);
+}
+
+RuleInputs::RuleInputs(const ImageFeatures& features, const wchar_t* src)
+    : m_width(features.width)
+    , m_height(features.height)
+    , m_path(NormalizePath(src))
+    , m_features(features)
+    , m_hasFeatures(true)
+{
+    m_lower = ToLower(m_path);
+}
+
+bool RuleInputs::HasAlpha()
+{
+    if (m_hasFeatures)
+        return m_features.hasAlpha;
+
+    if (m_hasAlpha < 0)
+    {
+        // Basta con el primer pixel con a < 255
+        TraceSpan span("AlphaScan");
+        m_hasAlpha = 0;
+        for (size_t y = 0; y < m_height && !m_hasAlpha; ++y)
+        {
+            const uint8_t* p = m_img->pixels + y * m_img->rowPitch + 3;
+            for (size_t x = 0; x < m_width; ++x, p += 4)
+            {
+                if (*p < 255)
+                {
+                    m_hasAlpha = 1;
+                    break;
+                }
+            }
+        }
+    }
+
+    return m_hasAlpha != 0;
+}
+
+const ImageFeatures& RuleInputs::Features()
+{
+    if (!m_hasFeatures)
+    {
+        TraceSpan span("ExtractImageFeatures");
+        ExtractImageFeatures(m_img, m_features);
+        m_hasFeatures = true;
+    }
+
+    return m_features;
+}
+
+// -------------------------------------------------------------
+// RuleTable
+// -------------------------------------------------------------
+
+std::shared_ptr<const RuleTable> RuleTable::Parse(const std::wstring& text, int* errorLine)
+{
+    auto table = std::make_shared<RuleTable>();
+    uint32_t hash = 2166136261u;
+
+    if (errorLine)
+        *errorLine = 0;
+
+    size_t pos = 0;
+    int lineNumber = 0;
+
+    while (pos < text.size())
+    {
+        size_t end = text.find(L'\n', pos);
+        if (end == std::wstring::npos)
+            end = text.size();
+
+        std::wstring line = text.substr(pos, end - pos);
+        pos = end + 1;
+        ++lineNumber;
+
+        size_t hashPos = line.find(L'#');
+        if (hashPos != std::wstring::npos)
+            line.resize(hashPos);
+
+        // Tokens separados por espacios
+        std::vector<std::wstring> tokens;
+        size_t i = 0;
+        while (i < line.size())
+        {
+            while (i < line.size() && iswspace(line[i])) ++i;
+            size_t j = i;
+            while (j < line.size() && !iswspace(line[j])) ++j;
+            if (j > i)
+                tokens.push_back(line.substr(i, j - i));
+            i = j;
+        }
+
+        if (tokens.empty())
+            continue;
+
+        Rule rule;
+        RuleId id;
+        if (!FindRule(tokens[0], id))
+        {
+            if (errorLine) *errorLine = lineNumber;
+            return nullptr;
+        }
+        rule.ruleId = id;
+        bool mips = false;
+
+        for (size_t t = 1; t < tokens.size(); ++t)
+        {
+            Clause clause;
+            clause.cost = 0;
+
+            const std::wstring& token = tokens[t];
+
+            if (token == L"+mips")
+            {
+                mips = true;
+                continue;
+            }
+            size_t start = 0;
+
+            while (start <= token.size())
+            {
+                size_t bar = token.find(L'|', start);
+                if (bar == std::wstring::npos)
+                    bar = token.size();
+
+                std::wstring alt = token.substr(start, bar - start);
+                start = bar + 1;
+
+                Condition c = {};
+                int cost = 0;
+                bool ok = true;
+
+                if (alt.compare(0, 5, L"path~") == 0 && alt.size() > 5)
+                {
+                    c.value = VALUE_PATH;
+                    c.text = ToLower(alt.substr(5));
+                }
+                else if (alt.compare(0, 9, L"pathcase~") == 0 && alt.size() > 9)
+                {
+                    c.value = VALUE_PATH_CASE;
+                    c.text = alt.substr(9);
+                }
+                else
+                {
+                    size_t opPos = alt.find_first_of(L"<>=!");
+                    const NamedValue* v = nullptr;
+
+                    if (opPos == 0 && alt.size() > 1 && alt[0] == L'!')
+                    {
+                        // !flag
+                        v = FindValue(alt.substr(1));
+                        c.op = OP_EQ;
+                        c.number = 0.0;
+                    }
+                    else if (opPos == std::wstring::npos)
+                    {
+                        // flag
+                        v = FindValue(alt);
+                        c.op = OP_NE;
+                        c.number = 0.0;
+                    }
+                    else
+                    {
+                        v = FindValue(alt.substr(0, opPos));
+
+                        std::wstring op = alt.substr(opPos, 2);
+                        size_t numPos = opPos + 2;
+                        if (op == L"<=") c.op = OP_LE;
+                        else if (op == L">=") c.op = OP_GE;
+                        else if (op == L"==") c.op = OP_EQ;
+                        else if (op == L"!=") c.op = OP_NE;
+                        else if (alt[opPos] == L'<') { c.op = OP_LT; numPos = opPos + 1; }
+                        else if (alt[opPos] == L'>') { c.op = OP_GT; numPos = opPos + 1; }
+                        else ok = false;
+
+                        if (ok)
+                        {
+                            const wchar_t* num = alt.c_str() + numPos;
+                            wchar_t* numEnd = nullptr;
+                            c.number = wcstod(num, &numEnd);
+                            ok = (numEnd != num && *numEnd == 0);
+                        }
+                    }
+
+                    if (!v)
+                        ok = false;
+                    else
+                    {
+                        c.value = v->value;
+                        cost = v->cost;
+                    }
+                }
+
+                if (!ok)
+                {
+                    if (errorLine) *errorLine = lineNumber;
+                    return nullptr;
+                }
+
+                clause.any.push_back(c);
+                clause.cost = std::max(clause.cost, cost);
+            }
+
+            rule.all.push_back(clause);
+        }
+
+        // Primero lo barato: si falla, lo caro no se llega a calcular
+        std::stable_sort(rule.all.begin(), rule.all.end(),
+            [](const Clause& a, const Clause& b) { return a.cost < b.cost; });
+
+        // Hash de la forma canonica (no del texto: comentarios y espacios no cuentan)
+        hash = HashBytes(hash, &rule.ruleId, sizeof(rule.ruleId));
+        for (const auto& clause : rule.all)
+        {
+            hash = HashBytes(hash, "&", 1);
+            for (const auto& c : clause.any)
+            {
+                hash = HashBytes(hash, &c.value, sizeof(c.value));
+                hash = HashBytes(hash, &c.op, sizeof(c.op));
+                hash = HashBytes(hash, &c.number, sizeof(c.number));
+                hash = HashBytes(hash, c.text.data(), c.text.size() * sizeof(wchar_t));
+            }
+        }
+
+        if (mips)
+        {
+            hash = HashBytes(hash, "+mips", 5);
+            table->m_mipRules |= uint64_t(1) << rule.ruleId;
+        }
+
+        table->m_rules.push_back(rule);
+    }
+
+    table->m_hash = hash;
+    return table;
+}
+
+const wchar_t* RuleTable::DefaultText()
+{
+    return kDefaultRules;
+}
+
+std::shared_ptr<const RuleTable> RuleTable::Current()
+{
+    std::lock_guard<std::mutex> lk(g_tableLock);
+
+    if (!g_table)
+        g_table = Parse(kDefaultRules);
+
+    return g_table;
+}
+
+void RuleTable::SetCurrent(std::shared_ptr<const RuleTable> table)
+{
+    std::lock_guard<std::mutex> lk(g_tableLock);
+    g_table = table ? table : Parse(kDefaultRules);
+}
+
+bool RuleTable::Evaluate(const Condition& c, RuleInputs& inputs)
+{
+    if (c.value == VALUE_PATH)
+        return inputs.LowerPath().find(c.text) != std::wstring::npos;
+
+    if (c.value == VALUE_PATH_CASE)
+        return inputs.Path().find(c.text) != std::wstring::npos;
+
+    size_t w = inputs.Width();
+    size_t h = inputs.Height();
+    size_t pw = (w + 3) & ~size_t(3);
+    size_t ph = (h + 3) & ~size_t(3);
+
+    // Los valores float se comparan en float (0.08 != 0.08f)
+    double v = 0.0;
+    bool single = false;
+    switch (c.value)
+    {
+    case VALUE_W:                v = double(w); break;
+    case VALUE_H:                v = double(h); break;
+    case VALUE_PW:               v = double(pw); break;
+    case VALUE_PH:               v = double(ph); break;
+    case VALUE_PADDED_ASPECT:    v = (pw && ph) ? std::max(double(pw) / double(ph), double(ph) / double(pw)) : 0.0; break;
+    case VALUE_HAS_ALPHA:        v = inputs.HasAlpha() ? 1.0 : 0.0; break;
+    case VALUE_SOFT_ALPHA:       v = DetectSoftAlpha(inputs.Features()) ? 1.0 : 0.0; break;
+    case VALUE_ALPHA_SOFT_RATIO: v = AlphaSoftRatio(inputs.Features()); single = true; break;
+    case VALUE_SAT_MID_RATIO:    v = SatMidRatio(inputs.Features()); single = true; break;
+    case VALUE_ALPHA_GRAD_AVG:   v = AlphaGradAverage(inputs.Features()); break;
+    case VALUE_LUMA_DIFF_AVG:    v = LumaDiffAverage(inputs.Features()); break;
+    case VALUE_COLOR_STDDEV:     v = ComputeColorStdDev(inputs.Features()); single = true; break;
+    case VALUE_LAPLACIAN:        v = LaplacianEnergy(inputs.Features()); single = true; break;
+    case VALUE_LONG_BAND_RATIO:  v = LongBandRatio(inputs.Features()); break;
+    default:                     return false;
+    }
+
+    if (single)
+        return Compare(c.op, float(v), float(c.number));
+
+    return Compare(c.op, v, c.number);
+}
+
+int RuleTable::Select(RuleInputs& inputs) const
+{
+    TraceSpan span("SelectRule");
+
+    for (const auto& rule : m_rules)
+    {
+        bool match = true;
+
+        for (const auto& clause : rule.all)
+        {
+            bool any = false;
+            for (const auto& c : clause.any)
+            {
+                if (Evaluate(c, inputs))
+                {
+                    any = true;
+                    break;
+                }
+            }
+
+            if (!any)
+            {
+                match = false;
+                break;
+            }
+        }
+
+        if (match)
+            return rule.ruleId;
+    }
+
+    return RULE_DEFAULT_BC7_HIGH_QUALITY;
+}
+
+uint32_t RuleTable::Signature(const wchar_t* src) const
+{
+    std::wstring path = NormalizePath(src);
+    std::wstring lower = ToLower(path);
+
+    uint32_t h = m_hash;
+    for (const auto& rule : m_rules)
+    {
+        for (const auto& clause : rule.all)
+        {
+            for (const auto& c : clause.any)
+            {
+                if (c.value != VALUE_PATH && c.value != VALUE_PATH_CASE)
+                    continue;
+
+                const std::wstring& subject = (c.value == VALUE_PATH) ? lower : path;
+                uint8_t bit = (subject.find(c.text) != std::wstring::npos) ? 1 : 0;
+                h = HashBytes(h, &bit, 1);
+            }
+        }
+    }
+
+    return h;
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <windows.h>
+#include "DirectXTex.h"
+#include "ImageFeatures.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+enum RuleId
+{
+    RULE_SMALL_ALPHA_ICON = 1,
+    RULE_GLOWFX_UNCOMPRESSED = 2,
+    RULE_DARK_GRADIENT_UNCOMPRESSED = 3,
+    RULE_ANIMATION_BC7 = 4,
+    RULE_JACKPOT_UNCOMPRESSED = 5,
+    RULE_PROGRESSCOUNTERS_UNCOMP = 6,
+    RULE_BIG_750_BC7 = 7,
+    RULE_SMALL_SOLID_SYMBOL_BC3 = 8,
+    RULE_LONG_STRIP_BC7 = 9,
+    RULE_LONG_STRIP_SHEET_UNCOMP = 10,
+    RULE_LONG_STRIP_SHEET_BC3 = 11,
+    RULE_FONTS_BC7 = 12,
+    // Retirado: el limite de tiempo baja de tier dentro de BC7 y ya no
+    // cambia a BC3, asi que no se devuelve nunca. Se deja el numero
+    // para que no se reutilice.
+    RULE_FALLBACK_BC3_RETIRED = 13,
+    RULE_FALLBACK_BC7_BALANCED = 14,
+    RULE_DEFAULT_BC7_HIGH_QUALITY = 15,
+    RULE_BIG_IMAGE_BC3 = 16,
+    // Regla final sin pasar del limite, pero el modelo de coste eligio
+    // una calidad de partida mas barata que HighQualityUniform
+    RULE_COST_MODEL_BC7 = 17
+
+};
+
+// -------------------------------------------------------------
+// Datos de entrada de las reglas, calculados solo cuando hacen falta.
+//
+// Tamano y ruta son gratis; hasAlpha se busca con salida temprana;
+// el resto sale de ImageFeatures, que se calcula una sola vez y solo
+// si alguna regla alcanzable lo pide.
+// -------------------------------------------------------------
+class RuleInputs
+{
+public:
+    // 'img' RGBA/BGRA 8 bits; tiene que vivir mientras se use
+    RuleInputs(const DirectX::Image* img, const wchar_t* src);
+
+    // Estadisticas ya calculadas (p.ej. por bandas)
+    RuleInputs(const ImageFeatures& features, const wchar_t* src);
+
+    size_t Width() const { return m_width; }
+    size_t Height() const { return m_height; }
+    const std::wstring& Path() const { return m_path; }
+    const std::wstring& LowerPath() const { return m_lower; }
+
+    bool HasAlpha();
+    const ImageFeatures& Features();
+    bool HasFeatures() const { return m_hasFeatures; }
+
+private:
+    const DirectX::Image* m_img = nullptr;
+    size_t m_width = 0;
+    size_t m_height = 0;
+    std::wstring m_path;        // con '\' como separador
+    std::wstring m_lower;
+
+    ImageFeatures m_features;
+    bool m_hasFeatures = false;
+    int m_hasAlpha = -1;        // -1 = sin calcular
+};
+
+// -------------------------------------------------------------
+// Tabla de reglas (texto, una regla por linea, gana la primera):
+//
+//   NOMBRE_REGLA  cond cond ...      todas se tienen que cumplir
+//   cond = a|b|...                   basta con una
+//   a    = valor<n  valor<=n  valor>n  valor>=n  valor==n  valor!=n
+//          flag  !flag
+//          path~texto      la ruta contiene texto (sin mayusculas)
+//          pathcase~texto  igual, distinguiendo mayusculas
+//   +mips                            no es condicion: el DDS de la
+//                                    regla lleva la cadena de mips
+//
+// Valores: w h pw ph (relleno a multiplo de 4) paddedAspect
+// alphaSoftRatio satMidRatio alphaGradAvg lumaDiffAvg colorStdDev
+// laplacian longBandRatio. Flags: hasAlpha softAlpha.
+// '#' empieza un comentario. Si ninguna regla se cumple:
+// DEFAULT_BC7_HIGH_QUALITY.
+// -------------------------------------------------------------
+class RuleTable
+{
+public:
+    // nullptr y errorLine (1..n) si el texto no es valido
+    static std::shared_ptr<const RuleTable> Parse(const std::wstring& text, int* errorLine = nullptr);
+
+    // Tabla activa (por defecto la de DefaultText())
+    static std::shared_ptr<const RuleTable> Current();
+    static void SetCurrent(std::shared_ptr<const RuleTable> table);
+    static const wchar_t* DefaultText();
+
+    int Select(RuleInputs& inputs) const;
+
+    // Hash de la tabla + que condiciones de ruta cumple 'src': dos
+    // archivos con la misma firma y los mismos pixeles dan el mismo DDS
+    uint32_t Signature(const wchar_t* src) const;
+
+    // true si alguna linea de la regla lleva +mips
+    bool WantsMips(int ruleId) const { return ruleId >= 0 && ruleId < 64 && ((m_mipRules >> ruleId) & 1); }
+
+private:
+    struct Condition
+    {
+        int value;              // RuleValue
+        int op;                 // RuleOp
+        double number;
+        std::wstring text;      // path~ / pathcase~
+    };
+
+    struct Clause
+    {
+        std::vector<Condition> any;
+        int cost;
+    };
+
+    struct Rule
+    {
+        int ruleId;
+        std::vector<Clause> all;
+    };
+
+    static bool Evaluate(const Condition& c, RuleInputs& inputs);
+
+    std::vector<Rule> m_rules;
+    uint32_t m_hash = 0;
+    uint64_t m_mipRules = 0;    // bit = RuleId
+};
@@ -9,8 +9,21 @@
 using std::powf;
 
 #include "DirectXTex.h"
+#include "ImageFeatures.h"
+#include "ImageKernels.h"
+#include "BCDecoder.h"
+#include <cstring>
+#include <vector>
 using namespace DirectX;
 
+// Detectores originales (DirectXTexExports.cpp), usados como referencia
+float ComputeColorStdDev(const DirectX::Image* img);
+bool DetectSoftAlpha(const DirectX::Image* img);
+bool IsGlowFX(const DirectX::Image* img);
+bool IsDarkGradientBackground(const DirectX::Image* img);
+bool IsLongStripSheet(const DirectX::Image* img);
+float LaplacianEnergy(const DirectX::Image* img);
+
 
 inline float Clamp01(float v)
 {
@@ -186,6 +199,156 @@ HRESULT ApplyGammaCorrection(const ScratchImage& src, float gamma, ScratchImage&
 //}
 
 
+//-----------------------------------------------------------
+// Verifica que ExtractImageFeatures + predicados tomen las
+// mismas decisiones que los detectores originales
+//-----------------------------------------------------------
+int VerifyFeatureDecisions()
+{
+    const wchar_t* samples[] =
+    {
+        L"1.png", L"2.png", L"3.png", L"4.png", L"5.png", L"6.png",
+        L"7.png", L"8.png", L"9.png", L"10.png", L"11.png",
+        L"static.png", L"Symbol.png"
+    };
+
+    int mismatches = 0;
+
+    for (const wchar_t* file : samples)
+    {
+        TexMetadata md{};
+        ScratchImage si;
+        if (FAILED(LoadFromWICFile(file, WIC_FLAGS_IGNORE_SRGB, &md, si)))
+        {
+            std::wcout << L"[FEATURES] skip " << file << std::endl;
+            continue;
+        }
+
+        const Image* base = si.GetImage(0, 0, 0);
+
+        ImageFeatures f;
+        ExtractImageFeatures(base, f);
+
+        float sdRef = ComputeColorStdDev(base);
+        float sdNew = ComputeColorStdDev(f);
+
+        bool same =
+            IsGlowFX(base) == IsGlowFX(f) &&
+            IsDarkGradientBackground(base) == IsDarkGradientBackground(f) &&
+            DetectSoftAlpha(base) == DetectSoftAlpha(f) &&
+            IsLongStripSheet(base) == IsLongStripSheet(f) &&
+            LaplacianEnergy(base) == LaplacianEnergy(f) &&
+            (sdRef < 18.0f) == (sdNew < 18.0f) &&
+            (sdRef < 22.0f) == (sdNew < 22.0f) &&
+            (sdRef > 25.0f) == (sdNew > 25.0f) &&
+            std::fabs(sdRef - sdNew) <= 1e-5f * std::max(1.0f, sdRef);
+
+        std::wcout << L"[FEATURES] " << file << (same ? L" OK" : L" MISMATCH")
+            << L" stddev=" << sdRef << L"/" << sdNew << std::endl;
+
+        if (!same)
+            mismatches++;
+    }
+
+    return mismatches;
+}
+
+
+//-----------------------------------------------------------
+// Compara fila a fila los kernels SSE2/AVX2 contra la version
+// escalar: tienen que dar exactamente el mismo resultado
+//-----------------------------------------------------------
+static int CompareKernelsOnRows(const AnalysisKernels& ref, const AnalysisKernels& k,
+    const uint8_t* rowU, const uint8_t* row, const uint8_t* rowD, size_t w)
+{
+    AlphaRowCounts a1, a2;
+    ref.alphaCounts(row, w, a1);
+    k.alphaCounts(row, w, a2);
+
+    ColorRowSums c1, c2;
+    ref.colorSums(row, w, c1);
+    k.colorSums(row, w, c2);
+
+    RowContent r1, r2;
+    ref.rowContent(row, w, r1);
+    k.rowContent(row, w, r2);
+
+    uint64_t s1 = 0, s2 = 0;
+    uint64_t g1 = ref.alphaGradEven(rowU, row, rowD, w, s1);
+    uint64_t g2 = k.alphaGradEven(rowU, row, rowD, w, s2);
+
+    bool same =
+        memcmp(&a1, &a2, sizeof(a1)) == 0 &&
+        memcmp(&c1, &c2, sizeof(c1)) == 0 &&
+        memcmp(&r1, &r2, sizeof(r1)) == 0 &&
+        g1 == g2 && s1 == s2 &&
+        ref.alphaVertChanges(rowU, row, w) == k.alphaVertChanges(rowU, row, w) &&
+        ref.satMidEven(row, w) == k.satMidEven(row, w) &&
+        ref.laplacianRow(rowU, row, rowD, w) == k.laplacianRow(rowU, row, rowD, w);
+
+    return same ? 0 : 1;
+}
+
+int VerifyAnalysisKernels()
+{
+    const AnalysisKernels* ref = GetAnalysisKernels(KernelLevel::Scalar);
+    int mismatches = 0;
+
+    std::wcout << L"[KERNELS] detected level = " << int(DetectKernelLevel()) << std::endl;
+
+    for (int level = int(KernelLevel::SSE2); level <= int(KernelLevel::AVX2); ++level)
+    {
+        const AnalysisKernels* k = GetAnalysisKernels(KernelLevel(level));
+        if (!k)
+            continue;
+
+        int levelMismatches = 0;
+
+        // Filas sinteticas con anchos que no son multiplo de 4/8
+        uint32_t seed = 12345;
+        std::vector<uint8_t> buf;
+
+        for (size_t w = 0; w < 300; ++w)
+        {
+            buf.resize(w * 4 * 3 + 4);
+            for (auto& b : buf)
+            {
+                seed = seed * 1664525u + 1013904223u;
+                uint8_t v = uint8_t(seed >> 24);
+                // Mezcla de 0/255 y valores intermedios para cubrir todos los cortes
+                b = (w % 3 == 0) ? ((v & 1) ? 255 : 0) : v;
+            }
+
+            const uint8_t* rowU = buf.data();
+            levelMismatches += CompareKernelsOnRows(*ref, *k, rowU, rowU + w * 4, rowU + w * 8, w);
+        }
+
+        // Filas reales de las imagenes de prueba
+        const wchar_t* samples[] = { L"1.png", L"10.png", L"static.png", L"Symbol.png" };
+
+        for (const wchar_t* file : samples)
+        {
+            TexMetadata md{};
+            ScratchImage si;
+            if (FAILED(LoadFromWICFile(file, WIC_FLAGS_IGNORE_SRGB, &md, si)))
+                continue;
+
+            const Image* base = si.GetImage(0, 0, 0);
+            for (size_t y = 1; y + 1 < base->height; ++y)
+            {
+                const uint8_t* row = base->pixels + base->rowPitch * y;
+                levelMismatches += CompareKernelsOnRows(*ref, *k, row - base->rowPitch, row, row + base->rowPitch, base->width);
+            }
+        }
+
+        std::wcout << L"[KERNELS] level " << level << (levelMismatches ? L" MISMATCH" : L" OK") << std::endl;
+        mismatches += levelMismatches;
+    }
+
+    return mismatches;
+}
+
+
 int main()
 {
     const wchar_t* src = L"BaseGame_Background.png";           // Tu imagen de prueba
@@ -210,6 +373,18 @@ int main()
     HRESULT hrTest = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
     std::wcout << L"CoInitializeEx = 0x" << std::hex << hrTest << std::endl;
 
+    if (VerifyAnalysisKernels() != 0)
+    {
+        std::wcout << L"ERROR: SIMD analysis kernels differ from scalar reference" << std::endl;
+        return -1;
+    }
+
+    if (VerifyFeatureDecisions() != 0)
+    {
+        std::wcout << L"ERROR: feature extractor decisions differ from reference" << std::endl;
+        return -1;
+    }
+
     // 1. Cargar PNG
     HRESULT hr = LoadFromWICFile(src, WIC_FLAGS_NONE, &meta, image);
     if (FAILED(hr))
@@ -392,6 +567,22 @@ DDS_DECODE:
         return -1;
     }
 
+    // WIC no guarda BC: el mip 0 a RGBA8 con el decodificador propio
+    if (IsBCDecodeFormat(mdCheck.format))
+    {
+        hr = siCheck.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM, mdCheck.width, mdCheck.height, 1, 1);
+        if (SUCCEEDED(hr))
+            hr = DecodeBC(*decoded.GetImage(0, 0, 0), *siCheck.GetImage(0, 0, 0));
+
+        if (FAILED(hr))
+        {
+            std::wcout << L"ERROR: BC decode failed. HR=" << std::hex << hr << std::endl;
+            return -1;
+        }
+
+        decoded = std::move(siCheck);
+    }
+
     hr = SaveToWICFile(
         decoded.GetImages(),
         decoded.GetImageCount(),
@@ -0,0 +1,1032 @@
+#include "TextureEncode.h"
+#include "BC7LaneEncoder.h"
+#include "BC7Pruning.h"
+#include "BCnLaneEncoder.h"
+#include "BlockCache.h"
+#include "BlockRDO.h"
+#include "BufferPool.h"
+#include "Trace.h"
+#include "WorkStealingPool.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using namespace DirectX;
+
+TEX_COMPRESS_FLAGS GetBC7CompressFlags(BC7Quality quality)
+{
+    TEX_COMPRESS_FLAGS flags = TEX_COMPRESS_DEFAULT;
+
+    switch (quality)
+    {
+        case BC7Quality::UltraFast:
+            // Ms rpido de todos (calidad baja-media)
+            flags |= TEX_COMPRESS_BC7_QUICK |
+                TEX_COMPRESS_UNIFORM;
+            break;
+
+        case BC7Quality::QuickOnly:
+            // Intermedio entre UltraFast y FastBalanced
+            // QUICK sin 3SUBSETS ni UNIFORM
+            flags |= TEX_COMPRESS_BC7_QUICK;
+            break;
+
+        case BC7Quality::FastBalanced:
+            // Rpido con buena calidad (recomendado)
+            flags |= TEX_COMPRESS_BC7_QUICK |
+                TEX_COMPRESS_BC7_USE_3SUBSETS;
+            break;
+
+        case BC7Quality::Balanced:
+            // Calidad alta, velocidad media
+            flags |= TEX_COMPRESS_BC7_USE_3SUBSETS;
+            break;
+
+        case BC7Quality::HighQuality:
+            flags |= TEX_COMPRESS_BC7_USE_3SUBSETS |
+                TEX_COMPRESS_BC7_QUICK |
+                TEX_COMPRESS_PARALLEL;
+            break;
+
+        case BC7Quality::HighQualityUniform:
+            // El ms lento de todos (totalmente exhaustivo)
+            flags |= TEX_COMPRESS_UNIFORM |
+                TEX_COMPRESS_BC7_USE_3SUBSETS;
+            break;
+        default:
+            break;
+    }
+
+    return flags;
+}
+
+HRESULT CompressBC7(const Image& rgba, ScratchImage& out, BC7Quality quality)
+{
+    return CompressTiled(rgba, DXGI_FORMAT_BC7_UNORM, GetBC7CompressFlags(quality), out, GetDefaultTileEncodeOptions());
+}
+
+HRESULT CompressBC7(const ScratchImage& rgba, ScratchImage& out, BC7Quality quality)
+{
+    if (rgba.GetImageCount() == 1)
+        return CompressBC7(*rgba.GetImage(0, 0, 0), out, quality);
+
+    TEX_COMPRESS_FLAGS flags = GetBC7CompressFlags(quality);
+
+    HRESULT hr = Compress(
+        rgba.GetImages(),
+        rgba.GetImageCount(),
+        rgba.GetMetadata(),
+        DXGI_FORMAT_BC7_UNORM,
+        flags,
+        1.0f,
+        out
+    );
+
+    return hr;
+}
+
+
+
+TEX_COMPRESS_FLAGS GetBC3CompressFlags()
+{
+    return TEX_COMPRESS_PARALLEL |    // Usa varios cores
+        TEX_COMPRESS_DITHER;          // Suaviza el error (como Squish perceptual)
+}
+
+HRESULT CompressBC3(const Image& rgba, ScratchImage& out)
+{
+    return CompressTiled(rgba, DXGI_FORMAT_BC3_UNORM, GetBC3CompressFlags(), out, GetDefaultTileEncodeOptions());
+}
+
+HRESULT CompressBC3(const ScratchImage& rgba, ScratchImage& out)
+{
+    if (rgba.GetImageCount() == 1)
+        return CompressBC3(*rgba.GetImage(0, 0, 0), out);
+
+    TEX_COMPRESS_FLAGS flags = GetBC3CompressFlags();
+
+    HRESULT hr = Compress(
+        rgba.GetImages(),
+        rgba.GetImageCount(),
+        rgba.GetMetadata(),
+        DXGI_FORMAT_BC3_UNORM,
+        flags,
+        1.0f,
+        out
+    );
+    return hr;
+}
+
+// -------------------------------------------------------------
+// BLOQUES TRIVIALES
+// -------------------------------------------------------------
+namespace
+{
+    struct SingleColorEntry
+    {
+        uint8_t e0;
+        uint8_t e1;
+    };
+
+    // Para cada valor de 8 bits, los extremos que mejor lo reproducen:
+    SingleColorEntry g_bc7Single[256];     // BC7 modo 5, 7 bits, indice 1 (peso 21)
+    SingleColorEntry g_bc1Single5[256];    // BC1 5 bits, indice 2 (2/3 e0 + 1/3 e1)
+    SingleColorEntry g_bc1Single6[256];    // BC1 6 bits, indice 2
+    std::once_flag g_singleColorOnce;
+
+    void BuildBC1Table(SingleColorEntry* table, int bits)
+    {
+        int maxV = (1 << bits) - 1;
+
+        for (int v = 0; v < 256; ++v)
+        {
+            float best = 1e9f;
+            for (int e0 = 0; e0 <= maxV; ++e0)
+            {
+                for (int e1 = 0; e1 <= maxV; ++e1)
+                {
+                    float c = (2.0f * e0 + e1) / (3.0f * maxV) * 255.0f;
+                    float err = fabsf(c - float(v)) + 0.001f * abs(e0 - e1);
+                    if (err < best)
+                    {
+                        best = err;
+                        table[v] = { uint8_t(e0), uint8_t(e1) };
+                    }
+                }
+            }
+        }
+    }
+
+    void BuildSingleColorTables()
+    {
+        for (int v = 0; v < 256; ++v)
+        {
+            int best = 1 << 30;
+            for (int e0 = 0; e0 < 128; ++e0)
+            {
+                for (int e1 = 0; e1 < 128; ++e1)
+                {
+                    int a = (e0 << 1) | (e0 >> 6);
+                    int b = (e1 << 1) | (e1 >> 6);
+                    int c = (a * 43 + b * 21 + 32) >> 6;
+                    int err = abs(c - v) * 256 + abs(e0 - e1);
+                    if (err < best)
+                    {
+                        best = err;
+                        g_bc7Single[v] = { uint8_t(e0), uint8_t(e1) };
+                    }
+                }
+            }
+        }
+
+        BuildBC1Table(g_bc1Single5, 5);
+        BuildBC1Table(g_bc1Single6, 6);
+    }
+
+    // Escritura de bits LSB primero (orden de BC7)
+    struct BlockBits
+    {
+        uint8_t* p;
+        size_t pos = 0;
+
+        void Put(uint32_t v, size_t n)
+        {
+            for (size_t i = 0; i < n; ++i, ++pos)
+            {
+                if ((v >> i) & 1)
+                    p[pos >> 3] |= uint8_t(1u << (pos & 7));
+            }
+        }
+    };
+
+    // Modo 5: color con indices de 2 bits y alpha aparte con extremos
+    // de 8 bits, asi el alpha sale exacto.
+    void EncodeBC7SingleColor(const uint8_t rgba[4], uint8_t* block)
+    {
+        memset(block, 0, 16);
+        BlockBits bits{ block };
+
+        bits.Put(1u << 5, 6);   // modo 5
+        bits.Put(0, 2);         // sin rotacion
+
+        for (int c = 0; c < 3; ++c)
+        {
+            bits.Put(g_bc7Single[rgba[c]].e0, 7);
+            bits.Put(g_bc7Single[rgba[c]].e1, 7);
+        }
+
+        bits.Put(rgba[3], 8);
+        bits.Put(rgba[3], 8);
+
+        // Indices de color: todos 1 (el ancla solo lleva 1 bit)
+        bits.Put(1, 1);
+        for (int i = 1; i < 16; ++i)
+            bits.Put(1, 2);
+
+        // Indices de alpha: todos 0 (ya estan a cero)
+    }
+
+    void EncodeBC3SingleColor(const uint8_t rgba[4], uint8_t* block)
+    {
+        memset(block, 0, 16);
+
+        // Alpha: a0 == a1, indices 0
+        block[0] = rgba[3];
+        block[1] = rgba[3];
+
+        uint16_t c0 = uint16_t((g_bc1Single5[rgba[0]].e0 << 11) | (g_bc1Single6[rgba[1]].e0 << 5) | g_bc1Single5[rgba[2]].e0);
+        uint16_t c1 = uint16_t((g_bc1Single5[rgba[0]].e1 << 11) | (g_bc1Single6[rgba[1]].e1 << 5) | g_bc1Single5[rgba[2]].e1);
+
+        block[8] = uint8_t(c0);
+        block[9] = uint8_t(c0 >> 8);
+        block[10] = uint8_t(c1);
+        block[11] = uint8_t(c1 >> 8);
+
+        // Indices de color: todos 2
+        block[12] = block[13] = block[14] = block[15] = 0xAA;
+    }
+
+    // Lee un bloque 4x4 repitiendo el borde en los bloques incompletos
+    void GatherBlock(const Image& img, size_t bx, size_t by, uint32_t px[16])
+    {
+        for (size_t j = 0; j < 4; ++j)
+        {
+            size_t y = std::min(by * 4 + j, img.height - 1);
+            const uint32_t* row = reinterpret_cast<const uint32_t*>(img.pixels + y * img.rowPitch);
+
+            for (size_t i = 0; i < 4; ++i)
+                px[j * 4 + i] = row[std::min(bx * 4 + i, img.width - 1)];
+        }
+    }
+
+    enum BlockKind
+    {
+        BLOCK_REGULAR,
+        BLOCK_CONSTANT,
+        BLOCK_TRANSPARENT
+    };
+
+    // 'color' recibe el RGBA a codificar si el bloque es trivial
+    BlockKind ClassifyBlock(const uint32_t px[16], uint8_t color[4])
+    {
+        bool constant = true;
+        bool transparent = true;
+        uint32_t sum[3] = {};
+
+        for (int i = 0; i < 16; ++i)
+        {
+            const uint8_t* p = reinterpret_cast<const uint8_t*>(&px[i]);
+            constant &= (px[i] == px[0]);
+            transparent &= (p[3] == 0);
+            sum[0] += p[0];
+            sum[1] += p[1];
+            sum[2] += p[2];
+        }
+
+        if (transparent)
+        {
+            // El color no se ve; se guarda la media para que el filtrado
+            // en los bordes no meta un color extrano
+            for (int c = 0; c < 3; ++c)
+                color[c] = uint8_t((sum[c] + 8) / 16);
+            color[3] = 0;
+            return BLOCK_TRANSPARENT;
+        }
+
+        if (constant)
+        {
+            memcpy(color, &px[0], 4);
+            return BLOCK_CONSTANT;
+        }
+
+        return BLOCK_REGULAR;
+    }
+}
+
+namespace
+{
+    // Bit que DirectXTex no usa: separa en la cache los bloques del
+    // codificador por carriles
+    const TEX_COMPRESS_FLAGS kLaneCacheFlag = TEX_COMPRESS_FLAGS(0x80000000);
+
+    // Lo mismo para los niveles de la poda de BC7 (por BC7SearchTier)
+    const TEX_COMPRESS_FLAGS kTierCacheFlags[kBC7TierCount] =
+    {
+        TEX_COMPRESS_DEFAULT, TEX_COMPRESS_FLAGS(0x20000000), TEX_COMPRESS_FLAGS(0x40000000)
+    };
+
+    // BC3 no tiene niveles de poda: el mismo bit marca el cluster fit
+    const TEX_COMPRESS_FLAGS kClusterFitCacheFlag = TEX_COMPRESS_FLAGS(0x20000000);
+
+    inline double CacheNowMs()
+    {
+        LARGE_INTEGER t, f;
+        QueryPerformanceCounter(&t);
+        QueryPerformanceFrequency(&f);
+        return double(t.QuadPart) * 1000.0 / double(f.QuadPart);
+    }
+
+    // Copia filas de bloques de 'src' a 'dst' (mismo ancho)
+    void CopyBlockRows(const Image& src, const Image& dst)
+    {
+        size_t rows = (dst.height + 3) / 4;
+        size_t rowBytes = std::min(src.rowPitch, dst.rowPitch);
+        for (size_t r = 0; r < rows; ++r)
+            memcpy(dst.pixels + r * dst.rowPitch, src.pixels + r * src.rowPitch, rowBytes);
+    }
+
+    // Codifica con Compress los bloques 'pending' (by * blocksW + bx)
+    // de 'rgba' y los deja en su sitio de 'dst'
+    HRESULT EncodeRegularBlocks(
+        const Image& rgba,
+        DXGI_FORMAT format,
+        TEX_COMPRESS_FLAGS flags,
+        const Image& dst,
+        const std::vector<uint32_t>& pending)
+    {
+        size_t blocksW = (rgba.width + 3) / 4;
+        size_t blocksH = (rgba.height + 3) / 4;
+
+        const std::vector<uint32_t>* packList = &pending;
+        std::vector<uint32_t> edge;
+
+        // Nada que ahorrar: los bloques completos van directos a Compress
+        // sin empaquetar. Solo se empaquetan los incompletos del borde,
+        // asi todos repiten el borde igual (GatherBlock).
+        if (pending.size() == blocksW * blocksH)
+        {
+            size_t fullW = rgba.width / 4;
+            size_t fullH = rgba.height / 4;
+
+            if (fullW && fullH)
+            {
+                Image interior = rgba;
+                interior.width = fullW * 4;
+                interior.height = fullH * 4;
+                interior.slicePitch = interior.rowPitch * interior.height;
+
+                ScratchImage encoded;
+                HRESULT hr = Compress(interior, format, flags, 1.0f, encoded);
+                if (FAILED(hr)) return hr;
+
+                Image interiorDst = dst;
+                interiorDst.height = interior.height;
+                CopyBlockRows(*encoded.GetImage(0, 0, 0), interiorDst);
+            }
+
+            if (fullW == blocksW && fullH == blocksH)
+                return S_OK;
+
+            for (uint32_t i : pending)
+            {
+                if ((i % blocksW) >= fullW || (i / blocksW) >= fullH)
+                    edge.push_back(i);
+            }
+
+            packList = &edge;
+        }
+
+        const std::vector<uint32_t>& list = *packList;
+        uint32_t px[16];
+
+        // Empaquetar los bloques en una imagen compacta
+        size_t packW = std::min(list.size(), blocksW);
+        size_t packH = (list.size() + packW - 1) / packW;
+
+        PooledImage packed;
+        HRESULT hr = packed.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM, packW * 4, packH * 4);
+        if (FAILED(hr)) return hr;
+
+        const Image& packImg = packed.GetImage();
+        memset(packImg.pixels, 0, packImg.slicePitch);
+
+        for (size_t i = 0; i < list.size(); ++i)
+        {
+            GatherBlock(rgba, list[i] % blocksW, list[i] / blocksW, px);
+
+            size_t px0 = (i % packW) * 4;
+            size_t py0 = (i / packW) * 4;
+            for (size_t j = 0; j < 4; ++j)
+                memcpy(packImg.pixels + (py0 + j) * packImg.rowPitch + px0 * 4, &px[j * 4], 16);
+        }
+
+        // Codificar y devolver cada bloque a su sitio
+        ScratchImage packedOut;
+        hr = Compress(packImg, format, flags, 1.0f, packedOut);
+        if (FAILED(hr)) return hr;
+
+        const Image* encoded = packedOut.GetImage(0, 0, 0);
+        for (size_t i = 0; i < list.size(); ++i)
+        {
+            size_t bx = list[i] % blocksW;
+            size_t by = list[i] / blocksW;
+
+            memcpy(dst.pixels + by * dst.rowPitch + bx * 16,
+                encoded->pixels + (i / packW) * encoded->rowPitch + (i % packW) * 16,
+                16);
+        }
+
+        return S_OK;
+    }
+
+    // Lo mismo con un codificador por carriles: los bloques se juntan
+    // en lotes y cada resultado (blockBytes) va directo a su sitio
+    template <class EncodeBatch>
+    void EncodeLaneBlocks(
+        const Image& rgba,
+        const Image& dst,
+        const std::vector<uint32_t>& pending,
+        size_t blockBytes,
+        EncodeBatch encode)
+    {
+        size_t blocksW = (rgba.width + 3) / 4;
+
+        const size_t kBatch = 64;
+        uint32_t px[kBatch][16];
+        uint8_t encoded[kBatch * 16];
+
+        for (size_t first = 0; first < pending.size(); first += kBatch)
+        {
+            size_t count = std::min(kBatch, pending.size() - first);
+
+            for (size_t i = 0; i < count; ++i)
+                GatherBlock(rgba, pending[first + i] % blocksW, pending[first + i] / blocksW, px[i]);
+
+            encode(px, count, encoded);
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                size_t bx = pending[first + i] % blocksW;
+                size_t by = pending[first + i] / blocksW;
+                memcpy(dst.pixels + by * dst.rowPitch + bx * blockBytes, encoded + i * blockBytes, blockBytes);
+            }
+        }
+    }
+
+    // Quien codifica los bloques normales de un grupo
+    struct PendingEncoder
+    {
+        TEX_COMPRESS_FLAGS flags;           // para Compress
+        const BC7LaneParams* bc7Lanes;      // BC7 por carriles (o nullptr)
+        const BCnLaneParams* bcnLanes;      // BC3 por carriles (o nullptr)
+        TEX_COMPRESS_FLAGS cacheFlags;      // clave en la cache de bloques
+        bool useCache;
+    };
+
+    // Bloques normales con el mismo codificador: los que ya estan en la
+    // cache de bloques (de esta imagen o de otra) se copian sin buscar
+    // nada y el resto pasa por Compress (o por los carriles)
+    HRESULT EncodePending(
+        const Image& rgba,
+        DXGI_FORMAT format,
+        const PendingEncoder& encoder,
+        const Image& dst,
+        std::vector<uint32_t>& pending)
+    {
+        TEX_COMPRESS_FLAGS cacheFlags = encoder.cacheFlags;
+
+        size_t blocksW = (rgba.width + 3) / 4;
+        uint32_t px[16];
+
+        bool useCache = encoder.useCache && BlockCache::Enabled();
+        uint64_t lookups = pending.size();
+        uint64_t hits = 0;
+        double lookupMs = 0.0;
+
+        if (useCache && !pending.empty())
+        {
+            double t0 = CacheNowMs();
+            size_t misses = 0;
+
+            for (uint32_t i : pending)
+            {
+                size_t bx = i % blocksW;
+                size_t by = i / blocksW;
+                GatherBlock(rgba, bx, by, px);
+
+                if (BlockCache::Lookup(px, format, cacheFlags, dst.pixels + by * dst.rowPitch + bx * 16))
+                    ++hits;
+                else
+                    pending[misses++] = i;
+            }
+
+            pending.resize(misses);
+            lookupMs = CacheNowMs() - t0;
+        }
+
+        if (pending.empty())
+        {
+            if (useCache)
+                BlockCache::Record(format, cacheFlags, lookups, hits, 0, 0.0, lookupMs);
+            return S_OK;
+        }
+
+        double t0 = useCache ? CacheNowMs() : 0.0;
+
+        if (encoder.bc7Lanes)
+        {
+            const BC7LaneKernels& kernels = GetBC7LaneKernels();
+            const BC7LaneParams& params = *encoder.bc7Lanes;
+
+            EncodeLaneBlocks(rgba, dst, pending, 16, [&](const uint32_t (*px)[16], size_t count, uint8_t* out)
+                {
+                    kernels.encode(px, count, reinterpret_cast<uint8_t (*)[16]>(out), params);
+                });
+        }
+        else if (encoder.bcnLanes)
+        {
+            const BCnLaneKernels& kernels = GetBCnLaneKernels();
+            const BCnLaneParams& params = *encoder.bcnLanes;
+
+            EncodeLaneBlocks(rgba, dst, pending, 16, [&](const uint32_t (*px)[16], size_t count, uint8_t* out)
+                {
+                    kernels.encode(format, px, count, out, params);
+                });
+        }
+        else
+        {
+            HRESULT hr = EncodeRegularBlocks(rgba, format, encoder.flags, dst, pending);
+            if (FAILED(hr)) return hr;
+        }
+
+        if (useCache)
+        {
+            double t1 = CacheNowMs();
+
+            for (uint32_t i : pending)
+            {
+                size_t bx = i % blocksW;
+                size_t by = i / blocksW;
+                GatherBlock(rgba, bx, by, px);
+                BlockCache::Insert(px, format, cacheFlags, dst.pixels + by * dst.rowPitch + bx * 16);
+            }
+
+            double t2 = CacheNowMs();
+            BlockCache::Record(format, cacheFlags, lookups, hits, pending.size(), t1 - t0, lookupMs + (t2 - t1));
+        }
+
+        return S_OK;
+    }
+
+    // CompressBlocks escribiendo en 'dst', que ya tiene el formato y
+    // el tamano de bloques de 'rgba' (puede ser un trozo de otra imagen).
+    // De 'options' solo cuentan el codificador y encoderOnly.
+    HRESULT EncodeBlocks(
+        const Image& rgba,
+        DXGI_FORMAT format,
+        TEX_COMPRESS_FLAGS flags,
+        const Image& dst,
+        const TileEncodeOptions& options,
+        BlockFastPathStats* stats)
+    {
+        bool rgba8 = rgba.format == DXGI_FORMAT_R8G8B8A8_UNORM && rgba.pixels && rgba.width && rgba.height;
+
+        // BC1/BC3/BC4 con el codificador propio (BCnLaneEncoder.h). BC1 y
+        // BC4 no tienen atajos ni cache: todo el trozo va directo.
+        BCnLaneParams bcnParams = {};
+        BCnEncoder bcnEncoder = (options.bcnEncoder >= 0) ? BCnEncoder(options.bcnEncoder) : GetBCnEncoder();
+        bool bcnLanes = rgba8 && GetBCnLaneParams(format, flags, bcnEncoder, bcnParams);
+
+        if (bcnLanes && format != DXGI_FORMAT_BC3_UNORM)
+        {
+            if (stats)
+            {
+                *stats = BlockFastPathStats();
+                stats->totalBlocks = uint32_t(((rgba.width + 3) / 4) * ((rgba.height + 3) / 4));
+            }
+            return EncodeBCnLanes(rgba, dst, bcnParams);
+        }
+
+        bool supported = rgba8 && (format == DXGI_FORMAT_BC7_UNORM || format == DXGI_FORMAT_BC3_UNORM);
+
+        if (!supported)
+        {
+            ScratchImage encoded;
+            HRESULT hr = Compress(rgba, format, flags, 1.0f, encoded);
+            if (FAILED(hr)) return hr;
+
+            CopyBlockRows(*encoded.GetImage(0, 0, 0), dst);
+            return S_OK;
+        }
+
+        std::call_once(g_singleColorOnce, BuildSingleColorTables);
+
+        // BC7 por carriles si la calidad de estas flags lo tiene puesto.
+        // En la cache va con otra clave: no da los mismos bloques.
+        const BC7LaneParams* lanes = nullptr;
+        if (format == DXGI_FORMAT_BC7_UNORM)
+        {
+            lanes = (options.bc7Backend >= 0)
+                ? GetBC7LaneParamsForFlags(flags, BC7Backend(options.bc7Backend))
+                : GetBC7LaneParamsForFlags(flags);
+        }
+        TEX_COMPRESS_FLAGS cacheFlags = (lanes || bcnLanes) ? (flags | kLaneCacheFlag) : flags;
+        if (bcnLanes && bcnParams.clusterFit)
+            cacheFlags |= kClusterFitCacheFlag;
+
+        // Poda de BC7 (BC7Pruning.h): cada bloque normal va al grupo de
+        // su nivel de busqueda. Con QUICK ya no hay nada que podar.
+        float pruning = (format == DXGI_FORMAT_BC7_UNORM && !options.encoderOnly) ? GetBC7Pruning() : 0.0f;
+        bool prune = pruning > 0.0f && !(flags & TEX_COMPRESS_BC7_QUICK);
+
+        // Sin modos de 3 subconjuntos que quitar, TWO_SUBSETS es FULL
+        bool hasThreeSubsets = !lanes && (flags & TEX_COMPRESS_BC7_USE_3SUBSETS);
+
+        size_t blocksW = (rgba.width + 3) / 4;
+        size_t blocksH = (rgba.height + 3) / 4;
+
+        BlockFastPathStats local = {};
+        local.totalBlocks = uint32_t(blocksW * blocksH);
+
+        // 1. Clasificar; los triviales se escriben ya
+        std::vector<uint32_t> pending[kBC7TierCount];
+        uint32_t px[16];
+        uint8_t color[4];
+
+        for (size_t by = 0; by < blocksH; ++by)
+        {
+            for (size_t bx = 0; bx < blocksW; ++bx)
+            {
+                GatherBlock(rgba, bx, by, px);
+
+                BlockKind kind = ClassifyBlock(px, color);
+                if (kind == BLOCK_REGULAR)
+                {
+                    BC7SearchTier tier = prune ? ClassifyBC7Block(px, pruning) : BC7_TIER_FULL;
+                    if (tier == BC7_TIER_TWO_SUBSETS && !hasThreeSubsets)
+                        tier = BC7_TIER_FULL;
+
+                    pending[tier].push_back(uint32_t(by * blocksW + bx));
+                    continue;
+                }
+
+                uint8_t* block = dst.pixels + by * dst.rowPitch + bx * 16;
+                if (format == DXGI_FORMAT_BC7_UNORM)
+                    EncodeBC7SingleColor(color, block);
+                else
+                    EncodeBC3SingleColor(color, block);
+
+                if (kind == BLOCK_TRANSPARENT)
+                    ++local.transparentBlocks;
+                else
+                    ++local.constantBlocks;
+            }
+        }
+
+        if (stats)
+            *stats = local;
+
+        if (prune)
+        {
+            uint64_t counts[kBC7TierCount];
+            for (size_t t = 0; t < kBC7TierCount; ++t)
+                counts[t] = pending[t].size();
+            RecordBC7Pruning(counts);
+        }
+
+        // 2. Cada grupo con sus flags; en la cache, cada nivel con su clave
+        for (size_t t = 0; t < kBC7TierCount; ++t)
+        {
+            if (pending[t].empty())
+                continue;
+
+            BC7SearchTier tier = BC7SearchTier(t);
+
+            BC7LaneParams tierLanes = {};
+            if (lanes)
+            {
+                tierLanes = *lanes;
+                if (tier == BC7_TIER_LINE)
+                    tierLanes.partitions = 0;
+            }
+
+            PendingEncoder encoder = {};
+            encoder.flags = GetBC7TierFlags(flags, tier);
+            encoder.bc7Lanes = lanes ? &tierLanes : nullptr;
+            encoder.bcnLanes = bcnLanes ? &bcnParams : nullptr;
+            encoder.cacheFlags = cacheFlags | kTierCacheFlags[t];
+            encoder.useCache = !options.encoderOnly;
+
+            HRESULT hr = EncodePending(rgba, format, encoder, dst, pending[t]);
+            if (FAILED(hr)) return hr;
+        }
+
+        return S_OK;
+    }
+
+    // RDO de bloques (BlockRDO.h) sobre la imagen ya codificada, si esta
+    // puesto y el formato lo admite
+    HRESULT ApplyDefaultBlockRDO(const Image& rgba, const Image& dst, bool parallel)
+    {
+        BlockRDOParams params = GetBlockRDO();
+        if (params.lambda <= 0.0f || !IsBlockRDOFormat(dst.format) || rgba.format != DXGI_FORMAT_R8G8B8A8_UNORM)
+            return S_OK;
+
+        return ApplyBlockRDO(rgba, dst, params, parallel);
+    }
+}
+
+HRESULT CompressBlocks(
+    const Image& rgba,
+    DXGI_FORMAT format,
+    TEX_COMPRESS_FLAGS flags,
+    ScratchImage& out,
+    BlockFastPathStats* stats)
+{
+    if (!IsCompressed(format) || !rgba.pixels)
+        return Compress(rgba, format, flags, 1.0f, out);
+
+    HRESULT hr = out.Initialize2D(format, rgba.width, rgba.height, 1, 1);
+    if (FAILED(hr)) return hr;
+
+    hr = EncodeBlocks(rgba, format, flags, *out.GetImage(0, 0, 0), TileEncodeOptions(), stats);
+    if (FAILED(hr)) return hr;
+
+    return ApplyDefaultBlockRDO(rgba, *out.GetImage(0, 0, 0), false);
+}
+
+// -------------------------------------------------------------
+// CODIFICACION POR TILES
+// -------------------------------------------------------------
+namespace
+{
+    std::mutex g_tileLock;
+    TileEncodeOptions g_tileDefaults;
+
+    // Pools compartidos por (hilos, afinidad). No se destruyen nunca:
+    // unirse a los hilos al descargar la DLL puede bloquear el loader.
+    std::map<std::pair<unsigned, uint64_t>, WorkStealingPool*> g_tilePools;
+
+    WorkStealingPool* GetTilePool(unsigned threads, uint64_t affinityMask)
+    {
+        std::lock_guard<std::mutex> lk(g_tileLock);
+
+        WorkStealingPool*& pool = g_tilePools[std::make_pair(threads, affinityMask)];
+        if (pool)
+            return pool;
+
+        std::function<void()> init;
+        if (affinityMask)
+        {
+            // Cada worker se queda con el siguiente bit de la mascara
+            auto next = std::make_shared<std::atomic<unsigned>>(0);
+            init = [next, affinityMask]()
+                {
+                    unsigned bits = 0;
+                    for (uint64_t m = affinityMask; m; m &= m - 1) ++bits;
+
+                    unsigned pick = next->fetch_add(1) % bits;
+                    uint64_t m = affinityMask;
+                    for (unsigned i = 0; i < pick; ++i) m &= m - 1;
+
+                    SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(m & (~m + 1)));
+                };
+        }
+
+        pool = new WorkStealingPool(threads, init);
+        return pool;
+    }
+}
+
+void SetDefaultTileEncodeOptions(const TileEncodeOptions& options)
+{
+    // El codificador por llamada no pasa a las demas conversiones
+    TileEncodeOptions defaults = options;
+    defaults.bc7Backend = -1;
+    defaults.bcnEncoder = -1;
+    defaults.encoderOnly = false;
+
+    std::lock_guard<std::mutex> lk(g_tileLock);
+    g_tileDefaults = defaults;
+}
+
+TileEncodeOptions GetDefaultTileEncodeOptions()
+{
+    std::lock_guard<std::mutex> lk(g_tileLock);
+    return g_tileDefaults;
+}
+
+unsigned ResolveTileThreads(const TileEncodeOptions& options)
+{
+    return options.threads ? options.threads : WorkStealingPool::DefaultWorkerCount();
+}
+
+WorkStealingPool* GetTileEncodePool(const TileEncodeOptions& options)
+{
+    return GetTilePool(ResolveTileThreads(options), options.affinityMask);
+}
+
+namespace
+{
+    // Codificacion por tiles sobre 'dst' (ya reservado)
+    HRESULT EncodeTiled(
+        const Image& rgba,
+        DXGI_FORMAT format,
+        TEX_COMPRESS_FLAGS flags,
+        const Image& dst,
+        const TileEncodeOptions& options,
+        BlockFastPathStats* stats)
+    {
+        TraceSpan span("EncodeTiled");
+
+        // El paralelismo lo ponen los tiles, no DirectXTex
+        flags &= ~TEX_COMPRESS_PARALLEL;
+
+        unsigned threads = ResolveTileThreads(options);
+        size_t blocksW = (rgba.width + 3) / 4;
+        size_t blocksH = (rgba.height + 3) / 4;
+
+        size_t tileRows = options.tileBlockRows
+            ? options.tileBlockRows
+            : std::max<size_t>(1, blocksH / (size_t(threads) * 4));
+        size_t tileCount = (blocksH + tileRows - 1) / tileRows;
+
+        if (threads <= 1 || tileCount <= 1)
+            return EncodeBlocks(rgba, format, flags, dst, options, stats);
+
+        std::atomic<HRESULT> firstError{ S_OK };
+        std::atomic<uint32_t> constantBlocks{ 0 };
+        std::atomic<uint32_t> transparentBlocks{ 0 };
+
+        WorkStealingPool* pool = GetTilePool(threads, options.affinityMask);
+        WorkStealingPool::TaskGroup group;
+        TraceContext traceContext = Trace::GetContext();
+
+        for (size_t t = 0; t < tileCount; ++t)
+        {
+            pool->Submit([&, t]()
+                {
+                    if (FAILED(firstError.load()))
+                        return;
+
+                    TraceContextScope traceScope(traceContext);
+                    TraceSpan tileSpan("EncodeTile");
+
+                    size_t by = t * tileRows;
+                    size_t rows = std::min(tileRows, blocksH - by);
+                    size_t y0 = by * 4;
+
+                    Image tile = rgba;
+                    tile.height = std::min(rows * 4, rgba.height - y0);
+                    tile.pixels = rgba.pixels + y0 * rgba.rowPitch;
+                    tile.slicePitch = tile.rowPitch * tile.height;
+
+                    // Cada tile escribe directamente sus filas de bloques
+                    Image tileDst = dst;
+                    tileDst.height = tile.height;
+                    tileDst.pixels = dst.pixels + by * dst.rowPitch;
+                    tileDst.slicePitch = dst.rowPitch * rows;
+
+                    BlockFastPathStats tileStats = {};
+                    HRESULT thr = EncodeBlocks(tile, format, flags, tileDst, options, &tileStats);
+                    if (FAILED(thr))
+                    {
+                        HRESULT expected = S_OK;
+                        firstError.compare_exchange_strong(expected, thr);
+                        return;
+                    }
+
+                    constantBlocks.fetch_add(tileStats.constantBlocks);
+                    transparentBlocks.fetch_add(tileStats.transparentBlocks);
+                }, &group);
+        }
+
+        pool->Wait(&group);
+
+        if (FAILED(firstError.load()))
+            return firstError.load();
+
+        if (stats)
+        {
+            stats->totalBlocks = uint32_t(blocksW * blocksH);
+            stats->constantBlocks = constantBlocks.load();
+            stats->transparentBlocks = transparentBlocks.load();
+        }
+
+        return S_OK;
+    }
+}
+
+HRESULT CompressTiled(
+    const Image& rgba,
+    DXGI_FORMAT format,
+    TEX_COMPRESS_FLAGS flags,
+    ScratchImage& out,
+    const TileEncodeOptions& options,
+    BlockFastPathStats* stats)
+{
+    if (!IsCompressed(format) || !rgba.pixels)
+        return CompressBlocks(rgba, format, flags & ~TEX_COMPRESS_PARALLEL, out, stats);
+
+    HRESULT hr = out.Initialize2D(format, rgba.width, rgba.height, 1, 1);
+    if (FAILED(hr)) return hr;
+
+    hr = EncodeTiled(rgba, format, flags, *out.GetImage(0, 0, 0), options, stats);
+    if (FAILED(hr) || options.encoderOnly) return hr;
+
+    return ApplyDefaultBlockRDO(rgba, *out.GetImage(0, 0, 0), ResolveTileThreads(options) > 1);
+}
+
+HRESULT CompressTiled(
+    const Image& rgba,
+    DXGI_FORMAT format,
+    TEX_COMPRESS_FLAGS flags,
+    const Image& dst,
+    const TileEncodeOptions& options,
+    BlockFastPathStats* stats)
+{
+    bool valid = IsCompressed(format) && rgba.pixels && dst.pixels
+        && dst.format == format && dst.width == rgba.width && dst.height == rgba.height;
+
+    if (!valid)
+        return E_INVALIDARG;
+
+    HRESULT hr = EncodeTiled(rgba, format, flags, dst, options, stats);
+    if (FAILED(hr) || options.encoderOnly) return hr;
+
+    return ApplyDefaultBlockRDO(rgba, dst, ResolveTileThreads(options) > 1);
+}
+
+// -------------------------------------------------------------
+// BC7 CON LIMITE DE TIEMPO
+// -------------------------------------------------------------
+
+HRESULT CompressBC7WithDeadline(
+    const Image& rgba,
+    const Image& dstImg,
+    const BC7Tier* tiers,
+    size_t tierCount,
+    BC7DeadlineStats* stats)
+{
+    if (!rgba.pixels || !tiers || tierCount == 0 || tierCount > kMaxBC7Tiers)
+        return E_INVALIDARG;
+
+    if (!dstImg.pixels || dstImg.format != DXGI_FORMAT_BC7_UNORM
+        || dstImg.width != rgba.width || dstImg.height != rgba.height)
+        return E_INVALIDARG;
+
+    TraceSpan span("CompressBC7WithDeadline");
+    uint64_t t0 = GetTickCount64();
+
+    size_t blocksW = (rgba.width + 3) / 4;
+    size_t blocksH = (rgba.height + 3) / 4;
+
+    BC7DeadlineStats local = {};
+    local.budgetMs = uint32_t(std::min<uint64_t>(tiers[0].deadlineMs, UINT32_MAX));
+    local.totalBlocks = uint32_t(blocksW * blocksH);
+    local.tierCount = uint32_t(tierCount);
+    for (size_t i = 0; i < tierCount; ++i)
+        local.tierQuality[i] = int32_t(tiers[i].quality);
+
+    HRESULT hr = S_OK;
+
+    // Una fila de bloques por hilo en cada banda (= granularidad del checkpoint)
+    TileEncodeOptions tileOptions = GetDefaultTileEncodeOptions();
+    tileOptions.tileBlockRows = 1;
+    size_t bandRows = ResolveTileThreads(tileOptions);
+
+    size_t tier = 0;
+
+    for (size_t by = 0; by < blocksH; by += bandRows)
+    {
+        // Checkpoint: si el tier actual ya agoto su tiempo, bajamos
+        uint64_t elapsed = GetTickCount64() - t0;
+        while (tier + 1 < tierCount && elapsed >= tiers[tier].deadlineMs)
+            ++tier;
+
+        size_t bandBlockRows = std::min(bandRows, blocksH - by);
+        size_t y0 = by * 4;
+
+        Image band = rgba;
+        band.height = std::min(bandBlockRows * 4, rgba.height - y0);
+        band.pixels = rgba.pixels + y0 * rgba.rowPitch;
+        band.slicePitch = band.rowPitch * band.height;
+
+        // La banda se codifica directamente en sus filas de bloques
+        Image bandDst = dstImg;
+        bandDst.height = band.height;
+        bandDst.pixels = dstImg.pixels + by * dstImg.rowPitch;
+        bandDst.slicePitch = dstImg.rowPitch * bandBlockRows;
+
+        hr = EncodeTiled(band, DXGI_FORMAT_BC7_UNORM, GetBC7CompressFlags(tiers[tier].quality), bandDst, tileOptions, nullptr);
+        if (FAILED(hr)) return hr;
+
+        local.tierBlocks[tier] += uint32_t(bandBlockRows * blocksW);
+    }
+
+    hr = ApplyDefaultBlockRDO(rgba, dstImg, bandRows > 1);
+    if (FAILED(hr)) return hr;
+
+    local.elapsedMs = uint32_t(std::min<uint64_t>(GetTickCount64() - t0, UINT32_MAX));
+
+    if (stats)
+        *stats = local;
+
+    return S_OK;
+}
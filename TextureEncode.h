@@ -0,0 +1,151 @@
+#pragma once
+
+#include <windows.h>
+#include "DirectXTex.h"
+#include <cstdint>
+
+enum class BC7Quality
+{
+    UltraFast = 0,        // QUICK + UNIFORM
+    FastBalanced = 1,     // QUICK + 3SUBSETS + UNIFORM
+    Balanced = 2,         // 3SUBSETS
+    HighQuality = 3,      // Full (solo PARALLEL)
+    HighQualityUniform = 4, // Full + UNIFORM
+    QuickOnly = 5
+};
+
+DirectX::TEX_COMPRESS_FLAGS GetBC7CompressFlags(BC7Quality quality);
+DirectX::TEX_COMPRESS_FLAGS GetBC3CompressFlags();
+
+HRESULT CompressBC7(const DirectX::ScratchImage& rgba, DirectX::ScratchImage& out, BC7Quality quality = BC7Quality::FastBalanced);
+HRESULT CompressBC3(const DirectX::ScratchImage& rgba, DirectX::ScratchImage& out);
+
+// Lo mismo sobre una imagen prestada (no se copia): sirve cualquier
+// Image que apunte a pixeles RGBA8 validos mientras dure la llamada
+HRESULT CompressBC7(const DirectX::Image& rgba, DirectX::ScratchImage& out, BC7Quality quality = BC7Quality::FastBalanced);
+HRESULT CompressBC3(const DirectX::Image& rgba, DirectX::ScratchImage& out);
+
+// -------------------------------------------------------------
+// Atajo para bloques 4x4 triviales (BC7 y BC3).
+//
+// Los bloques de un solo color o totalmente transparentes se escriben
+// desde tablas precalculadas (codificacion optima de un color); el
+// resto se empaqueta en una imagen compacta, pasa por Compress y se
+// vuelve a colocar en su sitio. Con otros formatos llama a Compress.
+// Con la cache de bloques activa (BlockCache.h), los normales que ya
+// se codificaron antes se copian de ahi en vez de pasar por Compress.
+// En BC7, si la calidad de las flags tiene puesto el codificador por
+// carriles (BC7LaneEncoder.h), los normales van por el y no por Compress.
+// Con la poda de BC7 activa (BC7Pruning.h) cada bloque normal se
+// codifica con las flags del nivel de busqueda que le toca. Con el
+// codificador BC1/BC3/BC4 propio puesto (BCnLaneEncoder.h), los
+// normales de BC3 van por el, y BC1/BC4 enteros tambien.
+// -------------------------------------------------------------
+struct BlockFastPathStats
+{
+    uint32_t totalBlocks;
+    uint32_t constantBlocks;        // un solo RGBA
+    uint32_t transparentBlocks;     // alpha == 0 en los 16 pixeles
+};
+
+HRESULT CompressBlocks(
+    const DirectX::Image& rgba,
+    DXGI_FORMAT format,
+    DirectX::TEX_COMPRESS_FLAGS flags,
+    DirectX::ScratchImage& out,
+    BlockFastPathStats* stats = nullptr);
+
+// -------------------------------------------------------------
+// Codificacion por tiles.
+//
+// La imagen se parte en tiles de filas de bloques que se reparten en
+// un pool propio (ver WorkStealingPool). Cada tile pasa por
+// CompressBlocks sin TEX_COMPRESS_PARALLEL, asi todas las calidades
+// BC7 y BC3 escalan igual. CompressBC7/CompressBC3 usan las opciones
+// por defecto (SetDefaultTileEncodeOptions).
+//
+// Con SetBlockRDO (BlockRDO.h) puesto, CompressBlocks y CompressTiled
+// pasan el RDO de bloques a la salida BC7/BC3 entera al final.
+//
+// El codificador sale de SetBC7Backend / SetBCnEncoder salvo que las
+// opciones de la llamada lo fijen (p.ej. un benchmark que compara
+// codificadores sin tocar lo que usan las demas conversiones).
+// -------------------------------------------------------------
+struct TileEncodeOptions
+{
+    unsigned threads = 0;           // 0 = un hilo por core logico
+    uint64_t affinityMask = 0;      // 0 = sin afinidad; si no, cada worker fijo a un bit
+    size_t tileBlockRows = 0;       // 0 = automatico (unos 4 tiles por hilo)
+
+    // Solo para esta llamada (no se guardan en las opciones por defecto)
+    int bc7Backend = -1;            // BC7Backend; -1 = el de SetBC7Backend
+    int bcnEncoder = -1;            // BCnEncoder; -1 = el de SetBCnEncoder
+    bool encoderOnly = false;       // sin cache de bloques, poda ni RDO
+};
+
+void SetDefaultTileEncodeOptions(const TileEncodeOptions& options);
+TileEncodeOptions GetDefaultTileEncodeOptions();
+
+// Numero de hilos que usaran estas opciones
+unsigned ResolveTileThreads(const TileEncodeOptions& options);
+
+// Pool de estas opciones (el mismo que usa CompressTiled), para otros
+// trabajos por bandas sobre la imagen que se codifica
+class WorkStealingPool;
+WorkStealingPool* GetTileEncodePool(const TileEncodeOptions& options);
+
+HRESULT CompressTiled(
+    const DirectX::Image& rgba,
+    DXGI_FORMAT format,
+    DirectX::TEX_COMPRESS_FLAGS flags,
+    DirectX::ScratchImage& out,
+    const TileEncodeOptions& options,
+    BlockFastPathStats* stats = nullptr);
+
+// Igual, escribiendo en 'dst' ya reservado (solo formatos BC, mismo
+// tamano que rgba), p.ej. la superficie de un DDSFileWriter
+HRESULT CompressTiled(
+    const DirectX::Image& rgba,
+    DXGI_FORMAT format,
+    DirectX::TEX_COMPRESS_FLAGS flags,
+    const DirectX::Image& dst,
+    const TileEncodeOptions& options,
+    BlockFastPathStats* stats = nullptr);
+
+// -------------------------------------------------------------
+// BC7 con limite de tiempo.
+//
+// La imagen se codifica por bandas de filas de bloques (una fila por
+// hilo, en paralelo con CompressTiled). Entre banda y banda se mira
+// el reloj: mientras no se pase deadlineMs del tier
+// actual se sigue con su calidad; si se pasa, lo que queda se hace
+// con el siguiente tier (mas barato). El ultimo tier no tiene limite.
+// Es una sola pasada: nunca se recodifica lo que ya esta hecho.
+// El RDO de bloques, si esta puesto, se pasa al final como en
+// CompressTiled (y cuenta en elapsedMs).
+// -------------------------------------------------------------
+static const size_t kMaxBC7Tiers = 4;
+
+struct BC7Tier
+{
+    BC7Quality quality;
+    uint64_t deadlineMs;    // ms desde el inicio de la llamada
+};
+
+// Se devuelve al llamador (tambien desde la DLL), solo tipos planos
+struct BC7DeadlineStats
+{
+    uint32_t budgetMs;                  // deadline del primer tier
+    uint32_t elapsedMs;                 // tiempo total de la codificacion
+    uint32_t totalBlocks;
+    uint32_t tierCount;
+    int32_t  tierQuality[kMaxBC7Tiers]; // BC7Quality de cada tier
+    uint32_t tierBlocks[kMaxBC7Tiers];  // bloques codificados en cada tier
+};
+
+HRESULT CompressBC7WithDeadline(
+    const DirectX::Image& rgba,
+    const DirectX::Image& dst,      // BC7 ya reservado, mismo tamano
+    const BC7Tier* tiers,
+    size_t tierCount,
+    BC7DeadlineStats* stats = nullptr);
@@ -0,0 +1,245 @@
+#include "Trace.h"
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Trace
+{
+    std::atomic<bool> g_enabled{ false };
+}
+
+namespace
+{
+    struct TraceEvent
+    {
+        const char* name;
+        uint64_t start;
+        uint64_t end;
+        uint32_t file;
+        int32_t rule;
+    };
+
+    // Buffer circular de un hilo. El lock solo lo comparten el propio
+    // hilo y quien vuelca o vacia, asi que casi nunca hay espera.
+    struct ThreadBuffer
+    {
+        std::mutex lock;
+        std::vector<TraceEvent> events;
+        uint64_t written = 0;
+        uint32_t threadId = 0;
+    };
+
+    struct FileEntry
+    {
+        std::wstring path;
+        int32_t rule = 0;
+    };
+
+    std::mutex g_registryLock;
+    std::vector<std::shared_ptr<ThreadBuffer>> g_buffers;   // viven mas que sus hilos
+    size_t g_eventsPerThread = 16384;
+
+    std::vector<FileEntry> g_files;                         // id - 1
+    std::map<std::wstring, uint32_t> g_fileIds;
+
+    thread_local ThreadBuffer* t_buffer = nullptr;
+    thread_local TraceContext t_context;
+
+    ThreadBuffer* GetThreadBuffer()
+    {
+        if (!t_buffer)
+        {
+            auto buffer = std::make_shared<ThreadBuffer>();
+            buffer->threadId = GetCurrentThreadId();
+
+            std::lock_guard<std::mutex> lk(g_registryLock);
+            buffer->events.resize(std::max<size_t>(g_eventsPerThread, 1));
+            g_buffers.push_back(buffer);
+            t_buffer = buffer.get();
+        }
+
+        return t_buffer;
+    }
+
+    std::string JsonString(const std::wstring& s)
+    {
+        std::string utf8;
+        if (!s.empty())
+        {
+            int n = WideCharToMultiByte(CP_UTF8, 0, s.c_str(), int(s.size()), nullptr, 0, nullptr, nullptr);
+            utf8.resize(size_t(n));
+            WideCharToMultiByte(CP_UTF8, 0, s.c_str(), int(s.size()), &utf8[0], n, nullptr, nullptr);
+        }
+
+        std::string out = "\"";
+        for (char c : utf8)
+        {
+            if (c == '"' || c == '\\')
+                out += '\\';
+            out += c;
+        }
+        return out + "\"";
+    }
+}
+
+namespace Trace
+{
+    void Configure(bool enabled, size_t eventsPerThread)
+    {
+        {
+            std::lock_guard<std::mutex> lk(g_registryLock);
+            if (eventsPerThread)
+                g_eventsPerThread = eventsPerThread;
+        }
+
+        g_enabled.store(enabled);
+    }
+
+    void Record(const char* name, uint64_t start, uint64_t end)
+    {
+        ThreadBuffer* buffer = GetThreadBuffer();
+
+        std::lock_guard<std::mutex> lk(buffer->lock);
+        TraceEvent& e = buffer->events[size_t(buffer->written % buffer->events.size())];
+        e.name = name;
+        e.start = start;
+        e.end = end;
+        e.file = t_context.file;
+        e.rule = t_context.rule;
+        ++buffer->written;
+    }
+
+    TraceContext GetContext()
+    {
+        return t_context;
+    }
+
+    void SetContext(const TraceContext& context)
+    {
+        t_context = context;
+    }
+
+    uint32_t InternFile(const wchar_t* path)
+    {
+        std::wstring key(path ? path : L"");
+
+        std::lock_guard<std::mutex> lk(g_registryLock);
+
+        auto it = g_fileIds.find(key);
+        if (it != g_fileIds.end())
+            return it->second;
+
+        FileEntry entry;
+        entry.path = key;
+        g_files.push_back(entry);
+
+        uint32_t id = uint32_t(g_files.size());
+        g_fileIds[key] = id;
+        return id;
+    }
+
+    void SetRule(int ruleId)
+    {
+        if (!IsEnabled())
+            return;
+
+        t_context.rule = ruleId;
+
+        if (t_context.file)
+        {
+            std::lock_guard<std::mutex> lk(g_registryLock);
+            if (t_context.file <= g_files.size())
+                g_files[t_context.file - 1].rule = ruleId;
+        }
+    }
+
+    void Clear()
+    {
+        std::lock_guard<std::mutex> lk(g_registryLock);
+
+        for (auto& buffer : g_buffers)
+        {
+            std::lock_guard<std::mutex> blk(buffer->lock);
+            buffer->written = 0;
+        }
+
+        // Los ids que tengan los hilos ahora mismo dejan de valer
+        g_files.clear();
+        g_fileIds.clear();
+    }
+
+    HRESULT WriteChromeTrace(const wchar_t* path)
+    {
+        struct Entry
+        {
+            TraceEvent event;
+            uint32_t threadId;
+        };
+
+        std::vector<Entry> all;
+        std::vector<FileEntry> files;
+
+        {
+            std::lock_guard<std::mutex> lk(g_registryLock);
+            files = g_files;
+
+            for (auto& buffer : g_buffers)
+            {
+                std::lock_guard<std::mutex> blk(buffer->lock);
+
+                size_t size = buffer->events.size();
+                uint64_t count = std::min<uint64_t>(buffer->written, size);
+
+                for (uint64_t i = buffer->written - count; i < buffer->written; ++i)
+                    all.push_back({ buffer->events[size_t(i % size)], buffer->threadId });
+            }
+        }
+
+        std::sort(all.begin(), all.end(), [](const Entry& a, const Entry& b) { return a.event.start < b.event.start; });
+
+        FILE* f = nullptr;
+        if (!path || _wfopen_s(&f, path, L"wb") != 0 || !f)
+            return E_INVALIDARG;
+
+        LARGE_INTEGER freq;
+        QueryPerformanceFrequency(&freq);
+        double usPerTick = 1e6 / double(freq.QuadPart);
+        uint64_t base = all.empty() ? 0 : all.front().event.start;
+        unsigned long pid = GetCurrentProcessId();
+
+        fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+        for (size_t i = 0; i < all.size(); ++i)
+        {
+            const TraceEvent& e = all[i].event;
+
+            // La regla del archivo si el span es anterior a elegirla
+            int32_t rule = e.rule;
+            std::string file = "null";
+            if (e.file && e.file <= files.size())
+            {
+                const FileEntry& entry = files[e.file - 1];
+                file = JsonString(entry.path);
+                if (!rule)
+                    rule = entry.rule;
+            }
+
+            fprintf(f, "{\"name\":\"%s\",\"cat\":\"dxtex\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%lu,\"tid\":%u,"
+                "\"args\":{\"file\":%s,\"rule\":%d}}%s\n",
+                e.name,
+                double(e.start - base) * usPerTick,
+                double(e.end - e.start) * usPerTick,
+                pid, all[i].threadId,
+                file.c_str(), rule,
+                (i + 1 < all.size()) ? "," : "");
+        }
+
+        fprintf(f, "]}\n");
+        fclose(f);
+        return S_OK;
+    }
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <windows.h>
+#include <atomic>
+#include <cstdint>
+
+// -------------------------------------------------------------
+// Trazas por etapa (spans) con salida en formato Chrome trace
+// (chrome://tracing, Perfetto).
+//
+// Cada hilo escribe en su propio buffer circular (los mas viejos se
+// pisan cuando se llena), asi que grabar un span no compite con otros
+// hilos. Apagado en tiempo de ejecucion (por defecto) un TraceSpan
+// cuesta una lectura atomica; con DXT_TRACE=0 desaparece al compilar.
+//
+// Cada span lleva el archivo y la regla del contexto del hilo
+// (TraceFileScope / Trace::SetRule). Las tareas de un pool heredan el
+// contexto de quien las lanza con TraceContextScope.
+// -------------------------------------------------------------
+#ifndef DXT_TRACE
+#define DXT_TRACE 1
+#endif
+
+static const bool kTraceCompiled = (DXT_TRACE != 0);
+
+struct TraceContext
+{
+    uint32_t file = 0;      // 0 = sin archivo (ver Trace::InternFile)
+    int32_t rule = 0;       // RuleId, 0 = aun no elegida
+};
+
+namespace Trace
+{
+    extern std::atomic<bool> g_enabled;
+
+    inline bool IsEnabled()
+    {
+        return kTraceCompiled && g_enabled.load(std::memory_order_relaxed);
+    }
+
+    inline uint64_t Now()
+    {
+        LARGE_INTEGER t;
+        QueryPerformanceCounter(&t);
+        return uint64_t(t.QuadPart);
+    }
+
+    // eventsPerThread: tamano de los buffers que se creen a partir de ahora
+    void Configure(bool enabled, size_t eventsPerThread);
+
+    // 'name' tiene que ser una cadena estatica
+    void Record(const char* name, uint64_t start, uint64_t end);
+
+    TraceContext GetContext();
+    void SetContext(const TraceContext& context);
+
+    // Id estable para una ruta (la misma ruta, el mismo id)
+    uint32_t InternFile(const wchar_t* path);
+
+    // Regla del archivo actual: tambien se aplica a los spans del mismo
+    // archivo grabados antes de elegirla (carga, detectores)
+    void SetRule(int ruleId);
+
+    // Vacia todos los buffers (y la tabla de archivos)
+    void Clear();
+
+    // JSON de Chrome trace con todos los spans guardados
+    HRESULT WriteChromeTrace(const wchar_t* path);
+}
+
+class TraceSpan
+{
+public:
+    explicit TraceSpan(const char* name)
+    {
+        if (Trace::IsEnabled())
+        {
+            m_name = name;
+            m_start = Trace::Now();
+        }
+    }
+
+    ~TraceSpan() { End(); }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+    // Cierra el span antes de salir del bloque
+    void End()
+    {
+        if (m_name)
+        {
+            Trace::Record(m_name, m_start, Trace::Now());
+            m_name = nullptr;
+        }
+    }
+
+private:
+    const char* m_name = nullptr;
+    uint64_t m_start = 0;
+};
+
+// Contexto del hilo mientras dura el objeto (p.ej. en una tarea del pool)
+class TraceContextScope
+{
+public:
+    explicit TraceContextScope(const TraceContext& context)
+    {
+        if (Trace::IsEnabled())
+        {
+            m_active = true;
+            m_saved = Trace::GetContext();
+            Trace::SetContext(context);
+        }
+    }
+
+    ~TraceContextScope()
+    {
+        if (m_active)
+            Trace::SetContext(m_saved);
+    }
+
+    TraceContextScope(const TraceContextScope&) = delete;
+    TraceContextScope& operator=(const TraceContextScope&) = delete;
+
+private:
+    bool m_active = false;
+    TraceContext m_saved;
+};
+
+// Archivo actual del hilo (regla a 0 hasta Trace::SetRule)
+class TraceFileScope
+{
+public:
+    explicit TraceFileScope(const wchar_t* path)
+    {
+        if (Trace::IsEnabled())
+        {
+            m_active = true;
+            m_saved = Trace::GetContext();
+
+            TraceContext context;
+            context.file = Trace::InternFile(path);
+            Trace::SetContext(context);
+        }
+    }
+
+    ~TraceFileScope()
+    {
+        if (m_active)
+            Trace::SetContext(m_saved);
+    }
+
+    TraceFileScope(const TraceFileScope&) = delete;
+    TraceFileScope& operator=(const TraceFileScope&) = delete;
+
+private:
+    bool m_active = false;
+    TraceContext m_saved;
+};
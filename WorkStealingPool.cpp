@@ -0,0 +1,173 @@
+#include "WorkStealingPool.h"
+
+namespace
+{
+    // Pool e indice de cola del worker actual (para Submit/Wait anidados)
+    thread_local const WorkStealingPool* t_pool = nullptr;
+    thread_local size_t t_queue = 0;
+}
+
+unsigned WorkStealingPool::DefaultWorkerCount()
+{
+    unsigned n = std::thread::hardware_concurrency();
+    return n ? n : 1;
+}
+
+WorkStealingPool::WorkStealingPool(unsigned workers,
+    std::function<void()> threadInit,
+    std::function<void()> threadExit)
+    : m_threadInit(std::move(threadInit))
+    , m_threadExit(std::move(threadExit))
+{
+    if (workers == 0)
+        workers = DefaultWorkerCount();
+
+    // Una cola extra para los hilos externos que llaman a Submit/Wait
+    for (unsigned i = 0; i <= workers; ++i)
+        m_queues.emplace_back(new Queue());
+
+    m_threads.reserve(workers);
+    for (unsigned i = 0; i < workers; ++i)
+        m_threads.emplace_back(&WorkStealingPool::WorkerLoop, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    Wait();
+
+    {
+        std::lock_guard<std::mutex> lk(m_sleepLock);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+
+    for (auto& t : m_threads)
+        t.join();
+}
+
+void WorkStealingPool::Submit(Task task, TaskGroup* group)
+{
+    if (group)
+        group->pending.fetch_add(1);
+    m_pending.fetch_add(1);
+
+    size_t q;
+    if (t_pool == this)
+        q = t_queue;
+    else
+        q = m_nextQueue.fetch_add(1) % m_threads.size();
+
+    // Se cuenta antes de encolar para que m_queued nunca baje de cero
+    {
+        std::lock_guard<std::mutex> lk(m_sleepLock);
+        m_queued.fetch_add(1);
+    }
+
+    {
+        std::lock_guard<std::mutex> lk(m_queues[q]->lock);
+        m_queues[q]->entries.push_back({ std::move(task), group });
+    }
+
+    m_wake.notify_one();
+    m_done.notify_all();
+}
+
+bool WorkStealingPool::TryPop(size_t self, Entry& out)
+{
+    // 1. Propia cola, por detras (lo ultimo que se metio esta caliente en cache)
+    {
+        Queue& q = *m_queues[self];
+        std::lock_guard<std::mutex> lk(q.lock);
+        if (!q.entries.empty())
+        {
+            out = std::move(q.entries.back());
+            q.entries.pop_back();
+            m_queued.fetch_sub(1);
+            return true;
+        }
+    }
+
+    // 2. Robar del frente de las demas colas
+    size_t n = m_queues.size();
+    for (size_t i = 1; i < n; ++i)
+    {
+        Queue& q = *m_queues[(self + i) % n];
+        std::lock_guard<std::mutex> lk(q.lock);
+        if (!q.entries.empty())
+        {
+            out = std::move(q.entries.front());
+            q.entries.pop_front();
+            m_queued.fetch_sub(1);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void WorkStealingPool::Run(Entry& entry)
+{
+    entry.task();
+    entry.task = nullptr;
+
+    bool groupDone = entry.group && entry.group->pending.fetch_sub(1) == 1;
+    bool allDone = m_pending.fetch_sub(1) == 1;
+
+    if (groupDone || allDone)
+    {
+        std::lock_guard<std::mutex> lk(m_sleepLock);
+        m_done.notify_all();
+    }
+}
+
+void WorkStealingPool::Wait(TaskGroup* group)
+{
+    size_t self = (t_pool == this) ? t_queue : m_threads.size();
+
+    auto Finished = [&]()
+        {
+            return group ? group->pending.load() == 0 : m_pending.load() == 0;
+        };
+
+    while (!Finished())
+    {
+        Entry entry;
+        if (TryPop(self, entry))
+        {
+            Run(entry);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lk(m_sleepLock);
+        m_done.wait(lk, [&]() { return Finished() || m_queued.load() > 0; });
+    }
+}
+
+void WorkStealingPool::WorkerLoop(unsigned index)
+{
+    t_pool = this;
+    t_queue = index;
+
+    if (m_threadInit)
+        m_threadInit();
+
+    for (;;)
+    {
+        Entry entry;
+        if (TryPop(index, entry))
+        {
+            Run(entry);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lk(m_sleepLock);
+        m_wake.wait(lk, [&]() { return m_stop || m_queued.load() > 0; });
+        if (m_stop && m_queued.load() == 0)
+            break;
+    }
+
+    if (m_threadExit)
+        m_threadExit();
+
+    t_pool = nullptr;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// -------------------------------------------------------------
+// Pool de hilos con una cola por worker y robo de trabajo.
+// Cada worker saca de su propia cola (LIFO) y, si esta vacia,
+// roba del frente de las colas de los demas.
+// -------------------------------------------------------------
+class WorkStealingPool
+{
+public:
+    using Task = std::function<void()>;
+
+    // Agrupa tareas para poder esperar solo por ellas
+    struct TaskGroup
+    {
+        std::atomic<size_t> pending{ 0 };
+    };
+
+    // workers == 0 -> un worker por core logico.
+    // threadInit/threadExit se llaman dentro de cada worker (p.ej. CoInitializeEx).
+    explicit WorkStealingPool(unsigned workers = 0,
+        std::function<void()> threadInit = {},
+        std::function<void()> threadExit = {});
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // Desde un worker la tarea va a su propia cola; desde fuera, round-robin
+    void Submit(Task task, TaskGroup* group = nullptr);
+
+    // Espera a que terminen las tareas del grupo (o todas si group == nullptr).
+    // El hilo que espera tambien ejecuta tareas mientras tanto.
+    void Wait(TaskGroup* group = nullptr);
+
+    unsigned WorkerCount() const { return unsigned(m_threads.size()); }
+
+    static unsigned DefaultWorkerCount();
+
+private:
+    struct Entry
+    {
+        Task task;
+        TaskGroup* group;
+    };
+
+    struct Queue
+    {
+        std::mutex lock;
+        std::deque<Entry> entries;
+    };
+
+    bool TryPop(size_t self, Entry& out);
+    void Run(Entry& entry);
+    void WorkerLoop(unsigned index);
+
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_sleepLock;
+    std::condition_variable m_wake;     // workers: hay tareas nuevas
+    std::condition_variable m_done;     // Wait(): algo termino o hay tareas
+
+    std::atomic<size_t> m_queued{ 0 };
+    std::atomic<size_t> m_pending{ 0 };
+    std::atomic<unsigned> m_nextQueue{ 0 };
+    bool m_stop = false;
+
+    std::function<void()> m_threadInit;
+    std::function<void()> m_threadExit;
+};